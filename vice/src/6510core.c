@@ -437,6 +437,12 @@
                 if (monitor_mask[CALLER]) {                                                    \
                     EXPORT_REGISTERS();                                                        \
                 }                                                                              \
+                if (monitor_mask[CALLER] & (MI_TRACE)) {                                       \
+                    monitor_cputrace_store(CALLER, CLK);                                       \
+                }                                                                              \
+                if (monitor_mask[CALLER] & (MI_PROFILE)) {                                     \
+                    monitor_profile_store(CALLER, CLK);                                        \
+                }                                                                              \
                 if (monitor_mask[CALLER] & (MI_STEP)) {                                        \
                     monitor_check_icount((uint16_t)reg_pc);                                        \
                     IMPORT_REGISTERS();                                                        \
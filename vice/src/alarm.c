@@ -54,6 +54,10 @@ void alarm_context_init(alarm_context_t *context, const char *name)
 
     context->num_pending_alarms = 0;
     context->next_pending_alarm_clk = (CLOCK) ~0L;
+    context->next_pending_alarm_idx = -1;
+#ifdef USE_ALARM_HEAP
+    context->next_pending_alarm = NULL;
+#endif
 }
 
 void alarm_context_destroy(alarm_context_t *context)
@@ -98,6 +102,15 @@ void alarm_context_time_warp(alarm_context_t *context, CLOCK warp_amount,
     } else {
         context->next_pending_alarm_clk -= warp_amount;
     }
+
+#ifdef USE_ALARM_HEAP
+    /* Shifting every entry by the same amount keeps the heap ordered unless
+       a clock wrapped around, so just rebuild it to be safe.  The next alarm
+       stays the same, as with the flat array.  */
+    for (i = context->num_pending_alarms / 2; i > 0; i--) {
+        alarm_context_heap_sift_down(context, i - 1);
+    }
+#endif
 }
 
 /* ------------------------------------------------------------------------ */
@@ -164,6 +177,54 @@ void alarm_destroy(alarm_t *alarm)
     lib_free(alarm);
 }
 
+#ifdef USE_ALARM_HEAP
+void alarm_unset(alarm_t *alarm)
+{
+    alarm_context_t *context;
+    int idx;
+    unsigned int last;
+
+    idx = alarm->pending_idx;
+
+    if (idx < 0) {
+        return;                 /* Not pending.  */
+    }
+    context = alarm->context;
+
+    last = --context->num_pending_alarms;
+
+    if (last != (unsigned int)idx) {
+        /* Move the last heap entry into the hole and restore the heap
+           property in whichever direction is needed.  */
+        alarm_t *moved = context->pending_alarms[last].alarm;
+
+        alarm_context_heap_place(context, (unsigned int)idx, moved,
+                                 context->pending_alarms[last].clk);
+        alarm_context_heap_sift_up(context, (unsigned int)idx);
+        alarm_context_heap_sift_down(context, (unsigned int)moved->pending_idx);
+    }
+
+    if ((unsigned int)alarm->slot != last) {
+        /* The flat list moves its last alarm into the hole; that alarm now
+           loses ties it used to win.  */
+        alarm_t *moved = context->slot_alarms[last];
+
+        moved->slot = alarm->slot;
+        context->slot_alarms[alarm->slot] = moved;
+        alarm_context_heap_sift_down(context, (unsigned int)moved->pending_idx);
+    }
+
+    if (context->num_pending_alarms == 0) {
+        context->next_pending_alarm_clk = (CLOCK) ~0L;
+        context->next_pending_alarm_idx = -1;
+        context->next_pending_alarm = NULL;
+    } else if (context->next_pending_alarm == alarm) {
+        alarm_context_update_next_pending(context);
+    }
+
+    alarm->pending_idx = -1;
+}
+#else
 void alarm_unset(alarm_t *alarm)
 {
     alarm_context_t *context;
@@ -205,6 +266,7 @@ void alarm_unset(alarm_t *alarm)
 
     alarm->pending_idx = -1;
 }
+#endif
 
 void alarm_log_too_many_alarms(void)
 {
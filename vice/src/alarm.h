@@ -45,10 +45,16 @@ struct alarm_s {
     /* Callback to be called when the alarm is dispatched.  */
     alarm_callback_t callback;
 
-    /* Index into the pending alarm list.  If < 0, the alarm is not
-       pending.  */
+    /* Index into the pending alarm list (or heap position when built with
+       USE_ALARM_HEAP).  If < 0, the alarm is not pending.  */
     int pending_idx;
 
+#ifdef USE_ALARM_HEAP
+    /* Index the alarm would have in the flat pending alarm list; used to
+       break ties between alarms due at the same clock.  */
+    int slot;
+#endif
+
     /* Call data */
     void *data;
 
@@ -75,7 +81,9 @@ struct alarm_context_s {
     struct alarm_s *alarms;
 
     /* Pending alarm array.  Statically allocated because it's slightly
-       faster this way.  */
+       faster this way.  When built with USE_ALARM_HEAP this is kept as a
+       binary min-heap ordered by `clk' and `slot', so the next alarm is always at
+       index 0.  */
     pending_alarms_t pending_alarms[ALARM_CONTEXT_MAX_PENDING_ALARMS];
     unsigned int num_pending_alarms;
 
@@ -84,6 +92,14 @@ struct alarm_context_s {
 
     /* Pending alarm number.  */
     int next_pending_alarm_idx;
+
+#ifdef USE_ALARM_HEAP
+    /* Pending alarms by their index in the flat list.  */
+    struct alarm_s *slot_alarms[ALARM_CONTEXT_MAX_PENDING_ALARMS];
+
+    /* Next alarm to dispatch.  */
+    struct alarm_s *next_pending_alarm;
+#endif
 };
 typedef struct alarm_context_s alarm_context_t;
 
@@ -109,6 +125,160 @@ inline static CLOCK alarm_context_next_pending_clk(alarm_context_t *context)
     return context->next_pending_alarm_clk;
 }
 
+#ifdef USE_ALARM_HEAP
+
+/* Binary min-heap implementation.  `alarm_set()' and `alarm_unset()' are
+   O(log n) instead of needing a linear scan whenever the next pending alarm
+   is moved.
+
+   Alarms due at the same clock are dispatched in the same order as with the
+   flat array: each alarm also keeps the index it would have there (`slot'),
+   a full scan of the array picks the highest index among the earliest
+   alarms, so the heap breaks ties on the highest slot, and like the array
+   the next alarm is only looked up again when the array would rescan.  */
+
+/* Nonzero if alarm `a' due at `a_clk' goes before `b' due at `b_clk'.  */
+inline static int alarm_context_heap_before(alarm_t *a, CLOCK a_clk,
+                                            alarm_t *b, CLOCK b_clk)
+{
+    return a_clk < b_clk || (a_clk == b_clk && a->slot > b->slot);
+}
+
+inline static void alarm_context_heap_place(alarm_context_t *context,
+                                            unsigned int idx,
+                                            alarm_t *alarm, CLOCK clk)
+{
+    context->pending_alarms[idx].alarm = alarm;
+    context->pending_alarms[idx].clk = clk;
+    alarm->pending_idx = (int)idx;
+}
+
+inline static void alarm_context_heap_sift_up(alarm_context_t *context,
+                                              unsigned int idx)
+{
+    alarm_t *alarm = context->pending_alarms[idx].alarm;
+    CLOCK clk = context->pending_alarms[idx].clk;
+
+    while (idx > 0) {
+        unsigned int parent = (idx - 1) >> 1;
+        pending_alarms_t *p = &context->pending_alarms[parent];
+
+        if (!alarm_context_heap_before(alarm, clk, p->alarm, p->clk)) {
+            break;
+        }
+        alarm_context_heap_place(context, idx, p->alarm, p->clk);
+        idx = parent;
+    }
+    alarm_context_heap_place(context, idx, alarm, clk);
+}
+
+inline static void alarm_context_heap_sift_down(alarm_context_t *context,
+                                                unsigned int idx)
+{
+    unsigned int num = context->num_pending_alarms;
+    alarm_t *alarm = context->pending_alarms[idx].alarm;
+    CLOCK clk = context->pending_alarms[idx].clk;
+
+    for (;;) {
+        unsigned int child = (idx << 1) + 1;
+        pending_alarms_t *c;
+
+        if (child >= num) {
+            break;
+        }
+        c = &context->pending_alarms[child];
+        if (child + 1 < num
+            && alarm_context_heap_before(c[1].alarm, c[1].clk,
+                                         c[0].alarm, c[0].clk)) {
+            child++;
+            c++;
+        }
+        if (!alarm_context_heap_before(c->alarm, c->clk, alarm, clk)) {
+            break;
+        }
+        alarm_context_heap_place(context, idx, c->alarm, c->clk);
+        idx = child;
+    }
+    alarm_context_heap_place(context, idx, alarm, clk);
+}
+
+/* Look up the next alarm again, as the flat array's scan would.  */
+inline static void alarm_context_update_next_pending(alarm_context_t *context)
+{
+    if (context->num_pending_alarms > 0) {
+        context->next_pending_alarm = context->pending_alarms[0].alarm;
+        context->next_pending_alarm_clk = context->pending_alarms[0].clk;
+        context->next_pending_alarm_idx = 0;
+    } else {
+        context->next_pending_alarm_clk = (CLOCK)~0L;
+    }
+}
+
+inline static void alarm_context_dispatch(alarm_context_t *context,
+                                          CLOCK cpu_clk)
+{
+    CLOCK offset;
+    alarm_t *alarm;
+
+    offset = (CLOCK)(cpu_clk - context->next_pending_alarm_clk);
+
+    alarm = context->next_pending_alarm;
+
+    (alarm->callback)(offset, alarm->data);
+}
+
+inline static void alarm_set(alarm_t *alarm, CLOCK cpu_clk)
+{
+    alarm_context_t *context;
+    int idx;
+
+    context = alarm->context;
+    idx = alarm->pending_idx;
+
+    if (idx < 0) {
+        unsigned int new_idx;
+
+        /* Not pending yet: add.  */
+
+        new_idx = context->num_pending_alarms;
+        if (new_idx >= ALARM_CONTEXT_MAX_PENDING_ALARMS) {
+            alarm_log_too_many_alarms();
+            return;
+        }
+
+        alarm->slot = (int)new_idx;
+        context->slot_alarms[new_idx] = alarm;
+
+        context->num_pending_alarms++;
+        alarm_context_heap_place(context, new_idx, alarm, cpu_clk);
+        alarm_context_heap_sift_up(context, new_idx);
+
+        if (cpu_clk < context->next_pending_alarm_clk) {
+            context->next_pending_alarm = alarm;
+            context->next_pending_alarm_clk = cpu_clk;
+            context->next_pending_alarm_idx = 0;
+        }
+    } else {
+        /* Already pending: modify.  */
+
+        CLOCK old_clk = context->pending_alarms[idx].clk;
+
+        context->pending_alarms[idx].clk = cpu_clk;
+        if (cpu_clk < old_clk) {
+            alarm_context_heap_sift_up(context, (unsigned int)idx);
+        } else {
+            alarm_context_heap_sift_down(context, (unsigned int)idx);
+        }
+
+        if (context->next_pending_alarm_clk > cpu_clk
+            || alarm == context->next_pending_alarm) {
+            alarm_context_update_next_pending(context);
+        }
+    }
+}
+
+#else /* !USE_ALARM_HEAP */
+
 inline static void alarm_context_update_next_pending(alarm_context_t *context)
 {
     CLOCK next_pending_alarm_clk = (CLOCK)~0L;
@@ -186,4 +356,6 @@ inline static void alarm_set(alarm_t *alarm, CLOCK cpu_clk)
     }
 }
 
+#endif /* USE_ALARM_HEAP */
+
 #endif
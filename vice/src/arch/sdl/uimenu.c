@@ -1213,6 +1213,11 @@ void sdl_ui_activate_pre_action(void)
     vsync_suspend_speed_eval();
     sound_suspend();
 
+    /* lines may still be drawn into the canvas by another thread */
+    if (sdl_active_canvas->parent_raster) {
+        raster_sync(sdl_active_canvas->parent_raster);
+    }
+
     if (sdl_vkbd_state & SDL_VKBD_ACTIVE) {
         sdl_vkbd_close();
     }
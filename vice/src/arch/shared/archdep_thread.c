@@ -0,0 +1,301 @@
+/** \file   archdep_thread.c
+ * \brief   Minimal thread, mutex and condition variable wrappers
+ *
+ * Thin wrappers around POSIX threads, used by the optional multithreaded
+ * parts of the emulation. On systems without pthreads
+ * archdep_thread_available() returns 0 and archdep_thread_create() fails,
+ * callers are expected to fall back to running their work inline in that
+ * case. The mutex and condition variable functions are no-ops then.
+ *
+ * OS support:
+ *  - Linux
+ *  - Windows (pthreads-win32/winpthreads)
+ *  - MacOS
+ *  - BSD
+ */
+
+/*
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+#include "archdep_defs.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef HAVE_PTHREAD_H
+# include <pthread.h>
+#endif
+
+#ifdef UNIX_COMPILE
+# include <unistd.h>
+#endif
+
+#ifdef WIN32_COMPILE
+# include <windows.h>
+#endif
+
+#include "lib.h"
+
+#include "archdep_thread.h"
+
+
+/** \brief  Thread object */
+struct archdep_thread_s {
+#ifdef HAVE_PTHREAD_H
+    pthread_t thread;           /**< pthread handle */
+#endif
+    archdep_thread_func_t func; /**< thread function */
+    void *data;                 /**< argument for \a func */
+};
+
+/** \brief  Mutex object */
+struct archdep_mutex_s {
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_t mutex;  /**< pthread mutex */
+#else
+    int dummy;              /**< unused */
+#endif
+};
+
+/** \brief  Condition variable object */
+struct archdep_cond_s {
+#ifdef HAVE_PTHREAD_H
+    pthread_cond_t cond;    /**< pthread condition variable */
+#else
+    int dummy;              /**< unused */
+#endif
+};
+
+
+/** \brief  Check if threads can be created on this system
+ *
+ * \return  1 if threads are supported, 0 otherwise
+ */
+int archdep_thread_available(void)
+{
+#ifdef HAVE_PTHREAD_H
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+
+/** \brief  Get the number of online processors
+ *
+ * \return  number of CPU cores, at least 1
+ */
+int archdep_cpu_count(void)
+{
+    int count = 1;
+
+#if defined(UNIX_COMPILE) && defined(_SC_NPROCESSORS_ONLN)
+    count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#elif defined(WIN32_COMPILE)
+    SYSTEM_INFO info;
+
+    GetSystemInfo(&info);
+    count = (int)info.dwNumberOfProcessors;
+#endif
+    return count < 1 ? 1 : count;
+}
+
+
+#ifdef HAVE_PTHREAD_H
+/** \brief  pthread entry point, calls the user function
+ *
+ * \param[in]   arg thread object
+ *
+ * \return  NULL
+ */
+static void *thread_entry(void *arg)
+{
+    archdep_thread_t *thread = arg;
+
+    thread->func(thread->data);
+    return NULL;
+}
+#endif
+
+
+/** \brief  Create and start a thread
+ *
+ * \param[in]   func    function to run in the new thread
+ * \param[in]   data    argument for \a func
+ *
+ * \return  thread object, or NULL if the thread could not be created
+ */
+archdep_thread_t *archdep_thread_create(archdep_thread_func_t func, void *data)
+{
+#ifdef HAVE_PTHREAD_H
+    archdep_thread_t *thread = lib_malloc(sizeof *thread);
+
+    thread->func = func;
+    thread->data = data;
+    if (pthread_create(&thread->thread, NULL, thread_entry, thread) != 0) {
+        lib_free(thread);
+        return NULL;
+    }
+    return thread;
+#else
+    return NULL;
+#endif
+}
+
+
+/** \brief  Wait for a thread to finish and free the thread object
+ *
+ * \param[in,out]   thread  thread object
+ */
+void archdep_thread_join(archdep_thread_t *thread)
+{
+    if (thread == NULL) {
+        return;
+    }
+#ifdef HAVE_PTHREAD_H
+    pthread_join(thread->thread, NULL);
+#endif
+    lib_free(thread);
+}
+
+
+/** \brief  Create a mutex
+ *
+ * \return  mutex object
+ */
+archdep_mutex_t *archdep_mutex_new(void)
+{
+    archdep_mutex_t *mutex = lib_malloc(sizeof *mutex);
+
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_init(&mutex->mutex, NULL);
+#endif
+    return mutex;
+}
+
+
+/** \brief  Destroy a mutex
+ *
+ * \param[in,out]   mutex   mutex object
+ */
+void archdep_mutex_destroy(archdep_mutex_t *mutex)
+{
+    if (mutex == NULL) {
+        return;
+    }
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_destroy(&mutex->mutex);
+#endif
+    lib_free(mutex);
+}
+
+
+/** \brief  Lock a mutex
+ *
+ * \param[in,out]   mutex   mutex object
+ */
+void archdep_mutex_lock(archdep_mutex_t *mutex)
+{
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_lock(&mutex->mutex);
+#endif
+}
+
+
+/** \brief  Unlock a mutex
+ *
+ * \param[in,out]   mutex   mutex object
+ */
+void archdep_mutex_unlock(archdep_mutex_t *mutex)
+{
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_unlock(&mutex->mutex);
+#endif
+}
+
+
+/** \brief  Create a condition variable
+ *
+ * \return  condition variable object
+ */
+archdep_cond_t *archdep_cond_new(void)
+{
+    archdep_cond_t *cond = lib_malloc(sizeof *cond);
+
+#ifdef HAVE_PTHREAD_H
+    pthread_cond_init(&cond->cond, NULL);
+#endif
+    return cond;
+}
+
+
+/** \brief  Destroy a condition variable
+ *
+ * \param[in,out]   cond    condition variable object
+ */
+void archdep_cond_destroy(archdep_cond_t *cond)
+{
+    if (cond == NULL) {
+        return;
+    }
+#ifdef HAVE_PTHREAD_H
+    pthread_cond_destroy(&cond->cond);
+#endif
+    lib_free(cond);
+}
+
+
+/** \brief  Wait on a condition variable
+ *
+ * \param[in,out]   cond    condition variable object
+ * \param[in,out]   mutex   mutex, must be locked by the caller
+ */
+void archdep_cond_wait(archdep_cond_t *cond, archdep_mutex_t *mutex)
+{
+#ifdef HAVE_PTHREAD_H
+    pthread_cond_wait(&cond->cond, &mutex->mutex);
+#endif
+}
+
+
+/** \brief  Wake up one thread waiting on a condition variable
+ *
+ * \param[in,out]   cond    condition variable object
+ */
+void archdep_cond_signal(archdep_cond_t *cond)
+{
+#ifdef HAVE_PTHREAD_H
+    pthread_cond_signal(&cond->cond);
+#endif
+}
+
+
+/** \brief  Wake up all threads waiting on a condition variable
+ *
+ * \param[in,out]   cond    condition variable object
+ */
+void archdep_cond_broadcast(archdep_cond_t *cond)
+{
+#ifdef HAVE_PTHREAD_H
+    pthread_cond_broadcast(&cond->cond);
+#endif
+}
@@ -0,0 +1,52 @@
+/** \file   archdep_thread.h
+ * \brief   Minimal thread, mutex and condition variable wrappers - header
+ */
+
+/*
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_ARCHDEP_THREAD_H
+#define VICE_ARCHDEP_THREAD_H
+
+typedef struct archdep_thread_s archdep_thread_t;
+typedef struct archdep_mutex_s archdep_mutex_t;
+typedef struct archdep_cond_s archdep_cond_t;
+
+typedef void (*archdep_thread_func_t)(void *data);
+
+int archdep_thread_available(void);
+int archdep_cpu_count(void);
+
+archdep_thread_t *archdep_thread_create(archdep_thread_func_t func, void *data);
+void archdep_thread_join(archdep_thread_t *thread);
+
+archdep_mutex_t *archdep_mutex_new(void);
+void archdep_mutex_destroy(archdep_mutex_t *mutex);
+void archdep_mutex_lock(archdep_mutex_t *mutex);
+void archdep_mutex_unlock(archdep_mutex_t *mutex);
+
+archdep_cond_t *archdep_cond_new(void);
+void archdep_cond_destroy(archdep_cond_t *cond);
+void archdep_cond_wait(archdep_cond_t *cond, archdep_mutex_t *mutex);
+void archdep_cond_signal(archdep_cond_t *cond);
+void archdep_cond_broadcast(archdep_cond_t *cond);
+
+#endif
@@ -55,11 +55,16 @@
 #define SNAP_MAJOR        0
 #define SNAP_MINOR        0
 
-int c128_snapshot_write(const char *name, int save_roms, int save_disks, int event_mode)
+static int c128_snapshot_write_internal(const char *name, snapshot_stream_t *stream,
+                                        int save_roms, int save_disks, int event_mode)
 {
     snapshot_t *s;
 
-    s = snapshot_create(name, ((uint8_t)(SNAP_MAJOR)), ((uint8_t)(SNAP_MINOR)), SNAP_MACHINE_NAME);
+    if (stream != NULL) {
+        s = snapshot_create_stream(stream, ((uint8_t)(SNAP_MAJOR)), ((uint8_t)(SNAP_MINOR)), SNAP_MACHINE_NAME);
+    } else {
+        s = snapshot_create(name, ((uint8_t)(SNAP_MAJOR)), ((uint8_t)(SNAP_MINOR)), SNAP_MACHINE_NAME);
+    }
     if (s == NULL) {
         return -1;
     }
@@ -80,7 +85,9 @@ int c128_snapshot_write(const char *name, int save_roms, int save_disks, int eve
         || joyport_snapshot_write_module(s, JOYPORT_2) < 0
         || userport_snapshot_write_module(s) < 0) {
         snapshot_close(s);
-        ioutil_remove(name);
+        if (name != NULL) {
+            ioutil_remove(name);
+        }
         return -1;
     }
 
@@ -88,12 +95,17 @@ int c128_snapshot_write(const char *name, int save_roms, int save_disks, int eve
     return 0;
 }
 
-int c128_snapshot_read(const char *name, int event_mode)
+static int c128_snapshot_read_internal(const char *name, snapshot_stream_t *stream,
+                                       int event_mode)
 {
     snapshot_t *s;
     uint8_t minor, major;
 
-    s = snapshot_open(name, &major, &minor, SNAP_MACHINE_NAME);
+    if (stream != NULL) {
+        s = snapshot_open_stream(stream, &major, &minor, SNAP_MACHINE_NAME);
+    } else {
+        s = snapshot_open(name, &major, &minor, SNAP_MACHINE_NAME);
+    }
     if (s == NULL) {
         return -1;
     }
@@ -139,3 +151,23 @@ fail:
 
     return -1;
 }
+
+int c128_snapshot_write(const char *name, int save_roms, int save_disks, int event_mode)
+{
+    return c128_snapshot_write_internal(name, NULL, save_roms, save_disks, event_mode);
+}
+
+int c128_snapshot_write_stream(snapshot_stream_t *stream, int save_roms, int save_disks, int event_mode)
+{
+    return c128_snapshot_write_internal(NULL, stream, save_roms, save_disks, event_mode);
+}
+
+int c128_snapshot_read(const char *name, int event_mode)
+{
+    return c128_snapshot_read_internal(name, NULL, event_mode);
+}
+
+int c128_snapshot_read_stream(snapshot_stream_t *stream, int event_mode)
+{
+    return c128_snapshot_read_internal(NULL, stream, event_mode);
+}
@@ -30,4 +30,9 @@
 extern int c128_snapshot_write(const char *name, int save_roms, int save_disks, int event_mode);
 extern int c128_snapshot_read(const char *name, int event_mode);
 
+struct snapshot_stream_s;
+extern int c128_snapshot_write_stream(struct snapshot_stream_s *stream, int save_roms,
+                                      int save_disks, int event_mode);
+extern int c128_snapshot_read_stream(struct snapshot_stream_s *stream, int event_mode);
+
 #endif
@@ -76,6 +76,21 @@
 #include <strings.h>
 #endif
 
+/* Batch jobs run in forked worker processes, with their output captured.  */
+#if defined(HAVE_FORK) && defined(UNIX_COMPILE)
+#define C1541_BATCH_FORK
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
+/* Batch jobs work on a private memory mapping of each image.  */
+#if defined(UNIX_COMPILE) && defined(HAVE_SYS_MMAN_H) && defined(HAVE_FMEMOPEN)
+#define C1541_BATCH_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #include "archdep.h"
 #include "cbmdos.h"
 #include "cbmimage.h"
@@ -102,6 +117,7 @@
 #include "vdrive-iec.h"
 #include "vdrive.h"
 #include "vice-event.h"
+#include "zfile.h"
 #include "zipcode.h"
 #include "p64.h"
 
@@ -221,6 +237,7 @@ static const char *image_format_name(unsigned int type);
 /* command handlers */
 static int attach_cmd(int nargs, char **args);
 static int bam_cmd(int nargs, char **args);
+static int batch_cmd(int nargs, char **args);
 static int bcopy_cmd(int nargs, char **args);
 static int bfill_cmd(int nargs, char **args);
 static int block_cmd(int nargs, char **args);
@@ -228,6 +245,7 @@ static int bpoke_cmd(int nargs, char **args);
 static int bread_cmd(int nargs, char **args);
 static int bwrite_cmd(int nargs, char **args);
 static int chain_cmd(int nargs, char **args);
+static int convert_cmd(int nargs, char **args);
 static int copy_cmd(int nargs, char **args);
 static int delete_cmd(int nargs, char **args);
 static int extract_cmd(int nargs, char **args);
@@ -360,6 +378,18 @@ const command_t command_list[] = {
       "<track-max>",
       0, 3,
       bam_cmd },
+    { "batch",
+      "batch <jobfile> [<jobs> [<directory>]]",
+      "Run the jobs listed in <jobfile>, one per line: a disk image followed by\n"
+      "a command and its arguments, which is run with the image in unit 8.\n"
+      "Each job gets a private copy of the image in memory, so commands that\n"
+      "change the image leave the file alone.  <jobs> worker processes run the\n"
+      "jobs in parallel (default 1).  If <directory> is given, each job runs in\n"
+      "<directory>/<line>, where <line> is the job's line number.  For each job\n"
+      "the output lines are printed as `<line> out <text>', followed by\n"
+      "`<line> done <code> <message> <job>', with tabs between the fields.",
+      1, 3,
+      batch_cmd },
     { "bcopy",
       "bcopy <src-track> <src-sector> <dst-track> <dst-sector> [<src-unit> "
       "[<dst-unit>]]",
@@ -400,6 +430,14 @@ const command_t command_list[] = {
       "Follow and print block chain starting at (<track>,<sector>)",
       2, 3,
       chain_cmd },
+    { "convert",
+      "convert <type> <imagename> [<unit>]",
+      "Create a new image <imagename> of type <type> (see `format') and copy\n"
+      "the disk in unit <unit> into it sector by sector, e.g. to turn a G64\n"
+      "image into a D64 image.  Both images must have the same sectors per\n"
+      "track.  Unreadable sectors are reported and left empty.",
+      2, 3,
+      convert_cmd },
     { "copy",
       "copy <source1> [<source2> ... <sourceN>] <destination>",
       "Copy `source1' ... `sourceN' into destination.  If N > 1, "
@@ -642,6 +680,11 @@ static int split_args(const char *line, int *nargs, char **args)
     begin_of_arg = 1;
 
     for (s = line;; s++) {
+        if (d - tmp >= (int)sizeof tmp - 1) {
+            fprintf(stderr, "argument too long\n");
+            *nargs = 0;
+            return -1;
+        }
         switch (*s) {
             case '"':
                 begin_of_arg = 0;
@@ -649,7 +692,9 @@ static int split_args(const char *line, int *nargs, char **args)
                 continue;
             case '\\':
                 begin_of_arg = 0;
-                *(d++) = *(++s);
+                if (s[1] != '\0') {
+                    *(d++) = *(++s);
+                }
                 continue;
             case ' ':   /* fallthrough */
             case '\t':  /* fallthrough */
@@ -777,6 +822,51 @@ static int arg_to_int(const char *arg, int *return_value)
 }
 
 
+/** \brief  Get error message for \a errval
+ *
+ * \param[in]   errval  error code
+ *
+ * \return  message, or `NULL` for `FD_OK`
+ */
+static const char *error_message(int errval)
+{
+    switch (errval) {
+        case FD_OK:
+            return NULL;
+        case FD_NOTREADY:
+            return "drive not ready";
+        case FD_CHANGED:
+            return "image file has changed on disk";
+        case FD_NOTRD:
+            return "cannot read file";
+        case FD_NOTWRT:
+            return "cannot write file";
+        case FD_WRTERR:
+            return "floppy write failed";
+        case FD_RDERR:
+            return "floppy read failed";
+        case FD_INCOMP:
+            return "incompatible DOS version";
+        case FD_BADIMAGE:
+            return "invalid image"; /* Disk or tape */
+        case FD_BADNAME:
+            return "invalid filename";
+        case FD_BADVAL:
+            return "illegal value";
+        case FD_BADDEV:
+            return "illegal device number";
+        case FD_BAD_TS:
+            return "inaccessible track or sector";
+        case FD_BAD_TRKNUM:
+            return "illegal track number";
+        case FD_BAD_SECNUM:
+            return "illegal sector number";
+        default:
+            return "<unknown error>";
+    }
+}
+
+
 /** \brief  Print error message for \a errval on stderr
  *
  * \param[in]   errval  error code
@@ -784,54 +874,7 @@ static int arg_to_int(const char *arg, int *return_value)
 static void print_error_message(int errval)
 {
     if (errval < 0) {
-        switch (errval) {
-            case FD_OK:
-                break;
-            case FD_NOTREADY:
-                fprintf(stderr, "drive not ready\n");
-                break;
-            case FD_CHANGED:
-                fprintf(stderr, "image file has changed on disk\n");
-                break;
-            case FD_NOTRD:
-                fprintf(stderr, "cannot read file\n");
-                break;
-            case FD_NOTWRT:
-                fprintf(stderr, "cannot write file\n");
-                break;
-            case FD_WRTERR:
-                fprintf(stderr, "floppy write failed\n");
-                break;
-            case FD_RDERR:
-                fprintf(stderr, "floppy read failed\n");
-                break;
-            case FD_INCOMP:
-                fprintf(stderr, "incompatible DOS version\n");
-                break;
-            case FD_BADIMAGE:
-                fprintf(stderr, "invalid image\n"); /* Disk or tape */
-                break;
-            case FD_BADNAME:
-                fprintf(stderr, "invalid filename\n");
-                break;
-            case FD_BADVAL:
-                fprintf(stderr, "illegal value\n");
-                break;
-            case FD_BADDEV:
-                fprintf(stderr, "illegal device number\n");
-                break;
-            case FD_BAD_TS:
-                fprintf(stderr, "inaccessible track or sector\n");
-                break;
-            case FD_BAD_TRKNUM:
-                fprintf(stderr, "illegal track number\n");
-                break;
-            case FD_BAD_SECNUM:
-                fprintf(stderr, "illegal sector number\n");
-                break;
-            default:
-                fprintf(stderr, "<unknown error>\n");
-        }
+        fprintf(stderr, "%s\n", error_message(errval));
     }
 }
 
@@ -867,6 +910,39 @@ static int translate_fsimage_error(int err)
  */
 #define LOOKUP_AMBIGUOUS -2
 
+/** \brief  Shortest abbreviations of commands that were added after older
+ *          commands with the same prefix, so that the abbreviations of
+ *          the older commands keep working
+ */
+static const struct {
+    const char *name;   /**< command name */
+    size_t min_len;     /**< shortest abbreviation */
+} command_min_abbrev[] = {
+    { "batch", 3 },     /* `ba' is `bam' */
+    { "convert", 3 },   /* `co' is `copy' */
+    { NULL, 0 }
+};
+
+
+/** \brief  Get the shortest abbreviation of command \a name
+ *
+ * \param[in]   name    command name
+ *
+ * \return  shortest length \a name can be abbreviated to
+ */
+static size_t command_min_len(const char *name)
+{
+    int i;
+
+    for (i = 0; command_min_abbrev[i].name != NULL; i++) {
+        if (strcmp(command_min_abbrev[i].name, name) == 0) {
+            return command_min_abbrev[i].min_len;
+        }
+    }
+    return 1;
+}
+
+
 /** \brief  Look up \a cmd in the command list
  *
  * \param[in]   cmd command name or part of command name
@@ -882,7 +958,7 @@ static int lookup_command(const char *cmd)
     for (i = 0; command_list[i].name != NULL; i++) {
         size_t len = strlen(command_list[i].name);
 
-        if (len < cmd_len) {
+        if (len < cmd_len || cmd_len < command_min_len(command_list[i].name)) {
             /* cmd will never match current command in list */
             continue;
         }
@@ -934,16 +1010,61 @@ static const char *image_format_name(unsigned int type)
 }
 
 
+/** \brief  Disk image types that can be created, by name
+ */
+static const struct {
+    const char *name;   /**< type name as given on the command line */
+    int type;           /**< DISK_IMAGE_TYPE_* */
+} image_type_names[] = {
+    { "d64", DISK_IMAGE_TYPE_D64 },
+    { "d67", DISK_IMAGE_TYPE_D67 },
+    { "d71", DISK_IMAGE_TYPE_D71 },
+    { "d81", DISK_IMAGE_TYPE_D81 },
+    { "d80", DISK_IMAGE_TYPE_D80 },
+    { "d82", DISK_IMAGE_TYPE_D82 },
+    { "g64", DISK_IMAGE_TYPE_G64 },
+    { "g71", DISK_IMAGE_TYPE_G71 },
+    { "x64", DISK_IMAGE_TYPE_X64 },
+    { "d1m", DISK_IMAGE_TYPE_D1M },
+    { "d2m", DISK_IMAGE_TYPE_D2M },
+    { "d4m", DISK_IMAGE_TYPE_D4M },
+    { NULL, 0 }
+};
+
+
+/** \brief  Get disk image type from its name
+ *
+ * \param[in,out]   name    type name, e.g. `d64' (the first character is
+ *                          turned into lower case)
+ *
+ * \return  DISK_IMAGE_TYPE_* or -1 when not found
+ */
+static int image_type_from_name(char *name)
+{
+    int i;
+
+    *name = util_tolower(*name);
+    for (i = 0; image_type_names[i].name != NULL; i++) {
+        if (strcmp(name, image_type_names[i].name) == 0) {
+            return image_type_names[i].type;
+        }
+    }
+    return -1;
+}
+
+
 
 
 /** \brief  Look up \a cmd and execute
+ *
+ * Errors are reported on stderr.
  *
  * \param[in]   nargs   number of arguments in \a args
  * \param[in]   args    arguments
  *
- * \return  0 on success, -1 on failure
+ * \return  FD_OK on success, < 0 on failure
  */
-static int lookup_and_execute_command(int nargs, char **args)
+static int execute_command(int nargs, char **args)
 {
     int match = lookup_command(args[0]);
 
@@ -955,17 +1076,13 @@ static int lookup_and_execute_command(int nargs, char **args)
             || nargs - 1 > (int)(cp->max_args)) {
             fprintf(stderr, "wrong number of arguments\n");
             fprintf(stderr, "syntax: %s\n", cp->syntax);
-            return -1;
+            return FD_BADVAL;
         } else {
             int retval;
 
             retval = command_list[match].func(nargs, args);
             print_error_message(retval);
-            if (retval == FD_OK) {
-                return 0;
-            } else {
-                return -1;
-            }
+            return retval;
         }
     } else {
         if (match == LOOKUP_AMBIGUOUS) {
@@ -975,11 +1092,24 @@ static int lookup_and_execute_command(int nargs, char **args)
             fprintf(stderr, "command `%s' unrecognized.  Try `help'\n",
                     args[0]);
         }
-        return -1;
+        return FD_BADVAL;
     }
 }
 
 
+/** \brief  Look up \a cmd and execute
+ *
+ * \param[in]   nargs   number of arguments in \a args
+ * \param[in]   args    arguments
+ *
+ * \return  0 on success, -1 on failure
+ */
+static int lookup_and_execute_command(int nargs, char **args)
+{
+    return execute_command(nargs, args) == FD_OK ? 0 : -1;
+}
+
+
 /** \brief  Parse and validate unit number from a '@<unit>:' string
  *
  * \param[in]   name    string to parse
@@ -1030,31 +1160,83 @@ static int is_valid_cbm_file_name(const char *name)
 /* ------------------------------------------------------------------------- */
 
 
+/** \brief  Create the media of \a image and open it
+ *
+ * \param[in,out]   image       disk image, with the device set
+ * \param[in]       name        path to disk image file/data
+ * \param[in]       stream      stream to read a file system image from instead
+ *                              of opening \a name, or `NULL`
+ * \param[in]       read_only   open the image read-only
+ *
+ * \return 0 on success <0 on failure
+ */
+static int image_media_open(disk_image_t *image, const char *name,
+                            FILE *stream, unsigned int read_only)
+{
+    disk_image_media_create(image);
+
+    image->gcr = NULL;
+    image->p64 = lib_calloc(1, sizeof(TP64Image));
+    P64ImageCreate((PP64Image)image->p64);
+    image->read_only = read_only;
+
+    disk_image_name_set(image, name);
+    if (stream != NULL) {
+        disk_image_fsimage_fd_set(image, stream);
+    }
+
+    if (disk_image_open(image) < 0) {
+        P64ImageDestroy((PP64Image)image->p64);
+        lib_free(image->p64);
+        disk_image_media_destroy(image);
+        return -1;
+    }
+    return 0;
+}
+
+
+/** \brief  Close \a image and free its media
+ *
+ * \param[in,out]   image   disk image opened with image_media_open()
+ */
+static void image_media_close(disk_image_t *image)
+{
+    P64ImageDestroy((PP64Image)image->p64);
+    lib_free(image->p64);
+    disk_image_close(image);
+    disk_image_media_destroy(image);
+}
+
+
 /** \brief  Open a disk image
  *
  * Depending on \a name, this either opens a block device (a seekable device,
  * such as an USB stick), a character device (a real drive using OpenCBM)
  * or an image stored on the host file system.
  *
- * \param[in,out]   vdrive  virtual drive
- * \param[in]       name    path to disk image file/data
- * \param[in]       unit    unit to attach disk to
+ * \param[in,out]   vdrive      virtual drive
+ * \param[in]       name        path to disk image file/data
+ * \param[in]       unit        unit to attach disk to
+ * \param[in]       stream      stream to read the image from instead of
+ *                              opening \a name, or `NULL`
+ * \param[in]       read_only   open the image read-only
  *
  * \return 0 on success <0 on failure
  */
 static int open_disk_image(vdrive_t *vdrive, const char *name,
-                           unsigned int unit)
+                           unsigned int unit, FILE *stream,
+                           unsigned int read_only)
 {
     disk_image_t *image;
 
     image = disk_image_create();
 
-    if (archdep_file_is_blockdev(name)) {
+    if (stream == NULL && archdep_file_is_blockdev(name)) {
         image->device = DISK_IMAGE_DEVICE_RAW;
         serial_device_type_set(SERIAL_DEVICE_RAW, unit);
         serial_realdevice_disable();
     } else {
-        if (archdep_file_is_chardev(name)) {
+        if (stream == NULL && archdep_file_is_chardev(name)) {
             image->device = DISK_IMAGE_DEVICE_REAL;
             serial_device_type_set(SERIAL_DEVICE_REAL, unit);
             serial_realdevice_enable();
@@ -1065,19 +1247,7 @@ static int open_disk_image(vdrive_t *vdrive, const char *name,
         }
     }
 
-    disk_image_media_create(image);
-
-    image->gcr = NULL;
-    image->p64 = lib_calloc(1, sizeof(TP64Image));
-    P64ImageCreate((PP64Image)image->p64);
-    image->read_only = 0;
-
-    disk_image_name_set(image, name);
-
-    if (disk_image_open(image) < 0) {
-        P64ImageDestroy((PP64Image)image->p64);
-        lib_free(image->p64);
-        disk_image_media_destroy(image);
+    if (image_media_open(image, name, stream, read_only) < 0) {
         disk_image_destroy(image);
         fprintf(stderr, "cannot open file `%s'\n", name);
         return -1;
@@ -1103,13 +1273,10 @@ static void close_disk_image(vdrive_t *vdrive, int unit)
 
     if (image != NULL) {
         vdrive_detach_image(image, (unsigned int)unit, vdrive);
-        P64ImageDestroy((PP64Image)image->p64);
-        lib_free(image->p64);
         if (image->device == DISK_IMAGE_DEVICE_REAL) {
             serial_realdevice_disable();
         }
-        disk_image_close(image);
-        disk_image_media_destroy(image);
+        image_media_close(image);
         disk_image_destroy(image);
         vdrive->image = NULL;
         /* also clean up buffer used by the vdrive */
@@ -1145,7 +1312,8 @@ static int open_image(int dev, char *name, int create, int disktype)
         }
     }
 
-    if (open_disk_image(drives[dev], name, (unsigned int)dev + UNIT_MIN) < 0) {
+    if (open_disk_image(drives[dev], name, (unsigned int)dev + UNIT_MIN,
+                        NULL, 0) < 0) {
         printf("cannot open disk image\n");
         return -1;
     }
@@ -1293,179 +1461,843 @@ static int attach_cmd(int nargs, char **args)
         default:
             return FD_BADDEV;
     }
-
-    archdep_expand_path(&path, args[1]);
-    open_disk_image(drives[dev], path, (unsigned int)dev + UNIT_MIN);
-    lib_free(path);
-    return FD_OK;
+
+    archdep_expand_path(&path, args[1]);
+    open_disk_image(drives[dev], path, (unsigned int)dev + UNIT_MIN, NULL, 0);
+    lib_free(path);
+    return FD_OK;
+}
+
+/** \brief  Maximum sector numbers to print in the sector header */
+#define BAM_SECTOR_HEADER_MAX_SECTORS   256
+/** \brief  Size of a sector number header line */
+#define BAM_SECTOR_HEADER_MAX_STRLEN   (BAM_SECTOR_HEADER_MAX_SECTORS + \
+        ((BAM_SECTOR_HEADER_MAX_SECTORS / 8) - 1))
+
+
+/** \brief  Print a sector numbers header for a BAM dump
+ *
+ * Prints a two line header with sector numbers, with a space between each
+ * block of eight sectors
+ *
+ * \param[in]   sectors number of sector number to print
+ */
+static void bam_print_sector_header(int sectors)
+{
+    char line1[BAM_SECTOR_HEADER_MAX_STRLEN + 1];
+    char line2[BAM_SECTOR_HEADER_MAX_STRLEN + 1];
+
+    int i = 0;
+    int p = 0;
+
+    assert(sectors < BAM_SECTOR_HEADER_MAX_SECTORS);
+
+    while (i < sectors && p < BAM_SECTOR_HEADER_MAX_STRLEN) {
+        line1[p] = (i / 10) + '0';
+        line2[p] = (i % 10) + '0';
+        i++;
+        p++;
+        if ((i % 8 == 0) && (i <sectors)) {
+            line1[p] = ' ';
+            line2[p] = ' ';
+            p++;
+        }
+    }
+    line1[p] = '\0';
+    line2[p] = '\0';
+
+    printf("    %s\n    %s\n", line1, line2);
+}
+
+
+/** \brief  Print BAM bitmap for tracks \a track_min to \a track_max inclusive
+ *
+ * \param[in]   vdrive      vdrive object
+ * \param[in]   track_min   starting track number
+ * \param[in]   track_max   last track number
+ *
+ * \return      FD_OK on success, < 0 on failure
+ */
+static int bam_print_tracks(vdrive_t *vdrive,
+                             unsigned int track_min,
+                             unsigned int track_max)
+{
+    unsigned int track;
+
+    for (track = track_min; track <= track_max; track++) {
+        unsigned int sectors = (unsigned int)vdrive_get_max_sectors(vdrive, track);
+        unsigned char *bitmap = vdrive_bam_get_track_entry(vdrive, track);
+        unsigned int s = 0;
+
+        if (bitmap == NULL) {
+            fprintf(stderr,
+                    "error: got NULL for bam entry for track %u\n",
+                    track);
+            return FD_BADVAL;
+        }
+
+        printf("%2u  ", track);
+        while (s < sectors) {
+            putchar(vdrive_bam_isset(bitmap, s) ? '.' : '*');
+            s++;
+            if ((s % 8 == 0) && (s < sectors)) {
+                putchar(' ');
+            }
+        }
+        putchar('\n');
+    }
+    return FD_OK;
+}
+
+
+/** \brief  Show BAM of an attached image
+ *
+ * Display a bitmap of used/free sectors for each track in the image
+ *
+ * Syntax: 
+ *
+ * \param[in]   nargs   argument count
+ * \param[in]   args    argument list
+ *
+ * \return  FD_OK on success, < 0 on failure
+ */
+static int bam_cmd(int nargs, char **args)
+{
+    int unit = drive_index + UNIT_MIN;
+    vdrive_t *vdrive;
+    int max_sectors;
+
+    unsigned int track_min = 0; /* 0 means first track in image */
+    unsigned int track_max = 0; /* 0 means last track in image */
+
+    int result = FD_OK;
+
+    /* get unit number, if provided by the user */
+    if (nargs == 2) {
+        unit = parse_unit_number(args[1]);
+        if (unit < 0) {
+            return unit;
+        }
+    } else if (nargs > 2) {
+        /* default unit, track-min and track-max */
+        result = parse_track_sector(args[1], args[2], &track_min, &track_max);
+        if (result < 0) {
+            return result;
+        }
+        if (nargs == 4) {
+            /* parse unit number */
+            unit = parse_unit_number(args[3]);
+            if (unit < 0) {
+                return unit;
+            }
+        }
+    }
+
+#if 0
+    printf("bam_cmd(): unit #%d\n", unit);
+#endif
+    /* get vdrive instance */
+    result = check_drive_ready(unit - UNIT_MIN);
+    if (result < 0) {
+        return result;
+    }
+    vdrive = drives[unit - UNIT_MIN];
+#if 0
+    printf("bam_cmd(): image format: %s\n", image_format_name(vdrive->image_format));
+    printf("bam_cmd(): BAM size: $%x\n", vdrive->bam_size);
+#endif
+
+    /* set track min and max */
+    if (track_min == 0) {
+        track_min = 1;
+    }
+    if (track_max == 0) {
+        track_max = vdrive->image->tracks;
+    }
+
+    if (track_min < 1 || track_max > vdrive->image->tracks) {
+        return FD_BAD_TRKNUM;
+    }
+    if (track_min > track_max) {
+        return FD_BADVAL;
+    }
+
+    /* print sector numbers header
+     * XXX: this assumes track 1 always has the maximum number of sectors for
+     *      an image */
+    max_sectors = vdrive_get_max_sectors(vdrive, 1);
+    if (max_sectors < 0) {
+        return FD_BADVAL;
+    }
+
+    /* print sector numbers header and the actual BAM bitmap per track */
+    bam_print_sector_header(max_sectors);
+    bam_print_tracks(vdrive, track_min, track_max);
+    return FD_OK;
+}
+
+
+/* ------------------------------------------------------------------------- */
+/* Batch mode */
+
+/** \brief  Return value of batch_cmd() when jobs failed
+ *
+ * Positive, so no error message is printed: the failures have been reported
+ * with the jobs already.
+ */
+#define BATCH_JOBS_FAILED   1
+
+
+/** \brief  Batch job, one line of the job list
+ */
+typedef struct batch_job_s {
+    int line;       /**< line number in the job list */
+    char *text;     /**< disk image, command and arguments */
+} batch_job_t;
+
+
+/** \brief  Jobs read from the job list
+ */
+static batch_job_t *batch_jobs = NULL;
+
+/** \brief  Number of jobs in `batch_jobs`
+ */
+static int batch_jobs_count = 0;
+
+/** \brief  Next job to run, when not handed out by the parent process
+ */
+static int batch_jobs_next = 0;
+
+/** \brief  Directory the jobs run in subdirectories of, or `NULL`
+ */
+static char *batch_dir = NULL;
+
+/** \brief  Current directory when the batch was started
+ */
+static char *batch_cwd = NULL;
+
+#ifdef C1541_BATCH_MMAP
+/** \brief  Private mapping of the image of the current job
+ */
+static void *batch_map = NULL;
+
+/** \brief  Size of `batch_map`
+ */
+static size_t batch_map_size = 0;
+#endif
+
+#ifdef C1541_BATCH_FORK
+/** \brief  Job numbers are handed out to the workers through this pipe
+ */
+static int batch_job_pipe[2] = { -1, -1 };
+
+/** \brief  Holds a single byte, taken by a worker while it prints a job
+ */
+static int batch_lock_pipe[2] = { -1, -1 };
+
+/** \brief  Workers report how many jobs they ran and how many failed here
+ */
+static int batch_status_pipe[2] = { -1, -1 };
+
+/** \brief  Output of the current job
+ */
+static FILE *batch_capture = NULL;
+
+/** \brief  stdout while the job output is captured
+ */
+static int batch_stdout = -1;
+
+/** \brief  stderr while the job output is captured
+ */
+static int batch_stderr = -1;
+#endif
+
+
+/** \brief  Read the job list \a path
+ *
+ * Empty lines and lines starting with `#` are skipped.
+ *
+ * \param[in]   path    job list
+ *
+ * \return  FD_OK on success, < 0 on failure
+ */
+static int batch_read_list(const char *path)
+{
+    FILE *f;
+    char buf[1024];
+    char *p;
+    int line = 0;
+    int size = 0;
+
+    f = fopen(path, MODE_READ_TEXT);
+    if (f == NULL) {
+        fprintf(stderr, "cannot open job list `%s'\n", path);
+        return FD_NOTRD;
+    }
+    while (util_get_line(buf, (int)sizeof buf, f) >= 0) {
+        line++;
+        /* tabs separate the fields of the records */
+        for (p = buf; *p != '\0'; p++) {
+            if (*p == '\t') {
+                *p = ' ';
+            }
+        }
+        for (p = buf; isspace((unsigned char)*p); p++) {
+            /* skip leading white space */
+        }
+        if (*p == '\0' || *p == '#') {
+            continue;
+        }
+        if (batch_jobs_count == size) {
+            size = size > 0 ? size * 2 : 256;
+            batch_jobs = lib_realloc(batch_jobs, (size_t)size * sizeof *batch_jobs);
+        }
+        batch_jobs[batch_jobs_count].line = line;
+        batch_jobs[batch_jobs_count].text = lib_stralloc(p);
+        batch_jobs_count++;
+    }
+    fclose(f);
+    return FD_OK;
+}
+
+
+/** \brief  Free the job list
+ */
+static void batch_free_list(void)
+{
+    int i;
+
+    for (i = 0; i < batch_jobs_count; i++) {
+        lib_free(batch_jobs[i].text);
+    }
+    lib_free(batch_jobs);
+    batch_jobs = NULL;
+    batch_jobs_count = 0;
+    batch_jobs_next = 0;
+}
+
+
+#ifdef C1541_BATCH_MMAP
+/** \brief  Map image \a name privately into memory
+ *
+ * Compressed images are unpacked by zfile first.  Writes only change pages
+ * private to this process, never the file.
+ *
+ * \param[in]   name    disk image
+ *
+ * \return  stream reading and writing the mapping, or `NULL` on failure
+ */
+static FILE *batch_map_image(const char *name)
+{
+    FILE *f;
+    FILE *stream;
+    struct stat st;
+    void *addr = MAP_FAILED;
+
+    f = zfile_fopen(name, MODE_READ);
+    if (f == NULL) {
+        return NULL;
+    }
+    if (fstat(fileno(f), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        addr = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE, fileno(f), 0);
+    }
+    zfile_fclose(f);
+    if (addr == MAP_FAILED) {
+        return NULL;
+    }
+
+    stream = fmemopen(addr, (size_t)st.st_size, "r+");
+    if (stream == NULL) {
+        munmap(addr, (size_t)st.st_size);
+        return NULL;
+    }
+    batch_map = addr;
+    batch_map_size = (size_t)st.st_size;
+    return stream;
+}
+
+
+/** \brief  Drop the mapping of the current job's image
+ */
+static void batch_unmap_image(void)
+{
+    if (batch_map != NULL) {
+        munmap(batch_map, batch_map_size);
+        batch_map = NULL;
+    }
+}
+#endif
+
+
+/** \brief  Attach image \a name to unit 8 for a job
+ *
+ * The job works on a private copy of the image in memory.  Where that is not
+ * supported, the image is opened read-only instead.
+ *
+ * \param[in]   name    disk image
+ *
+ * \return  0 on success, < 0 on failure
+ */
+static int batch_open_image(const char *name)
+{
+#ifdef C1541_BATCH_MMAP
+    FILE *stream = batch_map_image(name);
+
+    if (stream != NULL) {
+        if (open_disk_image(drives[0], name, UNIT_MIN, stream, 0) < 0) {
+            batch_unmap_image();
+            return -1;
+        }
+        return 0;
+    }
+#endif
+    return open_disk_image(drives[0], name, UNIT_MIN, NULL, 1);
+}
+
+
+/** \brief  Give each unit a new, empty virtual drive
+ */
+static void batch_reset_drives(void)
+{
+    int i;
+
+    for (i = 0; i < DRIVE_COUNT; i++) {
+        if (drives[i] != NULL) {
+            close_disk_image(drives[i], i + UNIT_MIN);
+            lib_free(drives[i]);
+        }
+        drives[i] = lib_calloc(1, sizeof *drives[i]);
+        p00save[i] = 0;
+    }
+    drive_index = 0;
+#ifdef C1541_BATCH_MMAP
+    batch_unmap_image();
+#endif
+}
+
+
+#ifdef C1541_BATCH_FORK
+/** \brief  Send stdout and stderr to the capture file
+ */
+static void batch_capture_start(void)
+{
+    if (batch_capture == NULL) {
+        return;
+    }
+    fflush(stdout);
+    fflush(stderr);
+    rewind(batch_capture);
+    if (ftruncate(fileno(batch_capture), 0) < 0
+            || dup2(fileno(batch_capture), STDOUT_FILENO) < 0
+            || dup2(fileno(batch_capture), STDERR_FILENO) < 0) {
+        dup2(batch_stdout, STDOUT_FILENO);
+        fprintf(stderr, "cannot capture job output: %s\n", strerror(errno));
+    }
+}
+
+
+/** \brief  Restore stdout and stderr, and rewind the capture file
+ */
+static void batch_capture_stop(void)
+{
+    if (batch_capture == NULL) {
+        return;
+    }
+    fflush(stdout);
+    fflush(stderr);
+    dup2(batch_stdout, STDOUT_FILENO);
+    dup2(batch_stderr, STDERR_FILENO);
+    rewind(batch_capture);
+}
+#endif
+
+
+/** \brief  Print the records of \a job
+ *
+ * The output of the job, one `<line> out <text>` record per line, is followed
+ * by a `<line> done <code> <message> <job>` record.  Workers print all
+ * records of a job in one go.
+ *
+ * \param[in]   job     job
+ * \param[in]   code    FD_OK or error code of the job
+ */
+static void batch_report(const batch_job_t *job, int code)
+{
+    const char *message = error_message(code);
+#ifdef C1541_BATCH_FORK
+    char buf[1024];
+    char token = 0;
+
+    if (batch_lock_pipe[0] >= 0 && read(batch_lock_pipe[0], &token, 1) != 1) {
+        fprintf(stderr, "cannot lock output: %s\n", strerror(errno));
+    }
+    if (batch_capture != NULL) {
+        while (fgets(buf, (int)sizeof buf, batch_capture) != NULL) {
+            size_t len = strlen(buf);
+
+            while (len > 0 && (buf[len - 1] == '\n' || buf[len - 1] == '\r')) {
+                buf[--len] = '\0';
+            }
+            printf("%d\tout\t%s\n", job->line, buf);
+        }
+    }
+#endif
+    printf("%d\tdone\t%d\t%s\t%s\n",
+           job->line, code, message != NULL ? message : "ok", job->text);
+    fflush(stdout);
+#ifdef C1541_BATCH_FORK
+    if (batch_lock_pipe[1] >= 0 && write(batch_lock_pipe[1], &token, 1) != 1) {
+        fprintf(stderr, "cannot unlock output: %s\n", strerror(errno));
+    }
+#endif
+}
+
+
+/** \brief  Run \a job
+ *
+ * The image is attached to unit 8 of a fresh set of drives, the command is
+ * run in the job's directory and the drives are reset afterwards.
+ *
+ * \param[in]   job     job
+ * \param[in]   args    argument list to reuse, see split_args()
+ *
+ * \return  FD_OK on success, < 0 on failure
+ */
+static int batch_run_job(const batch_job_t *job, char **args)
+{
+    int nargs;
+    int match;
+    int result;
+    char *name;
+    char *dir;
+
+    if (split_args(job->text, &nargs, args) < 0) {
+        return FD_BADVAL;
+    }
+    if (nargs < 2) {
+        fprintf(stderr, "a job needs a disk image and a command\n");
+        return FD_BADVAL;
+    }
+    match = lookup_command(args[1]);
+    if (match >= 0 && (command_list[match].func == batch_cmd
+                       || command_list[match].func == quit_cmd)) {
+        fprintf(stderr, "`%s' cannot be used in a batch job\n", args[1]);
+        return FD_BADVAL;
+    }
+
+    /* commands like `list' open the image again by name */
+    if (batch_dir != NULL && archdep_path_is_relative(args[0])) {
+        name = util_concat(batch_cwd, FSDEV_DIR_SEP_STR, args[0], NULL);
+        lib_free(args[0]);
+        args[0] = name;
+    }
+
+    if (batch_open_image(args[0]) < 0) {
+        result = FD_BADIMAGE;
+    } else if (batch_dir == NULL) {
+        result = execute_command(nargs - 1, args + 1);
+    } else {
+        name = lib_msprintf("%d", job->line);
+        dir = util_concat(batch_dir, FSDEV_DIR_SEP_STR, name, NULL);
+        ioutil_mkdir(dir, 0755);
+        if (ioutil_chdir(dir) < 0) {
+            fprintf(stderr, "cannot change to directory `%s'\n", dir);
+            result = FD_NOTWRT;
+        } else {
+            result = execute_command(nargs - 1, args + 1);
+            ioutil_chdir(batch_cwd);
+        }
+        lib_free(dir);
+        lib_free(name);
+    }
+
+    batch_reset_drives();
+    return result;
+}
+
+
+/** \brief  Get the next job to run
+ *
+ * \return  job or `NULL` when all jobs have been handed out
+ */
+static batch_job_t *batch_next_job(void)
+{
+#ifdef C1541_BATCH_FORK
+    if (batch_job_pipe[0] >= 0) {
+        int i;
+
+        if (read(batch_job_pipe[0], &i, sizeof i) != sizeof i
+                || i < 0 || i >= batch_jobs_count) {
+            return NULL;
+        }
+        return &batch_jobs[i];
+    }
+#endif
+    return batch_jobs_next < batch_jobs_count ? &batch_jobs[batch_jobs_next++] : NULL;
 }
 
-/** \brief  Maximum sector numbers to print in the sector header */
-#define BAM_SECTOR_HEADER_MAX_SECTORS   256
-/** \brief  Size of a sector number header line */
-#define BAM_SECTOR_HEADER_MAX_STRLEN   (BAM_SECTOR_HEADER_MAX_SECTORS + \
-        ((BAM_SECTOR_HEADER_MAX_SECTORS / 8) - 1))
-
 
-/** \brief  Print a sector numbers header for a BAM dump
+/** \brief  Run jobs until there are none left
  *
- * Prints a two line header with sector numbers, with a space between each
- * block of eight sectors
+ * \param[out]  failed  number of jobs that failed
  *
- * \param[in]   sectors number of sector number to print
+ * \return  number of jobs run
  */
-static void bam_print_sector_header(int sectors)
+static int batch_run_jobs(int *failed)
 {
-    char line1[BAM_SECTOR_HEADER_MAX_STRLEN + 1];
-    char line2[BAM_SECTOR_HEADER_MAX_STRLEN + 1];
+    char *args[MAXARG];
+    batch_job_t *job;
+    int count = 0;
+    int result;
+    int i;
 
-    int i = 0;
-    int p = 0;
+    for (i = 0; i < MAXARG; i++) {
+        args[i] = NULL;
+    }
+#ifdef C1541_BATCH_FORK
+    batch_capture = tmpfile();
+    batch_stdout = dup(STDOUT_FILENO);
+    batch_stderr = dup(STDERR_FILENO);
+    if (batch_capture == NULL || batch_stdout < 0 || batch_stderr < 0) {
+        fprintf(stderr, "cannot capture job output, printing it as it comes\n");
+        if (batch_capture != NULL) {
+            fclose(batch_capture);
+            batch_capture = NULL;
+        }
+    }
+#endif
 
-    assert(sectors < BAM_SECTOR_HEADER_MAX_SECTORS);
+    *failed = 0;
+    while ((job = batch_next_job()) != NULL) {
+#ifdef C1541_BATCH_FORK
+        batch_capture_start();
+#endif
+        result = batch_run_job(job, args);
+#ifdef C1541_BATCH_FORK
+        batch_capture_stop();
+#endif
+        batch_report(job, result);
+        count++;
+        if (result != FD_OK) {
+            (*failed)++;
+        }
+    }
 
-    while (i < sectors && p < BAM_SECTOR_HEADER_MAX_STRLEN) {
-        line1[p] = (i / 10) + '0';
-        line2[p] = (i % 10) + '0';
-        i++;
-        p++;
-        if ((i % 8 == 0) && (i <sectors)) {
-            line1[p] = ' ';
-            line2[p] = ' ';
-            p++;
+#ifdef C1541_BATCH_FORK
+    if (batch_capture != NULL) {
+        fclose(batch_capture);
+        batch_capture = NULL;
+    }
+    if (batch_stdout >= 0) {
+        close(batch_stdout);
+        batch_stdout = -1;
+    }
+    if (batch_stderr >= 0) {
+        close(batch_stderr);
+        batch_stderr = -1;
+    }
+#endif
+    for (i = 0; i < MAXARG; i++) {
+        if (args[i] != NULL) {
+            lib_free(args[i]);
         }
     }
-    line1[p] = '\0';
-    line2[p] = '\0';
+    return count;
+}
 
-    printf("    %s\n    %s\n", line1, line2);
+
+#ifdef C1541_BATCH_FORK
+/** \brief  Close both ends of \a fds
+ *
+ * \param[in,out]   fds     pipe
+ */
+static void batch_close_pipe(int *fds)
+{
+    if (fds[0] >= 0) {
+        close(fds[0]);
+        fds[0] = -1;
+    }
+    if (fds[1] >= 0) {
+        close(fds[1]);
+        fds[1] = -1;
+    }
 }
 
 
-/** \brief  Print BAM bitmap for tracks \a track_min to \a track_max inclusive
+/** \brief  Run the jobs in \a workers forked processes
  *
- * \param[in]   vdrive      vdrive object
- * \param[in]   track_min   starting track number
- * \param[in]   track_max   last track number
+ * The parent hands out the jobs and waits for the workers.  Only the parent
+ * returns.
  *
- * \return      FD_OK on success, < 0 on failure
+ * \param[in]   workers number of worker processes
+ * \param[out]  failed  number of jobs that failed or were not run
+ *
+ * \return  number of jobs run, or -1 if no worker could be started
  */
-static int bam_print_tracks(vdrive_t *vdrive,
-                             unsigned int track_min,
-                             unsigned int track_max)
+static int batch_spawn_workers(int workers, int *failed)
 {
-    unsigned int track;
+    int started = 0;
+    int done = 0;
+    int counts[2];
+    int status;
+    int i;
+    char token = 0;
+
+    if (pipe(batch_job_pipe) < 0
+            || pipe(batch_lock_pipe) < 0
+            || pipe(batch_status_pipe) < 0
+            || write(batch_lock_pipe[1], &token, 1) != 1) {
+        fprintf(stderr, "cannot create pipes: %s\n", strerror(errno));
+        batch_close_pipe(batch_job_pipe);
+        batch_close_pipe(batch_lock_pipe);
+        batch_close_pipe(batch_status_pipe);
+        return -1;
+    }
 
-    for (track = track_min; track <= track_max; track++) {
-        unsigned int sectors = (unsigned int)vdrive_get_max_sectors(vdrive, track);
-        unsigned char *bitmap = vdrive_bam_get_track_entry(vdrive, track);
-        unsigned int s = 0;
+    /* don't let the workers flush our buffered output again */
+    fflush(NULL);
 
-        if (bitmap == NULL) {
-            fprintf(stderr,
-                    "error: got NULL for bam entry for track %u\n",
-                    track);
-            return FD_BADVAL;
-        }
+    for (i = 0; i < workers; i++) {
+        pid_t pid = fork();
 
-        printf("%2u  ", track);
-        while (s < sectors) {
-            putchar(vdrive_bam_isset(bitmap, s) ? '.' : '*');
-            s++;
-            if ((s % 8 == 0) && (s < sectors)) {
-                putchar(' ');
+        if (pid == 0) {
+            close(batch_job_pipe[1]);
+            batch_job_pipe[1] = -1;
+            close(batch_status_pipe[0]);
+            batch_status_pipe[0] = -1;
+
+            counts[0] = batch_run_jobs(&counts[1]);
+            if (write(batch_status_pipe[1], counts, sizeof counts) != sizeof counts) {
+                exit(EXIT_FAILURE);
             }
+            exit(EXIT_SUCCESS);
         }
-        putchar('\n');
+        if (pid < 0) {
+            fprintf(stderr, "fork() failed: %s\n", strerror(errno));
+            break;
+        }
+        started++;
     }
-    return FD_OK;
+    close(batch_job_pipe[0]);
+    batch_job_pipe[0] = -1;
+    close(batch_status_pipe[1]);
+    batch_status_pipe[1] = -1;
+
+    if (started == 0) {
+        batch_close_pipe(batch_job_pipe);
+        batch_close_pipe(batch_lock_pipe);
+        batch_close_pipe(batch_status_pipe);
+        return -1;
+    }
+
+    for (i = 0; i < batch_jobs_count; i++) {
+        if (write(batch_job_pipe[1], &i, sizeof i) != sizeof i) {
+            fprintf(stderr, "cannot hand out job: %s\n", strerror(errno));
+            break;
+        }
+    }
+    batch_close_pipe(batch_job_pipe);
+
+    while (started > 0 && wait(&status) > 0) {
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+            fprintf(stderr, "a batch worker failed\n");
+        }
+        started--;
+    }
+
+    *failed = 0;
+    while (read(batch_status_pipe[0], counts, sizeof counts) == sizeof counts) {
+        done += counts[0];
+        *failed += counts[1];
+    }
+    batch_close_pipe(batch_status_pipe);
+    batch_close_pipe(batch_lock_pipe);
+
+    /* jobs lost with a worker count as failed */
+    *failed += batch_jobs_count - done;
+    return done;
 }
+#endif
 
 
-/** \brief  Show BAM of an attached image
+/** \brief  Run the jobs listed in a file
  *
- * Display a bitmap of used/free sectors for each track in the image
+ * Syntax: batch \<jobfile> [\<jobs> [\<directory>]]
  *
- * Syntax: 
+ * The jobs get drives of their own, the drives in use before are left alone.
  *
  * \param[in]   nargs   argument count
  * \param[in]   args    argument list
  *
- * \return  FD_OK on success, < 0 on failure
+ * \return  FD_OK if all jobs succeeded, `BATCH_JOBS_FAILED` if some failed,
+ *          < 0 on failure
  */
-static int bam_cmd(int nargs, char **args)
+static int batch_cmd(int nargs, char **args)
 {
-    int unit = drive_index + UNIT_MIN;
-    vdrive_t *vdrive;
-    int max_sectors;
-
-    unsigned int track_min = 0; /* 0 means first track in image */
-    unsigned int track_max = 0; /* 0 means last track in image */
-
-    int result = FD_OK;
+    vdrive_t *saved_drives[DRIVE_COUNT];
+    unsigned int saved_p00save[DRIVE_COUNT];
+    int saved_drive_index = drive_index;
+    int workers = 1;
+    int done = -1;
+    int failed = 0;
+    int result;
+    int i;
 
-    /* get unit number, if provided by the user */
-    if (nargs == 2) {
-        unit = parse_unit_number(args[1]);
-        if (unit < 0) {
-            return unit;
-        }
-    } else if (nargs > 2) {
-        /* default unit, track-min and track-max */
-        result = parse_track_sector(args[1], args[2], &track_min, &track_max);
-        if (result < 0) {
-            return result;
-        }
-        if (nargs == 4) {
-            /* parse unit number */
-            unit = parse_unit_number(args[3]);
-            if (unit < 0) {
-                return unit;
-            }
+    if (nargs >= 3) {
+        if (arg_to_int(args[2], &workers) < 0 || workers < 1) {
+            return FD_BADVAL;
         }
     }
 
-#if 0
-    printf("bam_cmd(): unit #%d\n", unit);
-#endif
-    /* get vdrive instance */
-    result = check_drive_ready(unit - UNIT_MIN);
+    result = batch_read_list(args[1]);
     if (result < 0) {
         return result;
     }
-    vdrive = drives[unit - UNIT_MIN];
-#if 0
-    printf("bam_cmd(): image format: %s\n", image_format_name(vdrive->image_format));
-    printf("bam_cmd(): BAM size: $%x\n", vdrive->bam_size);
-#endif
-
-    /* set track min and max */
-    if (track_min == 0) {
-        track_min = 1;
+    if (nargs >= 4) {
+        batch_dir = lib_stralloc(args[3]);
+        ioutil_mkdir(batch_dir, 0755);
     }
-    if (track_max == 0) {
-        track_max = vdrive->image->tracks;
+    batch_cwd = ioutil_current_dir();
+
+    for (i = 0; i < DRIVE_COUNT; i++) {
+        saved_drives[i] = drives[i];
+        saved_p00save[i] = p00save[i];
+        drives[i] = NULL;
     }
+    batch_reset_drives();
 
-    if (track_min < 1 || track_max > vdrive->image->tracks) {
-        return FD_BAD_TRKNUM;
+    if (workers > batch_jobs_count) {
+        workers = batch_jobs_count;
     }
-    if (track_min > track_max) {
-        return FD_BADVAL;
+#ifdef C1541_BATCH_FORK
+    if (workers > 1) {
+        done = batch_spawn_workers(workers, &failed);
+    }
+#else
+    if (workers > 1) {
+        fprintf(stderr, "parallel jobs are not supported on this platform\n");
+    }
+#endif
+    if (done < 0) {
+        done = batch_run_jobs(&failed);
     }
+    fprintf(stderr, "%d jobs, %d failed\n", batch_jobs_count, failed);
 
-    /* print sector numbers header
-     * XXX: this assumes track 1 always has the maximum number of sectors for
-     *      an image */
-    max_sectors = vdrive_get_max_sectors(vdrive, 1);
-    if (max_sectors < 0) {
-        return FD_BADVAL;
+    for (i = 0; i < DRIVE_COUNT; i++) {
+        lib_free(drives[i]);
+        drives[i] = saved_drives[i];
+        p00save[i] = saved_p00save[i];
     }
+    drive_index = saved_drive_index;
 
-    /* print sector numbers header and the actual BAM bitmap per track */
-    bam_print_sector_header(max_sectors);
-    bam_print_tracks(vdrive, track_min, track_max);
-    return FD_OK;
+    batch_free_list();
+    lib_free(batch_dir);
+    batch_dir = NULL;
+    lib_free(batch_cwd);
+    batch_cwd = NULL;
+
+    return failed > 0 ? BATCH_JOBS_FAILED : FD_OK;
 }
 
 
@@ -2031,6 +2863,138 @@ static int chain_cmd(int nargs, char **args)
 }
 
 
+/** \brief  Count the sectors of \a track in \a image
+ *
+ * \param[in]   image   disk image
+ * \param[in]   track   track number
+ *
+ * \return  number of sectors, 0 if \a image has no such track
+ */
+static unsigned int image_track_sectors(const disk_image_t *image,
+                                        unsigned int track)
+{
+    unsigned int sector = 0;
+
+    if (track > image->tracks) {
+        return 0;
+    }
+    while (sector < 256 && disk_image_check_sector(image, track, sector) >= 0) {
+        sector++;
+    }
+    return sector;
+}
+
+
+/** \brief  Copy a disk sector by sector into a new image of another type
+ *
+ * Syntax: convert \<type> \<imagename> [\<unit>]
+ *
+ * \param[in]   nargs   argument count
+ * \param[in]   args    argument list
+ *
+ * \return  FD_OK on success, or < 0 on failure
+ */
+static int convert_cmd(int nargs, char **args)
+{
+    unsigned char buffer[RAW_BLOCK_SIZE];
+    int unit = drive_index + UNIT_MIN;
+    int type;
+    vdrive_t *vdrive;
+    disk_image_t *image;
+    disk_addr_t dadr;
+    unsigned int tracks;
+    unsigned int sectors;
+    int unreadable = 0;
+    int result = FD_OK;
+    char *path;
+
+    type = image_type_from_name(args[1]);
+    if (type < 0) {
+        return FD_BADVAL;
+    }
+
+    /* get unit number, if specified */
+    if (nargs == 4) {
+        if (arg_to_int(args[3], &unit) < 0 || check_drive_unit(unit) < 0) {
+            return FD_BADDEV;
+        }
+    }
+    if (check_drive_ready(unit - UNIT_MIN) < 0) {
+        return FD_NOTREADY;
+    }
+    vdrive = drives[unit - UNIT_MIN];
+
+    archdep_expand_path(&path, args[2]);
+    if (cbmimage_create_image(path, (unsigned int)type) < 0) {
+        fprintf(stderr, "cannot create disk image `%s'\n", path);
+        lib_free(path);
+        return FD_WRTERR;
+    }
+    image = disk_image_create();
+    image->device = DISK_IMAGE_DEVICE_FS;
+    if (image_media_open(image, path, NULL, 0) < 0) {
+        fprintf(stderr, "cannot open disk image `%s'\n", path);
+        disk_image_destroy(image);
+        lib_free(path);
+        return FD_BADIMAGE;
+    }
+
+    /* only tracks both images have, with the same number of sectors */
+    tracks = image->tracks;
+    if (vdrive->image->tracks < tracks) {
+        tracks = vdrive->image->tracks;
+    }
+    for (dadr.track = 1; dadr.track <= tracks; dadr.track++) {
+        if (image_track_sectors(image, dadr.track)
+                != image_track_sectors(vdrive->image, dadr.track)) {
+            fprintf(stderr,
+                    "track %u of unit %d and `%s' differ in size\n",
+                    dadr.track, unit, path);
+            result = FD_BADIMAGE;
+            break;
+        }
+    }
+
+    if (result == FD_OK) {
+        printf("converting unit %d to `%s' ...\n", unit, path);
+        for (dadr.track = 1; dadr.track <= tracks && result == FD_OK; dadr.track++) {
+            sectors = image_track_sectors(image, dadr.track);
+            for (dadr.sector = 0; dadr.sector < sectors; dadr.sector++) {
+                if (vdrive_read_sector(vdrive, buffer, dadr.track, dadr.sector) != 0) {
+                    fprintf(stderr, "cannot read track %u sector %u\n",
+                            dadr.track, dadr.sector);
+                    unreadable++;
+                    continue;
+                }
+                if (disk_image_write_sector(image, buffer, &dadr) < 0) {
+                    fprintf(stderr, "cannot write track %u sector %u\n",
+                            dadr.track, dadr.sector);
+                    result = FD_WRTERR;
+                    break;
+                }
+            }
+        }
+        if (vdrive->image->tracks > tracks) {
+            printf("tracks %u-%u of unit %d not copied\n",
+                   tracks + 1, vdrive->image->tracks, unit);
+        }
+    }
+
+    image_media_close(image);
+    disk_image_destroy(image);
+    if (result == FD_BADIMAGE) {
+        ioutil_remove(path);
+    }
+    lib_free(path);
+
+    if (result == FD_OK && unreadable > 0) {
+        fprintf(stderr, "%d sectors could not be read\n", unreadable);
+        result = FD_RDERR;
+    }
+    return result;
+}
+
+
 /** \brief  Copy one or more files
  *
  * \param[in]   nargs   argument count
@@ -2409,33 +3373,8 @@ static int format_cmd(int nargs, char **args)
         case 5:
             /* format <diskname,id> <type> <imagename> [<unit>] */
             /* Create a new image.  */
-            /* TODO: change into table lookup */
-            *args[2] = util_tolower(*args[2]);
-            if (strcmp(args[2], "d64") == 0) {
-                disk_type = DISK_IMAGE_TYPE_D64;
-            } else if (strcmp(args[2], "d67") == 0) {
-                disk_type = DISK_IMAGE_TYPE_D67;
-            } else if (strcmp(args[2], "d71") == 0) {
-                disk_type = DISK_IMAGE_TYPE_D71;
-            } else if (strcmp(args[2], "d81") == 0) {
-                disk_type = DISK_IMAGE_TYPE_D81;
-            } else if (strcmp(args[2], "d80") == 0) {
-                disk_type = DISK_IMAGE_TYPE_D80;
-            } else if (strcmp(args[2], "d82") == 0) {
-                disk_type = DISK_IMAGE_TYPE_D82;
-            } else if (strcmp(args[2], "g64") == 0) {
-                disk_type = DISK_IMAGE_TYPE_G64;
-            } else if (strcmp(args[2], "g71") == 0) {
-                disk_type = DISK_IMAGE_TYPE_G71;
-            } else if (strcmp(args[2], "x64") == 0) {
-                disk_type = DISK_IMAGE_TYPE_X64;
-            } else if (strcmp(args[2], "d1m") == 0) {
-                disk_type = DISK_IMAGE_TYPE_D1M;
-            } else if (strcmp(args[2], "d2m") == 0) {
-                disk_type = DISK_IMAGE_TYPE_D2M;
-            } else if (strcmp(args[2], "d4m") == 0) {
-                disk_type = DISK_IMAGE_TYPE_D4M;
-            } else {
+            disk_type = image_type_from_name(args[2]);
+            if (disk_type < 0) {
                 return FD_BADVAL;
             }
             if (nargs > 4) {
@@ -4346,6 +5285,7 @@ static int unlynx_cmd(int nargs, char **args)
 static int validate_cmd(int nargs, char **args)
 {
     int dnr = drive_index;
+    int status;
 
     /* get unit number from args */
     if (nargs >= 2) {
@@ -4367,7 +5307,12 @@ static int validate_cmd(int nargs, char **args)
     }
 
     printf("validating in unit %d ...\n", dnr + 8);
-    vdrive_command_validate(drives[dnr]);
+    status = vdrive_command_validate(drives[dnr]);
+    if (status != CBMDOS_IPE_OK) {
+        printf("%02d, %s, 00, 00\n",
+                status, cbmdos_errortext((unsigned int)status));
+        return FD_RDERR;
+    }
 
     return FD_OK;
 }
@@ -4700,7 +5645,8 @@ int main(int argc, char **argv)
         if ((i - 1) == DRIVE_COUNT) {
             fprintf(stderr, "Ignoring disk image `%s'\n", argv[i]);
         } else {
-            open_disk_image(drives[i - 1], argv[i], (unsigned int)(i - 1 + 8));
+            open_disk_image(drives[i - 1], argv[i], (unsigned int)(i - 1 + 8),
+                            NULL, 0);
         }
     }
 
@@ -76,6 +76,66 @@ static io_source_list_t c64io_d700_head = { NULL, NULL, NULL };
 static io_source_list_t c64io_de00_head = { NULL, NULL, NULL };
 static io_source_list_t c64io_df00_head = { NULL, NULL, NULL };
 
+/* ---------------------------------------------------------------------------------------------------------- */
+
+/*
+    Per-address dispatch tables, rebuilt whenever a device is registered or
+    unregistered. Each entry holds the only device decoding that address, NULL
+    when there is none, or io_source_multiple when the list has to be walked to
+    resolve priorities and collisions.
+*/
+
+#define IO_PAGES 10
+
+static io_source_t io_source_multiple;
+
+static io_source_t *io_read_dispatch[IO_PAGES][0x100];
+static io_source_t *io_store_dispatch[IO_PAGES][0x100];
+
+static io_source_list_t * const io_page_head[IO_PAGES] = {
+    &c64io_d000_head, &c64io_d100_head, &c64io_d200_head, &c64io_d300_head,
+    &c64io_d400_head, &c64io_d500_head, &c64io_d600_head, &c64io_d700_head,
+    &c64io_de00_head, &c64io_df00_head
+};
+
+static const uint16_t io_page_base[IO_PAGES] = {
+    0xd000, 0xd100, 0xd200, 0xd300, 0xd400, 0xd500, 0xd600, 0xd700, 0xde00, 0xdf00
+};
+
+static void io_source_dispatch_update(io_source_list_t *head)
+{
+    io_source_list_t *current;
+    io_source_t *read;
+    io_source_t *store;
+    uint16_t addr;
+    int page, i;
+
+    for (page = 0; page < IO_PAGES; page++) {
+        if (io_page_head[page] == head) {
+            break;
+        }
+    }
+    assert(page < IO_PAGES);
+
+    for (i = 0; i < 0x100; i++) {
+        addr = (uint16_t)(io_page_base[page] + i);
+        read = NULL;
+        store = NULL;
+        for (current = head->next; current; current = current->next) {
+            if ((addr >= current->device->start_address) && (addr <= current->device->end_address)) {
+                if (current->device->read != NULL) {
+                    read = (read == NULL) ? current->device : &io_source_multiple;
+                }
+                if (current->device->store != NULL) {
+                    store = (store == NULL) ? current->device : &io_source_multiple;
+                }
+            }
+        }
+        io_read_dispatch[page][i] = read;
+        io_store_dispatch[page][i] = store;
+    }
+}
+
 static void io_source_detach(io_source_detach_t *source)
 {
     switch (source->det_id) {
@@ -291,9 +351,10 @@ static void io_source_log_collisions(uint16_t addr, int amount, io_source_list_t
     }
 }
 
-static inline uint8_t io_read(io_source_list_t *list, uint16_t addr)
+static inline uint8_t io_read(io_source_list_t *list, io_source_t **dispatch, uint16_t addr)
 {
     io_source_list_t *current = list->next;
+    io_source_t *device = dispatch[addr & 0xff];
     int io_source_counter = 0;
     int io_source_valid = 0;
     uint8_t realval = 0;
@@ -303,6 +364,14 @@ static inline uint8_t io_read(io_source_list_t *list, uint16_t addr)
 
     vicii_handle_pending_alarms_external(0);
 
+    /* a single device can neither collide nor be overridden */
+    if (device == NULL) {
+        return vicii_read_phi1();
+    } else if (device != &io_source_multiple) {
+        retval = device->read((uint16_t)(addr & device->address_mask));
+        return device->io_source_valid ? retval : vicii_read_phi1();
+    }
+
     while (current) {
         if (current->device->read != NULL) {
             if ((addr >= current->device->start_address) && (addr <= current->device->end_address)) {
@@ -389,15 +458,23 @@ static inline uint8_t io_peek(io_source_list_t *list, uint16_t addr)
     return vicii_read_phi1();
 }
 
-static inline void io_store(io_source_list_t *list, uint16_t addr, uint8_t value)
+static inline void io_store(io_source_list_t *list, io_source_t **dispatch, uint16_t addr, uint8_t value)
 {
     int writes = 0;
     uint16_t addy = 0xffff;
     io_source_list_t *current = list->next;
+    io_source_t *device = dispatch[addr & 0xff];
     void (*store)(uint16_t address, uint8_t data) = NULL;
 
     vicii_handle_pending_alarms_external_write();
 
+    if (device == NULL) {
+        return;
+    } else if (device != &io_source_multiple) {
+        device->store((uint16_t)(addr & device->address_mask), value);
+        return;
+    }
+
     while (current) {
         if (current->device->store != NULL) {
             if (addr >= current->device->start_address && addr <= current->device->end_address) {
@@ -471,6 +548,11 @@ io_source_list_t *io_source_register(io_source_t *device)
     retval->next = NULL;
     retval->device->order = order++;
 
+    while (current->previous != NULL) {
+        current = current->previous;
+    }
+    io_source_dispatch_update(current);
+
     return retval;
 }
 
@@ -494,6 +576,11 @@ void io_source_unregister(io_source_list_t *device)
         }
     }
 
+    while (prev->previous != NULL) {
+        prev = prev->previous;
+    }
+    io_source_dispatch_update(prev);
+
     lib_free(device);
 }
 
@@ -572,7 +659,7 @@ void cartio_set_highest_order(unsigned int nr)
 uint8_t c64io_d000_read(uint16_t addr)
 {
     DBGRW(("IO: io-d000 r %04x\n", addr));
-    return io_read(&c64io_d000_head, addr);
+    return io_read(&c64io_d000_head, io_read_dispatch[0], addr);
 }
 
 uint8_t c64io_d000_peek(uint16_t addr)
@@ -584,13 +671,13 @@ uint8_t c64io_d000_peek(uint16_t addr)
 void c64io_d000_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-d000 w %04x %02x\n", addr, value));
-    io_store(&c64io_d000_head, addr, value);
+    io_store(&c64io_d000_head, io_store_dispatch[0], addr, value);
 }
 
 uint8_t c64io_d100_read(uint16_t addr)
 {
     DBGRW(("IO: io-d100 r %04x\n", addr));
-    return io_read(&c64io_d100_head, addr);
+    return io_read(&c64io_d100_head, io_read_dispatch[1], addr);
 }
 
 uint8_t c64io_d100_peek(uint16_t addr)
@@ -602,13 +689,13 @@ uint8_t c64io_d100_peek(uint16_t addr)
 void c64io_d100_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-d100 w %04x %02x\n", addr, value));
-    io_store(&c64io_d100_head, addr, value);
+    io_store(&c64io_d100_head, io_store_dispatch[1], addr, value);
 }
 
 uint8_t c64io_d200_read(uint16_t addr)
 {
     DBGRW(("IO: io-d200 r %04x\n", addr));
-    return io_read(&c64io_d200_head, addr);
+    return io_read(&c64io_d200_head, io_read_dispatch[2], addr);
 }
 
 uint8_t c64io_d200_peek(uint16_t addr)
@@ -620,13 +707,13 @@ uint8_t c64io_d200_peek(uint16_t addr)
 void c64io_d200_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-d200 w %04x %02x\n", addr, value));
-    io_store(&c64io_d200_head, addr, value);
+    io_store(&c64io_d200_head, io_store_dispatch[2], addr, value);
 }
 
 uint8_t c64io_d300_read(uint16_t addr)
 {
     DBGRW(("IO: io-d300 r %04x\n", addr));
-    return io_read(&c64io_d300_head, addr);
+    return io_read(&c64io_d300_head, io_read_dispatch[3], addr);
 }
 
 uint8_t c64io_d300_peek(uint16_t addr)
@@ -638,13 +725,13 @@ uint8_t c64io_d300_peek(uint16_t addr)
 void c64io_d300_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-d300 w %04x %02x\n", addr, value));
-    io_store(&c64io_d300_head, addr, value);
+    io_store(&c64io_d300_head, io_store_dispatch[3], addr, value);
 }
 
 uint8_t c64io_d400_read(uint16_t addr)
 {
     DBGRW(("IO: io-d400 r %04x\n", addr));
-    return io_read(&c64io_d400_head, addr);
+    return io_read(&c64io_d400_head, io_read_dispatch[4], addr);
 }
 
 uint8_t c64io_d400_peek(uint16_t addr)
@@ -656,13 +743,13 @@ uint8_t c64io_d400_peek(uint16_t addr)
 void c64io_d400_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-d400 w %04x %02x\n", addr, value));
-    io_store(&c64io_d400_head, addr, value);
+    io_store(&c64io_d400_head, io_store_dispatch[4], addr, value);
 }
 
 uint8_t c64io_d500_read(uint16_t addr)
 {
     DBGRW(("IO: io-d500 r %04x\n", addr));
-    return io_read(&c64io_d500_head, addr);
+    return io_read(&c64io_d500_head, io_read_dispatch[5], addr);
 }
 
 uint8_t c64io_d500_peek(uint16_t addr)
@@ -674,13 +761,13 @@ uint8_t c64io_d500_peek(uint16_t addr)
 void c64io_d500_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-d500 w %04x %02x\n", addr, value));
-    io_store(&c64io_d500_head, addr, value);
+    io_store(&c64io_d500_head, io_store_dispatch[5], addr, value);
 }
 
 uint8_t c64io_d600_read(uint16_t addr)
 {
     DBGRW(("IO: io-d600 r %04x\n", addr));
-    return io_read(&c64io_d600_head, addr);
+    return io_read(&c64io_d600_head, io_read_dispatch[6], addr);
 }
 
 uint8_t c64io_d600_peek(uint16_t addr)
@@ -692,13 +779,13 @@ uint8_t c64io_d600_peek(uint16_t addr)
 void c64io_d600_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-d600 w %04x %02x\n", addr, value));
-    io_store(&c64io_d600_head, addr, value);
+    io_store(&c64io_d600_head, io_store_dispatch[6], addr, value);
 }
 
 uint8_t c64io_d700_read(uint16_t addr)
 {
     DBGRW(("IO: io-d700 r %04x\n", addr));
-    return io_read(&c64io_d700_head, addr);
+    return io_read(&c64io_d700_head, io_read_dispatch[7], addr);
 }
 
 uint8_t c64io_d700_peek(uint16_t addr)
@@ -710,13 +797,13 @@ uint8_t c64io_d700_peek(uint16_t addr)
 void c64io_d700_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-d700 w %04x %02x\n", addr, value));
-    io_store(&c64io_d700_head, addr, value);
+    io_store(&c64io_d700_head, io_store_dispatch[7], addr, value);
 }
 
 uint8_t c64io_de00_read(uint16_t addr)
 {
     DBGRW(("IO: io-de00 r %04x\n", addr));
-    return io_read(&c64io_de00_head, addr);
+    return io_read(&c64io_de00_head, io_read_dispatch[8], addr);
 }
 
 uint8_t c64io_de00_peek(uint16_t addr)
@@ -728,13 +815,13 @@ uint8_t c64io_de00_peek(uint16_t addr)
 void c64io_de00_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-de00 w %04x %02x\n", addr, value));
-    io_store(&c64io_de00_head, addr, value);
+    io_store(&c64io_de00_head, io_store_dispatch[8], addr, value);
 }
 
 uint8_t c64io_df00_read(uint16_t addr)
 {
     DBGRW(("IO: io-df00 r %04x\n", addr));
-    return io_read(&c64io_df00_head, addr);
+    return io_read(&c64io_df00_head, io_read_dispatch[9], addr);
 }
 
 uint8_t c64io_df00_peek(uint16_t addr)
@@ -746,7 +833,7 @@ uint8_t c64io_df00_peek(uint16_t addr)
 void c64io_df00_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-df00 w %04x %02x\n", addr, value));
-    io_store(&c64io_df00_head, addr, value);
+    io_store(&c64io_df00_head, io_store_dispatch[9], addr, value);
 }
 
 /* ---------------------------------------------------------------------------------------------------------- */
@@ -0,0 +1,528 @@
+/** \file   vsid-render.c
+ * \brief   Headless batch rendering of PSID tunes to audio files
+ *
+ * With -render VSID runs without a UI, reads a list of PSID files and renders
+ * each tune to its own audio file through a sound recording device, with warp
+ * mode enabled so the emulation is never throttled.
+ *
+ * Each line of the list is a PSID file, optionally followed by a tune number
+ * and a length ("seconds" or "m:ss"). Tune 0 or no tune renders every tune
+ * in the file. Without a length the HVSC Songlengths database is consulted,
+ * falling back to -renderlength.
+ *
+ * With -renderjobs N the list is rendered by N forked worker processes which
+ * take the next tune from a shared pipe when they finish one.
+ */
+
+/*
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#if defined(HAVE_FORK) && defined(UNIX_COMPILE)
+#define RENDER_USE_FORK
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
+#include "archdep.h"
+#include "archdep_join_paths.h"
+#include "cmdline.h"
+#include "hvsc.h"
+#include "ioutil.h"
+#include "lib.h"
+#include "log.h"
+#include "machine.h"
+#include "psid.h"
+#include "resources.h"
+#include "sound.h"
+#include "util.h"
+#include "vsyncapi.h"
+
+#include "vsid-render.h"
+
+
+/** \brief  Render a single tune
+ */
+typedef struct render_job_s {
+    char *path;     /**< PSID file */
+    int tune;       /**< tune number, 1-based */
+    int seconds;    /**< length to render */
+} render_job_t;
+
+/** \brief  Render state, advanced once per frame
+ */
+enum {
+    RENDER_IDLE,    /**< not rendering */
+    RENDER_INIT,    /**< read list and start workers on the next frame */
+    RENDER_NEXT,    /**< start the next tune */
+    RENDER_RUN,     /**< tune is playing */
+    RENDER_DONE     /**< all tunes rendered, quit */
+};
+
+static log_t render_log = LOG_ERR;
+
+static char *render_list = NULL;
+static char *render_dir = NULL;
+static char *render_format = NULL;
+static int render_jobs = 1;
+static int render_length = 180;
+
+static int render_state = RENDER_IDLE;
+
+static render_job_t *jobs = NULL;
+static int jobs_count = 0;
+static int jobs_next = 0;
+
+static render_job_t *current = NULL;
+static CLOCK current_cycles;
+static CLOCK current_cycles_end;
+
+static int rendered = 0;
+static int failed = 0;
+static double rendered_seconds = 0.0;
+static unsigned long start_time;
+
+#ifdef RENDER_USE_FORK
+/* Job numbers are handed out to the workers through this pipe.  */
+static int job_pipe[2] = { -1, -1 };
+#endif
+
+/* ------------------------------------------------------------------------- */
+
+static int cmdline_render(const char *param, void *extra_param)
+{
+    util_string_set(&render_list, param);
+    render_state = RENDER_INIT;
+    return 0;
+}
+
+static int cmdline_render_dir(const char *param, void *extra_param)
+{
+    util_string_set(&render_dir, param);
+    return 0;
+}
+
+static int cmdline_render_format(const char *param, void *extra_param)
+{
+    util_string_set(&render_format, param);
+    return 0;
+}
+
+static int cmdline_render_jobs(const char *param, void *extra_param)
+{
+    render_jobs = atoi(param);
+    if (render_jobs < 1) {
+        render_jobs = 1;
+    }
+    return 0;
+}
+
+static int cmdline_render_length(const char *param, void *extra_param)
+{
+    render_length = atoi(param);
+    if (render_length < 1) {
+        return -1;
+    }
+    return 0;
+}
+
+static const cmdline_option_t cmdline_options[] =
+{
+    { "-render", CALL_FUNCTION, CMDLINE_ATTRIB_NEED_ARGS,
+      cmdline_render, NULL, NULL, NULL,
+      "<Name>", "Render the PSID tunes listed in file <Name> to audio files as fast as possible, then quit" },
+    { "-renderdir", CALL_FUNCTION, CMDLINE_ATTRIB_NEED_ARGS,
+      cmdline_render_dir, NULL, NULL, NULL,
+      "<Path>", "Directory to write rendered tunes to" },
+    { "-renderformat", CALL_FUNCTION, CMDLINE_ATTRIB_NEED_ARGS,
+      cmdline_render_format, NULL, NULL, NULL,
+      "<Name>", "Sound recording device to render with (wav, flac, ...)" },
+    { "-renderjobs", CALL_FUNCTION, CMDLINE_ATTRIB_NEED_ARGS,
+      cmdline_render_jobs, NULL, NULL, NULL,
+      "<value>", "Number of worker processes rendering in parallel" },
+    { "-renderlength", CALL_FUNCTION, CMDLINE_ATTRIB_NEED_ARGS,
+      cmdline_render_length, NULL, NULL, NULL,
+      "<seconds>", "Length of tunes not found in the song length database" },
+    CMDLINE_LIST_END
+};
+
+int vsid_render_cmdline_options_init(void)
+{
+    return cmdline_register_options(cmdline_options);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Parse "seconds" or "m:ss", returns -1 if `s' is neither.  */
+static int render_parse_length(const char *s)
+{
+    char *end;
+    long value;
+
+    value = strtol(s, &end, 10);
+    if (end == s || value < 0) {
+        return -1;
+    }
+    if (*end == ':') {
+        const char *sec = end + 1;
+        long seconds = strtol(sec, &end, 10);
+
+        if (end == sec || seconds < 0 || seconds > 59) {
+            return -1;
+        }
+        value = value * 60 + seconds;
+    }
+    if (*end != '\0') {
+        return -1;
+    }
+    return (int)value;
+}
+
+static void render_add_job(const char *path, int tune, int seconds)
+{
+    long *lengths;
+    int songs;
+
+    if (seconds <= 0) {
+        songs = hvsc_sldb_get_lengths(path, &lengths);
+        if (songs >= tune && lengths[tune - 1] > 0) {
+            seconds = (int)lengths[tune - 1];
+        } else {
+            seconds = render_length;
+        }
+        if (lengths != NULL) {
+            free(lengths);
+        }
+    }
+
+    jobs = lib_realloc(jobs, (jobs_count + 1) * sizeof(render_job_t));
+    jobs[jobs_count].path = lib_stralloc(path);
+    jobs[jobs_count].tune = tune;
+    jobs[jobs_count].seconds = seconds;
+    jobs_count++;
+}
+
+/* Split a list line into the path and the optional trailing tune number and
+   length, then queue one job per tune.  */
+static void render_parse_line(char *line)
+{
+    char *fields[2];
+    int count = 0;
+    int tune = 0;
+    int seconds = 0;
+    int songs, dummy, i;
+
+    while (count < 2) {
+        char *p = line + strlen(line);
+
+        while (p > line && isspace((unsigned char)p[-1])) {
+            p--;
+        }
+        *p = '\0';
+        while (p > line && !isspace((unsigned char)p[-1])) {
+            p--;
+        }
+        if (p == line || render_parse_length(p) < 0) {
+            break;
+        }
+        fields[count++] = p;
+        p[-1] = '\0';
+    }
+    switch (count) {
+        case 2:
+            tune = atoi(fields[1]);
+            seconds = render_parse_length(fields[0]);
+            break;
+        case 1:
+            tune = atoi(fields[0]);
+            break;
+        default:
+            break;
+    }
+    while (isspace((unsigned char)*line)) {
+        line++;
+    }
+
+    if (tune > 0) {
+        render_add_job(line, tune, seconds);
+        return;
+    }
+
+    /* all tunes */
+    if (psid_load_file(line) < 0) {
+        log_error(render_log, "`%s' is not a valid PSID file.", line);
+        failed++;
+        return;
+    }
+    songs = psid_tunes(&dummy);
+    for (i = 1; i <= songs; i++) {
+        render_add_job(line, i, seconds);
+    }
+}
+
+static int render_read_list(void)
+{
+    FILE *f;
+    char buf[1024];
+
+    f = fopen(render_list, MODE_READ_TEXT);
+    if (f == NULL) {
+        log_error(render_log, "Cannot open render list `%s'.", render_list);
+        return -1;
+    }
+    while (util_get_line(buf, sizeof buf, f) >= 0) {
+        if (buf[0] == '\0' || buf[0] == '#') {
+            continue;
+        }
+        render_parse_line(buf);
+    }
+    fclose(f);
+
+    log_message(render_log, "%d tunes to render.", jobs_count);
+    return jobs_count > 0 ? 0 : -1;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void render_report(const char *what, int count, double emulated)
+{
+    double wall = (double)(vsyncarch_gettime() - start_time) / vsyncarch_frequency();
+
+    log_message(render_log,
+                "%d tunes %s, %d failed, %.1f s of audio in %.1f s (%.1f emulated seconds per second).",
+                count, what, failed, emulated, wall,
+                wall > 0.0 ? emulated / wall : 0.0);
+}
+
+#ifdef RENDER_USE_FORK
+/* Fork the workers.  The parent hands out the jobs, waits for the workers
+   and quits; only the workers return.  */
+static void render_spawn_workers(void)
+{
+    int workers = 0;
+    int status;
+    int i;
+    double total = 0.0;
+
+    if (render_jobs > jobs_count) {
+        render_jobs = jobs_count;
+    }
+    if (render_jobs < 2 || pipe(job_pipe) < 0) {
+        return;
+    }
+
+    /* A child gets none of our threads, only their state.  Close sound,
+       which stops the sound thread and the SID threads; each worker starts
+       its own when it opens sound again.  */
+    sound_close();
+
+    /* don't let the workers flush our buffered output again */
+    fflush(NULL);
+
+    for (i = 0; i < render_jobs; i++) {
+        pid_t pid = fork();
+
+        if (pid == 0) {
+            close(job_pipe[1]);
+            job_pipe[1] = -1;
+            /* list errors are reported by the parent */
+            failed = 0;
+            return;
+        }
+        if (pid < 0) {
+            log_error(render_log, "fork() failed: %s.", strerror(errno));
+            break;
+        }
+        workers++;
+    }
+    close(job_pipe[0]);
+    job_pipe[0] = -1;
+
+    if (workers == 0) {
+        /* render in this process after all */
+        close(job_pipe[1]);
+        job_pipe[1] = -1;
+        return;
+    }
+    log_message(render_log, "Started %d workers.", workers);
+
+    for (i = 0; i < jobs_count; i++) {
+        if (write(job_pipe[1], &i, sizeof i) != sizeof i) {
+            log_error(render_log, "Cannot hand out job: %s.", strerror(errno));
+            break;
+        }
+        total += jobs[i].seconds;
+    }
+    close(job_pipe[1]);
+
+    /* the workers log their own failures, only count them here */
+    while (workers > 0 && wait(&status) > 0) {
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+            failed++;
+        }
+        workers--;
+    }
+    render_report("handed to the workers", jobs_count, total);
+    exit(failed ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+#endif
+
+static render_job_t *render_next_job(void)
+{
+#ifdef RENDER_USE_FORK
+    if (job_pipe[0] >= 0) {
+        int i;
+
+        if (read(job_pipe[0], &i, sizeof i) != sizeof i || i < 0 || i >= jobs_count) {
+            return NULL;
+        }
+        return &jobs[i];
+    }
+#endif
+    return jobs_next < jobs_count ? &jobs[jobs_next++] : NULL;
+}
+
+static char *render_output_name(const render_job_t *job)
+{
+    char *name;
+    char *ext;
+    char *file;
+    char *path;
+
+    util_fname_split(job->path, NULL, &name);
+    ext = strrchr(name, '.');
+    if (ext != NULL && ext != name) {
+        *ext = '\0';
+    }
+    file = lib_msprintf("%s-%02d.%s", name, job->tune, render_format);
+    path = archdep_join_paths(render_dir, file, NULL);
+    lib_free(file);
+    lib_free(name);
+    return path;
+}
+
+static int render_start(render_job_t *job)
+{
+    char *out;
+
+    if (machine_autodetect_psid(job->path) < 0) {
+        log_error(render_log, "`%s' is not a valid PSID file.", job->path);
+        return -1;
+    }
+    psid_init_driver();
+    machine_play_psid(job->tune);
+
+    out = render_output_name(job);
+    log_message(render_log, "Rendering %s tune %d (%d s) to %s.",
+                job->path, job->tune, job->seconds, out);
+    resources_set_string("SoundRecordDeviceArg", out);
+    resources_set_string("SoundRecordDeviceName", render_format);
+    lib_free(out);
+
+    machine_trigger_reset(MACHINE_RESET_MODE_SOFT);
+
+    current = job;
+    current_cycles = 0;
+    current_cycles_end = (CLOCK)job->seconds * (CLOCK)machine_get_cycles_per_second();
+    return 0;
+}
+
+/* Called from the VSID vsync hook once per frame.  Tunes are switched on
+   frame boundaries, so the sound code closes the previous recording and
+   opens the next one at its next flush.  */
+void vsid_render_vsync(void)
+{
+    render_job_t *job;
+
+    switch (render_state) {
+        case RENDER_IDLE:
+            return;
+
+        case RENDER_INIT:
+            render_log = log_open("Render");
+            start_time = vsyncarch_gettime();
+            if (render_format == NULL) {
+                render_format = lib_stralloc("wav");
+            }
+            if (render_dir == NULL) {
+                render_dir = lib_stralloc(".");
+            }
+            ioutil_mkdir(render_dir, 0755);
+
+            resources_set_int("Sound", 1);
+            resources_set_string("SoundDeviceName", "dummy");
+            resources_set_int("WarpMode", 1);
+
+            if (render_read_list() < 0) {
+                log_error(render_log, "Nothing to render.");
+                exit(EXIT_FAILURE);
+            }
+#ifdef RENDER_USE_FORK
+            render_spawn_workers();
+#else
+            if (render_jobs > 1) {
+                log_warning(render_log, "Parallel rendering is not supported on this platform.");
+            }
+#endif
+            render_state = RENDER_NEXT;
+            /* fall through */
+
+        case RENDER_NEXT:
+            while ((job = render_next_job()) != NULL) {
+                if (render_start(job) == 0) {
+                    render_state = RENDER_RUN;
+                    return;
+                }
+                failed++;
+            }
+            render_state = RENDER_DONE;
+            return;
+
+        case RENDER_RUN:
+            if (current_cycles == 0 && !sound_is_recording()) {
+                log_error(render_log, "Cannot record with `%s'.", render_format);
+                failed++;
+                render_state = RENDER_NEXT;
+                return;
+            }
+            current_cycles += (CLOCK)machine_get_cycles_per_frame();
+            if (current_cycles >= current_cycles_end) {
+                sound_stop_recording();
+                rendered++;
+                rendered_seconds += current->seconds;
+                render_state = RENDER_NEXT;
+            }
+            return;
+
+        case RENDER_DONE:
+            /* the last recording has been closed by now */
+            render_report("rendered", rendered, rendered_seconds);
+            exit(failed ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
+}
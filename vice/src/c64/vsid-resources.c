@@ -55,6 +55,9 @@
 #include "c64fastiec.h"
 #include "hvsc.h"
 #include "archdep.h"
+#include "archdep_join_paths.h"
+#include "archdep_user_config_path.h"
+#include "ioutil.h"
 
 /* force  commit */
 
@@ -173,6 +176,7 @@ static int set_sync_factor(int val, void *param)
 
 static int set_hvsc_root(const char *path, void *param)
 {
+    static char *index_dir = NULL;
     char *result;
 
     /* expand ~, no effect on Windows */
@@ -184,6 +188,13 @@ static int set_hvsc_root(const char *path, void *param)
     hvsc_exit();
     hvsc_init(result);
     lib_free(result);
+
+    /* keep the Songlengths/STIL lookup indexes with the user config */
+    if (index_dir == NULL) {
+        index_dir = archdep_join_paths(archdep_user_config_path(), "hvsc-index", NULL);
+        ioutil_mkdir(index_dir, 0755);
+    }
+    hvsc_set_index_path(index_dir);
     return 0;
 }
 
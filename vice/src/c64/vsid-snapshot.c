@@ -54,11 +54,16 @@
 #define SNAP_MAJOR 1
 #define SNAP_MINOR 1
 
-int c64_snapshot_write(const char *name, int save_roms, int save_disks, int event_mode)
+static int c64_snapshot_write_internal(const char *name, snapshot_stream_t *stream,
+                                       int save_roms, int save_disks, int event_mode)
 {
     snapshot_t *s;
 
-    s = snapshot_create(name, ((uint8_t)(SNAP_MAJOR)), ((uint8_t)(SNAP_MINOR)), machine_get_name());
+    if (stream != NULL) {
+        s = snapshot_create_stream(stream, ((uint8_t)(SNAP_MAJOR)), ((uint8_t)(SNAP_MINOR)), machine_get_name());
+    } else {
+        s = snapshot_create(name, ((uint8_t)(SNAP_MAJOR)), ((uint8_t)(SNAP_MINOR)), machine_get_name());
+    }
     if (s == NULL) {
         return -1;
     }
@@ -78,7 +83,9 @@ int c64_snapshot_write(const char *name, int save_roms, int save_disks, int even
         || event_snapshot_write_module(s, event_mode) < 0
         || keyboard_snapshot_write_module(s)) {
         snapshot_close(s);
-        ioutil_remove(name);
+        if (name != NULL) {
+            ioutil_remove(name);
+        }
         return -1;
     }
 
@@ -86,12 +93,17 @@ int c64_snapshot_write(const char *name, int save_roms, int save_disks, int even
     return 0;
 }
 
-int c64_snapshot_read(const char *name, int event_mode)
+static int c64_snapshot_read_internal(const char *name, snapshot_stream_t *stream,
+                                      int event_mode)
 {
     snapshot_t *s;
     uint8_t minor, major;
 
-    s = snapshot_open(name, &major, &minor, machine_get_name());
+    if (stream != NULL) {
+        s = snapshot_open_stream(stream, &major, &minor, machine_get_name());
+    } else {
+        s = snapshot_open(name, &major, &minor, machine_get_name());
+    }
     if (s == NULL) {
         return -1;
     }
@@ -131,3 +143,23 @@ fail:
 
     return -1;
 }
+
+int c64_snapshot_write(const char *name, int save_roms, int save_disks, int event_mode)
+{
+    return c64_snapshot_write_internal(name, NULL, save_roms, save_disks, event_mode);
+}
+
+int c64_snapshot_write_stream(snapshot_stream_t *stream, int save_roms, int save_disks, int event_mode)
+{
+    return c64_snapshot_write_internal(NULL, stream, save_roms, save_disks, event_mode);
+}
+
+int c64_snapshot_read(const char *name, int event_mode)
+{
+    return c64_snapshot_read_internal(name, NULL, event_mode);
+}
+
+int c64_snapshot_read_stream(snapshot_stream_t *stream, int event_mode)
+{
+    return c64_snapshot_read_internal(NULL, stream, event_mode);
+}
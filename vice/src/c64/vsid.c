@@ -66,6 +66,7 @@
 #include "vicii-mem.h"
 #include "video.h"
 #include "vsid-cmdline-options.h"
+#include "vsid-render.h"
 #include "vsidui.h"
 #include "vsid-debugcart.h"
 #include "vsync.h"
@@ -151,6 +152,10 @@ int machine_cmdline_options_init(void)
         init_cmdline_options_fail("psid");
         return -1;
     }
+    if (vsid_render_cmdline_options_init() < 0) {
+        init_cmdline_options_fail("render");
+        return -1;
+    }
     if (debugcart_cmdline_options_init() < 0) {
         init_cmdline_options_fail("debug cart");
         return -1;
@@ -313,6 +318,8 @@ static void machine_vsync_hook(void)
         time = playtime;
     }
     clk_guard_prevent_overflow(maincpu_clk_guard);
+
+    vsid_render_vsync();
 }
 
 void machine_set_restore_key(int v)
@@ -408,6 +415,16 @@ int machine_read_snapshot(const char *name, int event_mode)
     return c64_snapshot_read(name, event_mode);
 }
 
+int machine_write_snapshot_stream(struct snapshot_stream_s *stream, int save_roms, int save_disks, int event_mode)
+{
+    return c64_snapshot_write_stream(stream, save_roms, save_disks, event_mode);
+}
+
+int machine_read_snapshot_stream(struct snapshot_stream_s *stream, int event_mode)
+{
+    return c64_snapshot_read_stream(stream, event_mode);
+}
+
 /* ------------------------------------------------------------------------- */
 
 int machine_autodetect_psid(const char *name)
@@ -880,6 +880,16 @@ int machine_read_snapshot(const char *name, int event_mode)
     return c64dtv_snapshot_read(name, event_mode);
 }
 
+int machine_write_snapshot_stream(struct snapshot_stream_s *stream, int save_roms, int save_disks, int event_mode)
+{
+    return c64dtv_snapshot_write_stream(stream, save_roms, save_disks, event_mode);
+}
+
+int machine_read_snapshot_stream(struct snapshot_stream_s *stream, int event_mode)
+{
+    return c64dtv_snapshot_read_stream(stream, event_mode);
+}
+
 /* ------------------------------------------------------------------------- */
 
 int machine_screenshot(screenshot_t *screenshot, struct video_canvas_s *canvas)
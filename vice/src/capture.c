@@ -0,0 +1,194 @@
+/*
+ * capture.c - Headless, unthrottled movie capture.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* `-capture' runs the emulator without a user interface (like `-console')
+   and records every frame plus the sound to a movie file.  The raster code
+   keeps drawing into its offscreen frame buffer, which is what the movie
+   drivers read in the normal, windowed case too, so each frame comes out
+   the same as a real time recording.  Vsync does not sleep and does not
+   skip frames while capturing, and sound goes to the dummy device, so the
+   emulation runs as fast as the host allows.  After `-captureframes'
+   frames the movie is closed and the emulator quits.  */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "capture.h"
+#include "cmdline.h"
+#include "lib.h"
+#include "log.h"
+#include "machine-video.h"
+#include "resources.h"
+#include "screenshot.h"
+#include "util.h"
+#include "vsync.h"
+#include "vsyncapi.h"
+
+/** \brief  Capture state, advanced once per frame
+ */
+enum {
+    CAPTURE_IDLE,   /**< not capturing */
+    CAPTURE_INIT,   /**< open the movie on the next frame */
+    CAPTURE_RUN     /**< recording */
+};
+
+static log_t capture_log = LOG_ERR;
+
+static char *capture_file = NULL;
+static char *capture_driver = NULL;
+static int capture_frames = 0;
+
+static int capture_state = CAPTURE_IDLE;
+
+static int captured = 0;
+static unsigned long start_time;
+
+/* ------------------------------------------------------------------------- */
+
+static int cmdline_capture(const char *param, void *extra_param)
+{
+    util_string_set(&capture_file, param);
+    capture_state = CAPTURE_INIT;
+    return 0;
+}
+
+static int cmdline_capture_driver(const char *param, void *extra_param)
+{
+    util_string_set(&capture_driver, param);
+    return 0;
+}
+
+static int cmdline_capture_frames(const char *param, void *extra_param)
+{
+    capture_frames = atoi(param);
+    if (capture_frames < 0) {
+        return -1;
+    }
+    return 0;
+}
+
+static const cmdline_option_t cmdline_options[] =
+{
+    { "-capture", CALL_FUNCTION, CMDLINE_ATTRIB_NEED_ARGS,
+      cmdline_capture, NULL, NULL, NULL,
+      "<Name>", "Record every frame and the sound to movie file <Name> as fast as possible, without user interface" },
+    { "-capturedriver", CALL_FUNCTION, CMDLINE_ATTRIB_NEED_ARGS,
+      cmdline_capture_driver, NULL, NULL, NULL,
+      "<Name>", "Movie driver to capture with (default: FFMPEG)" },
+    { "-captureframes", CALL_FUNCTION, CMDLINE_ATTRIB_NEED_ARGS,
+      cmdline_capture_frames, NULL, NULL, NULL,
+      "<value>", "Number of frames to capture before quitting (0: until the emulator quits)" },
+    CMDLINE_LIST_END
+};
+
+int capture_cmdline_options_init(void)
+{
+    return cmdline_register_options(cmdline_options);
+}
+
+/* ------------------------------------------------------------------------- */
+
+int capture_enabled(void)
+{
+    return capture_state != CAPTURE_IDLE;
+}
+
+static void capture_report(void)
+{
+    double wall = (double)(vsyncarch_gettime() - start_time) / vsyncarch_frequency();
+    double emulated = captured / vsync_get_refresh_frequency();
+
+    log_message(capture_log,
+                "%d frames (%.1f s) captured in %.1f s (%.1f frames per second).",
+                captured, emulated, wall, wall > 0.0 ? captured / wall : 0.0);
+}
+
+static int capture_start(void)
+{
+    capture_log = log_open("Capture");
+    if (capture_driver == NULL) {
+        capture_driver = lib_stralloc("FFMPEG");
+    }
+
+    /* never block on a real sound device */
+    resources_set_int("Sound", 1);
+    resources_set_string("SoundDeviceName", "dummy");
+
+    log_message(capture_log, "Capturing %s with %s.", capture_file, capture_driver);
+    if (screenshot_save(capture_driver, capture_file, machine_video_canvas_get(0)) < 0
+        || !screenshot_is_recording()) {
+        log_error(capture_log, "Cannot record `%s' with `%s'.", capture_file, capture_driver);
+        return -1;
+    }
+    start_time = vsyncarch_gettime();
+    return 0;
+}
+
+/* Called from vsync_do_vsync() once per frame.  The movie is opened on the
+   first frame, when the canvas exists; from then on each call accounts for
+   the frame the machine vsync hook has just recorded.  */
+void capture_vsync(void)
+{
+    switch (capture_state) {
+        case CAPTURE_IDLE:
+            return;
+
+        case CAPTURE_INIT:
+            if (capture_start() < 0) {
+                exit(EXIT_FAILURE);
+            }
+            capture_state = CAPTURE_RUN;
+            return;
+
+        case CAPTURE_RUN:
+            if (!screenshot_is_recording()) {
+                log_error(capture_log, "Recording stopped after %d frames.", captured);
+                exit(EXIT_FAILURE);
+            }
+            captured++;
+            if (capture_frames > 0 && captured >= capture_frames) {
+                screenshot_stop_recording();
+                capture_report();
+                exit(EXIT_SUCCESS);
+            }
+            return;
+    }
+}
+
+/* Close the movie properly when the emulator quits some other way, e.g.
+   through `-limitcycles'.  */
+void capture_shutdown(void)
+{
+    if (capture_state == CAPTURE_RUN && screenshot_is_recording()) {
+        screenshot_stop_recording();
+        capture_report();
+    }
+    capture_state = CAPTURE_IDLE;
+
+    lib_free(capture_file);
+    capture_file = NULL;
+    lib_free(capture_driver);
+    capture_driver = NULL;
+}
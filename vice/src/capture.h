@@ -0,0 +1,38 @@
+/*
+ * capture.h - Headless, unthrottled movie capture.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_CAPTURE_H
+#define VICE_CAPTURE_H
+
+extern int capture_cmdline_options_init(void);
+extern void capture_shutdown(void);
+
+/* Nonzero if a capture was requested on the command line.  While capturing,
+   vsync neither paces nor skips frames.  */
+extern int capture_enabled(void);
+
+/* Called once per emulated frame, after the machine vsync hook has handed
+   the finished frame to the recording driver.  */
+extern void capture_vsync(void);
+
+#endif
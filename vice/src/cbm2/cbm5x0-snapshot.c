@@ -56,12 +56,16 @@
 #define SNAP_MAJOR          0
 #define SNAP_MINOR          0
 
-int cbm2_snapshot_write(const char *name, int save_roms, int save_disks,
-                        int event_mode)
+static int cbm2_snapshot_write_internal(const char *name, snapshot_stream_t *stream,
+                                        int save_roms, int save_disks, int event_mode)
 {
     snapshot_t *s;
 
-    s = snapshot_create(name, SNAP_MAJOR, SNAP_MINOR, machine_get_name());
+    if (stream != NULL) {
+        s = snapshot_create_stream(stream, SNAP_MAJOR, SNAP_MINOR, machine_get_name());
+    } else {
+        s = snapshot_create(name, SNAP_MAJOR, SNAP_MINOR, machine_get_name());
+    }
 
     if (s == NULL) {
         return -1;
@@ -85,7 +89,9 @@ int cbm2_snapshot_write(const char *name, int save_roms, int save_disks,
         || joyport_snapshot_write_module(s, JOYPORT_1) < 0
         || joyport_snapshot_write_module(s, JOYPORT_2) < 0) {
         snapshot_close(s);
-        ioutil_remove(name);
+        if (name != NULL) {
+            ioutil_remove(name);
+        }
         return -1;
     }
 
@@ -93,12 +99,17 @@ int cbm2_snapshot_write(const char *name, int save_roms, int save_disks,
     return 0;
 }
 
-int cbm2_snapshot_read(const char *name, int event_mode)
+static int cbm2_snapshot_read_internal(const char *name, snapshot_stream_t *stream,
+                                       int event_mode)
 {
     snapshot_t *s;
     uint8_t minor, major;
 
-    s = snapshot_open(name, &major, &minor, machine_get_name());
+    if (stream != NULL) {
+        s = snapshot_open_stream(stream, &major, &minor, machine_get_name());
+    } else {
+        s = snapshot_open(name, &major, &minor, machine_get_name());
+    }
 
     if (s == NULL) {
         return -1;
@@ -132,6 +143,8 @@ int cbm2_snapshot_read(const char *name, int event_mode)
         goto fail;
     }
 
+    snapshot_close(s);
+
     sound_snapshot_finish();
 
     return 0;
@@ -145,3 +158,23 @@ fail:
 
     return -1;
 }
+
+int cbm2_snapshot_write(const char *name, int save_roms, int save_disks, int event_mode)
+{
+    return cbm2_snapshot_write_internal(name, NULL, save_roms, save_disks, event_mode);
+}
+
+int cbm2_snapshot_write_stream(snapshot_stream_t *stream, int save_roms, int save_disks, int event_mode)
+{
+    return cbm2_snapshot_write_internal(NULL, stream, save_roms, save_disks, event_mode);
+}
+
+int cbm2_snapshot_read(const char *name, int event_mode)
+{
+    return cbm2_snapshot_read_internal(name, NULL, event_mode);
+}
+
+int cbm2_snapshot_read_stream(snapshot_stream_t *stream, int event_mode)
+{
+    return cbm2_snapshot_read_internal(NULL, stream, event_mode);
+}
@@ -181,6 +181,7 @@ crtc_t crtc = {
         NULL,
         NULL,
         NULL,
+        NULL,
         0
     },
 
@@ -1065,6 +1065,7 @@ inline static void bit_write(void)
         current_image->cycle_counter_total = current_image->cycle_counter;
     }
     current_image->has_changed = 1;
+    tap_buffer_invalidate(current_image);
     datasette_update_ui_counter();
 }
 
@@ -107,6 +107,7 @@ extern void disk_image_resources_shutdown(void);
 extern void disk_image_fsimage_name_set(disk_image_t *image, const char *name);
 extern const char *disk_image_fsimage_name_get(const disk_image_t *image);
 extern void *disk_image_fsimage_fd_get(const disk_image_t *image);
+extern void disk_image_fsimage_fd_set(disk_image_t *image, void *fd);
 extern int disk_image_fsimage_create(const char *name, unsigned int type);
 
 extern void disk_image_rawimage_name_set(disk_image_t *image, const char *name);
@@ -123,6 +124,7 @@ extern void disk_image_media_destroy(disk_image_t *image);
 
 extern int disk_image_open(disk_image_t *image);
 extern int disk_image_close(disk_image_t *image);
+extern int disk_image_flush(disk_image_t *image, int force);
 
 extern int disk_image_read_sector(const disk_image_t *image, uint8_t *buf,
                                   const disk_addr_t *dadr);
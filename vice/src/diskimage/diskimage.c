@@ -413,6 +413,17 @@ void *disk_image_fsimage_fd_get(const disk_image_t *image)
 }
 
 
+/** \brief  Read \a image from the already open stream \a fd
+ *
+ * \param[in,out]   image   disk image
+ * \param[in]       fd      stream, see fsimage_fd_set()
+ */
+void disk_image_fsimage_fd_set(disk_image_t *image, void *fd)
+{
+    fsimage_fd_set(image, fd);
+}
+
+
 int disk_image_fsimage_create(const char *name, unsigned int type)
 {
     return fsimage_create(name, type);
@@ -584,6 +595,16 @@ int disk_image_close(disk_image_t *image)
     return rc;
 }
 
+/* Write back sectors that are only in memory.  Unless `force' is set only
+   once they are due, so this is cheap enough to call every frame.  */
+int disk_image_flush(disk_image_t *image, int force)
+{
+    if (image == NULL || image->device != DISK_IMAGE_DEVICE_FS) {
+        return 0;
+    }
+    return fsimage_flush(image, force);
+}
+
 /*-----------------------------------------------------------------------*/
 
 int disk_image_read_sector(const disk_image_t *image, uint8_t *buf, const disk_addr_t *dadr)
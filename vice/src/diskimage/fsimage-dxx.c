@@ -28,6 +28,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 #include "diskconstants.h"
 #include "diskimage.h"
@@ -43,6 +44,171 @@
 
 static log_t fsimage_dxx_log = LOG_ERR;
 
+/* Sector cache.
+
+   vdrive and c1541 access the image one sector at a time, which used to
+   cost a seek, a read or write and a flush per sector.  Now a sector is
+   read from the file only once; writes update the copy in memory and mark
+   it dirty.  Dirty sectors go back to the file in runs of consecutive
+   sectors: when the image is closed, before raw tracks are read from or
+   written to the file, when too many have piled up, and from
+   fsimage_flush() once the oldest unsaved write is a second old.  */
+
+#define CACHE_VALID 0x01
+#define CACHE_DIRTY 0x02
+
+/* Dirty sectors that force a write-back.  */
+#define CACHE_DIRTY_MAX 256
+
+/* Seconds a write may stay in memory only.  */
+#define CACHE_DELAY 1
+
+static long sector_offset(const disk_image_t *image, int sectors)
+{
+    long offset = sectors * 256;
+
+    if (image->type == DISK_IMAGE_TYPE_X64) {
+        offset += X64_HEADER_LENGTH;
+    }
+    return offset;
+}
+
+/* Make room for sector number `sectors'.  */
+static void cache_grow(fsimage_t *fsimage, int sectors)
+{
+    int len;
+
+    if (sectors < fsimage->cache.len) {
+        return;
+    }
+    len = (sectors + 256) & ~255;
+    fsimage->cache.data = lib_realloc(fsimage->cache.data, len * 256);
+    fsimage->cache.flags = lib_realloc(fsimage->cache.flags, len);
+    memset(fsimage->cache.flags + fsimage->cache.len, 0, len - fsimage->cache.len);
+    fsimage->cache.len = len;
+}
+
+static int cache_read(const disk_image_t *image, uint8_t *buf, int sectors)
+{
+    fsimage_t *fsimage = image->media.fsimage;
+    uint8_t *data;
+
+    cache_grow(fsimage, sectors);
+    data = fsimage->cache.data + sectors * 256;
+
+    if (!(fsimage->cache.flags[sectors] & CACHE_VALID)) {
+        if (util_fpread(fsimage->fd, data, 256, sector_offset(image, sectors)) < 0) {
+            return -1;
+        }
+        fsimage->cache.flags[sectors] = CACHE_VALID;
+    }
+    memcpy(buf, data, 256);
+    return 0;
+}
+
+static int cache_write(const disk_image_t *image, const uint8_t *buf, int sectors)
+{
+    fsimage_t *fsimage = image->media.fsimage;
+
+    cache_grow(fsimage, sectors);
+    memcpy(fsimage->cache.data + sectors * 256, buf, 256);
+
+    if (!(fsimage->cache.flags[sectors] & CACHE_DIRTY)) {
+        if (fsimage->cache.dirty++ == 0) {
+            fsimage->cache.since = time(NULL);
+        }
+    }
+    fsimage->cache.flags[sectors] = CACHE_VALID | CACHE_DIRTY;
+
+    if (fsimage->cache.dirty >= CACHE_DIRTY_MAX) {
+        return fsimage_dxx_flush(image, 1);
+    }
+    return 0;
+}
+
+/* Update cached sectors after `count' sectors from `sectors' on have been
+   written to the file directly.  */
+static void cache_update(const disk_image_t *image, const uint8_t *buf, int sectors, int count)
+{
+    fsimage_t *fsimage = image->media.fsimage;
+    int i;
+
+    for (i = sectors; i < sectors + count && i < fsimage->cache.len; i++) {
+        if (fsimage->cache.flags[i] & CACHE_DIRTY) {
+            fsimage->cache.dirty--;
+        }
+        if (fsimage->cache.flags[i] & CACHE_VALID) {
+            memcpy(fsimage->cache.data + i * 256, buf + (i - sectors) * 256, 256);
+            fsimage->cache.flags[i] = CACHE_VALID;
+        }
+    }
+}
+
+/* Write dirty sectors back to the file.  Unless `force' is set only if the
+   oldest of them has waited long enough.  */
+int fsimage_dxx_flush(const disk_image_t *image, int force)
+{
+    fsimage_t *fsimage = image->media.fsimage;
+    uint8_t *flags = fsimage->cache.flags;
+    int first, last, res = 0;
+
+    if (fsimage->cache.dirty == 0 && !fsimage->error_info.dirty) {
+        return 0;
+    }
+    if (!force && time(NULL) - fsimage->cache.since < CACHE_DELAY) {
+        return 0;
+    }
+
+    for (first = 0; first < fsimage->cache.len; first = last) {
+        last = first + 1;
+        if (!(flags[first] & CACHE_DIRTY)) {
+            continue;
+        }
+        flags[first] &= ~CACHE_DIRTY;
+        while (last < fsimage->cache.len && (flags[last] & CACHE_DIRTY)) {
+            flags[last++] &= ~CACHE_DIRTY;
+        }
+        if (util_fpwrite(fsimage->fd, fsimage->cache.data + first * 256,
+                         (last - first) * 256, sector_offset(image, first)) < 0) {
+            log_error(fsimage_dxx_log, "Error writing %i sectors to disk image.",
+                      last - first);
+            res = -1;
+        }
+    }
+    fsimage->cache.dirty = 0;
+
+    /* Error info after the sectors it belongs to.  */
+    if (fsimage->error_info.map != NULL && fsimage->error_info.dirty) {
+        long offset = fsimage->error_info.len * 256;
+
+        if (image->type == DISK_IMAGE_TYPE_X64) {
+            offset += X64_HEADER_LENGTH;
+        }
+        if (util_fpwrite(fsimage->fd, fsimage->error_info.map,
+                         fsimage->error_info.len, offset) < 0) {
+            log_error(fsimage_dxx_log, "Error writing error info to disk image.");
+            res = -1;
+        }
+    }
+    fsimage->error_info.dirty = 0;
+
+    /* Make sure the stream is visible to other readers.  */
+    fflush(fsimage->fd);
+    return res;
+}
+
+void fsimage_dxx_cache_free(const disk_image_t *image)
+{
+    fsimage_t *fsimage = image->media.fsimage;
+
+    lib_free(fsimage->cache.data);
+    lib_free(fsimage->cache.flags);
+    fsimage->cache.data = NULL;
+    fsimage->cache.flags = NULL;
+    fsimage->cache.len = 0;
+    fsimage->cache.dirty = 0;
+}
+
 int fsimage_dxx_write_half_track(disk_image_t *image, unsigned int half_track,
                                  const disk_track_t *raw)
 {
@@ -53,6 +219,10 @@ int fsimage_dxx_write_half_track(disk_image_t *image, unsigned int half_track,
     fsimage_t *fsimage = image->media.fsimage;
     fdc_err_t rf;
 
+    /* Write pending sectors and error info first, only this track's error
+       info is written below.  */
+    fsimage_dxx_flush(image, 1);
+
     track = half_track / 2;
 
     max_sector = disk_image_sector_per_track(image->type, track);
@@ -112,6 +282,7 @@ int fsimage_dxx_write_half_track(disk_image_t *image, unsigned int half_track,
         lib_free(buffer);
         return -1;
     }
+    cache_update(image, buffer, sectors, max_sector);
     lib_free(buffer);
     if (fsimage->error_info.map) {
         if (fsimage->error_info.dirty) {
@@ -157,6 +328,8 @@ int fsimage_read_dxx_image(const disk_image_t *image)
     int sectors;
     long offset;
 
+    fsimage_dxx_flush(image, 1);
+
     if (image->type == DISK_IMAGE_TYPE_D80
         || image->type == DISK_IMAGE_TYPE_D82) {
         sectors = disk_image_check_sector(image, BAM_TRACK_8050, BAM_SECTOR_8050);
@@ -247,7 +420,6 @@ int fsimage_read_dxx_image(const disk_image_t *image)
 int fsimage_dxx_read_sector(const disk_image_t *image, uint8_t *buf, const disk_addr_t *dadr)
 {
     int sectors;
-    long offset;
     fsimage_t *fsimage = image->media.fsimage;
     fdc_err_t rf;
 
@@ -259,14 +431,8 @@ int fsimage_dxx_read_sector(const disk_image_t *image, uint8_t *buf, const disk_
         return -1;
     }
 
-    offset = sectors * 256;
-
-    if (image->type == DISK_IMAGE_TYPE_X64) {
-        offset += X64_HEADER_LENGTH;
-    }
-
     if (image->gcr == NULL) {
-        if (util_fpread(fsimage->fd, buf, 256, offset) < 0) {
+        if (cache_read(image, buf, sectors) < 0) {
             log_error(fsimage_dxx_log,
                       "Error reading T:%i S:%i from disk image.",
                       dadr->track, dadr->sector);
@@ -311,7 +477,6 @@ int fsimage_dxx_read_sector(const disk_image_t *image, uint8_t *buf, const disk_
 int fsimage_dxx_write_sector(disk_image_t *image, const uint8_t *buf, const disk_addr_t *dadr)
 {
     int sectors;
-    long offset;
     fsimage_t *fsimage;
 
     fsimage = image->media.fsimage;
@@ -323,13 +488,8 @@ int fsimage_dxx_write_sector(disk_image_t *image, const uint8_t *buf, const disk
                   dadr->track, dadr->sector);
         return -1;
     }
-    offset = sectors * 256;
-
-    if (image->type == DISK_IMAGE_TYPE_X64) {
-        offset += X64_HEADER_LENGTH;
-    }
 
-    if (util_fpwrite(fsimage->fd, buf, 256, offset) < 0) {
+    if (cache_write(image, buf, sectors) < 0) {
         log_error(fsimage_dxx_log, "Error writing T:%i S:%i to disk image.",
                   dadr->track, dadr->sector);
         return -1;
@@ -338,23 +498,13 @@ int fsimage_dxx_write_sector(disk_image_t *image, const uint8_t *buf, const disk
         gcr_write_sector(&image->gcr->tracks[(dadr->track * 2) - 2], buf, (uint8_t)dadr->sector);
     }
 
+    /* Written back with the sector, see fsimage_dxx_flush().  */
     if ((fsimage->error_info.map != NULL)
         && (fsimage->error_info.map[sectors] != CBMDOS_FDC_ERR_OK)) {
-        offset = fsimage->error_info.len * 256 + sectors;
-
-        if (image->type == DISK_IMAGE_TYPE_X64) {
-            offset += X64_HEADER_LENGTH;
-        }
-
         fsimage->error_info.map[sectors] = CBMDOS_FDC_ERR_OK;
-        if (util_fpwrite(fsimage->fd, &fsimage->error_info.map[sectors], 1, offset) < 0) {
-            log_error(fsimage_dxx_log, "Error writing T:%i S:%i error info to disk image.",
-                      dadr->track, dadr->sector);
-        }
+        fsimage->error_info.dirty = 1;
     }
 
-    /* Make sure the stream is visible to other readers.  */
-    fflush(fsimage->fd);
     return 0;
 }
 
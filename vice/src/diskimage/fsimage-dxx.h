@@ -43,5 +43,7 @@ extern int fsimage_dxx_read_sector(const struct disk_image_s *image, uint8_t *bu
                                    const struct disk_addr_s *dadr);
 extern int fsimage_dxx_write_sector(struct disk_image_s *image, const uint8_t *buf,
                                     const struct disk_addr_s *dadr);
+extern int fsimage_dxx_flush(const struct disk_image_s *image, int force);
+extern void fsimage_dxx_cache_free(const struct disk_image_s *image);
 
 #endif
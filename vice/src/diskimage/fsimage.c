@@ -96,6 +96,25 @@ void *fsimage_fd_get(const disk_image_t *image)
     return (void *)(fsimage->fd);
 }
 
+
+/** \brief  Use an already open stream for \a image
+ *
+ * fsimage_open() then reads the image from \a fd instead of opening the file
+ * by name, and fsimage_close() closes \a fd.  The name is still used to
+ * guess the image type.
+ *
+ * \param[in,out]   image   disk image
+ * \param[in]       fd      stream with the image contents
+ */
+void fsimage_fd_set(disk_image_t *image, void *fd)
+{
+    fsimage_t *fsimage;
+
+    fsimage = image->media.fsimage;
+
+    fsimage->fd = (FILE *)fd;
+}
+
 /*-----------------------------------------------------------------------*/
 
 void fsimage_media_create(disk_image_t *image)
@@ -129,7 +148,9 @@ int fsimage_open(disk_image_t *image)
     fsimage = image->media.fsimage;
     fsimage->error_info.map = NULL;
 
-    if (image->read_only) {
+    if (fsimage->fd != NULL) {
+        /* stream set with fsimage_fd_set() */
+    } else if (image->read_only) {
         fsimage->fd = zfile_fopen(fsimage->name, MODE_READ);
     } else {
         fsimage->fd = zfile_fopen(fsimage->name, MODE_READ_WRITE);
@@ -170,6 +191,9 @@ int fsimage_close(disk_image_t *image)
         fsimage_write_p64_image(image);
     }*/
 
+    fsimage_dxx_flush(image, 1);
+    fsimage_dxx_cache_free(image);
+
     if (fsimage->error_info.map) {
         lib_free(fsimage->error_info.map);
         fsimage->error_info.map = NULL;
@@ -180,6 +204,15 @@ int fsimage_close(disk_image_t *image)
     return 0;
 }
 
+/* Write back cached sectors, see fsimage_dxx_flush().  */
+int fsimage_flush(disk_image_t *image, int force)
+{
+    if (image->media.fsimage->fd == NULL) {
+        return 0;
+    }
+    return fsimage_dxx_flush(image, force);
+}
+
 /*-----------------------------------------------------------------------*/
 
 int fsimage_read_sector(const disk_image_t *image, uint8_t *buf, const disk_addr_t *dadr)
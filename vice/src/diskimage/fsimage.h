@@ -28,6 +28,7 @@
 #define VICE_FSIMAGE_H
 
 #include <stdio.h>
+#include <time.h>
 
 #include "types.h"
 
@@ -42,6 +43,14 @@ typedef struct fsimage_s {
         int dirty;
         int len;
     } error_info;
+    /* Sector cache of D64 style images, see fsimage-dxx.c.  */
+    struct {
+        uint8_t *data;
+        uint8_t *flags;
+        int len;
+        int dirty;
+        time_t since;
+    } cache;
 } fsimage_t;
 
 
@@ -50,11 +59,13 @@ extern void fsimage_init(void);
 extern void fsimage_name_set(struct disk_image_s *image, const char *name);
 extern const char *fsimage_name_get(const struct disk_image_s *image);
 extern void *fsimage_fd_get(const disk_image_t *image);
+extern void fsimage_fd_set(struct disk_image_s *image, void *fd);
 extern void fsimage_media_create(struct disk_image_s *image);
 extern void fsimage_media_destroy(struct disk_image_s *image);
 
 extern int fsimage_open(struct disk_image_s *image);
 extern int fsimage_close(struct disk_image_s *image);
+extern int fsimage_flush(struct disk_image_s *image, int force);
 extern int fsimage_read_sector(const struct disk_image_s *image, uint8_t *buf,
                                const struct disk_addr_s *dadr);
 extern int fsimage_write_sector(struct disk_image_s *image, const uint8_t *buf,
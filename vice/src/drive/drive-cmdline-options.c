@@ -53,6 +53,12 @@ static const cmdline_option_t cmdline_options[] =
     { "-drivesoundvolume", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
       NULL, NULL, "DriveSoundEmulationVolume", NULL,
       "<Volume>", "Set volume for disk drive sound emulation (0-4000)" },
+    { "-drivethreads", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "DriveThreads", (void *)1,
+      NULL, "Run emulated disk drives on separate threads" },
+    { "+drivethreads", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "DriveThreads", (void *)0,
+      NULL, "Run all emulated disk drives on the main thread" },
     CMDLINE_LIST_END
 };
 
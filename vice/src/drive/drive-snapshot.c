@@ -101,11 +101,12 @@ RotationLastClk      CLOCK  2
 RotationTablePtr     DWORD  2      pointer to the rotation table
                                    (offset to the rotation table is saved)
 Type                 DWORD  2      drive type
+WobbleRand           DWORD  2      state of the RPM wobble generator (1.5)
 
 */
 
 #define DRIVE_SNAP_MAJOR 1
-#define DRIVE_SNAP_MINOR 4
+#define DRIVE_SNAP_MINOR 5
 
 int drive_snapshot_write_module(snapshot_t *s, int save_disks, int save_roms)
 {
@@ -232,6 +233,14 @@ int drive_snapshot_write_module(snapshot_t *s, int save_disks, int save_roms)
         }
     }
 
+    for (i = 0; i < 2; i++) {
+        drive = drive_context[i]->drive;
+        if (SMW_DW(m, drive->wobble_rand) < 0) {
+            snapshot_module_close(m);
+            return -1;
+        }
+    }
+
     if (snapshot_module_close(m) < 0) {
         return -1;
     }
@@ -547,6 +556,16 @@ int drive_snapshot_read_module(snapshot_t *s)
         SMR_B_INT(m, (int *)&(drive->byte_ready_active));
     }
 
+    if (major_version > 1 || minor_version >= 5) {
+        for (i = 0; i < 2; i++) {
+            drive = drive_context[i]->drive;
+            if (SMR_DW(m, &(drive->wobble_rand)) < 0) {
+                snapshot_module_close(m);
+                return -1;
+            }
+        }
+    }
+
     snapshot_module_close(m);
     m = NULL;
 
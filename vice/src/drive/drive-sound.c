@@ -1431,6 +1431,16 @@ static int motorvol[DRIVE_NUM];
 static int cycles_per_sec = 1000000;
 static int sample_rate = 22050;
 
+/* The drive events are passed through sound_store(), so they reach the
+   sound engine at the cycle they happen, on the sound thread if there is
+   one.  The register selects the event and the unit, the value is the half
+   track for head movements.  */
+#define DRIVE_SOUND_REG_MOTOR_ON    0x00
+#define DRIVE_SOUND_REG_MOTOR_OFF   0x04
+#define DRIVE_SOUND_REG_STEP        0x08
+#define DRIVE_SOUND_REG_STEP_BACK   0x0c
+#define DRIVE_SOUND_REG_OFF         0x10
+
 /* resources */
 extern int drive_sound_emulation;
 extern int drive_sound_emulation_volume;
@@ -1526,6 +1536,34 @@ static int drive_sound_machine_channels(void)
 
 static void drive_sound_machine_store(sound_t *psid, uint16_t addr, uint8_t val)
 {
+    int unit = addr & 3;
+
+    switch (addr & ~3) {
+        case DRIVE_SOUND_REG_MOTOR_ON:
+            motor[unit] = spinup;
+            drive_sound.chip_enabled = 1;
+            break;
+        case DRIVE_SOUND_REG_MOTOR_OFF:
+            motor[unit] = spindown;
+            drive_sound.chip_enabled = 1;
+            break;
+        case DRIVE_SOUND_REG_STEP:
+        case DRIVE_SOUND_REG_STEP_BACK:
+            stepvol[unit] = 100 - val;
+            if (val == 2 && (addr & ~3) == DRIVE_SOUND_REG_STEP_BACK) {
+                if (step[unit] == nosound) {
+                    drive_sound.chip_enabled = 1;
+                    step[unit] = bump;
+                }
+            } else {
+                step[unit] = (val < 18) ? stepping : stepping2;
+                drive_sound.chip_enabled = 1;
+            }
+            break;
+        case DRIVE_SOUND_REG_OFF:
+            drive_sound.chip_enabled = 0;
+            break;
+    }
 }
 
 static uint8_t drive_sound_machine_read(sound_t *psid, uint16_t addr)
@@ -1549,18 +1587,15 @@ static sound_chip_t drive_sound = {
 void drive_sound_update(int i, int unit)
 {
     if (!drive_sound_emulation) {
-        drive_sound.chip_enabled = 0;
+        sound_store((uint16_t)(drive_sound_offset + DRIVE_SOUND_REG_OFF), 0, 0);
         return;
     }
-    sound_store((uint16_t)drive_sound_offset, 0, 0);
     switch (i) {
         case DRIVE_SOUND_MOTOR_ON:
-            motor[unit] = spinup;
-            drive_sound.chip_enabled = 1;
+            sound_store((uint16_t)(drive_sound_offset + DRIVE_SOUND_REG_MOTOR_ON + unit), 0, 0);
             break;
         case DRIVE_SOUND_MOTOR_OFF:
-            motor[unit] = spindown;
-            drive_sound.chip_enabled = 1;
+            sound_store((uint16_t)(drive_sound_offset + DRIVE_SOUND_REG_MOTOR_OFF + unit), 0, 0);
             break;
     }
 }
@@ -1568,25 +1603,19 @@ void drive_sound_update(int i, int unit)
 void drive_sound_head(int track, int dir, int unit)
 {
     if (!drive_sound_emulation) {
-        drive_sound.chip_enabled = 0;
+        sound_store((uint16_t)(drive_sound_offset + DRIVE_SOUND_REG_OFF), 0, 0);
         return;
     }
-    sound_store((uint16_t)drive_sound_offset, 0, 0);
-    stepvol[unit] = 100 - track;
-    if (track == 2 && dir == -1) {
-        if (step[unit] == nosound) {
-            drive_sound.chip_enabled = 1;
-            step[unit] = bump;
-        }
-    } else {
-        step[unit] = (track < 18) ? stepping : stepping2;
-        drive_sound.chip_enabled = 1;
-    }
+    sound_store((uint16_t)(drive_sound_offset
+                           + ((dir == -1) ? DRIVE_SOUND_REG_STEP_BACK : DRIVE_SOUND_REG_STEP)
+                           + unit), (uint8_t)track, 0);
 }
 
 void drive_sound_stop(void)
 {
     int i;
+
+    sound_sync();
     for (i = 0; i < DRIVE_NUM; i++) {
         motor[i] = nosound;
         step[i] = nosound;
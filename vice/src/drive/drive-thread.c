@@ -0,0 +1,360 @@
+/*
+ * drive-thread.c - Run true drive CPUs on worker threads.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* When enabled with the `DriveThreads' resource, `drive_cpu_execute_all()'
+   and `drive_vsync_hook()' hand each drive's slice to a worker thread
+   instead of running the drives one after another.  The main thread runs
+   the lowest numbered drive itself.
+
+   To stay cycle exact with the serial mode, a drive must call
+   `drive_thread_bus_sync()' before it touches anything it shares with the
+   other drives or the main CPU (IEC bus, parallel cables, fast serial,
+   drive sound).  That waits until every lower numbered drive is done with
+   its slice.  Lower numbered drives have then finished all their bus
+   accesses, and higher numbered drives cannot have made any yet, which is
+   exactly what the drive saw when the drives were run in order.
+
+   A drive that executes a JAM opcode while the drives run in parallel
+   stops its slice right there.  Once every lower numbered drive is done
+   and the others are done, JAMmed or waiting for the bus, the main thread
+   resumes it at the same clock, so the JAM is handled on the main thread
+   exactly as in the serial mode.
+
+   Slices are only run in parallel when they are long enough to be worth
+   the synchronization, when all drives involved are IEC drives, and when
+   the monitor is not watching any of them.  Everything else falls back to
+   the serial path.  */
+
+#include "vice.h"
+
+#include <stdio.h>
+
+#include "archdep_thread.h"
+#include "drive-thread.h"
+#include "drive.h"
+#include "drivetypes.h"
+#include "interrupt.h"
+#include "log.h"
+#include "monitor.h"
+#include "types.h"
+
+
+/* Slices shorter than this many main CPU cycles are run serially.  Most
+   short slices come from the main CPU polling the IEC bus.  */
+#define DRIVE_THREAD_MIN_CYCLES 2000
+
+int drive_thread_slice_active = 0;
+int drive_thread_bus_synced[DRIVE_NUM];
+
+static int drive_threads_enabled = 0;
+
+/* Slice state, protected by `thread_lock'.  */
+static CLOCK slice_clk;
+static unsigned int slice_mask;
+static unsigned int slice_go;
+static unsigned int slice_done;
+static unsigned int slice_jammed;
+static unsigned int slice_waiting;
+static int threads_quit;
+
+/* `stop_clk' of the drives that stopped their slice at a JAM.  */
+static CLOCK jam_stop_clk[DRIVE_NUM];
+
+/* The drive the main thread is finishing after a JAM, or `DRIVE_NUM'.  */
+static unsigned int jam_resume_dnr = DRIVE_NUM;
+
+static archdep_thread_t *threads[DRIVE_NUM];
+static archdep_mutex_t *thread_lock = NULL;
+static archdep_cond_t *thread_cond = NULL;
+
+/* ------------------------------------------------------------------------- */
+
+static void drive_thread_main(void *data)
+{
+    unsigned int dnr = vice_ptr_to_uint(data);
+    unsigned int bit = 1U << dnr;
+
+    archdep_mutex_lock(thread_lock);
+
+    while (1) {
+        while (!(slice_go & bit) && !threads_quit) {
+            archdep_cond_wait(thread_cond, thread_lock);
+        }
+        if (threads_quit) {
+            break;
+        }
+        slice_go &= ~bit;
+        archdep_mutex_unlock(thread_lock);
+
+        drive_cpu_execute_one(drive_context[dnr], slice_clk);
+
+        archdep_mutex_lock(thread_lock);
+        if (!(slice_jammed & bit)) {
+            slice_done |= bit;
+        }
+        archdep_cond_broadcast(thread_cond);
+    }
+
+    archdep_mutex_unlock(thread_lock);
+}
+
+static void drive_thread_stop(void)
+{
+    unsigned int dnr;
+
+    if (thread_lock == NULL) {
+        return;
+    }
+
+    archdep_mutex_lock(thread_lock);
+    threads_quit = 1;
+    archdep_cond_broadcast(thread_cond);
+    archdep_mutex_unlock(thread_lock);
+
+    for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
+        archdep_thread_join(threads[dnr]);
+        threads[dnr] = NULL;
+    }
+
+    archdep_cond_destroy(thread_cond);
+    archdep_mutex_destroy(thread_lock);
+    thread_cond = NULL;
+    thread_lock = NULL;
+}
+
+static int drive_thread_start(void)
+{
+    unsigned int dnr;
+
+    if (!archdep_thread_available()) {
+        log_warning(LOG_DEFAULT, "DriveThreads: threads are not supported on this system.");
+        return -1;
+    }
+
+    thread_lock = archdep_mutex_new();
+    thread_cond = archdep_cond_new();
+    threads_quit = 0;
+    slice_go = 0;
+
+    for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
+        threads[dnr] = archdep_thread_create(drive_thread_main,
+                                             uint_to_void_ptr(dnr));
+        if (threads[dnr] == NULL) {
+            log_error(LOG_DEFAULT, "DriveThreads: cannot create drive thread.");
+            drive_thread_stop();
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int drive_thread_set_enabled(int val)
+{
+    val = val ? 1 : 0;
+
+    if (val == drive_threads_enabled) {
+        return 0;
+    }
+
+    if (val) {
+        if (drive_thread_start() < 0) {
+            return -1;
+        }
+    } else {
+        drive_thread_stop();
+    }
+
+    drive_threads_enabled = val;
+    return 0;
+}
+
+void drive_thread_shutdown(void)
+{
+    drive_thread_stop();
+    drive_threads_enabled = 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int drive_thread_eligible(drive_context_t *drv)
+{
+    switch (drv->drive->type) {
+        case DRIVE_TYPE_1540:
+        case DRIVE_TYPE_1541:
+        case DRIVE_TYPE_1541II:
+        case DRIVE_TYPE_1570:
+        case DRIVE_TYPE_1571:
+        case DRIVE_TYPE_1571CR:
+        case DRIVE_TYPE_1581:
+        case DRIVE_TYPE_2000:
+        case DRIVE_TYPE_4000:
+            break;
+        default:
+            return 0;
+    }
+
+    /* Breakpoints, watchpoints and single stepping need the monitor, and
+       asking about extending an image needs the UI.  Both must only be
+       entered from the main thread.  */
+    if (monitor_mask[drv->cpu->monspace] != 0
+        || (drv->cpu->int_status->global_pending_int & IK_MONITOR)
+        || drv->cpud->read_func_ptr != drv->cpud->read_tab[0]
+        || drv->drive->extend_image_policy == DRIVE_EXTEND_ASK) {
+        return 0;
+    }
+
+    return 1;
+}
+
+/* Run the drives in `mask' up to `clk_value' in parallel.  Return 0 on
+   success or -1 if the caller has to run them serially.  */
+int drive_thread_execute(CLOCK clk_value, unsigned int mask)
+{
+    unsigned int dnr, first = DRIVE_NUM, num_long = 0;
+
+    if (!drive_threads_enabled || drive_thread_slice_active) {
+        return -1;
+    }
+
+    for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
+        drive_context_t *drv;
+
+        if (!(mask & (1U << dnr))) {
+            continue;
+        }
+        drv = drive_context[dnr];
+        if (!drive_thread_eligible(drv)) {
+            return -1;
+        }
+        if (first == DRIVE_NUM) {
+            first = dnr;
+        }
+        if (clk_value > drv->cpu->last_clk
+            && clk_value - drv->cpu->last_clk >= DRIVE_THREAD_MIN_CYCLES) {
+            num_long++;
+        }
+    }
+
+    if (num_long < 2) {
+        return -1;
+    }
+
+    archdep_mutex_lock(thread_lock);
+    slice_clk = clk_value;
+    slice_mask = mask;
+    slice_done = 0;
+    slice_jammed = 0;
+    slice_waiting = 0;
+    for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
+        drive_thread_bus_synced[dnr] = (dnr == first);
+    }
+    slice_go = mask & ~(1U << first);
+    drive_thread_slice_active = 1;
+    archdep_cond_broadcast(thread_cond);
+    archdep_mutex_unlock(thread_lock);
+
+    drive_cpu_execute_one(drive_context[first], clk_value);
+
+    archdep_mutex_lock(thread_lock);
+    if (!(slice_jammed & (1U << first))) {
+        slice_done |= 1U << first;
+    }
+    archdep_cond_broadcast(thread_cond);
+    while (slice_done != mask) {
+        unsigned int jam = DRIVE_NUM, before;
+
+        for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
+            if (slice_jammed & (1U << dnr)) {
+                jam = dnr;
+                break;
+            }
+        }
+        before = mask & ((1U << jam) - 1);
+
+        /* Resume the lowest JAMmed drive once every drive before it is
+           done and none of the others is still running.  */
+        if (jam == DRIVE_NUM
+            || (slice_done & before) != before
+            || (slice_done | slice_jammed | slice_waiting) != mask) {
+            archdep_cond_wait(thread_cond, thread_lock);
+            continue;
+        }
+
+        slice_jammed &= ~(1U << jam);
+        drive_context[jam]->cpu->stop_clk = jam_stop_clk[jam];
+        drive_thread_bus_synced[jam] = 1;
+        jam_resume_dnr = jam;
+        archdep_mutex_unlock(thread_lock);
+
+        drive_cpu_execute_one(drive_context[jam], clk_value);
+
+        archdep_mutex_lock(thread_lock);
+        jam_resume_dnr = DRIVE_NUM;
+        slice_done |= 1U << jam;
+        archdep_cond_broadcast(thread_cond);
+    }
+    drive_thread_slice_active = 0;
+    archdep_mutex_unlock(thread_lock);
+
+    return 0;
+}
+
+void drive_thread_bus_sync_wait(unsigned int dnr)
+{
+    unsigned int before = slice_mask & ((1U << dnr) - 1);
+
+    archdep_mutex_lock(thread_lock);
+    if ((slice_done & before) != before) {
+        slice_waiting |= 1U << dnr;
+        archdep_cond_broadcast(thread_cond);
+        while ((slice_done & before) != before) {
+            archdep_cond_wait(thread_cond, thread_lock);
+        }
+        slice_waiting &= ~(1U << dnr);
+    }
+    archdep_mutex_unlock(thread_lock);
+
+    drive_thread_bus_synced[dnr] = 1;
+}
+
+/* Called when a drive executes a JAM opcode.  Return nonzero if the drive
+   is running in parallel with others; its slice then ends at the current
+   clock, with the drive still on the JAM opcode, and the main thread
+   resumes it from there in `drive_thread_execute()'.  */
+int drive_thread_defer_jam(drive_context_t *drv)
+{
+    unsigned int dnr = drv->mynumber;
+
+    if (!drive_thread_slice_active || dnr == jam_resume_dnr) {
+        return 0;
+    }
+
+    jam_stop_clk[dnr] = drv->cpu->stop_clk;
+    drv->cpu->stop_clk = *(drv->clk_ptr);
+
+    archdep_mutex_lock(thread_lock);
+    slice_jammed |= 1U << dnr;
+    archdep_mutex_unlock(thread_lock);
+
+    return 1;
+}
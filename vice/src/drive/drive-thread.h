@@ -0,0 +1,57 @@
+/*
+ * drive-thread.h - Run true drive CPUs on worker threads.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_DRIVE_THREAD_H
+#define VICE_DRIVE_THREAD_H
+
+#include "drive.h"
+#include "types.h"
+
+/* Nonzero while drive CPUs are running on worker threads.  */
+extern int drive_thread_slice_active;
+
+/* Nonzero once the drive may touch state shared with other drives or the
+   main CPU during the current slice.  */
+extern int drive_thread_bus_synced[DRIVE_NUM];
+
+extern void drive_thread_bus_sync_wait(unsigned int dnr);
+
+extern int drive_thread_set_enabled(int val);
+extern void drive_thread_shutdown(void);
+
+extern int drive_thread_execute(CLOCK clk_value, unsigned int mask);
+extern int drive_thread_defer_jam(struct drive_context_s *drv);
+
+/* Must be called by drive code before it accesses the IEC bus, a parallel
+   cable or anything else shared with other drives or the main CPU.  While
+   drives run in parallel this waits until all lower numbered drives have
+   finished their slice, which reproduces the order of the serial
+   `drive_cpu_execute_all()' exactly.  */
+inline static void drive_thread_bus_sync(unsigned int dnr)
+{
+    if (drive_thread_slice_active && !drive_thread_bus_synced[dnr]) {
+        drive_thread_bus_sync_wait(dnr);
+    }
+}
+
+#endif
@@ -49,6 +49,7 @@
 #include "diskimage.h"
 #include "drive-check.h"
 #include "drive-overflow.h"
+#include "drive-thread.h"
 #include "drive.h"
 #include "drivecpu.h"
 #include "drivecpu65c02.h"
@@ -72,6 +73,7 @@
 #include "drive-sound.h"
 #include "p64.h"
 #include "monitor.h"
+#include "vdrive.h"
 
 static int drive_init_was_called = 0;
 
@@ -225,6 +227,7 @@ int drive_init(void)
         drive->led_last_change_clk = *(drive->clk);
         drive->led_last_uiupdate_clk = *(drive->clk);
         drive->led_active_ticks = 0;
+        drive->wobble_rand = (uint32_t)lib_unsigned_rand(0, 0x7fffffff) | 1;
 
         rotation_reset(drive);
 
@@ -268,6 +271,8 @@ void drive_shutdown(void)
         return;
     }
 
+    drive_thread_shutdown();
+
     for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
         if (drive_context[dnr]->drive->type == DRIVE_TYPE_2000 || drive_context[dnr]->drive->type == DRIVE_TYPE_4000) {
             drivecpu65c02_shutdown(drive_context[dnr]);
@@ -595,6 +600,7 @@ void drive_set_half_track(int num, int side, drive_t *dptr)
    for `step' are `+1', '+2' and `-1'.  */
 void drive_move_head(int step, drive_t *drive)
 {
+    drive_thread_bus_sync(drive->mynumber);
     drive_gcr_data_writeback(drive);
     drive_sound_head(drive->current_half_track, step, drive->mynumber);
     drive_set_half_track(drive->current_half_track + step, drive->side, drive);
@@ -808,8 +814,19 @@ void drive_cpu_execute_one(drive_context_t *drv, CLOCK clk_value)
 void drive_cpu_execute_all(CLOCK clk_value)
 {
     unsigned int dnr;
+    unsigned int mask = 0;
     drive_t *drive;
 
+    for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
+        if (drive_context[dnr]->drive->enable) {
+            mask |= 1U << dnr;
+        }
+    }
+
+    if (drive_thread_execute(clk_value, mask) == 0) {
+        return;
+    }
+
     for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
         drive = drive_context[dnr]->drive;
         if (drive->enable) {
@@ -833,13 +850,23 @@ void drive_cpu_set_overflow(drive_context_t *drv)
 void drive_vsync_hook(void)
 {
     unsigned int dnr;
+    unsigned int mask = 0;
+    int threaded;
 
     drive_update_ui_status();
 
+    for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
+        drive_t *drive = drive_context[dnr]->drive;
+        if (drive->enable && drive->idling_method != DRIVE_IDLE_SKIP_CYCLES) {
+            mask |= 1U << dnr;
+        }
+    }
+    threaded = (drive_thread_execute(maincpu_clk, mask) == 0);
+
     for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
         drive_t *drive = drive_context[dnr]->drive;
         if (drive->enable) {
-            if (drive->idling_method != DRIVE_IDLE_SKIP_CYCLES) {
+            if (drive->idling_method != DRIVE_IDLE_SKIP_CYCLES && !threaded) {
                 drive_cpu_execute_one(drive_context[dnr], maincpu_clk);
             }
             if (drive->idling_method == DRIVE_IDLE_NO_IDLE) {
@@ -852,6 +879,14 @@ void drive_vsync_hook(void)
             /* printf("drive_vsync_hook drv %d @clk:%d\n", dnr, maincpu_clk); */
         }
     }
+
+    /* write back sectors the virtual drives have left in the image cache */
+    for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
+        vdrive_t *vdrive = file_system_get_vdrive(dnr + 8);
+        if (vdrive != NULL && vdrive->image != NULL) {
+            disk_image_flush(vdrive->image, 0);
+        }
+    }
 }
 
 /* ------------------------------------------------------------------------- */
@@ -328,6 +328,11 @@ typedef struct drive_s {
     /* rotations per minute (300rpm = 30000) */
     int rpm;
     int rpm_wobble;
+
+    /* State of the RPM wobble random number generator.  Each drive has its
+       own, so drives running on worker threads draw the same numbers as
+       drives running one after another.  */
+    uint32_t wobble_rand;
 } drive_t;
 
 
@@ -40,6 +40,7 @@
 #include "drive.h"
 #include "drivecpu.h"
 #include "drive-check.h"
+#include "drive-thread.h"
 #include "drivemem.h"
 #include "drivetypes.h"
 #include "interrupt.h"
@@ -482,6 +483,10 @@ static void drive_jam(drive_context_t *drv)
 
     cpu = drv->cpu;
 
+    if (drive_thread_defer_jam(drv)) {
+        return;
+    }
+
     switch (drv->drive->type) {
         case DRIVE_TYPE_1540:
             dname = "  1540";
@@ -39,6 +39,7 @@
 #include <string.h>
 
 #include "dolphindos3.h"
+#include "drive-thread.h"
 #include "drive.h"
 #include "drivemem.h"
 #include "drivetypes.h"
@@ -54,6 +55,7 @@ static mc6821_state my6821[DRIVE_NUM];
 static void dd3_set_pa(mc6821_state *ctx)
 {
     unsigned int dnr = (unsigned int)(((drive_context_t *)(ctx->p))->mynumber);
+    drive_thread_bus_sync(dnr);
     parallel_cable_drive_write(DRIVE_PC_DD3, ctx->dataA, PARALLEL_WRITE, dnr);
     /* DBG(("DD3 (%d) 6821 PA WR %02x\n", dnr, ctx->dataA)); */
 }
@@ -64,6 +66,8 @@ static uint8_t dd3_get_pa(mc6821_state *ctx)
     uint8_t data;
     int hs = 0;
 
+    drive_thread_bus_sync(dnr);
+
     /* output all pins that are in input mode as 1 first */
     parallel_cable_drive_write(DRIVE_PC_DD3, (uint8_t)((~ctx->ddrA) | ctx->dataA), PARALLEL_WRITE, dnr);
 
@@ -31,6 +31,7 @@
 
 #include "cia.h"
 #include "ciad.h"
+#include "drive-thread.h"
 #include "drivetypes.h"
 #include "iecdrive.h"
 #include "interrupt.h"
@@ -101,6 +102,7 @@ static void pulse_ciapc(cia_context_t *cia_context, CLOCK rclk)
     ciap = (drivecia1571_context_t *)(cia_context->prv);
 
     if (ciap->drive->parallel_cable == DRIVE_PC_STANDARD) {
+        drive_thread_bus_sync(ciap->number);
         parallel_cable_drive_write(DRIVE_PC_STANDARD, 0, PARALLEL_HS, ciap->number);
     }
 }
@@ -131,6 +133,7 @@ static void store_ciapb(cia_context_t *cia_context, CLOCK rclk, uint8_t byte)
     ciap = (drivecia1571_context_t *)(cia_context->prv);
 
     if (ciap->drive->parallel_cable == DRIVE_PC_STANDARD) {
+        drive_thread_bus_sync(ciap->number);
         parallel_cable_drive_write(DRIVE_PC_STANDARD, byte, PARALLEL_WRITE, ciap->number);
     }
 }
@@ -149,6 +152,7 @@ static uint8_t read_ciapb(cia_context_t *cia_context)
     ciap = (drivecia1571_context_t *)(cia_context->prv);
 
     if (ciap->drive->parallel_cable == DRIVE_PC_STANDARD) {
+        drive_thread_bus_sync(ciap->number);
         byte = parallel_cable_drive_read(ciap->drive->parallel_cable, 1);
     }
 
@@ -170,6 +174,7 @@ static void store_sdr(cia_context_t *cia_context, uint8_t byte)
 
     cia1571p = (drivecia1571_context_t *)(cia_context->prv);
 
+    drive_thread_bus_sync(cia1571p->number);
     iec_fast_drive_write((uint8_t)byte, cia1571p->number);
 }
 
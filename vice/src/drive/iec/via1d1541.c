@@ -33,6 +33,7 @@
 
 #include "debug.h"
 #include "drive.h"
+#include "drive-thread.h"
 #include "drivesync.h"
 #include "drivetypes.h"
 #include "glue1571.h"
@@ -154,6 +155,7 @@ static void store_pra(via_context_t *via_context, uint8_t byte, uint8_t oldpa_va
             glue1571_side_set((byte >> 2) & 1, via1p->drive);
         }
         if ((oldpa_value ^ byte) & 0x02) {
+            drive_thread_bus_sync(via1p->number);
             iec_fast_drive_direction(byte & 2, via1p->number);
         }
     } else {
@@ -163,6 +165,7 @@ static void store_pra(via_context_t *via_context, uint8_t byte, uint8_t oldpa_va
                 if (via1p->drive->type == DRIVE_TYPE_1540
                     || via1p->drive->type == DRIVE_TYPE_1541
                     || via1p->drive->type == DRIVE_TYPE_1541II) {
+                    drive_thread_bus_sync(via1p->number);
                     parallel_cable_drive_write(via1p->drive->parallel_cable, byte,
                                                (((addr == VIA_PRA) && ((via_context->via[VIA_PCR]
                                                                         & 0xe) == 0xa)) ? PARALLEL_WRITE_HS : PARALLEL_WRITE),
@@ -214,6 +217,8 @@ static void store_prb(via_context_t *via_context, uint8_t byte, uint8_t p_oldpb,
     if (byte != p_oldpb) {
         DEBUG_IEC_DRV_WRITE(byte);
 
+        drive_thread_bus_sync(via1p->number);
+
         if (iecbus != NULL) {
             uint8_t *drive_data, *drive_bus;
             unsigned int unit;
@@ -303,6 +308,7 @@ static uint8_t read_pra(via_context_t *via_context, uint16_t addr)
     switch (via1p->drive->parallel_cable) {
         case DRIVE_PC_STANDARD:
         case DRIVE_PC_FORMEL64:
+            drive_thread_bus_sync(via1p->number);
             byte = parallel_cable_drive_read(via1p->drive->parallel_cable,
                                              (((addr == VIA_PRA) && (via_context->via[VIA_PCR] & 0xe) == 0xa)) ? 1 : 0);
             break;
@@ -326,6 +332,8 @@ static uint8_t read_prb(via_context_t *via_context)
     /* 0 for drive0, 0x20 for drive 1 */
     orval = (via1p->number << 5);
 
+    drive_thread_bus_sync(via1p->number);
+
     if (iecbus != NULL) {
         byte = (((via_context->via[VIA_PRB] & 0x1a)
                  | iecbus->drv_port) ^ 0x85) | orval;
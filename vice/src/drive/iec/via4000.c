@@ -36,6 +36,7 @@
 
 #include "debug.h"
 #include "drive.h"
+#include "drive-thread.h"
 #include "drivesync.h"
 #include "drivetypes.h"
 #include "iecbus.h"
@@ -143,6 +144,8 @@ static void store_pra(via_context_t *via_context, uint8_t byte, uint8_t oldpa,
     if (byte != oldpa) {
         DEBUG_IEC_DRV_WRITE(byte);
 
+        drive_thread_bus_sync(viap->number);
+
         if (iecbus != NULL) {
             uint8_t *drive_data, *drive_bus;
             unsigned int unit;
@@ -218,6 +221,7 @@ static void store_sr(via_context_t *via_context, uint8_t byte)
 
     viap = (drivevia_context_t *)(via_context->prv);
 
+    drive_thread_bus_sync(viap->number);
     iec_fast_drive_write((uint8_t)(~byte), viap->number);
 }
 
@@ -236,6 +240,8 @@ static uint8_t read_pra(via_context_t *via_context, uint16_t addr)
 
     viap = (drivevia_context_t *)(via_context->prv);
 
+    drive_thread_bus_sync(viap->number);
+
     if (iecbus != NULL) {
         byte = (((via_context->via[VIA_PRA] & 0x1a)
                  | iecbus->drv_port) ^ 0x85);
@@ -44,6 +44,7 @@
 
 #include <stdio.h>
 
+#include "drive-thread.h"
 #include "drive-writeprotect.h"
 #include "drive.h"
 #include "drivetypes.h"
@@ -288,6 +289,8 @@ static void store_prb(via_context_t *via_context, uint8_t byte, uint8_t poldpb,
         rotation_speed_zone_set((byte >> 5) & 0x3, via2p->number);
     }
     if ((poldpb ^ byte) & 0x04) {   /* Motor on/off */
+        /* the drive sound is shared with the other drives */
+        drive_thread_bus_sync(via2p->number);
         drive_sound_update((byte & 4) ? DRIVE_SOUND_MOTOR_ON : DRIVE_SOUND_MOTOR_OFF, via2p->number);
         bra = drv->byte_ready_active;
         drv->byte_ready_active = (bra & ~0x04) | (byte & 0x04);
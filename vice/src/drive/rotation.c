@@ -284,6 +284,22 @@ inline static uint32_t RANDOM_nextUInt(rotation_t *rptr)
     return rptr->xorShift32 ^= (rptr->xorShift32 << 5);
 }
 
+/* RPM offset of -rpm_wobble/2 ... +rpm_wobble/2, drawn from the drive's own
+   generator so that it does not depend on the order the drive threads run.  */
+static int rotation_wobble(drive_t *dptr)
+{
+    uint32_t x = dptr->wobble_rand;
+
+    if (dptr->rpm_wobble == 0) {
+        return 0;
+    }
+    x ^= (x << 13);
+    x ^= (x >> 17);
+    x ^= (x << 5);
+    dptr->wobble_rand = x;
+    return (int)(x % (uint32_t)(dptr->rpm_wobble + 1)) - (dptr->rpm_wobble / 2);
+}
+
 void rotation_begins(drive_t *dptr)
 {
     unsigned int dnr = dptr->mynumber;
@@ -321,7 +337,7 @@ static void rotation_1541_gcr(drive_t *dptr, int ref_cycles)
      *    in reality the constant offset can be relatively large, but does not
      *    change a lot over time, so the random offset is rather small.
      */
-    wobble = dptr->rpm_wobble ? lib_unsigned_rand(0, dptr->rpm_wobble) - (dptr->rpm_wobble / 2) : 0;
+    wobble = rotation_wobble(dptr);
     tmp *= clk_ref_per_rev;
     tmp /= dptr->rpm + wobble;
     clk_ref_per_rev = (int)tmp;
@@ -961,7 +977,7 @@ static void rotation_1541_simple(drive_t *dptr)
     delta = *(dptr->clk) - rptr->rotation_last_clk;
     rptr->rotation_last_clk = *(dptr->clk);
 
-    wobble = dptr->rpm_wobble ? lib_unsigned_rand(0, dptr->rpm_wobble) - (dptr->rpm_wobble / 2) : 0;
+    wobble = rotation_wobble(dptr);
     tmp *= 30000UL;
     tmp /= (dptr->rpm + wobble);
     rpmscale = (unsigned long)(tmp);
@@ -32,6 +32,7 @@
 #include <string.h>
 
 #include "archdep.h"
+#include "archdep_thread.h"
 #include "cmdline.h"
 #include "ffmpegdrv.h"
 #include "ffmpeglib.h"
@@ -153,8 +154,66 @@ static int video_bitrate;
 static int audio_codec;
 static int video_codec;
 static int video_halve_framerate;
+static int encoder_thread_enabled;
+static int encoder_queue_size;
+static int encoder_drop_frames;
+
+/* encoder thread
+
+   With `FFMPEGEncoderThread' set, the palette lookup, scaling, encoding
+   and writing of the media file are done on a separate thread.  The
+   emulation only copies the indexed pixels out of the draw buffer, which
+   it overwrites with the next frame, into a free queue slot.  Audio
+   frames are not copied at all: the filled sample frame is handed to the
+   queue and the sound movie device carries on in the spare frame of the
+   slot.  When the queue is full, the emulation waits for the encoder, or
+   with `FFMPEGEncoderDropFrames' drops the video frame.  Audio is never
+   dropped.  */
+
+#define ENCODER_QUEUE_MIN  2
+#define ENCODER_QUEUE_MAX  64
+
+enum {
+    ENCODER_JOB_VIDEO,
+    ENCODER_JOB_AUDIO
+};
+
+typedef struct encoder_job_s {
+    int type;
+    int64_t pts;
+    /* video: indexed pixels of the visible area and their RGB values */
+    uint8_t *pixels;
+    uint8_t rgb[256 * 3];
+    /* audio: the samples, or a spare frame while the slot is free */
+    AVFrame *audio;
+} encoder_job_t;
+
+static encoder_job_t *encoder_queue = NULL;
+static int encoder_slots;
+static int encoder_head;
+static int encoder_tail;
+static int encoder_count;
+static int encoder_quit;
+static int encoder_failed;
+static int encoder_running;
+static archdep_thread_t *encoder_thread = NULL;
+static archdep_mutex_t *encoder_lock = NULL;
+static archdep_cond_t *encoder_cond_job = NULL;
+static archdep_cond_t *encoder_cond_slot = NULL;
+
+/* backpressure statistics, reported when the recording is closed */
+static unsigned long stat_video_frames;
+static unsigned long stat_audio_frames;
+static unsigned long stat_dropped;
+static unsigned long stat_waits;
+static int stat_peak;
+
+static int audio_inbuf_samples;
 
 static int ffmpegdrv_init_file(void);
+static void ffmpegdrv_encoder_start(void);
+static void ffmpegdrv_encoder_stop(void);
+static int ffmpegdrv_encoder_queue_audio(int64_t pts);
 
 static int set_container_format(const char *val, void *param)
 {
@@ -232,6 +291,28 @@ static int set_video_halve_framerate(int value, void *param)
     return 0;
 }
 
+static int set_encoder_thread_enabled(int val, void *param)
+{
+    encoder_thread_enabled = val ? 1 : 0;
+    return 0;
+}
+
+static int set_encoder_queue_size(int val, void *param)
+{
+    if (val < ENCODER_QUEUE_MIN || val > ENCODER_QUEUE_MAX) {
+        return -1;
+    }
+
+    encoder_queue_size = val;
+    return 0;
+}
+
+static int set_encoder_drop_frames(int val, void *param)
+{
+    encoder_drop_frames = val ? 1 : 0;
+    return 0;
+}
+
 /*---------- Resources ------------------------------------------------*/
 
 static const resource_string_t resources_string[] = {
@@ -253,6 +334,12 @@ static const resource_int_t resources_int[] = {
       &video_codec, set_video_codec, NULL },
     { "FFMPEGVideoHalveFramerate", 0, RES_EVENT_NO, NULL,
       &video_halve_framerate, set_video_halve_framerate, NULL },
+    { "FFMPEGEncoderThread", 1, RES_EVENT_NO, NULL,
+      &encoder_thread_enabled, set_encoder_thread_enabled, NULL },
+    { "FFMPEGEncoderQueue", 8, RES_EVENT_NO, NULL,
+      &encoder_queue_size, set_encoder_queue_size, NULL },
+    { "FFMPEGEncoderDropFrames", 0, RES_EVENT_NO, NULL,
+      &encoder_drop_frames, set_encoder_drop_frames, NULL },
     RESOURCE_INT_LIST_END
 };
 
@@ -275,6 +362,21 @@ static const cmdline_option_t cmdline_options[] =
     { "-ffmpegvideobitrate", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
       NULL, NULL, "FFMPEGVideoBitrate", NULL,
       "<value>", "Set bitrate for video stream in media file" },
+    { "-ffmpegthread", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "FFMPEGEncoderThread", (resource_value_t)1,
+      NULL, "Encode media files on a separate thread" },
+    { "+ffmpegthread", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "FFMPEGEncoderThread", (resource_value_t)0,
+      NULL, "Encode media files in the emulation thread" },
+    { "-ffmpegqueue", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "FFMPEGEncoderQueue", NULL,
+      "<frames>", "Set the number of frames queued for the encoder thread (2..64)" },
+    { "-ffmpegdropframes", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "FFMPEGEncoderDropFrames", (resource_value_t)1,
+      NULL, "Drop video frames when the encoder thread falls behind" },
+    { "+ffmpegdropframes", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "FFMPEGEncoderDropFrames", (resource_value_t)0,
+      NULL, "Wait for the encoder thread when it falls behind" },
     CMDLINE_LIST_END
 };
 
@@ -337,7 +439,6 @@ static AVFrame *alloc_audio_frame(enum AVSampleFormat sample_fmt,
 static int ffmpegdrv_open_audio(AVFormatContext *oc, AVStream *st)
 {
     AVCodecContext *c;
-    int audio_inbuf_samples;
     int ret;
     AVDictionary *opts = NULL;
 
@@ -498,78 +599,100 @@ static int ffmpegmovie_init_audio(int speed, int channels, soundmovie_buffer_t *
     return 0;
 }
 
-/* triggered by soundffmpegaudio->write */
-static int ffmpegmovie_encode_audio(soundmovie_buffer_t *audio_in)
+/* encode the samples in `frame' */
+static int ffmpegdrv_encode_audio(AVFrame *frame, int64_t pts)
 {
     int got_packet;
     int dst_nb_samples;
     AVPacket pkt = { 0 };
     AVCodecContext *c;
-    AVFrame *frame;
     int ret;
 
 #ifdef _MSC_VER
     AVRational tmp;
 #endif
 
-    if (audio_st.st) {
-        audio_st.frame->pts = audio_st.next_pts;
-        audio_st.next_pts += audio_in->size;
-
-        VICE_P_AV_INIT_PACKET(&pkt);
-        c = audio_st.st->codec;
+    audio_st.frame->pts = pts;
 
-        frame = audio_st.tmp_frame;
+    VICE_P_AV_INIT_PACKET(&pkt);
+    c = audio_st.st->codec;
 
-        if (frame) {
-            /* convert samples from native format to destination codec format, using the resampler */
-            /* compute destination number of samples */
+    if (frame) {
+        /* convert samples from native format to destination codec format, using the resampler */
+        /* compute destination number of samples */
 #ifndef HAVE_FFMPEG_AVRESAMPLE
-            dst_nb_samples = (int)VICE_P_AV_RESCALE_RND(VICE_P_SWR_GET_DELAY(swr_ctx, c->sample_rate) + frame->nb_samples, c->sample_rate, c->sample_rate, AV_ROUND_UP);
+        dst_nb_samples = (int)VICE_P_AV_RESCALE_RND(VICE_P_SWR_GET_DELAY(swr_ctx, c->sample_rate) + frame->nb_samples, c->sample_rate, c->sample_rate, AV_ROUND_UP);
 #else
-            dst_nb_samples = (int)VICE_P_AV_RESCALE_RND(VICE_P_AVRESAMPLE_GET_DELAY(avr_ctx, c->sample_rate) + frame->nb_samples, c->sample_rate, c->sample_rate, AV_ROUND_UP);
+        dst_nb_samples = (int)VICE_P_AV_RESCALE_RND(VICE_P_AVRESAMPLE_GET_DELAY(avr_ctx, c->sample_rate) + frame->nb_samples, c->sample_rate, c->sample_rate, AV_ROUND_UP);
 #endif
 
-            /* when we pass a frame to the encoder, it may keep a reference to it
-            * internally;
-            * make sure we do not overwrite it here
-            */
-            ret = VICE_P_AV_FRAME_MAKE_WRITABLE(audio_st.frame);
-            if (ret < 0)
-                return -1;
+        /* when we pass a frame to the encoder, it may keep a reference to it
+        * internally;
+        * make sure we do not overwrite it here
+        */
+        ret = VICE_P_AV_FRAME_MAKE_WRITABLE(audio_st.frame);
+        if (ret < 0)
+            return -1;
 
-            /* convert to destination format */
+        /* convert to destination format */
 #ifndef HAVE_FFMPEG_AVRESAMPLE
-            ret = VICE_P_SWR_CONVERT(swr_ctx, audio_st.frame->data, dst_nb_samples, (const uint8_t **)frame->data, frame->nb_samples);
+        ret = VICE_P_SWR_CONVERT(swr_ctx, audio_st.frame->data, dst_nb_samples, (const uint8_t **)frame->data, frame->nb_samples);
 #else
-            ret = VICE_P_AVRESAMPLE_CONVERT(avr_ctx, audio_st.frame->data, 0, dst_nb_samples, (const uint8_t **)frame->data, 0, frame->nb_samples);
+        ret = VICE_P_AVRESAMPLE_CONVERT(avr_ctx, audio_st.frame->data, 0, dst_nb_samples, (const uint8_t **)frame->data, 0, frame->nb_samples);
 #endif
-            if (ret < 0) {
-                log_debug("ffmpegdrv_encode_audio: Error while converting audio frame");
-                return -1;
-            }
-            frame = audio_st.frame;
+        if (ret < 0) {
+            log_debug("ffmpegdrv_encode_audio: Error while converting audio frame");
+            return -1;
+        }
+        frame = audio_st.frame;
 #ifdef _MSC_VER
-            tmp.num = 1;
-            tmp.den = c->sample_rate;
-            frame->pts = VICE_P_AV_RESCALE_Q(audio_st.samples_count, tmp, c->time_base);
+        tmp.num = 1;
+        tmp.den = c->sample_rate;
+        frame->pts = VICE_P_AV_RESCALE_Q(audio_st.samples_count, tmp, c->time_base);
 #else
-            frame->pts = VICE_P_AV_RESCALE_Q(audio_st.samples_count, (AVRational){ 1, c->sample_rate }, c->time_base);
+        frame->pts = VICE_P_AV_RESCALE_Q(audio_st.samples_count, (AVRational){ 1, c->sample_rate }, c->time_base);
 #endif
-            audio_st.samples_count += dst_nb_samples;
+        audio_st.samples_count += dst_nb_samples;
+    }
+
+    ret = VICE_P_AVCODEC_ENCODE_AUDIO2(audio_st.st->codec, &pkt, audio_st.frame, &got_packet);
+    if (ret < 0) {
+        log_debug("ffmpegdrv_encode_audio: Error while encoding audio frame");
+        return -1;
+    }
+    if (got_packet) {
+        if (write_frame(ffmpegdrv_oc, &c->time_base, audio_st.st, &pkt)<0)
+        {
+            log_debug("ffmpegdrv_encode_audio: Error while writing audio frame");
         }
+    }
 
-        ret = VICE_P_AVCODEC_ENCODE_AUDIO2(audio_st.st->codec, &pkt, audio_st.frame, &got_packet);
-        if (got_packet) {
-            if (write_frame(ffmpegdrv_oc, &c->time_base, audio_st.st, &pkt)<0)
-            {
-                log_debug("ffmpegdrv_encode_audio: Error while writing audio frame");
+    return 0;
+}
+
+/* triggered by soundffmpegaudio->write */
+static int ffmpegmovie_encode_audio(soundmovie_buffer_t *audio_in)
+{
+    int64_t pts;
+    int ret = 0;
+
+    if (audio_st.st) {
+        pts = audio_st.next_pts;
+        audio_st.next_pts += audio_in->size;
+
+        if (encoder_running) {
+            if (encoder_failed) {
+                ret = -1;
+            } else {
+                ffmpegdrv_encoder_queue_audio(pts);
             }
+        } else {
+            ret = ffmpegdrv_encode_audio(audio_st.tmp_frame, pts);
         }
     }
 
     audio_in->used = 0;
-    return 0;
+    return ret;
 }
 
 static void ffmpegmovie_close(void)
@@ -587,30 +710,51 @@ static soundmovie_funcs_t ffmpegdrv_soundmovie_funcs = {
 /*-----------------------*/
 /* video stream encoding */
 /*-----------------------*/
-static int ffmpegdrv_fill_rgb_image(screenshot_t *screenshot, AVFrame *pic)
+/* the visible area of the screenshot, centered in the video */
+static const uint8_t *ffmpegdrv_visible_area(screenshot_t *screenshot)
 {
-    int x, y;
     int dx, dy;
-    int colnum;
     int bufferoffset;
-    int x_dim = screenshot->width;
-    int y_dim = screenshot->height;
-    int pix = 0;
-    /* center the screenshot in the video */
-    dx = (video_width - x_dim) / 2;
-    dy = (video_height - y_dim) / 2;
+
+    dx = (video_width - (int)screenshot->width) / 2;
+    dy = (video_height - (int)screenshot->height) / 2;
     bufferoffset = screenshot->x_offset + (dx < 0 ? -dx : 0)
         + (screenshot->y_offset + (dy < 0 ? -dy : 0)) * screenshot->draw_buffer_line_size;
 
+    return screenshot->draw_buffer + bufferoffset;
+}
+
+static void ffmpegdrv_fill_rgb_table(screenshot_t *screenshot, uint8_t *rgb)
+{
+    unsigned int i;
+    unsigned int n = screenshot->palette->num_entries;
+
+    if (n > 256) {
+        n = 256;
+    }
+    for (i = 0; i < n; i++) {
+        rgb[i * 3] = screenshot->palette->entries[i].red;
+        rgb[i * 3 + 1] = screenshot->palette->entries[i].green;
+        rgb[i * 3 + 2] = screenshot->palette->entries[i].blue;
+    }
+}
+
+static int ffmpegdrv_fill_rgb_image(const uint8_t *src, int pitch,
+                                    const uint8_t *rgb, AVFrame *pic)
+{
+    int x, y;
+    const uint8_t *col;
+    uint8_t *dst = pic->data[0];
+
     for (y = 0; y < video_height; y++) {
         for (x = 0; x < video_width; x++) {
-            colnum = screenshot->draw_buffer[bufferoffset + x];
-            pic->data[0][pix + 3*x] = screenshot->palette->entries[colnum].red;
-            pic->data[0][pix + 3*x + 1] = screenshot->palette->entries[colnum].green;
-            pic->data[0][pix + 3*x + 2] = screenshot->palette->entries[colnum].blue;
+            col = &rgb[src[x] * 3];
+            dst[3*x] = col[0];
+            dst[3*x + 1] = col[1];
+            dst[3*x + 2] = col[2];
         }
-        bufferoffset += screenshot->draw_buffer_line_size;
-        pix += pic->linesize[0];
+        src += pitch;
+        dst += pic->linesize[0];
     }
 
     return 0;
@@ -824,6 +968,8 @@ static int ffmpegdrv_init_file(void)
 
     file_init_done = 1;
 
+    ffmpegdrv_encoder_start();
+
     return 0;
 }
 
@@ -882,6 +1028,9 @@ static int ffmpegdrv_close(screenshot_t *screenshot)
 {
     unsigned int i;
 
+    /* everything queued goes into the file before the trailer */
+    ffmpegdrv_encoder_stop();
+
     /* write the trailer, if any */
     if (file_init_done) {
         VICE_P_AV_WRITE_TRAILER(ffmpegdrv_oc);
@@ -915,35 +1064,17 @@ static int ffmpegdrv_close(screenshot_t *screenshot)
     return 0;
 }
 
-/* triggered by screenshot_record */
-static int ffmpegdrv_record(screenshot_t *screenshot)
+/* encode a frame of `video_width' x `video_height' indexed pixels */
+static int ffmpegdrv_encode_video(const uint8_t *src, int pitch,
+                                  const uint8_t *rgb, int64_t pts)
 {
     AVCodecContext *c;
     int ret;
 
-    if (audio_init_done && video_init_done && !file_init_done) {
-        ffmpegdrv_init_file();
-    }
-
-    if (video_st.st == NULL || !file_init_done) {
-        return 0;
-    }
-
-   if (audio_st.st && video_st.next_pts > audio_st.next_pts) {
-        /* drop this frame */
-        return 0;
-    }
-
-    framecounter++;
-    if (video_halve_framerate && (framecounter & 1)) {
-        /* drop every second frame */
-        return 0;
-    }
-
     c = video_st.st->codec;
 
     if (c->pix_fmt != VICE_AV_PIX_FMT_RGB24) {
-        ffmpegdrv_fill_rgb_image(screenshot, video_st.tmp_frame);
+        ffmpegdrv_fill_rgb_image(src, pitch, rgb, video_st.tmp_frame);
 
         if (sws_ctx != NULL) {
             VICE_P_SWS_SCALE(sws_ctx,
@@ -956,10 +1087,10 @@ static int ffmpegdrv_record(screenshot_t *screenshot)
                 video_st.frame->data, video_st.frame->linesize);
         }
     } else {
-        ffmpegdrv_fill_rgb_image(screenshot, video_st.frame);
+        ffmpegdrv_fill_rgb_image(src, pitch, rgb, video_st.frame);
     }
 
-    video_st.frame->pts = video_st.next_pts++;
+    video_st.frame->pts = pts;
 
     if (ffmpegdrv_oc->oformat->flags & AVFMT_RAWPICTURE) {
         AVPacket pkt;
@@ -1001,6 +1132,267 @@ static int ffmpegdrv_record(screenshot_t *screenshot)
     return 0;
 }
 
+/*-----------------------*/
+/* encoder thread        */
+/*-----------------------*/
+
+static void ffmpegdrv_encoder_main(void *data)
+{
+    encoder_job_t *job;
+    int ret;
+
+    archdep_mutex_lock(encoder_lock);
+    while (1) {
+        while (encoder_count == 0 && !encoder_quit) {
+            archdep_cond_wait(encoder_cond_job, encoder_lock);
+        }
+        if (encoder_count == 0) {
+            break;
+        }
+        job = &encoder_queue[encoder_tail];
+        archdep_mutex_unlock(encoder_lock);
+
+        if (job->type == ENCODER_JOB_VIDEO) {
+            ret = ffmpegdrv_encode_video(job->pixels, video_width, job->rgb,
+                                         job->pts);
+        } else {
+            ret = ffmpegdrv_encode_audio(job->audio, job->pts);
+        }
+
+        archdep_mutex_lock(encoder_lock);
+        if (ret < 0) {
+            encoder_failed = 1;
+        }
+        encoder_tail = (encoder_tail + 1) % encoder_slots;
+        encoder_count--;
+        archdep_cond_signal(encoder_cond_slot);
+    }
+    archdep_mutex_unlock(encoder_lock);
+}
+
+static void ffmpegdrv_encoder_free_queue(void)
+{
+    int i;
+
+    for (i = 0; i < encoder_slots; i++) {
+        lib_free(encoder_queue[i].pixels);
+        if (encoder_queue[i].audio != NULL) {
+            VICE_P_AV_FRAME_FREE(&encoder_queue[i].audio);
+        }
+    }
+    lib_free(encoder_queue);
+    encoder_queue = NULL;
+    encoder_slots = 0;
+}
+
+static void ffmpegdrv_encoder_stop(void)
+{
+    if (!encoder_running) {
+        return;
+    }
+
+    /* let the encoder drain the queue and quit */
+    archdep_mutex_lock(encoder_lock);
+    encoder_quit = 1;
+    archdep_cond_signal(encoder_cond_job);
+    archdep_mutex_unlock(encoder_lock);
+    archdep_thread_join(encoder_thread);
+    encoder_thread = NULL;
+    encoder_running = 0;
+
+    archdep_cond_destroy(encoder_cond_slot);
+    archdep_cond_destroy(encoder_cond_job);
+    archdep_mutex_destroy(encoder_lock);
+    encoder_cond_slot = NULL;
+    encoder_cond_job = NULL;
+    encoder_lock = NULL;
+
+    log_message(LOG_DEFAULT, "ffmpegdrv: encoder thread took %lu video and %lu audio frames, dropped %lu video frames, emulation waited %lu times, queue peak %d of %d.",
+                stat_video_frames, stat_audio_frames, stat_dropped, stat_waits,
+                stat_peak, encoder_slots);
+
+    ffmpegdrv_encoder_free_queue();
+}
+
+static void ffmpegdrv_encoder_start(void)
+{
+    int i;
+    AVCodecContext *c;
+
+    if (!encoder_thread_enabled || !archdep_thread_available()) {
+        return;
+    }
+
+    encoder_slots = encoder_queue_size;
+    encoder_queue = lib_calloc((size_t)encoder_slots, sizeof(encoder_job_t));
+    for (i = 0; i < encoder_slots; i++) {
+        if (video_st.st) {
+            encoder_queue[i].pixels = lib_malloc((size_t)(video_width * video_height));
+        }
+        if (audio_st.st) {
+            c = audio_st.st->codec;
+            encoder_queue[i].audio = alloc_audio_frame(AV_SAMPLE_FMT_S16,
+                                                       c->channel_layout,
+                                                       c->sample_rate,
+                                                       audio_inbuf_samples);
+            if (encoder_queue[i].audio == NULL) {
+                ffmpegdrv_encoder_free_queue();
+                return;
+            }
+        }
+    }
+
+    encoder_head = 0;
+    encoder_tail = 0;
+    encoder_count = 0;
+    encoder_quit = 0;
+    encoder_failed = 0;
+    stat_video_frames = 0;
+    stat_audio_frames = 0;
+    stat_dropped = 0;
+    stat_waits = 0;
+    stat_peak = 0;
+
+    encoder_lock = archdep_mutex_new();
+    encoder_cond_job = archdep_cond_new();
+    encoder_cond_slot = archdep_cond_new();
+    encoder_thread = archdep_thread_create(ffmpegdrv_encoder_main, NULL);
+    if (encoder_thread == NULL) {
+        log_debug("ffmpegdrv: Cannot start encoder thread, encoding in the emulation thread");
+        archdep_cond_destroy(encoder_cond_slot);
+        archdep_cond_destroy(encoder_cond_job);
+        archdep_mutex_destroy(encoder_lock);
+        encoder_cond_slot = NULL;
+        encoder_cond_job = NULL;
+        encoder_lock = NULL;
+        ffmpegdrv_encoder_free_queue();
+        return;
+    }
+    encoder_running = 1;
+}
+
+/* Get the next free queue slot, or NULL to drop a video frame.  */
+static encoder_job_t *ffmpegdrv_encoder_get_slot(int may_drop)
+{
+    encoder_job_t *job;
+
+    archdep_mutex_lock(encoder_lock);
+    if (encoder_count == encoder_slots) {
+        if (may_drop) {
+            stat_dropped++;
+            archdep_mutex_unlock(encoder_lock);
+            return NULL;
+        }
+        stat_waits++;
+        while (encoder_count == encoder_slots) {
+            archdep_cond_wait(encoder_cond_slot, encoder_lock);
+        }
+    }
+    job = &encoder_queue[encoder_head];
+    archdep_mutex_unlock(encoder_lock);
+
+    /* the slot at the head stays ours until it is queued */
+    return job;
+}
+
+static void ffmpegdrv_encoder_queue_job(void)
+{
+    archdep_mutex_lock(encoder_lock);
+    encoder_head = (encoder_head + 1) % encoder_slots;
+    encoder_count++;
+    if (encoder_count > stat_peak) {
+        stat_peak = encoder_count;
+    }
+    archdep_cond_signal(encoder_cond_job);
+    archdep_mutex_unlock(encoder_lock);
+}
+
+static int ffmpegdrv_encoder_queue_video(screenshot_t *screenshot, int64_t pts)
+{
+    encoder_job_t *job;
+    const uint8_t *src;
+    int y;
+
+    job = ffmpegdrv_encoder_get_slot(encoder_drop_frames);
+    if (job == NULL) {
+        return 0;
+    }
+
+    src = ffmpegdrv_visible_area(screenshot);
+    for (y = 0; y < video_height; y++) {
+        memcpy(job->pixels + y * video_width, src, (size_t)video_width);
+        src += screenshot->draw_buffer_line_size;
+    }
+    ffmpegdrv_fill_rgb_table(screenshot, job->rgb);
+    job->type = ENCODER_JOB_VIDEO;
+    job->pts = pts;
+    stat_video_frames++;
+
+    ffmpegdrv_encoder_queue_job();
+    return 0;
+}
+
+static int ffmpegdrv_encoder_queue_audio(int64_t pts)
+{
+    encoder_job_t *job;
+    AVFrame *spare;
+
+    job = ffmpegdrv_encoder_get_slot(0);
+
+    /* hand over the filled frame, carry on in the spare one */
+    spare = job->audio;
+    job->audio = audio_st.tmp_frame;
+    audio_st.tmp_frame = spare;
+    ffmpegdrv_audio_in.buffer = (int16_t *)spare->data[0];
+
+    job->type = ENCODER_JOB_AUDIO;
+    job->pts = pts;
+    stat_audio_frames++;
+
+    ffmpegdrv_encoder_queue_job();
+    return 0;
+}
+
+/* triggered by screenshot_record */
+static int ffmpegdrv_record(screenshot_t *screenshot)
+{
+    static uint8_t rgb[256 * 3];
+    int64_t pts;
+
+    if (audio_init_done && video_init_done && !file_init_done) {
+        ffmpegdrv_init_file();
+    }
+
+    if (video_st.st == NULL || !file_init_done) {
+        return 0;
+    }
+
+   if (audio_st.st && video_st.next_pts > audio_st.next_pts) {
+        /* drop this frame */
+        return 0;
+    }
+
+    framecounter++;
+    if (video_halve_framerate && (framecounter & 1)) {
+        /* drop every second frame */
+        return 0;
+    }
+
+    pts = video_st.next_pts++;
+
+    if (encoder_running) {
+        if (encoder_failed) {
+            return -1;
+        }
+        return ffmpegdrv_encoder_queue_video(screenshot, pts);
+    }
+
+    ffmpegdrv_fill_rgb_table(screenshot, rgb);
+    return ffmpegdrv_encode_video(ffmpegdrv_visible_area(screenshot),
+                                  (int)screenshot->draw_buffer_line_size,
+                                  rgb, pts);
+}
+
 static int ffmpegdrv_write(screenshot_t *screenshot)
 {
     return 0;
@@ -191,7 +191,7 @@ void hvsc_text_file_init_handle(hvsc_text_file_t *handle)
  */
 bool hvsc_text_file_open(const char *path, hvsc_text_file_t *handle)
 {
-    printf("%s(): opening '%s'\n", __func__, path);
+    hvsc_dbg("opening '%s'\n", path);
     hvsc_text_file_init_handle(handle);
 
     handle->fp = fopen(path, "rb");
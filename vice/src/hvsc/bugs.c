@@ -38,6 +38,7 @@
 
 #include "hvsc_defs.h"
 #include "base.h"
+#include "index.h"
 
 #include "bugs.h"
 
@@ -170,7 +171,19 @@ bool hvsc_bugs_open(const char *psid, hvsc_bugs_t *handle)
         return false;
     }
 
-    /* find the entry */
+    /* find the entry, via the index if possible */
+    switch (hvsc_index_seek_path(&(handle->bugs), handle->psid_path)) {
+        case 1:
+            hvsc_dbg("Found '%s' at line %ld\n", handle->psid_path,
+                    handle->bugs.lineno);
+            return bugs_parse(handle);
+        case 0:
+            hvsc_bugs_close(handle);
+            return false;
+        default:
+            break;
+    }
+
     while (true) {
         const char *line;
 
@@ -305,6 +305,13 @@ const char *hvsc_strerror(int n);
 void        hvsc_perror(const char *prefix);
 
 
+/*
+ * index.c stuff
+ */
+
+bool        hvsc_set_index_path(const char *path);
+
+
 /*
  * sldb.c stuff
  */
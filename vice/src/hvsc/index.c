@@ -0,0 +1,850 @@
+/* vim: set et ts=4 sw=4 sts=4 fdm=marker syntax=c.doxygen: */
+
+/** \file   src/lib/index.c
+ * \brief   On-disk lookup indexes for the SLDB and STIL
+ *
+ * Looking up an entry in Songlengths.md5 or STIL.txt used to mean scanning
+ * the text file from the start for every query. This module builds, once per
+ * text file, a small binary index of the lines that start an entry:
+ *
+ *  - a table of MD5 digests, sorted by digest
+ *  - a table of FNV-1a hashes of PSID paths, sorted by hash
+ *
+ * Each table entry holds the file offset and line number of its line, so a
+ * query is a binary search followed by a single seek into the text file.
+ *
+ * When an index directory has been set with hvsc_set_index_path(), the index
+ * is written there and memory mapped on later runs. The index records the
+ * size and modification time of its text file and is rebuilt automatically
+ * when either changes. Without an index directory the index is only kept in
+ * memory for the lifetime of the process.
+ */
+
+/*
+ *  HVSClib - a library to work with High Voltage SID Collection files
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.*
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#if !defined(_WIN32) && !defined(_WIN64)
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+#endif
+
+#include "hvsc.h"
+
+#include "hvsc_defs.h"
+#include "base.h"
+
+#include "index.h"
+
+
+/** \brief  Magic bytes at the start of an index file
+ */
+#define INDEX_MAGIC         "HVSCIDX"
+
+/** \brief  Index file format version
+ *
+ * Bump this whenever the layout of the index changes.
+ */
+#define INDEX_VERSION       1
+
+/** \brief  Byte order marker, an index written on another host is rebuilt
+ */
+#define INDEX_BYTEORDER     0x01020304
+
+/** \brief  Number of text files that can be indexed at the same time
+ *
+ * The SLDB and STIL, with room to spare.
+ */
+#define INDEX_SLOTS         4
+
+
+/** \brief  Index header
+ *
+ * Followed by `md5_count` index_md5_t entries and `path_count` index_path_t
+ * entries.
+ */
+typedef struct index_header_s {
+    char        magic[8];       /**< INDEX_MAGIC */
+    uint32_t    version;        /**< INDEX_VERSION */
+    uint32_t    byteorder;      /**< INDEX_BYTEORDER */
+    uint64_t    source_size;    /**< size of the indexed text file */
+    int64_t     source_mtime;   /**< modification time of the text file */
+    uint32_t    md5_count;      /**< number of MD5 entries */
+    uint32_t    path_count;     /**< number of path entries */
+} index_header_t;
+
+
+/** \brief  MD5 index entry
+ */
+typedef struct index_md5_s {
+    uint8_t     digest[HVSC_DIGEST_SIZE];   /**< MD5 digest */
+    uint32_t    offset;                     /**< offset of the line */
+    uint32_t    lineno;                     /**< line number of the line */
+} index_md5_t;
+
+
+/** \brief  Path index entry
+ */
+typedef struct index_path_s {
+    uint64_t    hash;       /**< FNV-1a hash of the path */
+    uint32_t    offset;     /**< offset of the line */
+    uint32_t    lineno;     /**< line number of the line */
+} index_path_t;
+
+
+/** \brief  Index of a text file
+ */
+typedef struct index_s {
+    char *                  source;         /**< path of the text file */
+    uint64_t                source_size;    /**< size of the text file */
+    int64_t                 source_mtime;   /**< mtime of the text file */
+    void *                  block;          /**< index data */
+    size_t                  block_size;     /**< size of the index data */
+    bool                    mapped;         /**< \a block is memory mapped */
+    const index_md5_t *     md5;            /**< MD5 table */
+    size_t                  md5_count;      /**< number of MD5 entries */
+    const index_path_t *    paths;          /**< path table */
+    size_t                  path_count;     /**< number of path entries */
+} index_t;
+
+
+/** \brief  Loaded indexes
+ */
+static index_t indexes[INDEX_SLOTS];
+
+/** \brief  Directory to store index files in, `NULL` to keep them in memory
+ */
+static char *index_dir = NULL;
+
+
+/** \brief  Calculate FNV-1a hash of \a len bytes of \a s
+ *
+ * \param[in]   s   string
+ * \param[in]   len length of \a s
+ *
+ * \return  hash
+ */
+static uint64_t index_hash(const char *s, size_t len)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        hash ^= (uint8_t)s[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+
+/** \brief  Parse the text representation of an MD5 digest
+ *
+ * \param[in]   s       32 hexadecimal digits
+ * \param[out]  digest  digest
+ *
+ * \return  bool
+ */
+static bool index_parse_digest(const char *s, uint8_t *digest)
+{
+    int i;
+
+    for (i = 0; i < HVSC_DIGEST_SIZE * 2; i++) {
+        int ch = (unsigned char)s[i];
+        int nybble;
+
+        if (ch >= '0' && ch <= '9') {
+            nybble = ch - '0';
+        } else if (ch >= 'a' && ch <= 'f') {
+            nybble = ch - 'a' + 10;
+        } else if (ch >= 'A' && ch <= 'F') {
+            nybble = ch - 'A' + 10;
+        } else {
+            return false;
+        }
+        if (i & 1) {
+            digest[i / 2] |= (uint8_t)nybble;
+        } else {
+            digest[i / 2] = (uint8_t)(nybble << 4);
+        }
+    }
+    return true;
+}
+
+
+/** \brief  Get size and modification time of \a path
+ *
+ * \param[in]   path    path to file
+ * \param[out]  size    size of file
+ * \param[out]  mtime   modification time of file
+ *
+ * \return  bool
+ */
+static bool index_stat(const char *path, uint64_t *size, int64_t *mtime)
+{
+    struct stat st;
+
+    if (stat(path, &st) != 0) {
+        hvsc_errno = HVSC_ERR_IO;
+        return false;
+    }
+    *size = (uint64_t)st.st_size;
+    *mtime = (int64_t)st.st_mtime;
+    return true;
+}
+
+
+/** \brief  Free the data of \a index
+ *
+ * \param[in,out]   index   index
+ */
+static void index_release(index_t *index)
+{
+    if (index->block != NULL) {
+#if !defined(_WIN32) && !defined(_WIN64)
+        if (index->mapped) {
+            munmap(index->block, index->block_size);
+        } else {
+            free(index->block);
+        }
+#else
+        free(index->block);
+#endif
+    }
+    if (index->source != NULL) {
+        free(index->source);
+    }
+    memset(index, 0, sizeof *index);
+}
+
+
+/** \brief  Validate index data in \a block and point \a index at its tables
+ *
+ * \param[in,out]   index   index
+ * \param[in]       block   index data
+ * \param[in]       size    size of \a block
+ *
+ * \return  false when \a block doesn't contain a valid index for the current
+ *          state of the text file
+ */
+static bool index_attach(index_t *index, void *block, size_t size)
+{
+    const index_header_t *header = block;
+    size_t md5_size;
+    size_t path_size;
+
+    if (size < sizeof *header
+            || memcmp(header->magic, INDEX_MAGIC, sizeof INDEX_MAGIC) != 0
+            || header->version != INDEX_VERSION
+            || header->byteorder != INDEX_BYTEORDER
+            || header->source_size != index->source_size
+            || header->source_mtime != index->source_mtime) {
+        return false;
+    }
+
+    md5_size = header->md5_count * sizeof *(index->md5);
+    path_size = header->path_count * sizeof *(index->paths);
+    if (sizeof *header + md5_size + path_size != size) {
+        return false;
+    }
+
+    index->block = block;
+    index->block_size = size;
+    index->md5 = (const index_md5_t *)((const uint8_t *)block + sizeof *header);
+    index->md5_count = header->md5_count;
+    index->paths = (const index_path_t *)((const uint8_t *)block
+            + sizeof *header + md5_size);
+    index->path_count = header->path_count;
+    return true;
+}
+
+
+/** \brief  Get path of the index file for text file \a source
+ *
+ * \param[in]   source  path to text file
+ *
+ * \return  heap-allocated path or `NULL` when no index directory is set
+ */
+static char *index_file_path(const char *source)
+{
+    const char *name;
+    char *file;
+    char *path;
+    size_t len;
+
+    if (index_dir == NULL) {
+        return NULL;
+    }
+
+    name = source + strlen(source);
+    while (name > source && name[-1] != '/' && name[-1] != '\\') {
+        name--;
+    }
+
+    len = strlen(name);
+    file = malloc(len + 5);
+    if (file == NULL) {
+        hvsc_errno = HVSC_ERR_OOM;
+        return NULL;
+    }
+    memcpy(file, name, len);
+    memcpy(file + len, ".idx", 5);
+
+    path = hvsc_paths_join(index_dir, file);
+    free(file);
+    return path;
+}
+
+
+/** \brief  Try to load the index file for \a index
+ *
+ * \param[in,out]   index   index, with the source members set
+ *
+ * \return  bool
+ */
+static bool index_load(index_t *index)
+{
+    char *path;
+    void *block;
+    size_t size;
+#if !defined(_WIN32) && !defined(_WIN64)
+    struct stat st;
+    int fd;
+#else
+    uint8_t *data;
+    long result;
+#endif
+
+    path = index_file_path(index->source);
+    if (path == NULL) {
+        return false;
+    }
+
+#if !defined(_WIN32) && !defined(_WIN64)
+    fd = open(path, O_RDONLY);
+    free(path);
+    if (fd < 0) {
+        return false;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    size = (size_t)st.st_size;
+    block = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (block == MAP_FAILED) {
+        return false;
+    }
+    if (!index_attach(index, block, size)) {
+        munmap(block, size);
+        return false;
+    }
+    index->mapped = true;
+#else
+    result = hvsc_read_file(&data, path);
+    free(path);
+    if (result <= 0) {
+        return false;
+    }
+    block = data;
+    size = (size_t)result;
+    if (!index_attach(index, block, size)) {
+        free(block);
+        return false;
+    }
+#endif
+    hvsc_dbg("loaded index for '%s'\n", index->source);
+    return true;
+}
+
+
+/** \brief  Write \a index to its index file
+ *
+ * Failure is not an error, the index is still usable from memory.
+ *
+ * \param[in]   index   index
+ */
+static void index_save(const index_t *index)
+{
+    char *path;
+    char *tmp;
+    size_t len;
+    FILE *fp;
+    bool ok;
+
+    path = index_file_path(index->source);
+    if (path == NULL) {
+        return;
+    }
+    len = strlen(path);
+    tmp = malloc(len + 5);
+    if (tmp == NULL) {
+        free(path);
+        return;
+    }
+    memcpy(tmp, path, len);
+    memcpy(tmp + len, ".tmp", 5);
+
+    /* write to a temporary file first, so a concurrent reader never sees a
+     * partially written index */
+    fp = fopen(tmp, "wb");
+    if (fp != NULL) {
+        ok = fwrite(index->block, 1, index->block_size, fp)
+            == index->block_size;
+        ok = (fclose(fp) == 0) && ok;
+        if (ok) {
+            remove(path);
+            ok = rename(tmp, path) == 0;
+        }
+        if (!ok) {
+            remove(tmp);
+        }
+    }
+    free(tmp);
+    free(path);
+}
+
+
+/** \brief  Comparison function for qsort() of the MD5 table
+ */
+static int index_md5_cmp(const void *p1, const void *p2)
+{
+    const index_md5_t *e1 = p1;
+    const index_md5_t *e2 = p2;
+    int result;
+
+    result = memcmp(e1->digest, e2->digest, HVSC_DIGEST_SIZE);
+    if (result == 0) {
+        /* keep file order for duplicates, the first one wins */
+        result = (e1->offset > e2->offset) - (e1->offset < e2->offset);
+    }
+    return result;
+}
+
+
+/** \brief  Comparison function for qsort() of the path table
+ */
+static int index_path_cmp(const void *p1, const void *p2)
+{
+    const index_path_t *e1 = p1;
+    const index_path_t *e2 = p2;
+
+    if (e1->hash != e2->hash) {
+        return e1->hash < e2->hash ? -1 : 1;
+    }
+    return (e1->offset > e2->offset) - (e1->offset < e2->offset);
+}
+
+
+/** \brief  Build \a index by scanning its text file
+ *
+ * Indexed are lines starting with an MD5 digest followed by '=' (SLDB
+ * entries), lines starting with "; /" (SLDB path comments) and lines starting
+ * with '/' (STIL entries).
+ *
+ * \param[in,out]   index   index, with the source members set
+ *
+ * \return  bool
+ */
+static bool index_build(index_t *index)
+{
+    uint8_t *data;
+    long size;
+    size_t pos;
+    size_t next;
+    uint32_t lineno = 0;
+    size_t md5_count = 0;
+    size_t path_count = 0;
+    size_t md5_max = 1024;
+    size_t path_max = 1024;
+    index_md5_t *md5;
+    index_path_t *paths;
+    index_header_t *header;
+    uint8_t *block;
+    size_t block_size;
+
+    size = hvsc_read_file(&data, index->source);
+    if (size < 0) {
+        return false;
+    }
+    if ((uint64_t)size != index->source_size || (uint64_t)size > UINT32_MAX) {
+        /* changed while reading, or too large for 32-bit offsets */
+        free(data);
+        return false;
+    }
+
+    md5 = malloc(md5_max * sizeof *md5);
+    paths = malloc(path_max * sizeof *paths);
+    if (md5 == NULL || paths == NULL) {
+        hvsc_errno = HVSC_ERR_OOM;
+        goto fail;
+    }
+
+    for (pos = 0; pos < (size_t)size; pos = next) {
+        const char *line = (const char *)data + pos;
+        const uint8_t *eol;
+        size_t len;
+
+        eol = memchr(data + pos, '\n', (size_t)size - pos);
+        if (eol != NULL) {
+            len = (size_t)(eol - (data + pos));
+            next = pos + len + 1;
+        } else {
+            len = (size_t)size - pos;
+            next = (size_t)size;
+        }
+        if (len > 0 && line[len - 1] == '\r') {
+            len--;
+        }
+        lineno++;
+
+        if (len > HVSC_DIGEST_SIZE * 2 && line[HVSC_DIGEST_SIZE * 2] == '='
+                && isxdigit((unsigned char)line[0])) {
+            if (md5_count == md5_max) {
+                index_md5_t *tmp = realloc(md5, md5_max * 2 * sizeof *md5);
+                if (tmp == NULL) {
+                    hvsc_errno = HVSC_ERR_OOM;
+                    goto fail;
+                }
+                md5 = tmp;
+                md5_max *= 2;
+            }
+            if (index_parse_digest(line, md5[md5_count].digest)) {
+                md5[md5_count].offset = (uint32_t)pos;
+                md5[md5_count].lineno = lineno;
+                md5_count++;
+            }
+        } else if ((len > 0 && line[0] == '/')
+                || (len > 2 && line[0] == ';' && line[1] == ' '
+                    && line[2] == '/')) {
+            size_t skip = line[0] == ';' ? 2 : 0;
+
+            if (path_count == path_max) {
+                index_path_t *tmp = realloc(paths,
+                        path_max * 2 * sizeof *paths);
+                if (tmp == NULL) {
+                    hvsc_errno = HVSC_ERR_OOM;
+                    goto fail;
+                }
+                paths = tmp;
+                path_max *= 2;
+            }
+            paths[path_count].hash = index_hash(line + skip, len - skip);
+            paths[path_count].offset = (uint32_t)pos;
+            paths[path_count].lineno = lineno;
+            path_count++;
+        }
+    }
+    free(data);
+    data = NULL;
+
+    qsort(md5, md5_count, sizeof *md5, index_md5_cmp);
+    qsort(paths, path_count, sizeof *paths, index_path_cmp);
+
+    /* pack header and tables into a single block, as stored on disk */
+    block_size = sizeof *header + md5_count * sizeof *md5
+        + path_count * sizeof *paths;
+    block = malloc(block_size);
+    if (block == NULL) {
+        hvsc_errno = HVSC_ERR_OOM;
+        goto fail;
+    }
+    header = (index_header_t *)block;
+    memset(header, 0, sizeof *header);
+    memcpy(header->magic, INDEX_MAGIC, sizeof INDEX_MAGIC);
+    header->version = INDEX_VERSION;
+    header->byteorder = INDEX_BYTEORDER;
+    header->source_size = index->source_size;
+    header->source_mtime = index->source_mtime;
+    header->md5_count = (uint32_t)md5_count;
+    header->path_count = (uint32_t)path_count;
+    memcpy(block + sizeof *header, md5, md5_count * sizeof *md5);
+    memcpy(block + sizeof *header + md5_count * sizeof *md5, paths,
+            path_count * sizeof *paths);
+    free(md5);
+    free(paths);
+
+    index_attach(index, block, block_size);
+    hvsc_dbg("built index for '%s': %" PRI_SIZE_T " digests, %" PRI_SIZE_T
+            " paths\n", index->source, md5_count, path_count);
+    return true;
+
+fail:
+    free(data);
+    free(md5);
+    free(paths);
+    return false;
+}
+
+
+/** \brief  Get an up-to-date index for text file \a source
+ *
+ * \param[in]   source  path to text file
+ *
+ * \return  index or `NULL` when no index could be loaded or built
+ */
+static const index_t *index_get(const char *source)
+{
+    index_t *index = NULL;
+    uint64_t size;
+    int64_t mtime;
+    int i;
+
+    if (!index_stat(source, &size, &mtime)) {
+        return NULL;
+    }
+
+    for (i = 0; i < INDEX_SLOTS; i++) {
+        if (indexes[i].source != NULL && strcmp(indexes[i].source, source) == 0) {
+            index = &indexes[i];
+            if (index->block != NULL && index->source_size == size
+                    && index->source_mtime == mtime) {
+                return index;
+            }
+            break;
+        }
+    }
+    if (index == NULL) {
+        for (i = 0; i < INDEX_SLOTS && indexes[i].source != NULL; i++) {
+            /* NOP */
+        }
+        if (i == INDEX_SLOTS) {
+            return NULL;
+        }
+        index = &indexes[i];
+    }
+
+    index_release(index);
+    index->source = hvsc_strdup(source);
+    if (index->source == NULL) {
+        return NULL;
+    }
+    index->source_size = size;
+    index->source_mtime = mtime;
+
+    if (index_load(index)) {
+        return index;
+    }
+    if (index_build(index)) {
+        index_save(index);
+        return index;
+    }
+    index_release(index);
+    return NULL;
+}
+
+
+/** \brief  Read the line at \a offset in \a handle
+ *
+ * \param[in,out]   handle  text file handle
+ * \param[in]       offset  offset of line
+ * \param[in]       lineno  line number of line
+ *
+ * \return  line or `NULL` on failure
+ */
+static const char *index_read_line(hvsc_text_file_t *handle, uint32_t offset,
+                                   uint32_t lineno)
+{
+    const char *line;
+
+    if (fseek(handle->fp, (long)offset, SEEK_SET) != 0) {
+        hvsc_errno = HVSC_ERR_IO;
+        return NULL;
+    }
+    line = hvsc_text_file_read(handle);
+    if (line != NULL) {
+        handle->lineno = (long)lineno;
+    }
+    return line;
+}
+
+
+/** \brief  Rewind \a handle so the caller can fall back to a linear scan
+ *
+ * \param[in,out]   handle  text file handle
+ *
+ * \return  -1
+ */
+static int index_fallback(hvsc_text_file_t *handle)
+{
+    rewind(handle->fp);
+    handle->lineno = 0;
+    return -1;
+}
+
+
+/** \brief  Position \a handle on the entry line for \a path
+ *
+ * Looks up \a path in the STIL entry lines ("/path") or SLDB comment lines
+ * ("; /path") of the text file opened in \a handle. On success the line has
+ * been read into \a handle and the file is positioned right after it, exactly
+ * as if the file had been scanned up to that line.
+ *
+ * \param[in,out]   handle  text file handle
+ * \param[in]       path    path to the PSID file, relative to the HVSC root
+ *
+ * \return  1 when found, 0 when not found, -1 when no index is available and
+ *          the caller should scan the file itself
+ */
+int hvsc_index_seek_path(hvsc_text_file_t *handle, const char *path)
+{
+    const index_t *index;
+    size_t plen;
+    uint64_t hash;
+    size_t lo;
+    size_t hi;
+
+    index = index_get(handle->path);
+    if (index == NULL) {
+        return index_fallback(handle);
+    }
+
+    plen = strlen(path);
+    hash = index_hash(path, plen);
+
+    /* find first entry with a matching hash */
+    lo = 0;
+    hi = index->path_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (index->paths[mid].hash < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    /* check candidates against the text, in case of hash collisions */
+    for (; lo < index->path_count && index->paths[lo].hash == hash; lo++) {
+        const char *line;
+
+        line = index_read_line(handle, index->paths[lo].offset,
+                index->paths[lo].lineno);
+        if (line == NULL) {
+            return index_fallback(handle);
+        }
+        if (*line == ';') {
+            line += 2;
+        }
+        if (strcmp(line, path) == 0) {
+            return 1;
+        }
+    }
+
+    hvsc_errno = HVSC_ERR_NOT_FOUND;
+    return 0;
+}
+
+
+/** \brief  Position \a handle on the SLDB entry line for \a digest
+ *
+ * On success the line has been read into \a handle.
+ *
+ * \param[in,out]   handle  text file handle
+ * \param[in]       digest  string representation of the MD5 digest (32 bytes)
+ *
+ * \return  1 when found, 0 when not found, -1 when no index is available and
+ *          the caller should scan the file itself
+ */
+int hvsc_index_seek_md5(hvsc_text_file_t *handle, const char *digest)
+{
+    const index_t *index;
+    uint8_t key[HVSC_DIGEST_SIZE];
+    const char *line;
+    size_t lo;
+    size_t hi;
+
+    if (!index_parse_digest(digest, key)) {
+        hvsc_errno = HVSC_ERR_INVALID;
+        return 0;
+    }
+
+    index = index_get(handle->path);
+    if (index == NULL) {
+        return index_fallback(handle);
+    }
+
+    lo = 0;
+    hi = index->md5_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (memcmp(index->md5[mid].digest, key, HVSC_DIGEST_SIZE) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == index->md5_count
+            || memcmp(index->md5[lo].digest, key, HVSC_DIGEST_SIZE) != 0) {
+        hvsc_errno = HVSC_ERR_NOT_FOUND;
+        return 0;
+    }
+
+    line = index_read_line(handle, index->md5[lo].offset,
+            index->md5[lo].lineno);
+    if (line == NULL) {
+        return index_fallback(handle);
+    }
+    return 1;
+}
+
+
+/** \brief  Set directory to store index files in
+ *
+ * Without an index directory indexes are built in memory once per process.
+ *
+ * \param[in]   path    directory, must exist, or `NULL` to not store indexes
+ *
+ * \return  bool
+ */
+bool hvsc_set_index_path(const char *path)
+{
+    if (index_dir != NULL) {
+        free(index_dir);
+        index_dir = NULL;
+    }
+    if (path != NULL) {
+        index_dir = hvsc_strdup(path);
+        if (index_dir == NULL) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/** \brief  Free all indexes and the index directory
+ */
+void hvsc_index_free(void)
+{
+    int i;
+
+    for (i = 0; i < INDEX_SLOTS; i++) {
+        index_release(&indexes[i]);
+    }
+    hvsc_set_index_path(NULL);
+}
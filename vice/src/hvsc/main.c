@@ -40,6 +40,7 @@
 #include "base.h"
 #include "stil.h"
 #include "sldb.h"
+#include "index.h"
 
 #include "main.h"
 
@@ -83,6 +84,7 @@ bool hvsc_init(const char *path)
 void hvsc_exit(void)
 {
     hvsc_free_paths();
+    hvsc_index_free();
 }
 
 
@@ -40,6 +40,7 @@
 
 #include "hvsc_defs.h"
 #include "base.h"
+#include "index.h"
 
 #include "sldb.h"
 
@@ -107,11 +108,25 @@ static char *find_sldb_entry_md5(const char *digest)
 {
     hvsc_text_file_t handle;
     const char *line;
+    char *s;
 
     if (!hvsc_text_file_open(hvsc_sldb_path, &handle)) {
         return NULL;
     }
 
+    switch (hvsc_index_seek_md5(&handle, digest)) {
+        case 1:
+            s = hvsc_strdup(handle.buffer);
+            hvsc_text_file_close(&handle);
+            return s;
+        case 0:
+            hvsc_text_file_close(&handle);
+            return NULL;
+        default:
+            /* no index, scan the file */
+            break;
+    }
+
     while (true) {
         line = hvsc_text_file_read(&handle);
         if (line == NULL) {
@@ -123,7 +138,7 @@ static char *find_sldb_entry_md5(const char *digest)
 #endif
         if (memcmp(digest, line, HVSC_DIGEST_SIZE * 2) == 0) {
             /* copy the current line before closing the file */
-            char *s = hvsc_strdup(handle.buffer);
+            s = hvsc_strdup(handle.buffer);
             hvsc_text_file_close(&handle);
             if (s == NULL) {
                 return NULL;
@@ -150,11 +165,31 @@ static char *find_sldb_entry_txt(const char *path)
     hvsc_text_file_t handle;
     size_t plen;
     const char *line;
+    char *s;
 
     if (!hvsc_text_file_open(hvsc_sldb_path, &handle)) {
         return NULL;
     }
 
+    /* the index positions the file right after the "; /path" line */
+    switch (hvsc_index_seek_path(&handle, path)) {
+        case 1:
+            line = hvsc_text_file_read(&handle);
+            if (line == NULL) {
+                hvsc_text_file_close(&handle);
+                return NULL;
+            }
+            s = hvsc_strdup(handle.buffer);
+            hvsc_text_file_close(&handle);
+            return s;
+        case 0:
+            hvsc_text_file_close(&handle);
+            return NULL;
+        default:
+            /* no index, scan the file */
+            break;
+    }
+
     plen = strlen(path);
 
     while (true) {
@@ -168,7 +203,6 @@ static char *find_sldb_entry_txt(const char *path)
         if (*line == ';') {
             if (strncmp(path, line + 2, plen) == 0) {
                 /* next line contains the actual entry */
-                char *s;
                 line = hvsc_text_file_read(&handle);
                 if (line == NULL) {
                     hvsc_text_file_close(&handle);
@@ -36,6 +36,7 @@
 
 #include "hvsc_defs.h"
 #include "base.h"
+#include "index.h"
 
 #include "stil.h"
 
@@ -525,7 +526,19 @@ bool hvsc_stil_open(const char *psid, hvsc_stil_t *handle)
         return false;
     }
 
-    /* find the entry */
+    /* find the entry, via the index if possible */
+    switch (hvsc_index_seek_path(&(handle->stil), handle->psid_path)) {
+        case 1:
+            hvsc_dbg("Found '%s' at line %ld\n", handle->psid_path,
+                    handle->stil.lineno);
+            return true;
+        case 0:
+            hvsc_stil_close(handle);
+            return false;
+        default:
+            break;
+    }
+
     while (true) {
         line = hvsc_text_file_read(&(handle->stil));
         if (line == NULL) {
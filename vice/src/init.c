@@ -29,6 +29,7 @@
 
 #include "archdep.h"
 #include "attach.h"
+#include "capture.h"
 #include "cmdline.h"
 #include "console.h"
 #include "debug.h"
@@ -47,6 +48,7 @@
 #include "palette.h"
 #include "ram.h"
 #include "resources.h"
+#include "rewind.h"
 #include "romset.h"
 #include "screenshot.h"
 #include "signals.h"
@@ -127,6 +129,12 @@ int init_resources(void)
         init_resource_fail("monitor");
         return -1;
     }
+    if (machine_class != VICE_MACHINE_VSID) {
+        if (rewind_resources_init() < 0) {
+            init_resource_fail("rewind");
+            return -1;
+        }
+    }
 #ifdef HAVE_NETWORK
     if (monitor_network_resources_init() < 0) {
         init_resource_fail("MONITOR_NETWORK");
@@ -204,6 +212,14 @@ int init_cmdline_options(void)
             init_cmdline_options_fail("RAM");
             return -1;
         }
+        if (rewind_cmdline_options_init() < 0) {
+            init_cmdline_options_fail("rewind");
+            return -1;
+        }
+        if (capture_cmdline_options_init() < 0) {
+            init_cmdline_options_fail("capture");
+            return -1;
+        }
     }
 #ifdef HAVE_NETWORK
     if (monitor_network_cmdline_options_init() < 0) {
@@ -224,7 +240,7 @@ int init_main(void)
 
     romset_init();
 
-    if (!video_disabled_mode) {
+    if (!video_disabled_mode || capture_enabled()) {
         palette_init();
     }
 
@@ -138,6 +138,12 @@ static int cmdline_limitcycles(const char *param, void *extra_param)
     return 0;
 }
 
+static int cmdline_seed(const char *param, void *extra_param)
+{
+    lib_rand_seed(strtoul(param, NULL, 0));
+    return 0;
+}
+
 static int cmdline_autostart(const char *param, void *extra_param)
 {
     cmdline_free_autostart_string();
@@ -216,6 +222,9 @@ static const cmdline_option_t common_cmdline_options[] =
     { "-limitcycles", CALL_FUNCTION, CMDLINE_ATTRIB_NEED_ARGS,
       cmdline_limitcycles, NULL, NULL, NULL,
       "<value>", "Specify number of cycles to run before quitting with an error." },
+    { "-seed", CALL_FUNCTION, CMDLINE_ATTRIB_NEED_ARGS,
+      cmdline_seed, NULL, NULL, NULL,
+      "<value>", "Set random seed (for testing)" },
     { "-console", CALL_FUNCTION, CMDLINE_ATTRIB_NONE,
       cmdline_console, NULL, NULL, NULL,
       NULL, "Console mode (for music playback)" },
@@ -1253,6 +1253,12 @@ void lib_init_rand(void)
     srand((unsigned int)time(NULL));
 }
 
+/* set a fixed random seed, so runs can be repeated exactly (for testing) */
+void lib_rand_seed(unsigned long seed)
+{
+    srand((unsigned int)seed);
+}
+
 unsigned int lib_unsigned_rand(unsigned int min, unsigned int max)
 {
     return min + (rand() / ((RAND_MAX / (max - min + 1)) + 1));
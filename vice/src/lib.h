@@ -42,6 +42,7 @@
 #endif
 
 extern void lib_init_rand(void);
+extern void lib_rand_seed(unsigned long seed);
 extern unsigned int lib_unsigned_rand(unsigned int min, unsigned int max);
 extern float lib_float_rand(float min, float max);
 
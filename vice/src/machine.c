@@ -34,6 +34,7 @@
 #include "archdep.h"
 #include "attach.h"
 #include "autostart.h"
+#include "capture.h"
 #include "clkguard.h"
 #include "cmdline.h"
 #include "console.h"
@@ -57,6 +58,7 @@
 #include "network.h"
 #include "printer.h"
 #include "resources.h"
+#include "rewind.h"
 #include "romset.h"
 #include "screenshot.h"
 #include "sound.h"
@@ -97,6 +99,7 @@ static int jam_action = MACHINE_JAM_ACTION_DIALOG;
 int machine_keymap_index;
 static char *ExitScreenshotName = NULL;
 static char *ExitScreenshotName1 = NULL;
+static char *ExitSnapshotName = NULL;
 
 
 /** \brief  List of emulator names
@@ -288,6 +291,15 @@ static void screenshot_at_exit(void)
     }
 }
 
+static void snapshot_at_exit(void)
+{
+    if ((ExitSnapshotName != NULL) && (ExitSnapshotName[0] != 0)) {
+        if (machine_write_snapshot(ExitSnapshotName, 0, 0, 0) < 0) {
+            log_error(LOG_DEFAULT, "Cannot write exit snapshot `%s'.", ExitSnapshotName);
+        }
+    }
+}
+
 void machine_shutdown(void)
 {
     if (!machine_init_was_called) {
@@ -295,6 +307,8 @@ void machine_shutdown(void)
         return;
     }
 
+    snapshot_at_exit();
+    capture_shutdown();
     screenshot_at_exit();
     screenshot_shutdown();
 
@@ -324,6 +338,8 @@ void machine_shutdown(void)
 
     monitor_shutdown();
 
+    rewind_shutdown();
+
     console_close_all();
 
     cmdline_shutdown();
@@ -408,9 +424,17 @@ static int set_exit_screenshot_name1(const char *val, void *param)
     return 0;
 }
 
+static int set_exit_snapshot_name(const char *val, void *param)
+{
+    util_string_set(&ExitSnapshotName, val);
+    return 0;
+}
+
 static resource_string_t resources_string[] = {
     { "ExitScreenshotName", "", RES_EVENT_NO, NULL,
       &ExitScreenshotName, set_exit_screenshot_name, NULL },
+    { "ExitSnapshotName", "", RES_EVENT_NO, NULL,
+      &ExitSnapshotName, set_exit_snapshot_name, NULL },
     RESOURCE_STRING_LIST_END
 };
 
@@ -445,6 +469,7 @@ void machine_common_resources_shutdown(void)
 {
     lib_free(ExitScreenshotName);
     lib_free(ExitScreenshotName1);
+    lib_free(ExitSnapshotName);
 }
 
 static const cmdline_option_t cmdline_options_c128[] =
@@ -458,6 +483,9 @@ static const cmdline_option_t cmdline_options_c128[] =
     { "-exitscreenshotvicii", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
       NULL, NULL, "ExitScreenshotName1", NULL,
       "<Name>", "Set name of screenshot to save when emulator exits." },
+    { "-exitsnapshot", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "ExitSnapshotName", NULL,
+      "<Name>", "Set name of snapshot to save when emulator exits." },
     CMDLINE_LIST_END
 };
 
@@ -469,6 +497,9 @@ static const cmdline_option_t cmdline_options[] =
     { "-exitscreenshot", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
       NULL, NULL, "ExitScreenshotName", NULL,
       "<Name>", "Set name of screenshot to save when emulator exits." },
+    { "-exitsnapshot", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "ExitSnapshotName", NULL,
+      "<Name>", "Set name of snapshot to save when emulator exits." },
     CMDLINE_LIST_END
 };
 
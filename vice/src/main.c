@@ -111,11 +111,15 @@ int main_program(int argc, char **argv)
     /* Check for -config and -console before initializing the user interface.
        -config  => use specified configuration file
        -console => no user interface
+       -render  => no user interface either (VSID batch rendering)
+       -capture => no user interface either (headless movie capture)
     */
     DBG(("main:early cmdline(argc:%d)\n", argc));
     for (i = 0; i < argc; i++) {
 #ifndef __OS2__
-        if ((!strcmp(argv[i], "-console")) || (!strcmp(argv[i], "--console"))) {
+        if ((!strcmp(argv[i], "-console")) || (!strcmp(argv[i], "--console"))
+            || (machine_class == VICE_MACHINE_VSID && !strcmp(argv[i], "-render"))
+            || (machine_class != VICE_MACHINE_VSID && !strcmp(argv[i], "-capture"))) {
             console_mode = 1;
             video_disabled_mode = 1;
         } else
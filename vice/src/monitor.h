@@ -39,7 +39,9 @@ enum mon_int {
     MI_NONE = 0,
     MI_BREAK = 1 << 0,
     MI_WATCH = 1 << 1,
-    MI_STEP = 1 << 2
+    MI_STEP = 1 << 2,
+    MI_TRACE = 1 << 3,
+    MI_PROFILE = 1 << 4
 };
 
 enum t_memspace {
@@ -153,6 +155,8 @@ extern int monitor_force_import(MEMSPACE mem);
 extern void monitor_check_icount(uint16_t a);
 extern void monitor_check_icount_interrupt(void);
 extern void monitor_check_watchpoints(unsigned int lastpc, unsigned int pc);
+extern void monitor_cputrace_store(MEMSPACE mem, CLOCK clk);
+extern void monitor_profile_store(MEMSPACE mem, CLOCK clk);
 
 extern void monitor_cpu_type_set(const char *cpu_type);
 
@@ -71,6 +71,21 @@ static checkpoint_list_t *breakpoints[NUM_MEMSPACES];
 static checkpoint_list_t *watchpoints_load[NUM_MEMSPACES];
 static checkpoint_list_t *watchpoints_store[NUM_MEMSPACES];
 
+/* Which pages and addresses are covered by any checkpoint of a list, so
+   the lists only need to be walked for accesses that can hit.  Addresses
+   are taken modulo 64 KiB, which can only cause false hits.  */
+struct checkpoint_map_s {
+    uint8_t pages[0x100];
+    uint8_t addrs[0x10000 / 8];
+};
+typedef struct checkpoint_map_s checkpoint_map_t;
+
+#define CHECKPOINT_MAP_EXEC  0
+#define CHECKPOINT_MAP_LOAD  1
+#define CHECKPOINT_MAP_STORE 2
+
+static checkpoint_map_t *checkpoint_maps[NUM_MEMSPACES][3];
+
 
 void mon_breakpoint_init(void)
 {
@@ -140,8 +155,70 @@ static checkpoint_t *find_checkpoint(int brknum)
     return NULL;
 }
 
+static void checkpoint_map_update(checkpoint_map_t **pmap, checkpoint_list_t *list)
+{
+    checkpoint_map_t *map = *pmap;
+    unsigned int start, count, loc;
+
+    if (list == NULL) {
+        lib_free(map);
+        *pmap = NULL;
+        return;
+    }
+
+    if (map == NULL) {
+        map = *pmap = lib_malloc(sizeof(checkpoint_map_t));
+    }
+    memset(map, 0, sizeof(checkpoint_map_t));
+
+    for (; list != NULL; list = list->next) {
+        start = addr_location(list->checkpt->start_addr);
+        count = 1;
+        if (mon_is_valid_addr(list->checkpt->end_addr)) {
+            count = addr_mask(addr_location(list->checkpt->end_addr) - start) + 1;
+        }
+        if (count > 0x10000) {
+            count = 0x10000;
+        }
+        for (; count > 0; count--, start++) {
+            loc = start & 0xffff;
+            map->pages[loc >> 8] = 1;
+            map->addrs[loc >> 3] |= (uint8_t)(1 << (loc & 7));
+        }
+    }
+}
+
+/* Return whether an access can hit any checkpoint, without walking the
+   checkpoint lists.  */
+bool mon_breakpoint_check_map(MEMSPACE mem, unsigned int addr, MEMORY_OP op)
+{
+    checkpoint_map_t *map;
+
+    switch (op) {
+        case e_load:
+            map = checkpoint_maps[mem][CHECKPOINT_MAP_LOAD];
+            break;
+        case e_store:
+            map = checkpoint_maps[mem][CHECKPOINT_MAP_STORE];
+            break;
+        default:
+            map = checkpoint_maps[mem][CHECKPOINT_MAP_EXEC];
+            break;
+    }
+
+    addr &= 0xffff;
+
+    return map != NULL
+           && map->pages[addr >> 8]
+           && (map->addrs[addr >> 3] & (1 << (addr & 7)));
+}
+
 static void update_checkpoint_state(MEMSPACE mem)
 {
+    checkpoint_map_update(&checkpoint_maps[mem][CHECKPOINT_MAP_EXEC], breakpoints[mem]);
+    checkpoint_map_update(&checkpoint_maps[mem][CHECKPOINT_MAP_LOAD], watchpoints_load[mem]);
+    checkpoint_map_update(&checkpoint_maps[mem][CHECKPOINT_MAP_STORE], watchpoints_store[mem]);
+
     if (watchpoints_load[mem] != NULL || watchpoints_store[mem] != NULL) {
         monitor_mask[mem] |= MI_WATCH;
         mon_interfaces[mem]->toggle_watchpoints_func(
@@ -290,6 +367,36 @@ void mon_breakpoint_print_checkpoints(void)
     }
 }
 
+bool mon_breakpoint_get_info(int cp_num, mon_checkpoint_info_t *info)
+{
+    checkpoint_t *cp = find_checkpoint(cp_num);
+
+    if (!cp) {
+        return FALSE;
+    }
+
+    info->checknum = cp->checknum;
+    info->start_addr = cp->start_addr;
+    info->end_addr = cp->end_addr;
+    info->hit_count = cp->hit_count;
+    info->ignore_count = cp->ignore_count;
+    info->has_condition = cp->condition != NULL;
+    info->stop = cp->stop;
+    info->enabled = cp->enabled == e_ON;
+    info->check_load = cp->check_load;
+    info->check_store = cp->check_store;
+    info->check_exec = cp->check_exec;
+    info->temporary = cp->temporary;
+
+    return TRUE;
+}
+
+/* Highest checkpoint number handed out so far.  */
+int mon_breakpoint_last_checknum(void)
+{
+    return breakpoint_count - 1;
+}
+
 void mon_breakpoint_delete_checkpoint(int cp_num)
 {
     int i;
@@ -401,8 +508,13 @@ bool mon_breakpoint_check_checkpoint(MEMSPACE mem, unsigned int addr, unsigned i
     char is_loadstore = 0;
     const char *op_str;
     const char *action_str;
-    int monbank = mon_interfaces[mem]->current_bank;
+    int monbank;
+
+    if (!mon_breakpoint_check_map(mem, addr, op)) {
+        return FALSE;
+    }
 
+    monbank = mon_interfaces[mem]->current_bank;
     monitor_cpu = monitor_cpu_for_memspace[mem];
     instpc = new_addr(mem, (monitor_cpu->mon_register_get_val)(mem, e_PC));
     loadstorepc = new_addr(mem, lastpc);
@@ -623,6 +735,7 @@ void mon_breakpoint_unset(MON_ADDR address)
     if (ptr) {
         /* there's a breakpoint, so remove it */
         remove_checkpoint_from_list( &breakpoints[mem], ptr->checkpt );
+        update_checkpoint_state(mem);
     }
 }
 
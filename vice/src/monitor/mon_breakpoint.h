@@ -35,6 +35,23 @@ typedef enum mon_breakpoint_type_e {
     BP_ACTIVE
 } mon_breakpoint_type_t;
 
+/* Copy of the state of a checkpoint, for front-ends that do not use the
+   text output of the monitor.  */
+typedef struct mon_checkpoint_info_s {
+    int checknum;
+    MON_ADDR start_addr;
+    MON_ADDR end_addr;
+    int hit_count;
+    int ignore_count;
+    bool has_condition;
+    bool stop;
+    bool enabled;
+    bool check_load;
+    bool check_store;
+    bool check_exec;
+    bool temporary;
+} mon_checkpoint_info_t;
+
 extern void mon_breakpoint_init(void);
 
 extern void mon_breakpoint_switch_checkpoint(int op, int breakpt_num);
@@ -45,8 +62,11 @@ extern void mon_breakpoint_set_checkpoint_condition(int brk_num, struct cond_nod
 extern void mon_breakpoint_set_checkpoint_command(int brk_num, char *cmd);
 extern bool mon_breakpoint_check_checkpoint(MEMSPACE mem, unsigned int addr,
                                             unsigned int lastpc, MEMORY_OP op);
+extern bool mon_breakpoint_check_map(MEMSPACE mem, unsigned int addr, MEMORY_OP op);
 extern int mon_breakpoint_add_checkpoint(MON_ADDR start_addr, MON_ADDR end_addr,
                                          bool stop, MEMORY_OP op, bool is_temp);
+extern bool mon_breakpoint_get_info(int cp_num, mon_checkpoint_info_t *info);
+extern int mon_breakpoint_last_checknum(void);
 
 extern mon_breakpoint_type_t mon_breakpoint_is(MON_ADDR address);
 extern void mon_breakpoint_set(MON_ADDR address);
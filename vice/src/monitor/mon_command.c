@@ -101,6 +101,27 @@ static const mon_cmds_t mon_cmd_array[] = {
       NO_FILENAME_ARG
     },
 
+    { "cputrace", "",
+      "\"<filename>\"",
+      "Write every instruction executed by the CPU of the current memory\n"
+      "space, with its registers and cycle count, to the trace file\n"
+      "specified until `cputraceoff' is entered.",
+      FILENAME_ARG
+    },
+
+    { "cputraceoff", "",
+      NULL,
+      "Stop writing the CPU trace started with `cputrace'.",
+      NO_FILENAME_ARG
+    },
+
+    { "cputraceshow", "",
+      "\"<filename>\" [<skip> [<count>]]",
+      "Show the instructions of a CPU trace file, skipping the first <skip>\n"
+      "instructions and showing at most <count> of them.",
+      FILENAME_ARG
+    },
+
     { "dump", "",
       "\"<filename>\"",
       "Write a snapshot of the machine into the file specified.\n"
@@ -154,6 +175,14 @@ static const mon_cmds_t mon_cmd_array[] = {
       NO_FILENAME_ARG
     },
 
+    { "rewind", "",
+      "[<count>]",
+      "Restore the machine state captured <count> captures ago (default 1)\n"
+      "from the rewind history and discard the newer captures.  The history\n"
+      "is recorded while the `Rewind' resource is enabled.",
+      NO_FILENAME_ARG
+    },
+
     { "screen", "sc",
       NULL,
       "Displays the contents of the screen.",
@@ -660,6 +689,40 @@ static const mon_cmds_t mon_cmd_array[] = {
       NO_FILENAME_ARG
     },
 
+    { "profile", "prof",
+      "on|off|toggle",
+      "Count the cycles spent at every address and in every routine by the\n"
+      "CPU of the current memory space.  Cycles stolen by DMA are charged to\n"
+      "the instruction that was running.  Routines are entered by JSR or an\n"
+      "interrupt and left when the stack is unwound.",
+      NO_FILENAME_ARG
+    },
+
+    { "profileclear", "",
+      NULL,
+      "Discard the profile data of the current memory space.",
+      NO_FILENAME_ARG
+    },
+
+    { "profileflat", "",
+      "[<count>]",
+      "Show the <count> addresses that used the most cycles (default 20).",
+      NO_FILENAME_ARG
+    },
+
+    { "profilegraph", "",
+      "[<count>]",
+      "Show the <count> routines with the most cycles including their\n"
+      "callees (default 20), each followed by the routines it called.",
+      NO_FILENAME_ARG
+    },
+
+    { "profilesave", "",
+      "\"<filename>\"",
+      "Save the profile data in the callgrind format.",
+      FILENAME_ARG
+    },
+
     { "record", "rec",
       "\"<filename>\"",
       "After this command, all commands entered are written to the specified\n"
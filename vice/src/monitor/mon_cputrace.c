@@ -0,0 +1,507 @@
+/*
+ * mon_cputrace.c - The VICE built-in monitor, CPU execution trace files.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* The trace is recorded from the IK_MONITOR path of the 65xx cores, so a
+   CPU that is not being traced (and has no breakpoints or watchpoints)
+   does not pay anything for it.
+
+   Trace file layout, all values little endian:
+
+   header:
+     0  "VICETRC"     magic
+     7  version       (CPUTRACE_VERSION)
+     8  memspace
+     9  cpu type      (CPU_TYPE_t)
+    10  pc            (2 bytes)
+    12  a, x, y, sp, status
+    17  reserved
+    18  clock         (8 bytes)
+
+   followed by one record per executed instruction:
+     flags    bits 0-1: number of operand bytes
+              bit 2: pc follows (the instruction does not follow the
+                     previous one)
+              bits 3-7: a, x, y, sp, status follow (changed since the
+                        previous record)
+     [pc]     2 bytes
+     opcode, operands
+     [a] [x] [y] [sp] [status]
+     cycles   varint, clock delta to the previous record
+
+   The whole stream is gzip compressed when zlib is available; the reader
+   accepts both.  */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "archdep.h"
+#include "interrupt.h"
+#include "lib.h"
+#include "mon_cputrace.h"
+#include "mon_disassemble.h"
+#include "monitor.h"
+#include "montypes.h"
+#include "types.h"
+
+
+#define CPUTRACE_MAGIC      "VICETRC"
+#define CPUTRACE_VERSION    1
+#define CPUTRACE_HEADER_SIZE 26
+
+#define CPUTRACE_BUFFER_SIZE 0x10000
+/* longest record: flags, pc, 3 instruction bytes, 5 registers, varint */
+#define CPUTRACE_RECORD_MAX  (1 + 2 + 3 + 5 + 10)
+
+#define FLAG_OPERANDS   0x03
+#define FLAG_PC         0x04
+#define FLAG_A          0x08
+#define FLAG_X          0x10
+#define FLAG_Y          0x20
+#define FLAG_SP         0x40
+#define FLAG_ST         0x80
+
+#ifdef HAVE_ZLIB
+typedef gzFile cputrace_file_t;
+#define cputrace_open_write(name)   gzopen(name, MODE_WRITE "1")
+#define cputrace_open_read(name)    gzopen(name, MODE_READ)
+#define cputrace_write(f, b, n)     ((size_t)gzwrite(f, b, (unsigned int)(n)) == (n))
+#define cputrace_read(f, b, n)      gzread(f, b, (unsigned int)(n))
+#define cputrace_close(f)           gzclose(f)
+#else
+typedef FILE *cputrace_file_t;
+#define cputrace_open_write(name)   fopen(name, MODE_WRITE)
+#define cputrace_open_read(name)    fopen(name, MODE_READ)
+#define cputrace_write(f, b, n)     (fwrite(b, 1, n, f) == (n))
+#define cputrace_read(f, b, n)      (int)fread(b, 1, n, f)
+#define cputrace_close(f)           fclose(f)
+#endif
+
+/* CPU state as of the previous record, used for the delta encoding.  */
+typedef struct cputrace_state_s {
+    unsigned int pc;
+    unsigned int len;
+    uint8_t reg[5];
+    uint64_t clk;
+} cputrace_state_t;
+
+static cputrace_file_t trace_file = NULL;
+static char *trace_name = NULL;
+static MEMSPACE trace_mem = e_invalid_space;
+static uint8_t *trace_buffer = NULL;
+static size_t trace_fill = 0;
+static int trace_error = 0;
+static uint64_t trace_count = 0;
+static CLOCK trace_last_clk;
+static cputrace_state_t trace_state;
+
+static const int reg_ids[5] = { e_A, e_X, e_Y, e_SP, e_FLAGS };
+
+/* ------------------------------------------------------------------------- */
+
+static void put_le(uint8_t *p, uint64_t val, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++) {
+        p[i] = (uint8_t)(val >> (i * 8));
+    }
+}
+
+static uint64_t get_le(const uint8_t *p, int len)
+{
+    uint64_t val = 0;
+    int i;
+
+    for (i = len - 1; i >= 0; i--) {
+        val = (val << 8) | p[i];
+    }
+    return val;
+}
+
+static void trace_flush(void)
+{
+    if (trace_fill > 0 && !trace_error) {
+        if (!cputrace_write(trace_file, trace_buffer, trace_fill)) {
+            trace_error = 1;
+        }
+    }
+    trace_fill = 0;
+}
+
+static void cputrace_mask(MEMSPACE mem, int on)
+{
+    if (on) {
+        monitor_mask[mem] |= MI_TRACE;
+        interrupt_monitor_trap_on(mon_interfaces[mem]->int_status);
+    } else {
+        monitor_mask[mem] &= ~MI_TRACE;
+        if (!monitor_mask[mem]) {
+            interrupt_monitor_trap_off(mon_interfaces[mem]->int_status);
+        }
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* called by macro DO_INTERRUPT() in the 65xx cores, registers have been
+   exported */
+void monitor_cputrace_store(MEMSPACE mem, CLOCK clk)
+{
+    monitor_cpu_type_t *cpu = monitor_cpu_for_memspace[mem];
+    const asm_opcode_info_t *info;
+    uint8_t *p, *flags;
+    uint8_t op, p1, p2;
+    unsigned int pc, len, i;
+    uint64_t delta;
+
+    if (mem != trace_mem || trace_file == NULL) {
+        return;
+    }
+
+    /* bank 0 is the CPU's view of memory */
+    pc = (unsigned int)(cpu->mon_register_get_val(mem, e_PC));
+    op = mon_get_mem_val_ex(mem, 0, (uint16_t)pc);
+    p1 = mon_get_mem_val_ex(mem, 0, (uint16_t)(pc + 1));
+    p2 = mon_get_mem_val_ex(mem, 0, (uint16_t)(pc + 2));
+    info = cpu->asm_opcode_info_get(op, p1, p2);
+    len = cpu->asm_addr_mode_get_size((unsigned int)(info->addr_mode), op, p1, p2);
+    if (len < 1 || len > 3) {
+        len = 1;
+    }
+
+    p = trace_buffer + trace_fill;
+    flags = p++;
+    *flags = (uint8_t)(len - 1);
+
+    if (pc != ((trace_state.pc + trace_state.len) & 0xffff)) {
+        *flags |= FLAG_PC;
+        *p++ = (uint8_t)pc;
+        *p++ = (uint8_t)(pc >> 8);
+    }
+    trace_state.pc = pc;
+    trace_state.len = len;
+
+    *p++ = op;
+    if (len > 1) {
+        *p++ = p1;
+    }
+    if (len > 2) {
+        *p++ = p2;
+    }
+
+    for (i = 0; i < 5; i++) {
+        uint8_t val = (uint8_t)(cpu->mon_register_get_val(mem, reg_ids[i]));
+
+        if (val != trace_state.reg[i]) {
+            *flags |= (uint8_t)(FLAG_A << i);
+            *p++ = val;
+            trace_state.reg[i] = val;
+        }
+    }
+
+    /* The clock counter is occasionally rebased by the overflow guard;
+       count no cycles for that step rather than a bogus huge delta.  */
+    delta = (clk >= trace_last_clk) ? (uint64_t)(clk - trace_last_clk) : 0;
+    trace_last_clk = clk;
+    trace_state.clk += delta;
+    do {
+        *p++ = (uint8_t)((delta & 0x7f) | ((delta > 0x7f) ? 0x80 : 0));
+        delta >>= 7;
+    } while (delta != 0);
+
+    trace_fill = (size_t)(p - trace_buffer);
+    trace_count++;
+
+    if (trace_fill > CPUTRACE_BUFFER_SIZE - CPUTRACE_RECORD_MAX) {
+        trace_flush();
+    }
+}
+
+void mon_cputrace_start(const char *filename)
+{
+    monitor_cpu_type_t *cpu;
+    uint8_t header[CPUTRACE_HEADER_SIZE];
+    MEMSPACE mem = default_memspace;
+    int i;
+
+    if (trace_file != NULL) {
+        mon_out("Already tracing to `%s'.\n", trace_name);
+        return;
+    }
+
+    cpu = monitor_cpu_for_memspace[mem];
+    if (!mon_cpu_is_65xx(mem)) {
+        mon_out("CPU tracing is only supported for 65xx CPUs.\n");
+        return;
+    }
+
+    trace_file = cputrace_open_write(filename);
+    if (trace_file == NULL) {
+        mon_out("Cannot create `%s'.\n", filename);
+        return;
+    }
+
+    memset(&trace_state, 0, sizeof(trace_state));
+    trace_state.pc = (unsigned int)(cpu->mon_register_get_val(mem, e_PC));
+    for (i = 0; i < 5; i++) {
+        trace_state.reg[i] = (uint8_t)(cpu->mon_register_get_val(mem, reg_ids[i]));
+    }
+    trace_last_clk = *(mon_interfaces[mem]->clk);
+    trace_state.clk = trace_last_clk;
+
+    memset(header, 0, sizeof(header));
+    memcpy(header, CPUTRACE_MAGIC, 7);
+    header[7] = CPUTRACE_VERSION;
+    header[8] = (uint8_t)mem;
+    header[9] = (uint8_t)(cpu->cpu_type);
+    put_le(header + 10, trace_state.pc, 2);
+    memcpy(header + 12, trace_state.reg, 5);
+    put_le(header + 18, trace_state.clk, 8);
+
+    trace_buffer = lib_malloc(CPUTRACE_BUFFER_SIZE);
+    memcpy(trace_buffer, header, sizeof(header));
+    trace_fill = sizeof(header);
+    trace_error = 0;
+    trace_count = 0;
+    trace_name = lib_stralloc(filename);
+    trace_mem = mem;
+
+    /* the first record then only carries the instruction itself */
+    trace_state.len = 0;
+
+    cputrace_mask(mem, 1);
+    mon_out("Tracing %s CPU to `%s'.\n", mon_memspace_string[mem], filename);
+}
+
+void mon_cputrace_stop(void)
+{
+    if (trace_file == NULL) {
+        mon_out("No CPU trace running.\n");
+        return;
+    }
+
+    cputrace_mask(trace_mem, 0);
+    trace_flush();
+    cputrace_close(trace_file);
+
+    if (trace_error) {
+        mon_out("Error writing `%s', the trace is incomplete.\n", trace_name);
+    } else {
+        mon_out("Traced %lu instructions to `%s'.\n",
+                (unsigned long)trace_count, trace_name);
+    }
+
+    trace_file = NULL;
+    trace_mem = e_invalid_space;
+    lib_free(trace_buffer);
+    trace_buffer = NULL;
+    lib_free(trace_name);
+    trace_name = NULL;
+}
+
+void mon_cputrace_shutdown(void)
+{
+    if (trace_file != NULL) {
+        mon_cputrace_stop();
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+typedef struct cputrace_reader_s {
+    cputrace_file_t file;
+    uint8_t *buffer;
+    int pos;
+    int len;
+} cputrace_reader_t;
+
+/* Return the next byte of the trace or -1 at the end.  */
+static int reader_get(cputrace_reader_t *r)
+{
+    if (r->pos >= r->len) {
+        r->len = cputrace_read(r->file, r->buffer, CPUTRACE_BUFFER_SIZE);
+        r->pos = 0;
+        if (r->len <= 0) {
+            r->len = 0;
+            return -1;
+        }
+    }
+    return r->buffer[r->pos++];
+}
+
+static int reader_get_bytes(cputrace_reader_t *r, uint8_t *dest, int len)
+{
+    int i, c;
+
+    for (i = 0; i < len; i++) {
+        if ((c = reader_get(r)) < 0) {
+            return -1;
+        }
+        dest[i] = (uint8_t)c;
+    }
+    return 0;
+}
+
+void mon_cputrace_show(const char *filename, int skip, int count)
+{
+    cputrace_reader_t r;
+    cputrace_state_t state;
+    uint8_t header[CPUTRACE_HEADER_SIZE];
+    uint8_t insn[3];
+    MEMSPACE mem;
+    uint64_t n = 0;
+    int c, i, flags, len, shift, truncated = 0;
+    uint64_t delta;
+    unsigned opc_size;
+    const char *dis_inst;
+
+    if (trace_file != NULL && trace_name != NULL
+        && strcmp(trace_name, filename) == 0) {
+        trace_flush();
+    }
+
+    r.file = cputrace_open_read(filename);
+    if (r.file == NULL) {
+        mon_out("Cannot open `%s'.\n", filename);
+        return;
+    }
+    r.buffer = lib_malloc(CPUTRACE_BUFFER_SIZE);
+    r.pos = r.len = 0;
+
+    if (reader_get_bytes(&r, header, CPUTRACE_HEADER_SIZE) < 0
+        || memcmp(header, CPUTRACE_MAGIC, 7) != 0) {
+        mon_out("`%s' is not a CPU trace file.\n", filename);
+        goto done;
+    }
+    if (header[7] != CPUTRACE_VERSION) {
+        mon_out("Unsupported CPU trace version %d.\n", header[7]);
+        goto done;
+    }
+
+    mem = (MEMSPACE)header[8];
+    if (mem <= e_default_space || mem >= e_invalid_space) {
+        mem = e_comp_space;
+    }
+    state.pc = (unsigned int)get_le(header + 10, 2);
+    state.len = 0;
+    memcpy(state.reg, header + 12, 5);
+    state.clk = get_le(header + 18, 8);
+
+    if (skip < 0) {
+        skip = 0;
+    }
+
+    while ((c = reader_get(&r)) >= 0) {
+        flags = c;
+        len = (flags & FLAG_OPERANDS) + 1;
+        if (len > 3) {
+            mon_out("Corrupt CPU trace record.\n");
+            break;
+        }
+
+        if (flags & FLAG_PC) {
+            uint8_t pc[2];
+
+            if (reader_get_bytes(&r, pc, 2) < 0) {
+                truncated = 1;
+                break;
+            }
+            state.pc = pc[0] | (pc[1] << 8);
+        } else {
+            state.pc = (state.pc + state.len) & 0xffff;
+        }
+        state.len = (unsigned int)len;
+
+        memset(insn, 0, sizeof(insn));
+        if (reader_get_bytes(&r, insn, len) < 0) {
+            truncated = 1;
+            break;
+        }
+
+        for (i = 0; i < 5; i++) {
+            if (flags & (FLAG_A << i)) {
+                if ((c = reader_get(&r)) < 0) {
+                    break;
+                }
+                state.reg[i] = (uint8_t)c;
+            }
+        }
+        if (i < 5) {
+            truncated = 1;
+            break;
+        }
+
+        delta = 0;
+        shift = 0;
+        do {
+            if ((c = reader_get(&r)) < 0 || shift > 63) {
+                break;
+            }
+            delta |= (uint64_t)(c & 0x7f) << shift;
+            shift += 7;
+        } while (c & 0x80);
+        if (c < 0 || (c & 0x80)) {
+            truncated = 1;
+            break;
+        }
+        state.clk += delta;
+
+        if (n++ < (uint64_t)skip) {
+            continue;
+        }
+
+        dis_inst = mon_disassemble_to_string_ex(mem, state.pc, insn[0], insn[1],
+                                                insn[2], 0, 1, &opc_size);
+
+        mon_out("%10lu  %04x  %-30s - A:%02x X:%02x Y:%02x SP:%02x %c%c-%c%c%c%c%c\n",
+            (unsigned long)state.clk, state.pc, dis_inst,
+            state.reg[0], state.reg[1], state.reg[2], state.reg[3],
+            ((state.reg[4] & (1 << 7)) != 0) ? 'N' : ' ',
+            ((state.reg[4] & (1 << 6)) != 0) ? 'V' : ' ',
+            ((state.reg[4] & (1 << 4)) != 0) ? 'B' : ' ',
+            ((state.reg[4] & (1 << 3)) != 0) ? 'D' : ' ',
+            ((state.reg[4] & (1 << 2)) != 0) ? 'I' : ' ',
+            ((state.reg[4] & (1 << 1)) != 0) ? 'Z' : ' ',
+            ((state.reg[4] & (1 << 0)) != 0) ? 'C' : ' '
+            );
+
+        if ((count > 0 && n >= (uint64_t)skip + (uint64_t)count)
+            || mon_stop_output != 0) {
+            break;
+        }
+    }
+
+    if (truncated) {
+        mon_out("Trace ends in the middle of a record.\n");
+    }
+
+done:
+    cputrace_close(r.file);
+    lib_free(r.buffer);
+}
@@ -0,0 +1,35 @@
+/*
+ * mon_cputrace.h - The VICE built-in monitor, CPU execution trace files.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_MON_CPUTRACE_H
+#define VICE_MON_CPUTRACE_H
+
+#include "montypes.h"
+#include "types.h"
+
+extern void mon_cputrace_start(const char *filename);
+extern void mon_cputrace_stop(void);
+extern void mon_cputrace_show(const char *filename, int skip, int count);
+extern void mon_cputrace_shutdown(void);
+
+#endif
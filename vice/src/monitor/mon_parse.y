@@ -71,11 +71,13 @@ extern char *alloca();
 #include "machine.h"
 #include "mon_breakpoint.h"
 #include "mon_command.h"
+#include "mon_cputrace.h"
 #include "mon_disassemble.h"
 #include "mon_drive.h"
 #include "mon_file.h"
 #include "mon_memmap.h"
 #include "mon_memory.h"
+#include "mon_profile.h"
 #include "mon_register.h"
 #include "mon_util.h"
 #include "montypes.h"
@@ -165,7 +167,9 @@ extern int cur_len, last_len;
 %token CMD_ATTACH CMD_DETACH CMD_MON_RESET CMD_TAPECTRL CMD_CARTFREEZE
 %token CMD_CPUHISTORY CMD_MEMMAPZAP CMD_MEMMAPSHOW CMD_MEMMAPSAVE
 %token CMD_COMMENT CMD_LIST CMD_STOPWATCH RESET
-%token CMD_EXPORT CMD_AUTOSTART CMD_AUTOLOAD CMD_MAINCPU_TRACE
+%token CMD_EXPORT CMD_AUTOSTART CMD_AUTOLOAD CMD_MAINCPU_TRACE CMD_REWIND
+%token CMD_CPUTRACE CMD_CPUTRACE_OFF CMD_CPUTRACE_SHOW
+%token CMD_PROFILE CMD_PROFILE_CLEAR CMD_PROFILE_FLAT CMD_PROFILE_GRAPH CMD_PROFILE_SAVE
 %token<str> CMD_LABEL_ASGN
 %token<i> L_PAREN R_PAREN ARG_IMMEDIATE REG_A REG_X REG_Y COMMA INST_SEP
 %token<i> L_BRACKET R_BRACKET LESS_THAN REG_U REG_S REG_PC REG_PCR
@@ -249,12 +253,28 @@ machine_state_rules: CMD_BANK end_cmd
                      { mon_cpuhistory(-1); }
                    | CMD_CPUHISTORY opt_sep expression end_cmd
                      { mon_cpuhistory($3); }
+                   | CMD_PROFILE TOGGLE end_cmd
+                     { mon_profile_toggle($2); }
+                   | CMD_PROFILE_CLEAR end_cmd
+                     { mon_profile_clear(); }
+                   | CMD_PROFILE_FLAT end_cmd
+                     { mon_profile_flat(-1); }
+                   | CMD_PROFILE_FLAT opt_sep expression end_cmd
+                     { mon_profile_flat($3); }
+                   | CMD_PROFILE_GRAPH end_cmd
+                     { mon_profile_graph(-1); }
+                   | CMD_PROFILE_GRAPH opt_sep expression end_cmd
+                     { mon_profile_graph($3); }
                    | CMD_RETURN end_cmd
                      { mon_instruction_return(); }
                    | CMD_DUMP filename end_cmd
                      { machine_write_snapshot($2,0,0,0); /* FIXME */ }
                    | CMD_UNDUMP filename end_cmd
                      { machine_read_snapshot($2, 0); }
+                   | CMD_REWIND end_cmd
+                     { mon_rewind(1); }
+                   | CMD_REWIND opt_sep expression end_cmd
+                     { mon_rewind($3); }
                    | CMD_STEP end_cmd
                      { mon_instructions_step(-1); }
                    | CMD_STEP opt_sep expression end_cmd
@@ -576,6 +596,18 @@ cmd_file_rules: CMD_RECORD filename end_cmd
                 { mon_end_recording(); }
               | CMD_PLAYBACK filename end_cmd
                 { mon_playback_init($2); }
+              | CMD_CPUTRACE filename end_cmd
+                { mon_cputrace_start($2); }
+              | CMD_CPUTRACE_OFF end_cmd
+                { mon_cputrace_stop(); }
+              | CMD_PROFILE_SAVE filename end_cmd
+                { mon_profile_save($2); }
+              | CMD_CPUTRACE_SHOW filename end_cmd
+                { mon_cputrace_show($2, 0, -1); }
+              | CMD_CPUTRACE_SHOW filename opt_sep expression end_cmd
+                { mon_cputrace_show($2, $4, -1); }
+              | CMD_CPUTRACE_SHOW filename opt_sep expression opt_sep expression end_cmd
+                { mon_cputrace_show($2, $4, $6); }
               ;
 
 data_entry_rules: CMD_ENTER_DATA address data_list end_cmd
@@ -0,0 +1,598 @@
+/*
+ * mon_profile.c - The VICE built-in monitor, cycle profiler.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* Like the CPU trace, the profiler is fed from the IK_MONITOR path of the
+   65xx cores and costs nothing while it is off.
+
+   The clock difference between two consecutive instructions is charged to
+   the first one, so cycles stolen by badlines, sprite DMA or the REU, and
+   the interrupt sequence that follows an instruction, all count for the
+   instruction that was running.
+
+   Routines are tracked with a shadow call stack.  A JSR (stack pointer two
+   lower) enters its target, an interrupt or BRK (stack pointer three lower)
+   enters the handler.  A routine is left as soon as the stack pointer rises
+   above the value it had on entry, which covers RTS/RTI as well as code
+   that drops its return address or resets the stack.  */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "archdep.h"
+#include "lib.h"
+#include "mon_disassemble.h"
+#include "mon_profile.h"
+#include "monitor.h"
+#include "montypes.h"
+#include "interrupt.h"
+#include "types.h"
+#include "version.h"
+
+
+#define OP_JSR 0x20
+
+#define PROFILE_ADDRS     0x10000
+/* pseudo routine for code running outside of any call */
+#define PROFILE_TOP       0x10000
+#define PROFILE_MAX_DEPTH 256
+
+#define PROFILE_DEFAULT_COUNT 20
+
+/* One caller/callee pair of the call graph.  */
+typedef struct profile_edge_s {
+    unsigned int caller;
+    unsigned int callee;
+    unsigned int site;      /* address of the last calling instruction */
+    unsigned long calls;
+    uint64_t cycles;        /* inclusive cycles spent in callee */
+} profile_edge_t;
+
+typedef struct profile_frame_s {
+    unsigned int routine;
+    unsigned int sp;        /* stack pointer after entering the routine */
+    uint64_t entry;         /* `total' at entry */
+    int edge;
+} profile_frame_t;
+
+typedef struct profile_s {
+    uint64_t *cycles;               /* per address */
+    unsigned long *count;           /* per address */
+    unsigned int *owner;            /* per address, routine + 1 */
+    uint64_t *incl;                 /* per routine */
+    unsigned long *calls;           /* per routine */
+
+    profile_edge_t *edges;          /* open addressing hash */
+    int edges_size;
+    int edges_used;
+
+    profile_frame_t stack[PROFILE_MAX_DEPTH];
+    int depth;
+
+    int have_prev;
+    unsigned int prev_pc;
+    unsigned int prev_sp;
+    uint8_t prev_op, prev_p1, prev_p2;
+    CLOCK prev_clk;
+
+    uint64_t total;
+    unsigned long instructions;
+} profile_t;
+
+static profile_t *profiles[NUM_MEMSPACES];
+
+/* ------------------------------------------------------------------------- */
+
+static profile_t *profile_new(void)
+{
+    profile_t *p = lib_calloc(1, sizeof(profile_t));
+
+    p->cycles = lib_calloc(PROFILE_ADDRS, sizeof(uint64_t));
+    p->count = lib_calloc(PROFILE_ADDRS, sizeof(unsigned long));
+    p->owner = lib_calloc(PROFILE_ADDRS, sizeof(unsigned int));
+    p->incl = lib_calloc(PROFILE_ADDRS + 1, sizeof(uint64_t));
+    p->calls = lib_calloc(PROFILE_ADDRS + 1, sizeof(unsigned long));
+    p->edges_size = 1024;
+    p->edges = lib_calloc((size_t)p->edges_size, sizeof(profile_edge_t));
+    return p;
+}
+
+static void profile_free(profile_t *p)
+{
+    lib_free(p->cycles);
+    lib_free(p->count);
+    lib_free(p->owner);
+    lib_free(p->incl);
+    lib_free(p->calls);
+    lib_free(p->edges);
+    lib_free(p);
+}
+
+static void profile_reset(profile_t *p)
+{
+    memset(p->cycles, 0, PROFILE_ADDRS * sizeof(uint64_t));
+    memset(p->count, 0, PROFILE_ADDRS * sizeof(unsigned long));
+    memset(p->owner, 0, PROFILE_ADDRS * sizeof(unsigned int));
+    memset(p->incl, 0, (PROFILE_ADDRS + 1) * sizeof(uint64_t));
+    memset(p->calls, 0, (PROFILE_ADDRS + 1) * sizeof(unsigned long));
+    memset(p->edges, 0, (size_t)p->edges_size * sizeof(profile_edge_t));
+    p->edges_used = 0;
+    p->depth = 0;
+    p->have_prev = 0;
+    p->total = 0;
+    p->instructions = 0;
+}
+
+/* Edge slots with calls == 0 are free; an edge is counted as soon as it
+   is created.  */
+static int edge_find(profile_t *p, unsigned int caller, unsigned int callee)
+{
+    unsigned int mask = (unsigned int)p->edges_size - 1;
+    unsigned int i = ((caller * 0x9e3779b1u) ^ callee) & mask;
+
+    while (p->edges[i].calls != 0) {
+        if (p->edges[i].caller == caller && p->edges[i].callee == callee) {
+            return (int)i;
+        }
+        i = (i + 1) & mask;
+    }
+    return (int)i;
+}
+
+static int edge_get(profile_t *p, unsigned int caller, unsigned int callee)
+{
+    int i = edge_find(p, caller, callee);
+
+    if (p->edges[i].calls == 0) {
+        if ((p->edges_used + 1) * 2 > p->edges_size) {
+            profile_edge_t *old = p->edges;
+            int j, old_size = p->edges_size;
+
+            p->edges_size *= 2;
+            p->edges = lib_calloc((size_t)p->edges_size, sizeof(profile_edge_t));
+            for (j = 0; j < old_size; j++) {
+                if (old[j].calls != 0) {
+                    p->edges[edge_find(p, old[j].caller, old[j].callee)] = old[j];
+                }
+            }
+            lib_free(old);
+            /* the frames refer to edges by index */
+            for (j = 0; j < p->depth; j++) {
+                p->stack[j].edge = edge_find(p, j > 0 ? p->stack[j - 1].routine : PROFILE_TOP,
+                                             p->stack[j].routine);
+            }
+            i = edge_find(p, caller, callee);
+        }
+        p->edges[i].caller = caller;
+        p->edges[i].callee = callee;
+        p->edges_used++;
+    }
+    return i;
+}
+
+static unsigned int current_routine(profile_t *p)
+{
+    return p->depth > 0 ? p->stack[p->depth - 1].routine : PROFILE_TOP;
+}
+
+static void frame_push(profile_t *p, unsigned int routine, unsigned int sp,
+                       unsigned int site)
+{
+    profile_frame_t *f;
+    int e;
+
+    if (p->depth >= PROFILE_MAX_DEPTH) {
+        return;
+    }
+    e = edge_get(p, current_routine(p), routine);
+    p->edges[e].calls++;
+    p->edges[e].site = site;
+    p->calls[routine]++;
+
+    f = &p->stack[p->depth++];
+    f->routine = routine;
+    f->sp = sp;
+    f->entry = p->total;
+    f->edge = e;
+}
+
+static void frame_pop(profile_t *p)
+{
+    profile_frame_t *f = &p->stack[--p->depth];
+    uint64_t cycles = p->total - f->entry;
+    int i;
+
+    p->edges[f->edge].cycles += cycles;
+
+    /* recursive calls are already covered by the outermost one */
+    for (i = 0; i < p->depth; i++) {
+        if (p->stack[i].routine == f->routine) {
+            return;
+        }
+    }
+    p->incl[f->routine] += cycles;
+}
+
+static void profile_mask(MEMSPACE mem, int on)
+{
+    if (on) {
+        monitor_mask[mem] |= MI_PROFILE;
+        interrupt_monitor_trap_on(mon_interfaces[mem]->int_status);
+    } else {
+        monitor_mask[mem] &= ~MI_PROFILE;
+        if (!monitor_mask[mem]) {
+            interrupt_monitor_trap_off(mon_interfaces[mem]->int_status);
+        }
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* called by macro DO_INTERRUPT() in the 65xx cores, registers have been
+   exported */
+void monitor_profile_store(MEMSPACE mem, CLOCK clk)
+{
+    monitor_cpu_type_t *cpu = monitor_cpu_for_memspace[mem];
+    profile_t *p = profiles[mem];
+    unsigned int pc, sp, drop;
+
+    if (p == NULL) {
+        return;
+    }
+
+    pc = (unsigned int)(cpu->mon_register_get_val(mem, e_PC)) & 0xffff;
+    sp = (unsigned int)(cpu->mon_register_get_val(mem, e_SP)) & 0xff;
+
+    if (p->have_prev) {
+        unsigned int prev = p->prev_pc;
+        /* the clock may have been rebased by the overflow guard */
+        CLOCK delta = (clk >= p->prev_clk) ? clk - p->prev_clk : 0;
+
+        p->cycles[prev] += delta;
+        p->count[prev]++;
+        p->owner[prev] = current_routine(p) + 1;
+        p->total += delta;
+        p->instructions++;
+
+        while (p->depth > 0 && sp > p->stack[p->depth - 1].sp) {
+            frame_pop(p);
+        }
+
+        drop = (p->prev_sp - sp) & 0xff;
+        if (p->prev_op == OP_JSR && (drop == 2 || drop == 5)) {
+            frame_push(p, (unsigned int)(p->prev_p1 | (p->prev_p2 << 8)),
+                       (p->prev_sp - 2) & 0xff, prev);
+            drop -= 2;
+        }
+        if (drop == 3) {
+            frame_push(p, pc, sp, prev);
+        }
+    }
+
+    /* bank 0 is the CPU's view of memory */
+    p->prev_op = mon_get_mem_val_ex(mem, 0, (uint16_t)pc);
+    if (p->prev_op == OP_JSR) {
+        p->prev_p1 = mon_get_mem_val_ex(mem, 0, (uint16_t)(pc + 1));
+        p->prev_p2 = mon_get_mem_val_ex(mem, 0, (uint16_t)(pc + 2));
+    }
+    p->prev_pc = pc;
+    p->prev_sp = sp;
+    p->prev_clk = clk;
+    p->have_prev = 1;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static profile_t *profile_for_output(MEMSPACE mem)
+{
+    if (profiles[mem] == NULL || profiles[mem]->instructions == 0) {
+        mon_out("No profile data for %s.\n", mon_memspace_string[mem]);
+        return NULL;
+    }
+    return profiles[mem];
+}
+
+/* Name of a routine for the reports: its label if there is one.  */
+static const char *routine_name(MEMSPACE mem, unsigned int routine, char *buf)
+{
+    const char *label;
+
+    if (routine == PROFILE_TOP) {
+        return "(top)";
+    }
+    label = mon_symbol_table_lookup_name(mem, (uint16_t)routine);
+    if (label != NULL) {
+        return label;
+    }
+    sprintf(buf, "$%04x", routine);
+    return buf;
+}
+
+static double percent(uint64_t part, uint64_t total)
+{
+    return total ? (100.0 * (double)part) / (double)total : 0.0;
+}
+
+static const uint64_t *sort_key;
+
+static int cmp_desc(const void *a, const void *b)
+{
+    uint64_t ka = sort_key[*(const unsigned int *)a];
+    uint64_t kb = sort_key[*(const unsigned int *)b];
+
+    if (ka != kb) {
+        return ka < kb ? 1 : -1;
+    }
+    return (*(const unsigned int *)a < *(const unsigned int *)b) ? -1 : 1;
+}
+
+static const profile_t *sort_profile;
+
+static int cmp_owner(const void *a, const void *b)
+{
+    unsigned int aa = *(const unsigned int *)a, ab = *(const unsigned int *)b;
+    unsigned int oa = sort_profile->owner[aa], ob = sort_profile->owner[ab];
+
+    if (oa != ob) {
+        return oa < ob ? -1 : 1;
+    }
+    return aa < ab ? -1 : 1;
+}
+
+static int cmp_caller(const void *a, const void *b)
+{
+    const profile_edge_t *ea = *(profile_edge_t * const *)a;
+    const profile_edge_t *eb = *(profile_edge_t * const *)b;
+
+    if (ea->caller != eb->caller) {
+        return ea->caller < eb->caller ? -1 : 1;
+    }
+    return ea->callee < eb->callee ? -1 : (ea->callee > eb->callee);
+}
+
+void mon_profile_toggle(int value)
+{
+    MEMSPACE mem = default_memspace;
+    int on = (monitor_mask[mem] & MI_PROFILE) != 0;
+
+    if (value == e_TOGGLE) {
+        value = on ? e_OFF : e_ON;
+    }
+
+    if (value == e_ON) {
+        if (!mon_cpu_is_65xx(mem)) {
+            mon_out("Profiling is only supported for 65xx CPUs.\n");
+            return;
+        }
+        if (profiles[mem] == NULL) {
+            profiles[mem] = profile_new();
+        }
+        /* a gap in the data must not be charged to the last instruction */
+        profiles[mem]->have_prev = 0;
+        profiles[mem]->depth = 0;
+        profile_mask(mem, 1);
+    } else {
+        profile_mask(mem, 0);
+    }
+    mon_out("Profiling %s is %s.\n", mon_memspace_string[mem],
+            value == e_ON ? "on" : "off");
+}
+
+void mon_profile_clear(void)
+{
+    if (profiles[default_memspace] != NULL) {
+        profile_reset(profiles[default_memspace]);
+    }
+}
+
+void mon_profile_flat(int count)
+{
+    MEMSPACE mem = default_memspace;
+    profile_t *p = profile_for_output(mem);
+    unsigned int *order, n = 0, addr;
+    char buf[8];
+    int i;
+
+    if (p == NULL) {
+        return;
+    }
+    if (count <= 0) {
+        count = PROFILE_DEFAULT_COUNT;
+    }
+
+    order = lib_malloc(PROFILE_ADDRS * sizeof(unsigned int));
+    for (addr = 0; addr < PROFILE_ADDRS; addr++) {
+        if (p->count[addr]) {
+            order[n++] = addr;
+        }
+    }
+    sort_key = p->cycles;
+    qsort(order, n, sizeof(unsigned int), cmp_desc);
+
+    mon_out("%lu instructions, %lu cycles\n", p->instructions,
+            (unsigned long)p->total);
+    mon_out("addr      cycles      %%      count  routine   instruction\n");
+    for (i = 0; i < count && (unsigned int)i < n && !mon_stop_output; i++) {
+        unsigned opc_size;
+        const char *dis;
+
+        addr = order[i];
+        dis = mon_disassemble_to_string_ex(mem, addr,
+                                           mon_get_mem_val(mem, (uint16_t)addr),
+                                           mon_get_mem_val(mem, (uint16_t)(addr + 1)),
+                                           mon_get_mem_val(mem, (uint16_t)(addr + 2)),
+                                           0, 1, &opc_size);
+        mon_out("%04x %11lu %6.2f %10lu  %-8s  %s\n", addr,
+                (unsigned long)p->cycles[addr], percent(p->cycles[addr], p->total),
+                p->count[addr], routine_name(mem, p->owner[addr] - 1, buf), dis);
+    }
+    lib_free(order);
+}
+
+void mon_profile_graph(int count)
+{
+    MEMSPACE mem = default_memspace;
+    profile_t *p = profile_for_output(mem);
+    uint64_t *self;
+    unsigned int *order, n = 0, addr;
+    char buf[8];
+    int i, e;
+
+    if (p == NULL) {
+        return;
+    }
+    if (count <= 0) {
+        count = PROFILE_DEFAULT_COUNT;
+    }
+
+    self = lib_calloc(PROFILE_ADDRS + 1, sizeof(uint64_t));
+    for (addr = 0; addr < PROFILE_ADDRS; addr++) {
+        if (p->count[addr]) {
+            self[p->owner[addr] - 1] += p->cycles[addr];
+        }
+    }
+    /* code outside of any call is "inside" the top level */
+    p->incl[PROFILE_TOP] = p->total;
+
+    order = lib_malloc((PROFILE_ADDRS + 1) * sizeof(unsigned int));
+    for (addr = 0; addr <= PROFILE_ADDRS; addr++) {
+        if (p->incl[addr] || self[addr]) {
+            order[n++] = addr;
+        }
+    }
+    sort_key = p->incl;
+    qsort(order, n, sizeof(unsigned int), cmp_desc);
+
+    mon_out("routine        calls   inclusive      %%        self      %%\n");
+    for (i = 0; i < count && (unsigned int)i < n && !mon_stop_output; i++) {
+        unsigned int r = order[i];
+
+        mon_out("%-10s %9lu %11lu %6.2f %11lu %6.2f\n",
+                routine_name(mem, r, buf), p->calls[r],
+                (unsigned long)p->incl[r], percent(p->incl[r], p->total),
+                (unsigned long)self[r], percent(self[r], p->total));
+        for (e = 0; e < p->edges_size; e++) {
+            profile_edge_t *edge = &p->edges[e];
+
+            if (edge->calls != 0 && edge->caller == r) {
+                mon_out("  -> %-10s %5lu %11lu %6.2f\n",
+                        routine_name(mem, edge->callee, buf), edge->calls,
+                        (unsigned long)edge->cycles, percent(edge->cycles, p->total));
+            }
+        }
+    }
+    lib_free(order);
+    lib_free(self);
+}
+
+/* Write the profile in the callgrind format, so it can be browsed with
+   KCachegrind and similar tools.  */
+void mon_profile_save(const char *filename)
+{
+    MEMSPACE mem = default_memspace;
+    profile_t *p = profile_for_output(mem);
+    FILE *fp;
+    profile_edge_t **edges;
+    unsigned int *order, addr, n = 0, m = 0, i, j;
+    char buf[8];
+    int e;
+
+    if (p == NULL) {
+        return;
+    }
+
+    fp = fopen(filename, MODE_WRITE);
+    if (fp == NULL) {
+        mon_out("Cannot create `%s'.\n", filename);
+        return;
+    }
+
+    fprintf(fp, "# callgrind format\n");
+    fprintf(fp, "version: 1\n");
+    fprintf(fp, "creator: VICE " VERSION "\n");
+    fprintf(fp, "cmd: %s\n", mon_memspace_string[mem]);
+    fprintf(fp, "positions: instr\n");
+    fprintf(fp, "events: Cycles Instructions\n");
+    fprintf(fp, "summary: %lu %lu\n", (unsigned long)p->total, p->instructions);
+
+    /* each fn block holds the addresses owned by the routine followed by
+       its calls */
+    order = lib_malloc(PROFILE_ADDRS * sizeof(unsigned int));
+    for (addr = 0; addr < PROFILE_ADDRS; addr++) {
+        if (p->count[addr]) {
+            order[n++] = addr;
+        }
+    }
+    sort_profile = p;
+    qsort(order, n, sizeof(unsigned int), cmp_owner);
+
+    edges = lib_malloc((size_t)(p->edges_used + 1) * sizeof(profile_edge_t *));
+    for (e = 0; e < p->edges_size; e++) {
+        if (p->edges[e].calls != 0) {
+            edges[m++] = &p->edges[e];
+        }
+    }
+    qsort(edges, m, sizeof(profile_edge_t *), cmp_caller);
+
+    i = j = 0;
+    while (i < n || j < m) {
+        unsigned int r;
+
+        if (j >= m || (i < n && p->owner[order[i]] - 1 <= edges[j]->caller)) {
+            r = p->owner[order[i]] - 1;
+        } else {
+            r = edges[j]->caller;
+        }
+        fprintf(fp, "\nfn=%s\n", routine_name(mem, r, buf));
+        for (; i < n && p->owner[order[i]] - 1 == r; i++) {
+            addr = order[i];
+            fprintf(fp, "0x%04x %lu %lu\n", addr,
+                    (unsigned long)p->cycles[addr], p->count[addr]);
+        }
+        for (; j < m && edges[j]->caller == r; j++) {
+            fprintf(fp, "cfn=%s\n", routine_name(mem, edges[j]->callee, buf));
+            fprintf(fp, "calls=%lu 0x%04x\n", edges[j]->calls, edges[j]->callee);
+            fprintf(fp, "0x%04x %lu\n", edges[j]->site, (unsigned long)edges[j]->cycles);
+        }
+    }
+    lib_free(edges);
+    lib_free(order);
+
+    if (fclose(fp) != 0) {
+        mon_out("Error writing `%s'.\n", filename);
+    }
+}
+
+void mon_profile_shutdown(void)
+{
+    int i;
+
+    for (i = 0; i < NUM_MEMSPACES; i++) {
+        if (profiles[i] != NULL) {
+            profile_free(profiles[i]);
+            profiles[i] = NULL;
+        }
+    }
+}
@@ -167,7 +167,10 @@ int mon_out(const char *format, ...)
     va_end(ap);
 
 #ifdef HAVE_NETWORK
-    if (monitor_is_remote()) {
+    if (monitor_is_binary()) {
+        /* binary clients only get framed responses */
+        rc = 0;
+    } else if (monitor_is_remote()) {
         rc = monitor_network_transmit(buffer, strlen(buffer));
     } else {
 #endif
@@ -262,13 +265,18 @@ char *uimon_in(const char *prompt)
 
 #ifdef HAVE_NETWORK
         if (monitor_is_remote()) {
-            if (monitor_network_transmit(prompt, strlen(prompt)) < 0) {
+            if (!monitor_is_binary()
+                && monitor_network_transmit(prompt, strlen(prompt)) < 0) {
               return NULL;
             }
 
             p = monitor_network_get_command_line();
             if (p == NULL) {
-                mon_set_command(NULL, "x", NULL);
+                /* binary step and exit commands leave the monitor by
+                   themselves, a pending "x" would end the next session */
+                if (!monitor_is_binary()) {
+                    mon_set_command(NULL, "x", NULL);
+                }
                 return NULL;
             }
         } else {
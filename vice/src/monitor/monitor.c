@@ -64,6 +64,7 @@
 #include "machine-video.h"
 #include "mem.h"
 #include "mon_breakpoint.h"
+#include "mon_cputrace.h"
 #include "mon_disassemble.h"
 #include "mon_memmap.h"
 #include "mon_memory.h"
@@ -74,6 +75,7 @@
 #endif
 
 #include "mon_parse.h"
+#include "mon_profile.h"
 #include "mon_register.h"
 #include "mon_ui.h"
 #include "mon_util.h"
@@ -81,6 +83,7 @@
 #include "monitor_network.h"
 #include "montypes.h"
 #include "resources.h"
+#include "rewind.h"
 #include "screenshot.h"
 #include "sysfile.h"
 #include "traps.h"
@@ -534,6 +537,22 @@ bool check_drive_emu_level_ok(int drive_num)
     return TRUE;
 }
 
+/* True if the CPU of `mem' is run by one of the 8 bit 65xx cores, which
+   can feed the CPU trace and profiler.  */
+bool mon_cpu_is_65xx(MEMSPACE mem)
+{
+    switch (monitor_cpu_for_memspace[mem]->cpu_type) {
+        case CPU_6502:
+        case CPU_6502DTV:
+        case CPU_WDC65C02:
+        case CPU_R65C02:
+        case CPU_65SC02:
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
 void monitor_cpu_type_set(const char *cpu_type)
 {
     int serchcpu;
@@ -1168,6 +1187,8 @@ void monitor_shutdown(void)
     int i;
 
     mon_log_file_close();
+    mon_cputrace_shutdown();
+    mon_profile_shutdown();
 
     list = monitor_cpu_type_list;
 
@@ -1835,6 +1856,28 @@ void mon_stack_up(int count)
     mon_out("Going up %d stack frame(s).\n", (count >= 0) ? count : 1);
 }
 
+void mon_rewind(int steps)
+{
+    int captures, keyframes, taken;
+    size_t bytes;
+    double seconds;
+
+    if (!rewind_get_info(&captures, &keyframes, &bytes, &seconds) || captures == 0) {
+        mon_out("No rewind history recorded (see the `Rewind' resource).\n");
+        return;
+    }
+
+    taken = rewind_step_back(steps);
+    if (taken < 0) {
+        mon_out("Rewind failed.\n");
+        return;
+    }
+
+    rewind_get_info(&captures, &keyframes, &bytes, &seconds);
+    mon_out("Rewound %d capture(s); %d left (%d keyframes, %lu KiB, %.1f seconds).\n",
+            taken, captures, keyframes, (unsigned long)(bytes / 1024), seconds);
+}
+
 void mon_stack_down(int count)
 {
     mon_out("Going down %d stack frame(s).\n", (count >= 0) ? count : 1);
@@ -1966,7 +2009,8 @@ void mon_delete_conditional(cond_node_t *cnode)
 
 void monitor_watch_push_load_addr(uint16_t addr, MEMSPACE mem)
 {
-    if (inside_monitor) {
+    /* most accesses are to unwatched addresses, drop those right here */
+    if (inside_monitor || !mon_breakpoint_check_map(mem, addr, e_load)) {
         return;
     }
 
@@ -1981,7 +2025,7 @@ void monitor_watch_push_load_addr(uint16_t addr, MEMSPACE mem)
 
 void monitor_watch_push_store_addr(uint16_t addr, MEMSPACE mem)
 {
-    if (inside_monitor) {
+    if (inside_monitor || !mon_breakpoint_check_map(mem, addr, e_store)) {
         return;
     }
 
@@ -2280,6 +2324,10 @@ static void monitor_open(void)
         mon_interfaces[default_memspace]->current_bank = monbank; /* restore value used in monitor */
         disassemble_on_entry = 0;
     }
+
+    if (monitor_is_remote()) {
+        monitor_network_stopped();
+    }
 }
 
 static int monitor_process(char *cmd)
@@ -2353,7 +2401,9 @@ static void monitor_close(int check)
 
     /* last_cmd = NULL; */
 
-    if (!monitor_is_remote()) {
+    if (monitor_is_remote()) {
+        monitor_network_resumed();
+    } else {
         if (mon_console_suspend_on_leaving) {
             /*
                 if there is no log, or if the console can not stay open when the emulation
@@ -38,6 +38,8 @@
 #include "cmdline.h"
 #include "lib.h"
 #include "log.h"
+#include "mon_breakpoint.h"
+#include "mon_register.h"
 #include "monitor.h"
 #include "monitor_network.h"
 #include "montypes.h"
@@ -56,7 +58,15 @@ static vice_network_socket_t * connected_socket = NULL;
 static char * monitor_server_address = NULL;
 static int monitor_enabled = 0;
 
-static int monitor_binary_input = 0;
+/* Bytes received from the client but not yet processed.  */
+static unsigned char *rx_buffer = NULL;
+static size_t rx_length = 0;
+static size_t rx_size = 0;
+
+/* Set once the client sent a framed binary command.  From then on, the
+   connection only carries binary frames from VICE: text output and
+   prompts are dropped, and stop/resume/JAM events are sent.  */
+static int binary_client = 0;
 
 
 int monitor_network_transmit(const char * buffer, size_t buffer_length)
@@ -80,6 +90,8 @@ static void monitor_network_quit(void)
 {
     vice_network_socket_close(connected_socket);
     connected_socket = NULL;
+    rx_length = 0;
+    binary_client = 0;
 }
 
 int monitor_network_receive(char * buffer, size_t buffer_length)
@@ -122,67 +134,23 @@ static int monitor_network_data_available(void)
 
 void monitor_check_remote(void)
 {
-    if (monitor_network_data_available()) {
+    /* commands pipelined after a step or exit are already buffered */
+    if ((connected_socket != NULL && rx_length > 0)
+        || monitor_network_data_available()) {
         monitor_startup_trap();
     }
 }
 
-static char * monitor_network_extract_text_command_line(char * pbuffer, int buffer_size, int * pbuffer_pos)
-{
-    char * cr_start = NULL;
-    char * cr_end = NULL;
-    char * p = NULL;
-
-    do {
-        cr_start = strchr(pbuffer, '\n');
-        cr_end = strchr(pbuffer, '\r');
-
-        if (cr_start || cr_end) {
-            if (cr_start == NULL) {
-                cr_start = cr_end;
-            } else if (cr_end == NULL) {
-                cr_end = cr_start;
-            } else if (cr_end < cr_start) {
-                char * cr_temp = cr_end;
-                cr_end = cr_start;
-                cr_start = cr_temp;
-            }
-
-            assert(cr_start != NULL);
-            assert(cr_end != NULL);
-        }
-
-        if (cr_start) {
-            assert(cr_end != NULL);
-
-            *cr_start = 0;
-            p = lib_stralloc(pbuffer);
-
-            memmove(pbuffer, cr_end + 1, strlen(cr_end + 1));
-
-            *pbuffer_pos -= (int)(strlen(p) + (cr_end - cr_start) + 1);
-            pbuffer[*pbuffer_pos] = 0;
-            break;
-        } else if (*pbuffer_pos >= buffer_size) {
-            /* we have a command that is too large:
-             * process it anyway, so the sender knows something is wrong
-             */
-            p = lib_stralloc(pbuffer);
-            *pbuffer_pos = 0;
-            pbuffer[0] = 0;
-            break;
-        }
-    } while (0);
-
-    return p;
-}
-
 /*
     The binary remote monitor commands are injected into the "normal" commands.
     The remote monitor detects a binary command because it starts with ASCII STX
-    (0x02). After this, there is one byte telling the length of the command. The
-    next byte describes the command. Currently, only 0x01 is implemented which
-    is "memdump".
+    (0x02).  There are two kinds of binary commands: the original "memdump"
+    command, and framed commands, which carry a request ID.
+
+    1. memdump
+
+    After the STX, there is one byte telling the length of the command. The
+    next byte describes the command, 0x01 for "memdump".
 
     Note that the command length byte (the one after STX) does *not* count the
     STX, the command length nor the command byte.
@@ -222,17 +190,113 @@ static char * monitor_network_extract_text_command_line(char * pbuffer, int buff
     0x00: ok, everything worked
     0x80: command length is not long enough for this specific command
     0x81: an invalid parameter occurred
+    0x83: the command is not known
+    0x8f: the command failed
 
     If an error stats but "ok" occurs, then VICE will output more details for
     the reason into its log. [...]
+
+    2. framed commands
+
+    A framed command has a version byte (0x02) where memdump has its length,
+    which memdump never uses.  All numbers are little endian.
+
+    byte 0: STX (0x02)
+    byte 1: API version (0x02)
+    byte 2-5: body length
+    byte 6-9: request ID, chosen by the client
+    byte 10: command
+    byte 11-: body
+
+    Every framed command is answered with one or more responses:
+
+    byte 0: STX (0x02)
+    byte 1: API version (0x02)
+    byte 2-5: body length
+    byte 6: response type, usually the command
+    byte 7: error code, see above
+    byte 8-11: request ID of the command, 0xffffffff for events
+    byte 12-: body
+
+    Commands are processed in order and may be sent without waiting for
+    the responses.  Commands that leave the monitor (advance, exit) let the
+    emulation run; the commands queued behind them are processed when the
+    monitor is entered again.
+
+    Once a framed command was received, the connection carries nothing but
+    frames: text output and prompts are no longer sent, and the events
+    below are sent whenever the monitor is entered or left.
+
+    Memspaces are numbered as for memdump.  In the bodies, a "checkpoint
+    info" is: number (4), start (2), end (2), stop (1), enabled (1),
+    operation (1, bit 0 load, bit 1 store, bit 2 exec), temporary (1),
+    hit count (4), ignore count (4), has condition (1), memspace (1).
+
+    0x01 memory get: side effects (1), start (2), end (2), memspace (1),
+         bank (2).  Response: the bytes from start to end inclusive.
+    0x02 memory set: side effects (1, unused), start (2), end (2),
+         memspace (1), bank (2), then the bytes to write.
+    0x11 checkpoint get: number (4).  Response: checkpoint info.
+    0x12 checkpoint set: start (2), end (2), stop (1), enabled (1),
+         operation (1), temporary (1), memspace (1).
+         Response: checkpoint info.
+    0x13 checkpoint delete: number (4).
+    0x14 checkpoint list: one 0x11 response per checkpoint, then a 0x14
+         response with the count (4).
+    0x15 checkpoint toggle: number (4), enabled (1).
+    0x31 registers get: memspace (1).  Response: count (2), then per
+         register: ID (1), size in bits (1), value (2), name length (1),
+         name.
+    0x32 registers set: memspace (1), count (2), then per register:
+         ID (1), value (2).  Response: as registers get.
+    0x71 advance instructions: step over subroutines (1), count (2).
+    0x81 ping: empty response.
+    0x82 banks available: memspace (1).  Response: count (2), then per
+         bank: ID (2), name length (1), name.
+    0xaa exit: leave the monitor and resume emulation.
+
+    Events:
+    0x61 JAM: the CPU jammed, body is the message text.  A stopped event
+         follows when the monitor is entered.
+    0x62 stopped: the monitor was entered, memspace (1), PC (2).
+    0x63 resumed: the monitor was left, memspace (1), PC (2).
 */
 
 #define ASC_STX 0x02
 #define MON_CMD_MEMDUMP 1
 
+#define MON_API_VERSION 0x02
+#define MON_FRAME_HEADER_SIZE 11
+#define MON_RESPONSE_HEADER_SIZE 12
+#define MON_FRAME_MAX_BODY 0x20000
+#define MON_EVENT_ID 0xffffffffu
+
+#define MON_CMD_MEM_GET                 0x01
+#define MON_CMD_MEM_SET                 0x02
+#define MON_CMD_CHECKPOINT_GET          0x11
+#define MON_CMD_CHECKPOINT_SET          0x12
+#define MON_CMD_CHECKPOINT_DELETE       0x13
+#define MON_CMD_CHECKPOINT_LIST         0x14
+#define MON_CMD_CHECKPOINT_TOGGLE       0x15
+#define MON_CMD_REGISTERS_GET           0x31
+#define MON_CMD_REGISTERS_SET           0x32
+#define MON_CMD_ADVANCE_INSTRUCTIONS    0x71
+#define MON_CMD_PING                    0x81
+#define MON_CMD_BANKS_AVAILABLE         0x82
+#define MON_CMD_EXIT                    0xaa
+
+#define MON_RESPONSE_CHECKPOINT_INFO    0x11
+#define MON_RESPONSE_REGISTER_INFO      0x31
+
+#define MON_EVENT_JAM                   0x61
+#define MON_EVENT_STOPPED               0x62
+#define MON_EVENT_RESUMED               0x63
+
 #define MON_ERR_OK            0
 #define MON_ERR_CMD_TOO_SHORT 0x80  /* command length is not enough for this command */
 #define MON_ERR_INVALID_PARAMETER 0x81  /* command has invalid parameters */
+#define MON_ERR_UNKNOWN_COMMAND 0x83  /* command is not known */
+#define MON_ERR_CMD_FAILURE   0x8f  /* command could not be executed */
 
 static void monitor_network_binary_answer(unsigned int length, unsigned char errorcode, unsigned char * answer)
 {
@@ -257,7 +321,53 @@ static void monitor_network_binary_error(unsigned char errorcode)
     monitor_network_binary_answer(0, errorcode, NULL);
 }
 
-static void monitor_network_process_binary_command(unsigned char * pbuffer, int buffer_size, int * pbuffer_pos, unsigned int command_length)
+static int binary_get_memspace(unsigned char value, MEMSPACE *memspace)
+{
+    switch (value) {
+        case 0: *memspace = e_comp_space; break;
+        case 1: *memspace = e_disk8_space; break;
+        case 2: *memspace = e_disk9_space; break;
+        case 3: *memspace = e_disk10_space; break;
+        case 4: *memspace = e_disk11_space; break;
+        default:
+            return -1;
+    }
+
+    if (mon_interfaces[*memspace] == NULL
+        || monitor_cpu_for_memspace[*memspace] == NULL) {
+        return -1;
+    }
+
+    if (monitor_diskspace_dnr(*memspace) >= 0
+        && !check_drive_emu_level_ok(monitor_diskspace_dnr(*memspace) + 8)) {
+        return -1;
+    }
+
+    return 0;
+}
+
+static unsigned char binary_memspace_id(MEMSPACE memspace)
+{
+    return memspace >= e_disk8_space ? (unsigned char)(memspace - e_disk8_space + 1) : 0;
+}
+
+/* Read a block through the memory interface of the memspace directly,
+   instead of going through mon_get_mem_val() for every byte.  */
+static void binary_mem_read(MEMSPACE memspace, int bank, int side_effects,
+                            unsigned int start, unsigned int length, unsigned char *dest)
+{
+    monitor_interface_t *mi = mon_interfaces[memspace];
+    uint8_t (*reader)(int bank, uint16_t addr, void *context);
+    unsigned int i;
+
+    reader = (side_effects || mi->mem_bank_peek == NULL) ? mi->mem_bank_read : mi->mem_bank_peek;
+
+    for (i = 0; i < length; i++) {
+        dest[i] = reader(bank, (uint16_t)ADDR_LIMIT(start + i), mi->context);
+    }
+}
+
+static void monitor_network_process_binary_command(unsigned char * pbuffer, unsigned int command_length)
 {
     int command = pbuffer[2];
     int ok = 1;
@@ -272,16 +382,10 @@ static void monitor_network_process_binary_command(unsigned char * pbuffer, int
 
                 MEMSPACE memspace = e_default_space;
 
-                switch (pbuffer[7]) {
-                    case 0: memspace = e_comp_space; break;
-                    case 1: memspace = e_disk8_space; break;
-                    case 2: memspace = e_disk9_space; break;
-                    case 3: memspace = e_disk10_space; break;
-                    case 4: memspace = e_disk11_space; break;
-                    default:
-                        monitor_network_binary_error(MON_ERR_INVALID_PARAMETER);
-                        log_message(LOG_DEFAULT, "monitor_network binary memdump: Unknown memspace %u", pbuffer[7]);
-                        ok = 0;
+                if (binary_get_memspace(pbuffer[7], &memspace) < 0) {
+                    monitor_network_binary_error(MON_ERR_INVALID_PARAMETER);
+                    log_message(LOG_DEFAULT, "monitor_network binary memdump: Unknown memspace %u", pbuffer[7]);
+                    ok = 0;
                 }
 
                 if (startaddress >= endaddress) {
@@ -294,13 +398,11 @@ static void monitor_network_process_binary_command(unsigned char * pbuffer, int
 
                 if (ok) {
                     unsigned int length = endaddress - startaddress + 1;
-                    unsigned int i;
 
                     unsigned char * p = lib_malloc(length);
 
-                    for (i = 0; i < length; i++) {
-                        p[i] = mon_get_mem_val(memspace, (uint16_t)ADDR_LIMIT(startaddress + i));
-                    }
+                    binary_mem_read(memspace, mon_interfaces[memspace]->current_bank, sidefx,
+                                    startaddress, length, p);
 
                     monitor_network_binary_answer(length, MON_ERR_OK, p);
                     lib_free(p);
@@ -312,62 +414,522 @@ static void monitor_network_process_binary_command(unsigned char * pbuffer, int
             log_message(LOG_DEFAULT, "monitor_network binary command: unknown command %u, skipping command length of %u", command, command_length);
             break;
     }
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void put_le(unsigned char *p, unsigned int value, int bytes)
+{
+    int i;
+
+    for (i = 0; i < bytes; i++) {
+        p[i] = (unsigned char)(value >> (i * 8));
+    }
+}
+
+static unsigned int get_le(const unsigned char *p, int bytes)
+{
+    unsigned int value = 0;
+    int i;
 
-    *pbuffer_pos = 0;
-    pbuffer[0] = 0;
+    for (i = bytes - 1; i >= 0; i--) {
+        value = (value << 8) | p[i];
+    }
+    return value;
 }
 
+/* Send a framed response.  The header and body go out in a single send,
+   so pipelined responses are not split into small packets.  */
+static void monitor_network_frame_response(unsigned char type, unsigned char errorcode,
+                                           unsigned int request_id,
+                                           const unsigned char *body, unsigned int length)
+{
+    unsigned char *frame = lib_malloc(MON_RESPONSE_HEADER_SIZE + length);
+
+    frame[0] = ASC_STX;
+    frame[1] = MON_API_VERSION;
+    put_le(frame + 2, length, 4);
+    frame[6] = type;
+    frame[7] = errorcode;
+    put_le(frame + 8, request_id, 4);
+    if (length > 0) {
+        memcpy(frame + MON_RESPONSE_HEADER_SIZE, body, length);
+    }
 
-char * monitor_network_get_command_line(void)
+    monitor_network_transmit((char *)frame, MON_RESPONSE_HEADER_SIZE + length);
+    lib_free(frame);
+}
+
+static void monitor_network_frame_error(unsigned char type, unsigned char errorcode,
+                                        unsigned int request_id)
 {
-    static char buffer[260] = { 0 };
-    static int bufferpos = 0;
+    monitor_network_frame_response(type, errorcode, request_id, NULL, 0);
+}
 
-    char * p = NULL;
+static int binary_bank_valid(MEMSPACE memspace, int bank)
+{
+    const char **bnp;
 
-    do {
-        /* Do not read more from network until all commands in current buffer is fully processed */
-        if (bufferpos == 0) {
-            int n = monitor_network_receive(buffer + bufferpos, sizeof buffer - bufferpos - 1);
+    if (mon_interfaces[memspace]->mem_bank_list == NULL) {
+        return bank == 0;
+    }
 
-            if (n > 0) {
-                bufferpos += n;
-            } else if (n <= 0) {
-                monitor_network_quit();
+    for (bnp = mon_interfaces[memspace]->mem_bank_list(); *bnp != NULL; bnp++) {
+        if (mon_interfaces[memspace]->mem_bank_from_name(*bnp) == bank) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void binary_checkpoint_info(const mon_checkpoint_info_t *info, unsigned int request_id)
+{
+    unsigned char body[22];
+
+    put_le(body, (unsigned int)info->checknum, 4);
+    put_le(body + 4, addr_location(info->start_addr), 2);
+    put_le(body + 6, addr_location(info->end_addr), 2);
+    body[8] = info->stop;
+    body[9] = info->enabled;
+    body[10] = (unsigned char)((info->check_load ? e_load : 0)
+                               | (info->check_store ? e_store : 0)
+                               | (info->check_exec ? e_exec : 0));
+    body[11] = info->temporary;
+    put_le(body + 12, (unsigned int)info->hit_count, 4);
+    put_le(body + 16, (unsigned int)info->ignore_count, 4);
+    body[20] = info->has_condition;
+    body[21] = binary_memspace_id(addr_memspace(info->start_addr));
+
+    monitor_network_frame_response(MON_RESPONSE_CHECKPOINT_INFO, MON_ERR_OK,
+                                   request_id, body, 22);
+}
+
+static void binary_registers_info(MEMSPACE memspace, unsigned int request_id)
+{
+    mon_reg_list_t *list, *regs;
+    unsigned char *body;
+    unsigned int length = 2, count = 0;
+
+    list = mon_register_list_get(memspace);
+
+    for (regs = list; regs->name != NULL; regs++) {
+        length += 5 + (unsigned int)strlen(regs->name);
+    }
+    body = lib_malloc(length);
+
+    length = 2;
+    for (regs = list; regs->name != NULL; regs++) {
+        size_t name_length = strlen(regs->name);
+
+        /* memory mapped registers and flag views have no register ID */
+        if (regs->flags & (MON_REGISTER_IS_MEMORY | MON_REGISTER_IS_FLAGS)) {
+            continue;
+        }
+        body[length] = (unsigned char)regs->id;
+        body[length + 1] = (unsigned char)regs->size;
+        put_le(body + length + 2, regs->val, 2);
+        body[length + 4] = (unsigned char)name_length;
+        memcpy(body + length + 5, regs->name, name_length);
+        length += 5 + (unsigned int)name_length;
+        count++;
+    }
+    put_le(body, count, 2);
+
+    monitor_network_frame_response(MON_RESPONSE_REGISTER_INFO, MON_ERR_OK,
+                                   request_id, body, length);
+    lib_free(body);
+    lib_free(list);
+}
+
+/* Process one framed command.  Return nonzero if the monitor should be
+   left.  */
+static int monitor_network_process_frame(unsigned char command, unsigned int request_id,
+                                         const unsigned char *body, unsigned int length)
+{
+    MEMSPACE memspace;
+    mon_checkpoint_info_t info;
+    unsigned int start, end, i;
+    int bank;
+
+    switch (command) {
+        case MON_CMD_MEM_GET:
+        case MON_CMD_MEM_SET:
+            if (length < 8) {
                 break;
             }
+            start = get_le(body + 1, 2);
+            end = get_le(body + 3, 2);
+            bank = (int)get_le(body + 6, 2);
+            if (end < start || binary_get_memspace(body[5], &memspace) < 0
+                || !binary_bank_valid(memspace, bank)) {
+                monitor_network_frame_error(command, MON_ERR_INVALID_PARAMETER, request_id);
+                return 0;
+            }
+            if (command == MON_CMD_MEM_GET) {
+                unsigned char *data = lib_malloc(end - start + 1);
+
+                binary_mem_read(memspace, bank, body[0], start, end - start + 1, data);
+                monitor_network_frame_response(command, MON_ERR_OK, request_id,
+                                               data, end - start + 1);
+                lib_free(data);
+            } else {
+                monitor_interface_t *mi = mon_interfaces[memspace];
 
-            /* check if we got a binary command */
-            if (bufferpos == n) {
-                if (buffer[0] == ASC_STX) {
-                    monitor_binary_input = 1;
+                if (length < 8 + end - start + 1) {
+                    break;
+                }
+                for (i = start; i <= end; i++) {
+                    mi->mem_bank_write(bank, (uint16_t)i, body[8 + i - start], mi->context);
                 }
+                monitor_network_frame_error(command, MON_ERR_OK, request_id);
             }
-        }
+            return 0;
 
-        if (monitor_binary_input) {
-            if (bufferpos > 2) {
-                /* we already got the length, get it */
-                unsigned int command_length = buffer[1];
+        case MON_CMD_CHECKPOINT_GET:
+            if (length < 4) {
+                break;
+            }
+            if (!mon_breakpoint_get_info((int)get_le(body, 4), &info)) {
+                monitor_network_frame_error(command, MON_ERR_INVALID_PARAMETER, request_id);
+            } else {
+                binary_checkpoint_info(&info, request_id);
+            }
+            return 0;
 
-                if (3 + command_length <= (unsigned int)bufferpos) {
-                    monitor_network_process_binary_command((unsigned char*)buffer, sizeof buffer, &bufferpos, command_length);
-                    monitor_binary_input = 0;
+        case MON_CMD_CHECKPOINT_SET:
+            if (length < 9) {
+                break;
+            }
+            start = get_le(body, 2);
+            end = get_le(body + 2, 2);
+            if (end < start || (body[6] & ~(e_load | e_store | e_exec)) != 0
+                || body[6] == 0 || binary_get_memspace(body[8], &memspace) < 0) {
+                monitor_network_frame_error(command, MON_ERR_INVALID_PARAMETER, request_id);
+            } else {
+                /* temporary checkpoints make the text monitor leave at once;
+                   binary clients decide that themselves */
+                int old_exit_mon = exit_mon;
+                int checknum = mon_breakpoint_add_checkpoint(new_addr(memspace, start),
+                                                             new_addr(memspace, end),
+                                                             body[4] != 0,
+                                                             (MEMORY_OP)body[6],
+                                                             body[7] != 0);
+                exit_mon = old_exit_mon;
+                if (!body[5]) {
+                    mon_breakpoint_switch_checkpoint(e_OFF, checknum);
                 }
+                mon_breakpoint_get_info(checknum, &info);
+                binary_checkpoint_info(&info, request_id);
+            }
+            return 0;
+
+        case MON_CMD_CHECKPOINT_DELETE:
+        case MON_CMD_CHECKPOINT_TOGGLE:
+            if (length < (command == MON_CMD_CHECKPOINT_TOGGLE ? 5u : 4u)) {
+                break;
+            }
+            if (!mon_breakpoint_get_info((int)get_le(body, 4), &info)) {
+                monitor_network_frame_error(command, MON_ERR_INVALID_PARAMETER, request_id);
             } else {
-                bufferpos = 0;
+                if (command == MON_CMD_CHECKPOINT_DELETE) {
+                    mon_breakpoint_delete_checkpoint(info.checknum);
+                } else {
+                    mon_breakpoint_switch_checkpoint(body[4] ? e_ON : e_OFF, info.checknum);
+                }
+                monitor_network_frame_error(command, MON_ERR_OK, request_id);
+            }
+            return 0;
+
+        case MON_CMD_CHECKPOINT_LIST:
+            {
+                unsigned char count[4];
+                int n = 0, checknum;
+
+                for (checknum = 1; checknum <= mon_breakpoint_last_checknum(); checknum++) {
+                    if (mon_breakpoint_get_info(checknum, &info)) {
+                        binary_checkpoint_info(&info, request_id);
+                        n++;
+                    }
+                }
+                put_le(count, (unsigned int)n, 4);
+                monitor_network_frame_response(command, MON_ERR_OK, request_id, count, 4);
+            }
+            return 0;
+
+        case MON_CMD_REGISTERS_GET:
+            if (length < 1) {
+                break;
             }
-            monitor_binary_input = 0;
+            if (binary_get_memspace(body[0], &memspace) < 0) {
+                monitor_network_frame_error(command, MON_ERR_INVALID_PARAMETER, request_id);
+            } else {
+                binary_registers_info(memspace, request_id);
+            }
+            return 0;
+
+        case MON_CMD_REGISTERS_SET:
+            {
+                unsigned int count;
+
+                if (length < 3) {
+                    break;
+                }
+                count = get_le(body + 1, 2);
+                if (length < 3 + count * 3) {
+                    break;
+                }
+                if (binary_get_memspace(body[0], &memspace) < 0) {
+                    monitor_network_frame_error(command, MON_ERR_INVALID_PARAMETER, request_id);
+                    return 0;
+                }
+                for (i = 0; i < count; i++) {
+                    if (!mon_register_valid(memspace, body[3 + i * 3])) {
+                        monitor_network_frame_error(command, MON_ERR_INVALID_PARAMETER, request_id);
+                        return 0;
+                    }
+                }
+                for (i = 0; i < count; i++) {
+                    monitor_cpu_for_memspace[memspace]->mon_register_set_val(memspace,
+                        body[3 + i * 3], (uint16_t)get_le(body + 4 + i * 3, 2));
+                }
+                binary_registers_info(memspace, request_id);
+            }
+            return 0;
+
+        case MON_CMD_ADVANCE_INSTRUCTIONS:
+            if (length < 3) {
+                break;
+            }
+            monitor_network_frame_error(command, MON_ERR_OK, request_id);
+            if (body[0]) {
+                mon_instructions_next((int)get_le(body + 1, 2));
+            } else {
+                mon_instructions_step((int)get_le(body + 1, 2));
+            }
+            return 1;
+
+        case MON_CMD_PING:
+            monitor_network_frame_error(command, MON_ERR_OK, request_id);
+            return 0;
+
+        case MON_CMD_BANKS_AVAILABLE:
+            {
+                const char **bnp;
+                unsigned char *data;
+                unsigned int size = 2, count = 0;
+
+                if (length < 1) {
+                    break;
+                }
+                if (binary_get_memspace(body[0], &memspace) < 0) {
+                    monitor_network_frame_error(command, MON_ERR_INVALID_PARAMETER, request_id);
+                    return 0;
+                }
+                if (mon_interfaces[memspace]->mem_bank_list == NULL) {
+                    monitor_network_frame_error(command, MON_ERR_CMD_FAILURE, request_id);
+                    return 0;
+                }
+                for (bnp = mon_interfaces[memspace]->mem_bank_list(); *bnp != NULL; bnp++) {
+                    size += 3 + (unsigned int)strlen(*bnp);
+                }
+                data = lib_malloc(size);
+                size = 2;
+                for (bnp = mon_interfaces[memspace]->mem_bank_list(); *bnp != NULL; bnp++) {
+                    size_t name_length = strlen(*bnp);
+
+                    put_le(data + size, (unsigned int)mon_interfaces[memspace]->mem_bank_from_name(*bnp), 2);
+                    data[size + 2] = (unsigned char)name_length;
+                    memcpy(data + size + 3, *bnp, name_length);
+                    size += 3 + (unsigned int)name_length;
+                    count++;
+                }
+                put_le(data, count, 2);
+                monitor_network_frame_response(command, MON_ERR_OK, request_id, data, size);
+                lib_free(data);
+            }
+            return 0;
+
+        case MON_CMD_EXIT:
+            monitor_network_frame_error(command, MON_ERR_OK, request_id);
+            mon_exit();
+            return 1;
+
+        default:
+            log_message(LOG_DEFAULT, "monitor_network binary command: unknown command %u", command);
+            monitor_network_frame_error(command, MON_ERR_UNKNOWN_COMMAND, request_id);
+            return 0;
+    }
+
+    monitor_network_frame_error(command, MON_ERR_CMD_TOO_SHORT, request_id);
+    return 0;
+}
+
+static void monitor_network_event(unsigned char type, const unsigned char *body, unsigned int length)
+{
+    if (connected_socket != NULL && binary_client) {
+        monitor_network_frame_response(type, MON_ERR_OK, MON_EVENT_ID, body, length);
+    }
+}
+
+static void monitor_network_pc_event(unsigned char type)
+{
+    unsigned char body[3];
+
+    body[0] = binary_memspace_id(default_memspace);
+    put_le(body + 1, (monitor_cpu_for_memspace[default_memspace]->mon_register_get_val)(default_memspace, e_PC), 2);
+    monitor_network_event(type, body, 3);
+}
+
+void monitor_network_stopped(void)
+{
+    monitor_network_pc_event(MON_EVENT_STOPPED);
+}
+
+void monitor_network_resumed(void)
+{
+    monitor_network_pc_event(MON_EVENT_RESUMED);
+}
+
+int monitor_is_binary(void)
+{
+    return connected_socket != NULL && binary_client;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void rx_consume(size_t count)
+{
+    memmove(rx_buffer, rx_buffer + count, rx_length - count);
+    rx_length -= count;
+}
+
+/* Take a text command line from the receive buffer, or return NULL if the
+   line is not complete yet.  */
+static char * monitor_network_extract_text_command_line(void)
+{
+    size_t i;
+    char * p;
+
+    for (i = 0; i < rx_length; i++) {
+        if (rx_buffer[i] == '\n' || rx_buffer[i] == '\r') {
+            break;
+        }
+    }
+
+    if (i == rx_length) {
+        if (rx_length < 256) {
+            return NULL;
+        }
+        /* we have a command that is too large:
+         * process it anyway, so the sender knows something is wrong
+         */
+    }
+
+    p = lib_malloc(i + 1);
+    memcpy(p, rx_buffer, i);
+    p[i] = 0;
+
+    if (i < rx_length) {
+        /* skip a "\r\n" or "\n\r" pair as one line end */
+        if (i + 1 < rx_length && rx_buffer[i + 1] != rx_buffer[i]
+            && (rx_buffer[i + 1] == '\n' || rx_buffer[i + 1] == '\r')) {
+            i++;
+        }
+        i++;
+    }
+    rx_consume(i);
+
+    return p;
+}
+
+/* Process the binary commands at the start of the receive buffer.  Return
+   1 if a text command line follows, 0 if more data is needed and -1 if
+   the monitor should be left.  */
+static int monitor_network_process_binary(void)
+{
+    while (rx_length > 0) {
+        if (rx_buffer[0] != ASC_STX) {
+            return 1;
+        }
+        if (rx_length < 2) {
+            return 0;
+        }
+
+        if (rx_buffer[1] == MON_API_VERSION) {
+            unsigned int length;
+
+            if (rx_length < MON_FRAME_HEADER_SIZE) {
+                return 0;
+            }
+            length = get_le(rx_buffer + 2, 4);
+            if (length > MON_FRAME_MAX_BODY) {
+                log_message(LOG_DEFAULT, "monitor_network binary command: frame of %u bytes is too large, closing connection", length);
+                monitor_network_quit();
+                return -1;
+            }
+            if (rx_length < MON_FRAME_HEADER_SIZE + length) {
+                return 0;
+            }
+
+            binary_client = 1;
+            if (monitor_network_process_frame(rx_buffer[10], get_le(rx_buffer + 6, 4),
+                                              rx_buffer + MON_FRAME_HEADER_SIZE, length)) {
+                rx_consume(MON_FRAME_HEADER_SIZE + length);
+                return -1;
+            }
+            rx_consume(MON_FRAME_HEADER_SIZE + length);
         } else {
-            p = monitor_network_extract_text_command_line(buffer, sizeof buffer, &bufferpos);
+            unsigned int command_length;
+
+            if (rx_length < 3) {
+                return 0;
+            }
+            command_length = rx_buffer[1];
+            if (3 + command_length > rx_length) {
+                return 0;
+            }
+            monitor_network_process_binary_command(rx_buffer, command_length);
+            rx_consume(3 + command_length);
+        }
+    }
+
+    return 0;
+}
+
+char * monitor_network_get_command_line(void)
+{
+    char * p = NULL;
+
+    do {
+        int state = monitor_network_process_binary();
+
+        if (state < 0) {
+            break;
+        }
+
+        if (state > 0) {
+            p = monitor_network_extract_text_command_line();
             if (p) {
                 break;
-            } else {
-                /* if no cmd was returned - reset buffer to start and fetch new cmd. */
-                bufferpos = 0;
             }
         }
 
+        /* the buffered data does not hold a complete command, get more */
+        if (rx_size - rx_length < 4096) {
+            rx_size = rx_size ? rx_size * 2 : 8192;
+            rx_buffer = lib_realloc(rx_buffer, rx_size);
+        }
+
+        {
+            int n = monitor_network_receive((char *)rx_buffer + rx_length, rx_size - rx_length);
+
+            if (n <= 0) {
+                monitor_network_quit();
+                break;
+            }
+            rx_length += (size_t)n;
+        }
+
         ui_dispatch_events();
     } while (1);
 
@@ -565,9 +1127,13 @@ ui_jam_action_t monitor_network_ui_jam_dialog(const char *format, ...)
     txt = lib_mvsprintf(format, ap);
     va_end(ap);
 
-    monitor_network_transmit(init_string, sizeof init_string - 1);
-    monitor_network_transmit(txt, strlen(txt));
-    monitor_network_transmit(end_string, sizeof end_string - 1);
+    if (binary_client) {
+        monitor_network_event(MON_EVENT_JAM, (const unsigned char *)txt, (unsigned int)strlen(txt));
+    } else {
+        monitor_network_transmit(init_string, sizeof init_string - 1);
+        monitor_network_transmit(txt, strlen(txt));
+        monitor_network_transmit(end_string, sizeof end_string - 1);
+    }
 
     lib_free(txt);
 
@@ -609,6 +1175,19 @@ int monitor_is_remote(void)
     return 0;
 }
 
+int monitor_is_binary(void)
+{
+    return 0;
+}
+
+void monitor_network_stopped(void)
+{
+}
+
+void monitor_network_resumed(void)
+{
+}
+
 ui_jam_action_t monitor_network_ui_jam_dialog(const char *format, ...)
 {
     return UI_JAM_HARD_RESET;
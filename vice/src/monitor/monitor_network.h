@@ -44,6 +44,10 @@ extern int monitor_network_transmit(const char * buffer, size_t buffer_length);
 extern char * monitor_network_get_command_line(void);
 
 extern int monitor_is_remote(void);
+extern int monitor_is_binary(void);
+
+extern void monitor_network_stopped(void);
+extern void monitor_network_resumed(void);
 
 extern ui_jam_action_t monitor_network_ui_jam_dialog(const char *format, ...);
 
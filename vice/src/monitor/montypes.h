@@ -252,6 +252,7 @@ extern void mon_display_screen(void);
 extern void mon_instructions_step(int count);
 extern void mon_instructions_next(int count);
 extern void mon_instruction_return(void);
+extern void mon_rewind(int steps);
 extern void mon_stack_up(int count);
 extern void mon_stack_down(int count);
 extern void mon_print_convert(int val);
@@ -269,6 +270,7 @@ extern long mon_evaluate_address_range(MON_ADDR *start_addr, MON_ADDR *end_addr,
                                        bool must_be_range, uint16_t default_len);
 
 extern bool check_drive_emu_level_ok(int drive_num);
+extern bool mon_cpu_is_65xx(MEMSPACE mem);
 extern void mon_print_conditional(cond_node_t *cnode);
 extern void mon_delete_conditional(cond_node_t *cnode);
 extern int mon_evaluate_conditional(cond_node_t *cnode);
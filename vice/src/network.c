@@ -40,6 +40,7 @@
 
 #include "archdep.h"
 #include "cmdline.h"
+#include "crc32.h"
 #include "interrupt.h"
 #include "lib.h"
 #include "log.h"
@@ -48,6 +49,7 @@
 #include "mos6510.h"
 #include "network.h"
 #include "resources.h"
+#include "snapshot.h"
 #include "types.h"
 #include "uiapi.h"
 #include "util.h"
@@ -78,6 +80,60 @@ static int current_frame, frame_to_play;
 static event_list_state_t *frame_event_list = NULL;
 static char *snapshotfilename;
 
+static int rollback_enabled;
+static int rollback_window;
+static int test_latency;
+static int test_jitter;
+
+/* Number of frames the local input may run ahead of the confirmed remote
+   input; 0 selects the classic lockstep mode. Agreed on at connect time. */
+static int rollback_frames;
+
+/* Messages held back to simulate a slow connection.  */
+typedef struct network_delayed_s {
+    unsigned long due;
+    uint8_t *buf;
+    unsigned int len;
+    struct network_delayed_s *next;
+} network_delayed_t;
+
+static network_delayed_t *delayed_head = NULL;
+static network_delayed_t *delayed_tail = NULL;
+
+/* Rollback mode keeps the input and the machine state at the start of the
+   last frames in a ring, indexed by frame number.  */
+#define ROLLBACK_SLOTS          64
+#define ROLLBACK_FRAMES_MAX     30
+#define ROLLBACK_HASH_INTERVAL  10
+
+typedef struct rollback_frame_s {
+    int frame;
+    event_list_state_t *local;
+    event_list_state_t *remote;
+    uint8_t *state;
+    size_t state_size;
+    size_t state_alloc;
+    uint32_t hash;
+    int hash_valid;
+    uint32_t remote_hash;
+    int remote_hash_valid;
+} rollback_frame_t;
+
+static rollback_frame_t rollback_ring[ROLLBACK_SLOTS];
+static event_list_state_t rollback_pending;
+static snapshot_stream_t *rollback_stream = NULL;
+
+/* Frames below rollback_created have their local input fixed, frames below
+   rollback_confirmed have the remote input too, and rollback_next is the
+   next frame to be emulated.  */
+static int rollback_created;
+static int rollback_confirmed;
+static int rollback_next;
+static int rollback_from;
+static int rollback_rerun;
+static int rollback_hash_next;
+static int rollback_hash_unsent;
+
 static int set_server_name(const char *val, void *param)
 {
     util_string_set(&server_name, val);
@@ -113,6 +169,42 @@ static int set_network_control(int val, void *param)
     return 0;
 }
 
+static int set_rollback_enabled(int val, void *param)
+{
+    rollback_enabled = val ? 1 : 0;
+    return 0;
+}
+
+static int set_rollback_window(int val, void *param)
+{
+    if (val < 1 || val > ROLLBACK_FRAMES_MAX) {
+        return -1;
+    }
+
+    rollback_window = val;
+    return 0;
+}
+
+static int set_test_latency(int val, void *param)
+{
+    if (val < 0 || val > 1000) {
+        return -1;
+    }
+
+    test_latency = val;
+    return 0;
+}
+
+static int set_test_jitter(int val, void *param)
+{
+    if (val < 0 || val > 1000) {
+        return -1;
+    }
+
+    test_jitter = val;
+    return 0;
+}
+
 /*---------- Resources ------------------------------------------------*/
 
 static const resource_string_t resources_string[] = {
@@ -128,6 +220,14 @@ static const resource_int_t resources_int[] = {
       &res_server_port, set_server_port, NULL },
     { "NetworkControl", NETWORK_CONTROL_DEFAULT, RES_EVENT_SAME, NULL,
       &network_control, set_network_control, NULL },
+    { "NetworkRollback", 0, RES_EVENT_NO, NULL,
+      &rollback_enabled, set_rollback_enabled, NULL },
+    { "NetworkRollbackFrames", 8, RES_EVENT_NO, NULL,
+      &rollback_window, set_rollback_window, NULL },
+    { "NetworkTestLatency", 0, RES_EVENT_NO, NULL,
+      &test_latency, set_test_latency, NULL },
+    { "NetworkTestJitter", 0, RES_EVENT_NO, NULL,
+      &test_jitter, set_test_jitter, NULL },
     RESOURCE_INT_LIST_END
 };
 
@@ -212,6 +312,21 @@ static const cmdline_option_t cmdline_options[] =
     { "-netplayctrl", CALL_FUNCTION, CMDLINE_ATTRIB_NEED_ARGS,
       network_control_cmd, NULL, NULL, NULL,
       "<key,joy1,joy2,dev,rsrc>", "Set the netplay control elements (keyboard, joystick1, joystick2, devices and resources), each item takes a value (0: None, 1: Server, 2: Client, 3: Both)" },
+    { "-netplayrollback", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "NetworkRollback", (resource_value_t)1,
+      NULL, "Predict the remote input and roll back on mismatch instead of waiting for it (set on the server)" },
+    { "+netplayrollback", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "NetworkRollback", (resource_value_t)0,
+      NULL, "Run netplay in lockstep with a fixed input delay" },
+    { "-netplayrollbackframes", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "NetworkRollbackFrames", NULL,
+      "<frames>", "Set how many frames the netplay input may be predicted ahead (1..30)" },
+    { "-netplaylatency", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "NetworkTestLatency", NULL,
+      "<ms>", "Delay outgoing netplay frames by this many milliseconds, for testing" },
+    { "-netplayjitter", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "NetworkTestJitter", NULL,
+      "<ms>", "Add up to this many milliseconds of random delay to outgoing netplay frames, for testing" },
     CMDLINE_LIST_END
 };
 
@@ -343,8 +458,9 @@ static int network_recv_buffer(vice_network_socket_t * s, uint8_t *buf, int len)
     while (received_total < len) {
         t = vice_network_receive(s, buf, len - received_total, 0);
 
-        if (t < 0) {
-            return t;
+        /* 0 means the remote side closed the connection */
+        if (t <= 0) {
+            return -1;
         }
 
         received_total += t;
@@ -377,8 +493,442 @@ static int network_send_buffer(vice_network_socket_t * s, const uint8_t *buf, in
     return 0;
 }
 
+/* Send all held back messages that are due, or all of them.  */
+static int network_flush_delayed(int all)
+{
+    network_delayed_t *d;
+    unsigned long now = vsyncarch_gettime();
+    int ret = 0;
+
+    while (delayed_head != NULL
+           && (all || (signed long)(now - delayed_head->due) >= 0)) {
+        d = delayed_head;
+        delayed_head = d->next;
+        if (ret == 0) {
+            ret = network_send_buffer(network_socket, d->buf, (int)d->len);
+        }
+        lib_free(d->buf);
+        lib_free(d);
+    }
+    if (delayed_head == NULL) {
+        delayed_tail = NULL;
+    }
+    return ret;
+}
+
+static void network_free_delayed(void)
+{
+    network_delayed_t *d;
+
+    while (delayed_head != NULL) {
+        d = delayed_head;
+        delayed_head = d->next;
+        lib_free(d->buf);
+        lib_free(d);
+    }
+    delayed_tail = NULL;
+}
+
+/* Send a length prefixed message, held back by the configured test latency
+   and jitter if any.  */
+static int network_send_message(const uint8_t *buf, unsigned int len)
+{
+    network_delayed_t *d;
+    unsigned long delay;
+
+    if (test_latency == 0 && test_jitter == 0 && delayed_head == NULL) {
+        uint8_t len4[4];
+
+        util_int_to_le_buf4(len4, (int)len);
+        if (network_send_buffer(network_socket, len4, 4) < 0
+            || network_send_buffer(network_socket, buf, (int)len) < 0) {
+            return -1;
+        }
+        return 0;
+    }
+
+    delay = test_latency;
+    if (test_jitter > 0) {
+        delay += lib_unsigned_rand(0, test_jitter);
+    }
+
+    d = lib_malloc(sizeof(network_delayed_t));
+    d->buf = lib_malloc(len + 4);
+    d->len = len + 4;
+    d->next = NULL;
+    util_int_to_le_buf4(d->buf, (int)len);
+    memcpy(d->buf + 4, buf, len);
+    d->due = vsyncarch_gettime() + delay * (vsyncarch_frequency() / 1000);
+
+    /* the stream stays in order, jitter only bunches messages up */
+    if (delayed_tail != NULL) {
+        if ((signed long)(d->due - delayed_tail->due) < 0) {
+            d->due = delayed_tail->due;
+        }
+        delayed_tail->next = d;
+    } else {
+        delayed_head = d;
+    }
+    delayed_tail = d;
+
+    return network_flush_delayed(0);
+}
+
+/* Wait for incoming data while still sending the held back messages, so
+   that two peers with test latency cannot wait for each other.  */
+static int network_wait_data(void)
+{
+    int ret;
+
+    while ((ret = vice_network_select_poll_one(network_socket)) == 0) {
+        if (network_flush_delayed(0) < 0) {
+            return -1;
+        }
+        vsyncarch_sleep(vsyncarch_frequency() / 1000);
+    }
+    return ret < 0 ? -1 : 0;
+}
+
+/*-------------------------------------------------------------------------*/
+
+/* Rollback mode: the local input of a frame is sent right away and the
+   frame is emulated without waiting for the remote input, predicting that
+   the remote keyboard and joysticks did not change.  The machine state at
+   the start of every frame is kept in memory; when remote input turns out
+   to differ from the prediction, the oldest affected frame is restored and
+   the frames up to the present are emulated again, without being shown.
+   Every ROLLBACK_HASH_INTERVAL frames a checksum of a fully confirmed state
+   is exchanged to detect a desync.  */
+
+static void rollback_slot_clear(rollback_frame_t *slot, int frame)
+{
+    if (slot->local != NULL) {
+        event_clear_list(slot->local);
+        lib_free(slot->local);
+        slot->local = NULL;
+    }
+    if (slot->remote != NULL) {
+        event_clear_list(slot->remote);
+        lib_free(slot->remote);
+        slot->remote = NULL;
+    }
+    slot->frame = frame;
+    slot->state_size = 0;
+    slot->hash_valid = 0;
+    slot->remote_hash_valid = 0;
+}
+
+static rollback_frame_t *rollback_slot(int frame)
+{
+    rollback_frame_t *slot = &rollback_ring[frame % ROLLBACK_SLOTS];
+
+    if (slot->frame != frame) {
+        rollback_slot_clear(slot, frame);
+    }
+    return slot;
+}
+
+static void rollback_init(void)
+{
+    int i;
+
+    for (i = 0; i < ROLLBACK_SLOTS; i++) {
+        rollback_ring[i].frame = -1;
+    }
+    rollback_created = 0;
+    rollback_confirmed = 0;
+    rollback_next = 0;
+    rollback_from = -1;
+    rollback_rerun = 0;
+    rollback_hash_next = 0;
+    rollback_hash_unsent = -1;
+
+    event_register_event_list(&rollback_pending);
+    event_init_image_list();
+}
+
+static void rollback_free(void)
+{
+    int i;
+
+    for (i = 0; i < ROLLBACK_SLOTS; i++) {
+        rollback_slot_clear(&rollback_ring[i], -1);
+        lib_free(rollback_ring[i].state);
+        rollback_ring[i].state = NULL;
+        rollback_ring[i].state_alloc = 0;
+    }
+    if (rollback_pending.base != NULL) {
+        event_clear_list(&rollback_pending);
+        rollback_pending.base = NULL;
+        event_destroy_image_list();
+    }
+    if (rollback_stream != NULL) {
+        snapshot_memory_stream_free(rollback_stream);
+        rollback_stream = NULL;
+    }
+    rollback_rerun = 0;
+}
+
+static int rollback_check_hash(rollback_frame_t *slot)
+{
+    if (slot->hash_valid && slot->remote_hash_valid
+        && slot->hash != slot->remote_hash) {
+        log_error(LOG_DEFAULT, "netplay: state of frame %d differs from remote.",
+                  slot->frame);
+        ui_error("Network out of sync - disconnecting.");
+        network_disconnect();
+        return -1;
+    }
+    return 0;
+}
+
+static int rollback_capture(rollback_frame_t *slot)
+{
+    size_t size;
+
+    if (rollback_stream == NULL) {
+        rollback_stream = snapshot_memory_stream_new();
+    }
+
+    if (machine_write_snapshot_stream(rollback_stream, 0, 0, 0) < 0) {
+        return -1;
+    }
+
+    size = snapshot_memory_stream_size(rollback_stream);
+    if (size > slot->state_alloc) {
+        slot->state = lib_realloc(slot->state, size);
+        slot->state_alloc = size;
+    }
+    memcpy(slot->state, snapshot_memory_stream_data(rollback_stream), size);
+    slot->state_size = size;
+    return 0;
+}
+
+static void rollback_frame_trap(uint16_t addr, void *data)
+{
+    rollback_frame_t *slot;
+    event_list_state_t *client_list, *server_list;
+
+    if (!network_connected()) {
+        return;
+    }
+
+    if (rollback_from >= 0) {
+        slot = rollback_slot(rollback_from);
+        snapshot_memory_stream_set_data(rollback_stream, slot->state,
+                                        slot->state_size);
+        if (machine_read_snapshot_stream(rollback_stream, 0) < 0) {
+            ui_error("Cannot restore netplay state - disconnecting.");
+            network_disconnect();
+            return;
+        }
+        rollback_next = rollback_from;
+        rollback_from = -1;
+    }
+
+    slot = rollback_slot(rollback_next);
+    if (rollback_capture(slot) < 0) {
+        ui_error("Cannot save netplay state - disconnecting.");
+        network_disconnect();
+        return;
+    }
+
+    /* The states up to here were emulated with confirmed input only.  */
+    while (rollback_hash_next <= rollback_next
+           && rollback_hash_next <= rollback_confirmed) {
+        rollback_frame_t *hashed = rollback_slot(rollback_hash_next);
+
+        if (!hashed->hash_valid) {
+            hashed->hash = crc32_buf((const char *)hashed->state,
+                                     (unsigned int)hashed->state_size);
+            hashed->hash_valid = 1;
+            rollback_hash_unsent = rollback_hash_next;
+            if (rollback_check_hash(hashed) < 0) {
+                return;
+            }
+        }
+        rollback_hash_next += ROLLBACK_HASH_INTERVAL;
+    }
+
+    /* A missing remote list predicts that nothing changed remotely.  */
+    if (network_mode == NETWORK_SERVER_CONNECTED) {
+        server_list = slot->local;
+        client_list = slot->remote;
+    } else {
+        server_list = slot->remote;
+        client_list = slot->local;
+    }
+    if (server_list != NULL) {
+        event_playback_event_list(server_list);
+    }
+    if (client_list != NULL) {
+        event_playback_event_list(client_list);
+    }
+
+    rollback_next++;
+}
+
+static int rollback_send_frame(void)
+{
+    rollback_frame_t *slot = rollback_slot(rollback_created);
+    uint8_t *event_buf = NULL;
+    uint8_t *buf;
+    unsigned int len;
+    int ret;
+
+    slot->local = lib_malloc(sizeof(event_list_state_t));
+    *slot->local = rollback_pending;
+    event_register_event_list(&rollback_pending);
+
+    len = network_create_event_buffer(&event_buf, slot->local);
+    buf = lib_malloc(len + 12);
+    util_int_to_le_buf4(&buf[0], rollback_created);
+    util_int_to_le_buf4(&buf[4], rollback_hash_unsent);
+    util_dword_to_le_buf(&buf[8], rollback_hash_unsent >= 0
+                         ? rollback_slot(rollback_hash_unsent)->hash : 0);
+    memcpy(&buf[12], event_buf, len);
+    rollback_hash_unsent = -1;
+
+    ret = network_send_message(buf, len + 12);
+
+    lib_free(event_buf);
+    lib_free(buf);
+    rollback_created++;
+    return ret;
+}
+
+static int rollback_receive_frame(void)
+{
+    uint8_t len4[4];
+    uint8_t *buf;
+    unsigned int len;
+    int frame, hash_frame;
+    rollback_frame_t *slot;
+
+    if (network_recv_buffer(network_socket, len4, 4) < 0) {
+        return -1;
+    }
+
+    len = (unsigned int)util_le_buf4_to_int(len4);
+    if (len == 0) {
+        /* remote host suspended emulation */
+        if (suspended == 0) {
+            ui_display_statustext("Remote host suspending...", 0);
+            suspended = 1;
+            vsync_suspend_speed_eval();
+        }
+        return 0;
+    }
+    if (len < 12 + 3 * 4) {
+        return -1;
+    }
+    if (suspended == 1) {
+        ui_display_statustext("", 0);
+        suspended = 0;
+    }
+
+    buf = lib_malloc(len);
+    if (network_recv_buffer(network_socket, buf, (int)len) < 0) {
+        lib_free(buf);
+        return -1;
+    }
+
+    frame = util_le_buf4_to_int(&buf[0]);
+    hash_frame = util_le_buf4_to_int(&buf[4]);
+    if (frame != rollback_confirmed) {
+        log_error(LOG_DEFAULT, "netplay: got frame %d, expected %d.",
+                  frame, rollback_confirmed);
+        lib_free(buf);
+        return -1;
+    }
+
+    slot = rollback_slot(frame);
+    slot->remote = network_create_event_list(&buf[12]);
+    rollback_confirmed++;
+
+    /* The frame already ran with a prediction that turned out wrong.  */
+    if (frame < rollback_next && slot->remote->base->type != EVENT_LIST_END
+        && (rollback_from < 0 || frame < rollback_from)) {
+        rollback_from = frame;
+    }
+
+    /* the remote side only hashes frames we have sent already */
+    if (hash_frame >= 0 && hash_frame > rollback_created - ROLLBACK_SLOTS / 2
+        && hash_frame <= rollback_created) {
+        slot = rollback_slot(hash_frame);
+        slot->remote_hash = util_le_buf_to_dword(&buf[8]);
+        slot->remote_hash_valid = 1;
+        if (rollback_check_hash(slot) < 0) {
+            lib_free(buf);
+            return 1;
+        }
+    }
+
+    lib_free(buf);
+    return 0;
+}
+
+static void network_hook_rollback(void)
+{
+    int ret;
+
+    if (network_flush_delayed(0) < 0) {
+        ui_display_statustext("Remote host disconnected.", 1);
+        network_disconnect();
+        return;
+    }
+
+    if (rollback_next == rollback_created) {
+        if (rollback_send_frame() < 0) {
+            ui_display_statustext("Remote host disconnected.", 1);
+            network_disconnect();
+            return;
+        }
+    }
+
+    /* Take what has arrived; wait only if the prediction would get too
+       far ahead of the remote input.  */
+    do {
+        while ((ret = vice_network_select_poll_one(network_socket)) > 0) {
+            ret = rollback_receive_frame();
+            if (ret != 0) {
+                break;
+            }
+        }
+        if (ret == 0 && rollback_created - rollback_confirmed > rollback_frames) {
+            ret = network_wait_data();
+        }
+        if (ret < 0) {
+            ui_display_statustext("Remote host disconnected.", 1);
+            network_disconnect();
+            return;
+        }
+        if (ret > 0) {
+            /* desync, already disconnected */
+            return;
+        }
+    } while (rollback_created - rollback_confirmed > rollback_frames);
+
+    rollback_rerun = (rollback_from >= 0 ? rollback_from : rollback_next)
+                     < rollback_created - 1;
+
+    interrupt_maincpu_trigger_trap(rollback_frame_trap, (void *)0);
+}
+
 #define NUM_OF_TESTPACKETS 50
 
+/* Netplay protocol version, exchanged in the test packets.  Version 1 sends
+   the rollback window after the frame delay.  The server puts the magic and
+   its version into each packet and the client its version into the echo, a
+   peer without a version leaves them alone and counts as version 0.  */
+#define NETWORK_PROTOCOL_VERSION    1
+
+#define TESTPACKET_MAGIC            0
+#define TESTPACKET_SERVER_VERSION   3
+#define TESTPACKET_CLIENT_VERSION   4
+
+static const uint8_t testpacket_magic[3] = { 'V', 'N', 'P' };
+
 typedef struct {
     unsigned long t;
     unsigned char buf[0x60];
@@ -388,6 +938,8 @@ static void network_test_delay(void)
 {
     int i, j;
     uint8_t new_frame_delta;
+    uint8_t new_rollback_frames;
+    uint8_t remote_version = 0;
     unsigned char *buf;
     testpacket pkt;
 
@@ -403,11 +955,21 @@ static void network_test_delay(void)
     if (network_mode == NETWORK_SERVER_CONNECTED) {
         for (i = 0; i < NUM_OF_TESTPACKETS; i++) {
             pkt.t = vsyncarch_gettime();
+            memcpy(&pkt.buf[TESTPACKET_MAGIC], testpacket_magic, sizeof(testpacket_magic));
+            pkt.buf[TESTPACKET_SERVER_VERSION] = NETWORK_PROTOCOL_VERSION;
+            pkt.buf[TESTPACKET_CLIENT_VERSION] = 0;
             if (network_send_buffer(network_socket, buf, sizeof(testpacket)) < 0
                 || network_recv_buffer(network_socket, buf, sizeof(testpacket)) < 0) {
-                return;
+                goto disconnected;
             }
             packet_delay[i] = vsyncarch_gettime() - pkt.t;
+            remote_version = pkt.buf[TESTPACKET_CLIENT_VERSION];
+        }
+        if (remote_version != NETWORK_PROTOCOL_VERSION) {
+            ui_error("Client uses netplay protocol version %d, this is version %d.",
+                     remote_version, NETWORK_PROTOCOL_VERSION);
+            network_disconnect();
+            return;
         }
         /* Sort the packets delays*/
         for (i = 0; i < NUM_OF_TESTPACKETS - 1; i++) {
@@ -430,25 +992,60 @@ static void network_test_delay(void)
         new_frame_delta = 5 + (uint8_t)(vsync_get_refresh_frequency()
                                      * packet_delay[(int)(0.1 * NUM_OF_TESTPACKETS)]
                                      / (float)vsyncarch_frequency());
+        new_rollback_frames = rollback_enabled ? (uint8_t)rollback_window : 0;
         network_send_buffer(network_socket, &new_frame_delta,
                             sizeof(new_frame_delta));
+        network_send_buffer(network_socket, &new_rollback_frames,
+                            sizeof(new_rollback_frames));
     } else {
         /* network_mode == NETWORK_CLIENT */
         for (i = 0; i < NUM_OF_TESTPACKETS; i++) {
-            if (network_recv_buffer(network_socket, buf, sizeof(testpacket)) < 0
-                || network_send_buffer(network_socket, buf, sizeof(testpacket)) < 0) {
-                return;
+            if (network_recv_buffer(network_socket, buf, sizeof(testpacket)) < 0) {
+                goto disconnected;
+            }
+            if (memcmp(&pkt.buf[TESTPACKET_MAGIC], testpacket_magic, sizeof(testpacket_magic)) == 0) {
+                remote_version = pkt.buf[TESTPACKET_SERVER_VERSION];
+            } else {
+                remote_version = 0;
+            }
+            pkt.buf[TESTPACKET_CLIENT_VERSION] = NETWORK_PROTOCOL_VERSION;
+            if (network_send_buffer(network_socket, buf, sizeof(testpacket)) < 0) {
+                goto disconnected;
             }
         }
-        network_recv_buffer(network_socket, &new_frame_delta,
-                            sizeof(new_frame_delta));
+        if (remote_version != NETWORK_PROTOCOL_VERSION) {
+            ui_error("Server uses netplay protocol version %d, this is version %d.",
+                     remote_version, NETWORK_PROTOCOL_VERSION);
+            network_disconnect();
+            return;
+        }
+        new_rollback_frames = 0;
+        if (network_recv_buffer(network_socket, &new_frame_delta,
+                                sizeof(new_frame_delta)) < 0
+            || network_recv_buffer(network_socket, &new_rollback_frames,
+                                   sizeof(new_rollback_frames)) < 0) {
+            goto disconnected;
+        }
     }
     network_free_frame_event_list();
-    frame_delta = new_frame_delta;
-    network_init_frame_event_list();
-    sprintf(st, "Using %d frames delay.", frame_delta);
-    log_debug("netplay connected with %d frames delta.", frame_delta);
+    rollback_frames = new_rollback_frames;
+    if (rollback_frames > 0) {
+        rollback_init();
+        sprintf(st, "Predicting up to %d frames ahead.", rollback_frames);
+        log_debug("netplay connected with rollback over %d frames.", rollback_frames);
+    } else {
+        frame_delta = new_frame_delta;
+        network_init_frame_event_list();
+        sprintf(st, "Using %d frames delay.", frame_delta);
+        log_debug("netplay connected with %d frames delta.", frame_delta);
+    }
     ui_display_statustext(st, 1);
+    return;
+
+disconnected:
+    /* don't leave the frame lists unset while connected */
+    ui_display_statustext("Remote host disconnected.", 1);
+    network_disconnect();
 }
 
 static void network_server_connect_trap(uint16_t addr, void *data)
@@ -565,10 +1162,19 @@ static void network_client_connect_trap(uint16_t addr, void *data)
 
 /*-------------------------------------------------------------------------*/
 
+static event_list_state_t *network_record_list(void)
+{
+    if (rollback_frames > 0) {
+        return &rollback_pending;
+    }
+    return &(frame_event_list[current_frame]);
+}
+
 void network_event_record(unsigned int type, void *data, unsigned int size)
 {
     unsigned int control = 0;
     uint8_t joyport;
+    static const CLOCK no_delay = 0;
 
     switch (type) {
         case EVENT_KEYBOARD_MATRIX:
@@ -607,7 +1213,14 @@ void network_event_record(unsigned int type, void *data, unsigned int size)
         return;
     }
 
-    event_record_in_list(&(frame_event_list[current_frame]), type, data, size);
+    /* Input takes effect at the start of the frame it is played in, so
+       that no input alarm is pending when a rollback state is saved.  */
+    if (rollback_frames > 0 && type == EVENT_KEYBOARD_DELAY
+        && size == sizeof(no_delay)) {
+        data = (void *)&no_delay;
+    }
+
+    event_record_in_list(network_record_list(), type, data, size);
 }
 
 void network_attach_image(unsigned int unit, const char *filename)
@@ -622,7 +1235,7 @@ void network_attach_image(unsigned int unit, const char *filename)
         return;
     }
 
-    event_record_attach_in_list(&(frame_event_list[current_frame]), unit, filename, 1);
+    event_record_attach_in_list(network_record_list(), unit, filename, 1);
 }
 
 int network_get_mode(void)
@@ -749,6 +1362,11 @@ int network_connect_client(void)
 
 void network_disconnect(void)
 {
+    network_free_delayed();
+    if (rollback_frames > 0) {
+        rollback_free();
+        rollback_frames = 0;
+    }
     vice_network_socket_close(network_socket);
     if (network_mode == NETWORK_SERVER_CONNECTED) {
         network_mode = NETWORK_SERVER;
@@ -766,6 +1384,7 @@ void network_suspend(void)
         return;
     }
 
+    network_flush_delayed(1);
     network_send_buffer(network_socket, (uint8_t *)&dummy_buf_len, sizeof(unsigned int));
 
     suspended = 1;
@@ -779,7 +1398,6 @@ static void network_hook_connected_send(void)
 {
     uint8_t *local_event_buf = NULL;
     unsigned int send_len;
-    uint8_t send_len4[4];
 
     /* create and send current event buffer */
     network_event_record(EVENT_LIST_END, NULL, 0);
@@ -789,9 +1407,7 @@ static void network_hook_connected_send(void)
     t1 = vsyncarch_gettime();
 #endif
 
-    util_int_to_le_buf4(send_len4, (int)send_len);
-    if (network_send_buffer(network_socket, send_len4, 4) < 0
-        || network_send_buffer(network_socket, local_event_buf, send_len) < 0) {
+    if (network_send_message(local_event_buf, send_len) < 0) {
         ui_display_statustext("Remote host disconnected.", 1);
         network_disconnect();
     }
@@ -818,7 +1434,8 @@ static void network_hook_connected_receive(void)
 
     if (frame_buffer_full) {
         do {
-            if (network_recv_buffer(network_socket, recv_len4, 4) < 0) {
+            if (network_wait_data() < 0
+                || network_recv_buffer(network_socket, recv_len4, 4) < 0) {
                 ui_display_statustext("Remote host disconnected.", 1);
                 network_disconnect();
                 return;
@@ -906,7 +1523,9 @@ void network_hook(void)
         }
     }
 
-    if (network_connected()) {
+    if (network_connected() && rollback_frames > 0) {
+        network_hook_rollback();
+    } else if (network_connected()) {
         network_hook_connected_send();
         network_hook_connected_receive();
 #ifdef NETWORK_DEBUG
@@ -916,6 +1535,11 @@ void network_hook(void)
     }
 }
 
+int network_resimulating(void)
+{
+    return network_connected() && rollback_rerun;
+}
+
 void network_shutdown(void)
 {
     if (network_connected()) {
@@ -979,4 +1603,9 @@ int network_get_mode(void)
 {
     return NETWORK_IDLE;
 }
+
+int network_resimulating(void)
+{
+    return 0;
+}
 #endif
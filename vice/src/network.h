@@ -62,6 +62,7 @@ extern int network_get_mode(void);
 extern void network_hook(void);
 extern void network_event_record(unsigned int type, void *data, unsigned int size);
 extern void network_attach_image(unsigned int unit, const char *filename);
+extern int network_resimulating(void);
 
 extern void network_shutdown(void);
 
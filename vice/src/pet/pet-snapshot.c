@@ -57,13 +57,17 @@
 #define SNAP_MAJOR 0
 #define SNAP_MINOR 0
 
-int pet_snapshot_write(const char *name, int save_roms, int save_disks,
-                       int event_mode)
+static int pet_snapshot_write_internal(const char *name, snapshot_stream_t *stream,
+                                       int save_roms, int save_disks, int event_mode)
 {
     snapshot_t *s;
     int ef = 0;
 
-    s = snapshot_create(name, SNAP_MAJOR, SNAP_MINOR, machine_name);
+    if (stream != NULL) {
+        s = snapshot_create_stream(stream, SNAP_MAJOR, SNAP_MINOR, machine_name);
+    } else {
+        s = snapshot_create(name, SNAP_MAJOR, SNAP_MINOR, machine_name);
+    }
 
     if (s == NULL) {
         return -1;
@@ -93,20 +97,25 @@ int pet_snapshot_write(const char *name, int save_roms, int save_disks,
 
     snapshot_close(s);
 
-    if (ef) {
+    if (ef && name != NULL) {
         ioutil_remove(name);
     }
 
     return ef;
 }
 
-int pet_snapshot_read(const char *name, int event_mode)
+static int pet_snapshot_read_internal(const char *name, snapshot_stream_t *stream,
+                                      int event_mode)
 {
     snapshot_t *s;
     uint8_t minor, major;
     int ef = 0;
 
-    s = snapshot_open(name, &major, &minor, machine_name);
+    if (stream != NULL) {
+        s = snapshot_open_stream(stream, &major, &minor, machine_name);
+    } else {
+        s = snapshot_open(name, &major, &minor, machine_name);
+    }
 
     if (s == NULL) {
         return -1;
@@ -149,3 +158,23 @@ int pet_snapshot_read(const char *name, int event_mode)
 
     return ef;
 }
+
+int pet_snapshot_write(const char *name, int save_roms, int save_disks, int event_mode)
+{
+    return pet_snapshot_write_internal(name, NULL, save_roms, save_disks, event_mode);
+}
+
+int pet_snapshot_write_stream(snapshot_stream_t *stream, int save_roms, int save_disks, int event_mode)
+{
+    return pet_snapshot_write_internal(NULL, stream, save_roms, save_disks, event_mode);
+}
+
+int pet_snapshot_read(const char *name, int event_mode)
+{
+    return pet_snapshot_read_internal(name, NULL, event_mode);
+}
+
+int pet_snapshot_read_stream(snapshot_stream_t *stream, int event_mode)
+{
+    return pet_snapshot_read_internal(NULL, stream, event_mode);
+}
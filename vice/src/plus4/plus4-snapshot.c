@@ -58,13 +58,16 @@
 #define SNAP_MAJOR 1
 #define SNAP_MINOR 1
 
-int plus4_snapshot_write(const char *name, int save_roms, int save_disks,
-                         int event_mode)
+static int plus4_snapshot_write_internal(const char *name, snapshot_stream_t *stream,
+                                         int save_roms, int save_disks, int event_mode)
 {
     snapshot_t *s;
 
-    s = snapshot_create(name, ((uint8_t)(SNAP_MAJOR)), ((uint8_t)(SNAP_MINOR)),
-                        machine_name);
+    if (stream != NULL) {
+        s = snapshot_create_stream(stream, ((uint8_t)(SNAP_MAJOR)), ((uint8_t)(SNAP_MINOR)), machine_name);
+    } else {
+        s = snapshot_create(name, ((uint8_t)(SNAP_MAJOR)), ((uint8_t)(SNAP_MINOR)), machine_name);
+    }
     if (s == NULL) {
         return -1;
     }
@@ -85,7 +88,9 @@ int plus4_snapshot_write(const char *name, int save_roms, int save_disks,
         || joyport_snapshot_write_module(s, JOYPORT_2) < 0
         || userport_snapshot_write_module(s) < 0) {
         snapshot_close(s);
-        ioutil_remove(name);
+        if (name != NULL) {
+            ioutil_remove(name);
+        }
         DBG(("error writing snapshot modules.\n"));
         return -1;
     }
@@ -94,12 +99,17 @@ int plus4_snapshot_write(const char *name, int save_roms, int save_disks,
     return 0;
 }
 
-int plus4_snapshot_read(const char *name, int event_mode)
+static int plus4_snapshot_read_internal(const char *name, snapshot_stream_t *stream,
+                                        int event_mode)
 {
     snapshot_t *s;
     uint8_t minor, major;
 
-    s = snapshot_open(name, &major, &minor, machine_name);
+    if (stream != NULL) {
+        s = snapshot_open_stream(stream, &major, &minor, machine_name);
+    } else {
+        s = snapshot_open(name, &major, &minor, machine_name);
+    }
 
     if (s == NULL) {
         return -1;
@@ -145,3 +155,23 @@ fail:
     DBG(("error loading snapshot modules.\n"));
     return -1;
 }
+
+int plus4_snapshot_write(const char *name, int save_roms, int save_disks, int event_mode)
+{
+    return plus4_snapshot_write_internal(name, NULL, save_roms, save_disks, event_mode);
+}
+
+int plus4_snapshot_write_stream(snapshot_stream_t *stream, int save_roms, int save_disks, int event_mode)
+{
+    return plus4_snapshot_write_internal(NULL, stream, save_roms, save_disks, event_mode);
+}
+
+int plus4_snapshot_read(const char *name, int event_mode)
+{
+    return plus4_snapshot_read_internal(name, NULL, event_mode);
+}
+
+int plus4_snapshot_read_stream(snapshot_stream_t *stream, int event_mode)
+{
+    return plus4_snapshot_read_internal(NULL, stream, event_mode);
+}
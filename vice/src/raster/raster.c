@@ -245,6 +245,7 @@ int raster_init(raster_t *raster,
     raster->num_cached_lines = 0;
 
     raster->fake_draw_buffer_line = NULL;
+    raster->sync = NULL;
 
     raster->can_disable_border = 0;
     raster->border_disable = 0;
@@ -477,6 +478,13 @@ void raster_force_repaint(raster_t *raster)
     raster->num_cached_lines = 0;
 }
 
+void raster_sync(raster_t *raster)
+{
+    if (raster->sync != NULL) {
+        raster->sync(raster);
+    }
+}
+
 void raster_set_title(raster_t *raster, const char *name)
 {
     char *title;
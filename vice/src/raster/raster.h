@@ -183,6 +183,10 @@ struct raster_s {
     int (*fill_sprite_cache)(struct raster_s *, struct raster_cache_s *,
                              unsigned int *, unsigned int *);
 
+    /* Wait for lines still being drawn into the canvas by another thread,
+       so the UI can draw into it; NULL when the chip draws in place.  */
+    void (*sync)(struct raster_s *);
+
     int intialized;
 };
 typedef struct raster_s raster_t;
@@ -214,6 +218,7 @@ extern void raster_set_geometry(raster_t *raster,
 extern void raster_new_cache(raster_t *raster, unsigned int screen_height);
 extern void raster_draw_buffer_ptr_update(raster_t *raster);
 extern void raster_force_repaint(raster_t *raster);
+extern void raster_sync(raster_t *raster);
 extern void raster_set_title(raster_t *raster, const char *name);
 extern void raster_skip_frame(raster_t *raster, int skip);
 extern void raster_enable_cache(raster_t *raster, int enable);
@@ -25,6 +25,7 @@
 #endif
 
 #include "filter.h"
+#include "tablecache.h"
 #include "dac.h"
 #include "spline.h"
 #include <math.h>
@@ -225,6 +226,39 @@ static model_filter_init_t model_filter_init[2] = {
   }
 };
 
+// Version of the table cache format and of the table calculations below.
+// Increase it when either changes; changes to the model parameters above
+// are covered by the hash in the cache key.
+static const unsigned int filter_cache_version = 1;
+
+// FNV-1a hash over the model parameters, for the table cache key.
+static unsigned int hash_bytes(unsigned int h, const void* data, int size)
+{
+  const unsigned char* p = (const unsigned char*)data;
+  for (int i = 0; i < size; i++) {
+    h = (h ^ p[i])*16777619u;
+  }
+  return h;
+}
+
+static unsigned int hash_model_filter_init()
+{
+  unsigned int h = 2166136261u;
+
+  for (int m = 0; m < 2; m++) {
+    const model_filter_init_t& fi = model_filter_init[m];
+    const double param[] = {
+      fi.voice_voltage_range, fi.voice_DC_voltage, fi.C, fi.Vdd, fi.Vth,
+      fi.Ut, fi.k, fi.uCox, fi.WL_vcr, fi.WL_snake, fi.dac_zero,
+      fi.dac_scale, fi.dac_2R_div_R, fi.dac_term ? 1.0 : 0.0
+    };
+    h = hash_bytes(h, fi.opamp_voltage,
+                   fi.opamp_voltage_size*sizeof(*fi.opamp_voltage));
+    h = hash_bytes(h, param, sizeof(param));
+  }
+  return h;
+}
+
 unsigned short Filter::resonance[16][1 << 16];
 unsigned short Filter::vcr_kVg[1 << 16];
 unsigned short Filter::vcr_n_Ids_term[1 << 16];
@@ -252,6 +286,26 @@ Filter::Filter()
 {
   static bool class_init;
 
+  // The tables only depend on the model constants compiled into this file,
+  // so a cache written with the same constants can be used as is.
+  const unsigned int cache_key[] = {
+    filter_cache_version, hash_model_filter_init()
+  };
+  const TableCache::segment_t cache_seg[] = {
+    { model_filter, sizeof(model_filter) },
+    { resonance, sizeof(resonance) },
+    { vcr_kVg, sizeof(vcr_kVg) },
+    { vcr_n_Ids_term, sizeof(vcr_n_Ids_term) },
+    { &n_snake, sizeof(n_snake) },
+    { &n_param, sizeof(n_param) }
+  };
+  const int cache_n_seg = sizeof(cache_seg)/sizeof(cache_seg[0]);
+
+  if (!class_init) {
+    class_init = TableCache::load("filter", cache_key, sizeof(cache_key),
+                                  cache_seg, cache_n_seg);
+  }
+
   if (!class_init) {
     double tmp_n_param[2];
 
@@ -442,12 +496,8 @@ Filter::Filter()
       // scaled 5 bits
       n_param = (int)(tmp_n_param[1] * 32 + 0.5);
 
-      model_filter_init_t& fi = model_filter_init[1];
       model_filter_t& f = model_filter[1];
 
-      double Vgt = fi.k * ((4.75 * 1.6) - fi.Vth);
-      kVgt = (int)(f.vo_N16 * (Vgt - fi.opamp_voltage[0][0]) + 0.5);
-
       // DAC table.
       // W/L ratio for frequency DAC, bits are proportional.
       // scaled 5 bits
@@ -476,8 +526,6 @@ Filter::Filter()
       double N16 = f.vo_N16;
       double vmin = fi.opamp_voltage[0][0];
 
-      Vw_bias = 0;
-
       // Normalized snake current factor, 1 cycle at 1MHz.
       // Fit in 5 bits.
       n_snake = (int)(fi.WL_snake * tmp_n_param[0] + 0.5);
@@ -531,9 +579,20 @@ Filter::Filter()
       }
     }
 
+    TableCache::save("filter", cache_key, sizeof(cache_key),
+                     cache_seg, cache_n_seg);
+
     class_init = true;
   }
 
+  // DAC gate voltage, 8580 only.
+  {
+    model_filter_init_t& fi = model_filter_init[1];
+    double Vgt = fi.k * ((4.75 * 1.6) - fi.Vth);
+    kVgt = (int)(model_filter[1].vo_N16 * (Vgt - fi.opamp_voltage[0][0]) + 0.5);
+  }
+  Vw_bias = 0;
+
   enable_filter(true);
   set_chip_model(MOS6581);
   set_voice_mask(0x07);
@@ -25,8 +25,26 @@
 #endif
 
 #include "sid.h"
+#include "tablecache.h"
 #include <math.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// AVX2 is not part of the x86 baseline, so its kernel is compiled for it
+// separately and only used when the CPU reports support at run time.
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#define RESID_FIR_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define RESID_FIR_NEON
+#include <arm_neon.h>
+#endif
+
 #ifndef round
 #define round(x) (x>=0.0?floor(x+0.5):ceil(x-0.5))
 #endif
@@ -34,6 +52,9 @@
 namespace reSID
 {
 
+// Set once a FIR convolution kernel has been selected, see set_fir_kernel().
+static bool fir_kernel_selected = false;
+
 // ----------------------------------------------------------------------------
 // Constructor.
 // ----------------------------------------------------------------------------
@@ -48,6 +69,10 @@ SID::SID()
   fir_f_cycles_per_sample = 0;
   fir_filter_scale = 0;
 
+  if (!fir_kernel_selected) {
+    set_fir_kernel(FIR_KERNEL_AUTO);
+  }
+
   sid_model = MOS6581;
   voice[0].set_sync_source(&voice[2]);
   voice[1].set_sync_source(&voice[0]);
@@ -623,6 +648,21 @@ bool SID::set_sampling_parameters(double clock_freq, sampling_method method,
   delete[] fir;
   fir = new short[fir_N*fir_RES];
 
+  // The large tables for SAMPLE_RESAMPLE_FASTMEM take much longer to
+  // calculate than to read back from the table cache.
+  bool cache_fir = TableCache::enabled() && fir_N*fir_RES >= (1 << 20);
+  double cache_key[] = {
+    double(fir_RES), double(fir_N), beta, f_cycles_per_sample, filter_scale
+  };
+  TableCache::segment_t cache_seg = {
+    fir, sizeof(short)*fir_N*fir_RES
+  };
+
+  if (cache_fir && TableCache::load("fir", cache_key, sizeof(cache_key),
+                                    &cache_seg, 1)) {
+    return true;
+  }
+
   // Calculate fir_RES FIR tables for linear interpolation.
   for (int i = 0; i < fir_RES; i++) {
     int fir_offset = i*fir_N + fir_N/2;
@@ -640,6 +680,10 @@ bool SID::set_sampling_parameters(double clock_freq, sampling_method method,
     }
   }
 
+  if (cache_fir) {
+    TableCache::save("fir", cache_key, sizeof(cache_key), &cache_seg, 1);
+  }
+
   return true;
 }
 
@@ -860,6 +904,234 @@ int SID::clock_interpolate(cycle_count& delta_t, short* buf, int n, int interlea
 }
 
 
+// ----------------------------------------------------------------------------
+// FIR convolution kernels.
+//
+// Every kernel computes the plain 32 bit integer sum of the 16 bit products.
+// The vector kernels only add the products in a different order, which does
+// not change the result of (wrapping) integer additions, so all kernels are
+// bit exact with the scalar code.
+//
+// convolve() computes one dot product of n taps, convolve2() computes the
+// two dot products needed for the linear interpolation between two FIR
+// tables in one pass.
+// ----------------------------------------------------------------------------
+typedef int (*fir_convolve_t)(const short* s, const short* f, int n);
+typedef void (*fir_convolve2_t)(const short* s1, const short* f1,
+                                const short* s2, const short* f2, int n,
+                                int& v1, int& v2);
+
+static int convolve_scalar(const short* s, const short* f, int n)
+{
+  int v = 0;
+  for (int j = 0; j < n; j++) {
+    v += s[j]*f[j];
+  }
+  return v;
+}
+
+static void convolve2_scalar(const short* s1, const short* f1,
+                             const short* s2, const short* f2, int n,
+                             int& v1, int& v2)
+{
+  v1 = convolve_scalar(s1, f1, n);
+  v2 = convolve_scalar(s2, f2, n);
+}
+
+#if defined(__SSE2__)
+static inline int hsum_sse2(__m128i v)
+{
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, 0x4e));
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, 0xb1));
+  return _mm_cvtsi128_si32(v);
+}
+
+static int convolve_sse2(const short* s, const short* f, int n)
+{
+  __m128i acc = _mm_setzero_si128();
+  int j = 0;
+  for (; j + 8 <= n; j += 8) {
+    acc = _mm_add_epi32(acc,
+      _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(s + j)),
+                     _mm_loadu_si128((const __m128i*)(f + j))));
+  }
+  return hsum_sse2(acc) + convolve_scalar(s + j, f + j, n - j);
+}
+
+static void convolve2_sse2(const short* s1, const short* f1,
+                           const short* s2, const short* f2, int n,
+                           int& v1, int& v2)
+{
+  __m128i acc1 = _mm_setzero_si128();
+  __m128i acc2 = _mm_setzero_si128();
+  int j = 0;
+  for (; j + 8 <= n; j += 8) {
+    acc1 = _mm_add_epi32(acc1,
+      _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(s1 + j)),
+                     _mm_loadu_si128((const __m128i*)(f1 + j))));
+    acc2 = _mm_add_epi32(acc2,
+      _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(s2 + j)),
+                     _mm_loadu_si128((const __m128i*)(f2 + j))));
+  }
+  v1 = hsum_sse2(acc1) + convolve_scalar(s1 + j, f1 + j, n - j);
+  v2 = hsum_sse2(acc2) + convolve_scalar(s2 + j, f2 + j, n - j);
+}
+#endif
+
+#ifdef RESID_FIR_AVX2
+// Sum of the 16 taps per iteration, with a final 8 tap step when at least
+// 8 taps remain.
+__attribute__((target("avx2")))
+static inline int madd_avx2(const short* s, const short* f, int n, int& j)
+{
+  __m256i acc = _mm256_setzero_si256();
+  __m128i acc_lo;
+  for (; j + 16 <= n; j += 16) {
+    acc = _mm256_add_epi32(acc,
+      _mm256_madd_epi16(_mm256_loadu_si256((const __m256i*)(s + j)),
+                        _mm256_loadu_si256((const __m256i*)(f + j))));
+  }
+  acc_lo = _mm_add_epi32(_mm256_castsi256_si128(acc),
+                         _mm256_extracti128_si256(acc, 1));
+  if (j + 8 <= n) {
+    acc_lo = _mm_add_epi32(acc_lo,
+      _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(s + j)),
+                     _mm_loadu_si128((const __m128i*)(f + j))));
+    j += 8;
+  }
+  acc_lo = _mm_add_epi32(acc_lo, _mm_shuffle_epi32(acc_lo, 0x4e));
+  acc_lo = _mm_add_epi32(acc_lo, _mm_shuffle_epi32(acc_lo, 0xb1));
+  return _mm_cvtsi128_si32(acc_lo);
+}
+
+__attribute__((target("avx2")))
+static int convolve_avx2(const short* s, const short* f, int n)
+{
+  int j = 0;
+  int v = madd_avx2(s, f, n, j);
+  return v + convolve_scalar(s + j, f + j, n - j);
+}
+
+__attribute__((target("avx2")))
+static void convolve2_avx2(const short* s1, const short* f1,
+                           const short* s2, const short* f2, int n,
+                           int& v1, int& v2)
+{
+  int j1 = 0, j2 = 0;
+  v1 = madd_avx2(s1, f1, n, j1);
+  v2 = madd_avx2(s2, f2, n, j2);
+  v1 += convolve_scalar(s1 + j1, f1 + j1, n - j1);
+  v2 += convolve_scalar(s2 + j2, f2 + j2, n - j2);
+}
+#endif
+
+#ifdef RESID_FIR_NEON
+static inline int hsum_neon(int32x4_t v)
+{
+  // Add as unsigned to keep the wrap around well defined.
+  uint32x4_t u = vreinterpretq_u32_s32(v);
+  return int(vgetq_lane_u32(u, 0) + vgetq_lane_u32(u, 1)
+             + vgetq_lane_u32(u, 2) + vgetq_lane_u32(u, 3));
+}
+
+static inline int32x4_t madd_neon(int32x4_t acc, const short* s, const short* f)
+{
+  int16x8_t x = vld1q_s16(s);
+  int16x8_t y = vld1q_s16(f);
+  acc = vmlal_s16(acc, vget_low_s16(x), vget_low_s16(y));
+  return vmlal_s16(acc, vget_high_s16(x), vget_high_s16(y));
+}
+
+static int convolve_neon(const short* s, const short* f, int n)
+{
+  int32x4_t acc = vdupq_n_s32(0);
+  int j = 0;
+  for (; j + 8 <= n; j += 8) {
+    acc = madd_neon(acc, s + j, f + j);
+  }
+  return hsum_neon(acc) + convolve_scalar(s + j, f + j, n - j);
+}
+
+static void convolve2_neon(const short* s1, const short* f1,
+                           const short* s2, const short* f2, int n,
+                           int& v1, int& v2)
+{
+  int32x4_t acc1 = vdupq_n_s32(0);
+  int32x4_t acc2 = vdupq_n_s32(0);
+  int j = 0;
+  for (; j + 8 <= n; j += 8) {
+    acc1 = madd_neon(acc1, s1 + j, f1 + j);
+    acc2 = madd_neon(acc2, s2 + j, f2 + j);
+  }
+  v1 = hsum_neon(acc1) + convolve_scalar(s1 + j, f1 + j, n - j);
+  v2 = hsum_neon(acc2) + convolve_scalar(s2 + j, f2 + j, n - j);
+}
+#endif
+
+static fir_convolve_t convolve = convolve_scalar;
+static fir_convolve2_t convolve2 = convolve2_scalar;
+
+// ----------------------------------------------------------------------------
+// Select the FIR convolution kernel.
+// ----------------------------------------------------------------------------
+bool SID::set_fir_kernel(fir_kernel kernel)
+{
+  switch (kernel) {
+  case FIR_KERNEL_AUTO:
+    // Pick the fastest kernel supported by the CPU.
+    convolve = convolve_scalar;
+    convolve2 = convolve2_scalar;
+#if defined(__SSE2__)
+    convolve = convolve_sse2;
+    convolve2 = convolve2_sse2;
+#endif
+#ifdef RESID_FIR_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+      convolve = convolve_avx2;
+      convolve2 = convolve2_avx2;
+    }
+#endif
+#ifdef RESID_FIR_NEON
+    convolve = convolve_neon;
+    convolve2 = convolve2_neon;
+#endif
+    break;
+  case FIR_KERNEL_SCALAR:
+    convolve = convolve_scalar;
+    convolve2 = convolve2_scalar;
+    break;
+#if defined(__SSE2__)
+  case FIR_KERNEL_SSE2:
+    convolve = convolve_sse2;
+    convolve2 = convolve2_sse2;
+    break;
+#endif
+#ifdef RESID_FIR_AVX2
+  case FIR_KERNEL_AVX2:
+    __builtin_cpu_init();
+    if (!__builtin_cpu_supports("avx2")) {
+      return false;
+    }
+    convolve = convolve_avx2;
+    convolve2 = convolve2_avx2;
+    break;
+#endif
+#ifdef RESID_FIR_NEON
+  case FIR_KERNEL_NEON:
+    convolve = convolve_neon;
+    convolve2 = convolve2_neon;
+    break;
+#endif
+  default:
+    return false;
+  }
+
+  fir_kernel_selected = true;
+  return true;
+}
+
+
 // ----------------------------------------------------------------------------
 // SID clocking with audio sampling - cycle based with audio resampling.
 //
@@ -926,25 +1198,20 @@ int SID::clock_resample(cycle_count& delta_t, short* buf, int n, int interleave)
     short* fir_start = fir + fir_offset*fir_N;
     short* sample_start = sample + sample_index - fir_N - 1 + RINGSIZE;
 
-    // Convolution with filter impulse response.
-    int v1 = 0;
-    for (int j = 0; j < fir_N; j++) {
-      v1 += sample_start[j]*fir_start[j];
-    }
+    short* sample_start_next = sample_start;
 
     // Use next FIR table, wrap around to first FIR table using
     // next sample.
     if (unlikely(++fir_offset == fir_RES)) {
       fir_offset = 0;
-      ++sample_start;
+      ++sample_start_next;
     }
-    fir_start = fir + fir_offset*fir_N;
+    short* fir_start_next = fir + fir_offset*fir_N;
 
-    // Convolution with filter impulse response.
-    int v2 = 0;
-    for (int k = 0; k < fir_N; k++) {
-      v2 += sample_start[k]*fir_start[k];
-    }
+    // Convolution with both filter impulse responses.
+    int v1, v2;
+    convolve2(sample_start, fir_start, sample_start_next, fir_start_next,
+              fir_N, v1, v2);
 
     // Linear interpolation.
     // fir_offset_rmd is equal for all samples, it can thus be factorized out:
@@ -1002,10 +1269,7 @@ int SID::clock_resample_fastmem(cycle_count& delta_t, short* buf, int n, int int
     short* sample_start = sample + sample_index - fir_N + RINGSIZE;
 
     // Convolution with filter impulse response.
-    int v = 0;
-    for (int j = 0; j < fir_N; j++) {
-      v += sample_start[j]*fir_start[j];
-    }
+    int v = convolve(sample_start, fir_start, fir_N);
 
     v >>= FIR_SHIFT;
 
@@ -47,6 +47,18 @@ public:
   double filter_scale = 0.97);
   void adjust_sampling_frequency(double sample_freq);
 
+  // Convolution kernel of the resampling FIR filter, for all SIDs.  The
+  // default is the fastest kernel the CPU supports.  Returns false if the
+  // kernel is not available.
+  enum fir_kernel {
+    FIR_KERNEL_AUTO,
+    FIR_KERNEL_SCALAR,
+    FIR_KERNEL_SSE2,
+    FIR_KERNEL_AVX2,
+    FIR_KERNEL_NEON
+  };
+  static bool set_fir_kernel(fir_kernel kernel);
+
   void clock();
   void clock(cycle_count delta_t);
   int clock(cycle_count& delta_t, short* buf, int n, int interleave = 1);
@@ -0,0 +1,172 @@
+//  ---------------------------------------------------------------------------
+//  This file is part of reSID, a MOS6581 SID emulator engine.
+//  Copyright (C) 2010  Dag Lem <resid@nimrod.no>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//  ---------------------------------------------------------------------------
+
+#include "tablecache.h"
+#include <stdio.h>
+#include <string.h>
+
+namespace reSID
+{
+
+// Bump when the file layout changes.
+static const unsigned int TABLE_CACHE_VERSION = 1;
+static const char TABLE_CACHE_MAGIC[8] = { 'r', 'e', 'S', 'I', 'D', 't', 'b', 'l' };
+
+typedef struct {
+  char magic[8];
+  unsigned int version;
+  unsigned int key_size;
+  unsigned long long data_size;
+  unsigned long long checksum;
+} header_t;
+
+char* TableCache::directory = 0;
+
+// 64 bit FNV-1a.
+static unsigned long long fnv1a(unsigned long long h, const void* data,
+                                unsigned long size)
+{
+  const unsigned char* p = (const unsigned char*)data;
+  for (unsigned long i = 0; i < size; i++) {
+    h ^= p[i];
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+static const unsigned long long FNV_BASIS = 0xcbf29ce484222325ULL;
+
+// The file name contains the key hash, so tables for different parameters
+// (e.g. sampling rates) can be cached side by side.
+static char* cache_file_name(const char* dir, const char* name,
+                             const void* key, unsigned int key_size)
+{
+  unsigned long long h = fnv1a(FNV_BASIS, key, key_size);
+  size_t len = strlen(dir) + strlen(name) + 32;
+  char* path = new char[len];
+  snprintf(path, len, "%s/%s-%08x%08x.bin", dir, name,
+           (unsigned int)(h >> 32), (unsigned int)h);
+  return path;
+}
+
+void TableCache::set_directory(const char* dir)
+{
+  delete[] directory;
+  directory = 0;
+
+  if (dir && *dir) {
+    directory = new char[strlen(dir) + 1];
+    strcpy(directory, dir);
+  }
+}
+
+bool TableCache::enabled()
+{
+  return directory != 0;
+}
+
+bool TableCache::load(const char* name, const void* key, unsigned int key_size,
+                      const segment_t* seg, int n_seg)
+{
+  if (!directory) {
+    return false;
+  }
+
+  char* path = cache_file_name(directory, name, key, key_size);
+  FILE* fd = fopen(path, "rb");
+  delete[] path;
+  if (!fd) {
+    return false;
+  }
+
+  unsigned long long data_size = 0;
+  for (int i = 0; i < n_seg; i++) {
+    data_size += seg[i].size;
+  }
+
+  header_t header;
+  char* file_key = new char[key_size];
+  bool ok = fread(&header, sizeof(header), 1, fd) == 1
+    && memcmp(header.magic, TABLE_CACHE_MAGIC, sizeof(header.magic)) == 0
+    && header.version == TABLE_CACHE_VERSION
+    && header.key_size == key_size
+    && header.data_size == data_size
+    && fread(file_key, 1, key_size, fd) == key_size
+    && memcmp(file_key, key, key_size) == 0;
+  delete[] file_key;
+
+  unsigned long long checksum = FNV_BASIS;
+  for (int i = 0; ok && i < n_seg; i++) {
+    ok = fread(seg[i].data, 1, seg[i].size, fd) == seg[i].size;
+    if (ok) {
+      checksum = fnv1a(checksum, seg[i].data, seg[i].size);
+    }
+  }
+  fclose(fd);
+
+  // The tables may have been partially overwritten; the caller recomputes
+  // them from scratch in that case.
+  return ok && checksum == header.checksum;
+}
+
+void TableCache::save(const char* name, const void* key, unsigned int key_size,
+                      const segment_t* seg, int n_seg)
+{
+  if (!directory) {
+    return;
+  }
+
+  header_t header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, TABLE_CACHE_MAGIC, sizeof(header.magic));
+  header.version = TABLE_CACHE_VERSION;
+  header.key_size = key_size;
+  header.checksum = FNV_BASIS;
+  for (int i = 0; i < n_seg; i++) {
+    header.data_size += seg[i].size;
+    header.checksum = fnv1a(header.checksum, seg[i].data, seg[i].size);
+  }
+
+  // Write to a temporary file first, so that concurrent processes never
+  // see a partially written cache file.
+  char* path = cache_file_name(directory, name, key, key_size);
+  char* tmp_path = new char[strlen(path) + 5];
+  strcpy(tmp_path, path);
+  strcat(tmp_path, ".tmp");
+
+  FILE* fd = fopen(tmp_path, "wb");
+  if (fd) {
+    bool ok = fwrite(&header, sizeof(header), 1, fd) == 1
+      && fwrite(key, 1, key_size, fd) == key_size;
+    for (int i = 0; ok && i < n_seg; i++) {
+      ok = fwrite(seg[i].data, 1, seg[i].size, fd) == seg[i].size;
+    }
+    if (fclose(fd) != 0) {
+      ok = false;
+    }
+    if (!ok || rename(tmp_path, path) != 0) {
+      remove(tmp_path);
+    }
+  }
+
+  delete[] tmp_path;
+  delete[] path;
+}
+
+} // namespace reSID
@@ -0,0 +1,55 @@
+//  ---------------------------------------------------------------------------
+//  This file is part of reSID, a MOS6581 SID emulator engine.
+//  Copyright (C) 2010  Dag Lem <resid@nimrod.no>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//  ---------------------------------------------------------------------------
+
+#ifndef RESID_TABLECACHE_H
+#define RESID_TABLECACHE_H
+
+#include "resid-config.h"
+
+namespace reSID
+{
+
+// On-disk cache for the large precomputed tables (filter model, resampling
+// FIR).  A cache file holds a header with format version, key, size and
+// checksum, followed by the raw table data, so it can be read back (or
+// mapped) in one go.  Any mismatch makes the caller recompute the table.
+class TableCache
+{
+public:
+  typedef struct {
+    void* data;
+    unsigned long size;
+  } segment_t;
+
+  // Directory for the cache files; 0 or "" disables the cache.
+  static void set_directory(const char* dir);
+  static bool enabled();
+
+  static bool load(const char* name, const void* key, unsigned int key_size,
+                   const segment_t* seg, int n_seg);
+  static void save(const char* name, const void* key, unsigned int key_size,
+                   const segment_t* seg, int n_seg);
+
+protected:
+  static char* directory;
+};
+
+} // namespace reSID
+
+#endif // not RESID_TABLECACHE_H
@@ -0,0 +1,126 @@
+//  ---------------------------------------------------------------------------
+//  This file is part of reSID, a MOS6581 SID emulator engine.
+//  Copyright (C) 2010  Dag Lem <resid@nimrod.no>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//  ---------------------------------------------------------------------------
+
+// Check that every FIR convolution kernel the CPU supports renders the same
+// samples as the scalar kernel, in both resampling modes.  The sampling
+// frequencies give filters of different lengths, so the vector kernels run
+// with different numbers of taps left over for the scalar tail.
+
+#include "sid.h"
+#include <stdio.h>
+#include <string.h>
+
+using namespace reSID;
+
+enum {
+  CLOCK_FREQ = 985248,
+  CYCLES = 100000,
+  BUFSIZE = 8192
+};
+
+static const struct {
+  const char* name;
+  SID::fir_kernel kernel;
+} kernels[] = {
+  { "SSE2", SID::FIR_KERNEL_SSE2 },
+  { "AVX2", SID::FIR_KERNEL_AVX2 },
+  { "NEON", SID::FIR_KERNEL_NEON }
+};
+
+static const struct {
+  sampling_method method;
+  double sample_freq;
+  double pass_freq;
+} setups[] = {
+  { SAMPLE_RESAMPLE, 22050, -1 },
+  { SAMPLE_RESAMPLE, 44100, -1 },
+  { SAMPLE_RESAMPLE, 44100, 16000 },
+  { SAMPLE_RESAMPLE, 48000, -1 },
+  { SAMPLE_RESAMPLE_FASTMEM, 44100, -1 }
+};
+
+// Voice 1 sawtooth, voice 2 pulse and voice 3 noise, with voices 1 and 2
+// through the resonant low pass filter.
+static const reg8 tune[][2] = {
+  { 0x00, 0x00 }, { 0x01, 0x10 }, { 0x05, 0x09 }, { 0x06, 0xf0 },
+  { 0x07, 0x45 }, { 0x08, 0x23 }, { 0x09, 0x00 }, { 0x0a, 0x08 },
+  { 0x0c, 0x00 }, { 0x0d, 0xf0 }, { 0x0e, 0x00 }, { 0x0f, 0x40 },
+  { 0x13, 0x00 }, { 0x14, 0xf0 }, { 0x15, 0x00 }, { 0x16, 0x40 },
+  { 0x17, 0xf3 }, { 0x18, 0x1f }, { 0x04, 0x21 }, { 0x0b, 0x41 },
+  { 0x12, 0x81 }
+};
+
+static int render(sampling_method method, double sample_freq,
+                  double pass_freq, short* buf)
+{
+  SID sid;
+  int n = 0;
+
+  sid.set_sampling_parameters(CLOCK_FREQ, method, sample_freq, pass_freq);
+  for (unsigned int i = 0; i < sizeof(tune)/sizeof(*tune); i++) {
+    sid.write(tune[i][0], tune[i][1]);
+  }
+
+  for (int half = 0; half < 2; half++) {
+    cycle_count delta_t = CYCLES/2;
+    while (delta_t > 0 && n < BUFSIZE) {
+      n += sid.clock(delta_t, buf + n, BUFSIZE - n);
+    }
+    // Raise the filter cutoff for the second half.
+    if (half == 0) {
+      sid.write(0x16, 0xc0);
+    }
+  }
+
+  return n;
+}
+
+int main()
+{
+  static short ref[BUFSIZE], out[BUFSIZE];
+  int failed = 0;
+
+  for (unsigned int i = 0; i < sizeof(setups)/sizeof(*setups); i++) {
+    SID::set_fir_kernel(SID::FIR_KERNEL_SCALAR);
+    int n_ref = render(setups[i].method, setups[i].sample_freq,
+                       setups[i].pass_freq, ref);
+
+    for (unsigned int k = 0; k < sizeof(kernels)/sizeof(*kernels); k++) {
+      if (!SID::set_fir_kernel(kernels[k].kernel)) {
+        continue;
+      }
+      int n = render(setups[i].method, setups[i].sample_freq,
+                     setups[i].pass_freq, out);
+
+      bool ok = n == n_ref && memcmp(out, ref, n*sizeof(short)) == 0;
+      printf("%s, %s at %.0f Hz", kernels[k].name,
+             setups[i].method == SAMPLE_RESAMPLE ? "resample" : "fastmem",
+             setups[i].sample_freq);
+      if (setups[i].pass_freq > 0) {
+        printf(", pass band %.0f Hz", setups[i].pass_freq);
+      }
+      printf(": %s\n", ok ? "ok" : "differs from the scalar kernel");
+      if (!ok) {
+        failed = 1;
+      }
+    }
+  }
+
+  return failed;
+}
@@ -0,0 +1,671 @@
+/*
+ * rewind.c - Rewind buffer of in-memory machine snapshots.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* Every `RewindInterval' frames a snapshot of the machine is written into
+   a memory stream.  Captures are kept in a ring, oldest first.  Every
+   REWIND_KEYFRAME_INTERVAL captures a keyframe is stored; the captures in
+   between are stored as the XOR against that keyframe.  Both are run
+   length encoded, which turns the (mostly unchanged) RAM contents into
+   a few bytes.  When the ring grows beyond `RewindBufferSize' KiB the
+   oldest keyframe is dropped together with its deltas.
+
+   Encoded format: a sequence of
+     <varint zero count> <varint literal count> <literal bytes>
+   where a zero stands for a byte equal to the reference and a literal is
+   the XOR with the reference.  Keyframes use an all-zero reference.  */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cmdline.h"
+#include "interrupt.h"
+#include "lib.h"
+#include "log.h"
+#include "machine.h"
+#include "maincpu.h"
+#include "network.h"
+#include "resources.h"
+#include "rewind.h"
+#include "snapshot.h"
+#include "types.h"
+#include "vsync.h"
+#include "vsyncapi.h"
+
+/* Captures between two keyframes.  */
+#define REWIND_KEYFRAME_INTERVAL 32
+
+/* Zero runs shorter than this are folded into the literal run.  */
+#define REWIND_MIN_ZERO_RUN 4
+
+typedef struct rewind_entry_s {
+    /* Encoded snapshot.  */
+    uint8_t *data;
+    size_t size;
+
+    /* Size of the decoded snapshot.  */
+    size_t raw_size;
+
+    /* Flag: encoded against an all-zero reference.  */
+    int keyframe;
+
+    /* Value of vsync_frame_counter at capture time.  */
+    int frame;
+} rewind_entry_t;
+
+static log_t rewind_log = LOG_ERR;
+
+/* Resources.  */
+static int rewind_enabled = 0;
+static int rewind_interval = 25;
+static int rewind_buffer_size = 32768;
+static int rewind_verify = 0;
+
+/* Ring of captures.  */
+static rewind_entry_t *entries = NULL;
+static int entries_alloc = 0;
+static int entries_first = 0;
+static int entries_count = 0;
+static size_t entries_bytes = 0;
+
+/* Stream the machine snapshots are written to and read from.  */
+static snapshot_stream_t *rewind_stream = NULL;
+
+/* Decoded copy of the newest keyframe, the reference for new deltas.  */
+static uint8_t *key_buf = NULL;
+static size_t key_size = 0;
+static size_t key_alloc = 0;
+
+/* Scratch buffer for encoding and decoding.  */
+static uint8_t *work_buf = NULL;
+static size_t work_alloc = 0;
+
+/* Copy of a capture while it is checked with `RewindVerify'.  */
+static uint8_t *verify_buf = NULL;
+static size_t verify_alloc = 0;
+static unsigned long verify_failures = 0;
+
+static int captures_since_keyframe = 0;
+static int frames_until_capture = 0;
+static int capture_pending = 0;
+
+/* Flag and clock of the last restore, used to tell whether the machine
+   still sits on the newest capture.  */
+static int restored = 0;
+static CLOCK restored_clk;
+
+/* Number and total host time of the machine snapshot writes and reads,
+   logged at shutdown.  */
+static unsigned long capture_count = 0;
+static unsigned long capture_time = 0;
+static unsigned long restore_count = 0;
+static unsigned long restore_time = 0;
+
+/* ------------------------------------------------------------------------- */
+
+static rewind_entry_t *rewind_entry(int i)
+{
+    return &entries[(entries_first + i) % entries_alloc];
+}
+
+static void rewind_buffer_reserve(uint8_t **buf, size_t *alloc, size_t needed)
+{
+    if (needed > *alloc) {
+        *buf = lib_realloc(*buf, needed);
+        *alloc = needed;
+    }
+}
+
+static uint8_t *rewind_put_varint(uint8_t *p, size_t value)
+{
+    while (value >= 0x80) {
+        *p++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *p++ = (uint8_t)value;
+    return p;
+}
+
+static const uint8_t *rewind_get_varint(const uint8_t *p, const uint8_t *end, size_t *value)
+{
+    size_t v = 0;
+    int shift = 0;
+
+    while (p < end && (*p & 0x80)) {
+        v |= (size_t)(*p++ & 0x7f) << shift;
+        shift += 7;
+    }
+    if (p >= end) {
+        return NULL;
+    }
+    *value = v | ((size_t)*p++ << shift);
+    return p;
+}
+
+static uint8_t rewind_ref_byte(const uint8_t *ref, size_t ref_size, size_t i)
+{
+    return (i < ref_size) ? ref[i] : 0;
+}
+
+/* Encode `data' against `ref' (which may be shorter, or NULL) into
+   work_buf.  Returns the encoded size.  */
+static size_t rewind_encode(const uint8_t *data, size_t size, const uint8_t *ref, size_t ref_size)
+{
+    size_t i = 0, zeros, lit_start, lit_end, run;
+    uint8_t *p;
+
+    if (ref == NULL) {
+        ref_size = 0;
+    }
+
+    /* Worst case: a pair header for every REWIND_MIN_ZERO_RUN bytes.  */
+    rewind_buffer_reserve(&work_buf, &work_alloc, size + (size / REWIND_MIN_ZERO_RUN + 1) * 20);
+    p = work_buf;
+
+    while (i < size) {
+        zeros = i;
+        while (i < size && data[i] == rewind_ref_byte(ref, ref_size, i)) {
+            i++;
+        }
+        zeros = i - zeros;
+
+        /* Extend the literal run until a long enough zero run follows.  */
+        lit_start = i;
+        lit_end = i;
+        while (lit_end < size) {
+            if (data[lit_end] != rewind_ref_byte(ref, ref_size, lit_end)) {
+                lit_end++;
+                continue;
+            }
+            run = 0;
+            while (lit_end + run < size && run < REWIND_MIN_ZERO_RUN
+                   && data[lit_end + run] == rewind_ref_byte(ref, ref_size, lit_end + run)) {
+                run++;
+            }
+            if (run >= REWIND_MIN_ZERO_RUN || lit_end + run == size) {
+                break;
+            }
+            lit_end += run;
+        }
+
+        p = rewind_put_varint(p, zeros);
+        p = rewind_put_varint(p, lit_end - lit_start);
+        for (i = lit_start; i < lit_end; i++) {
+            *p++ = data[i] ^ rewind_ref_byte(ref, ref_size, i);
+        }
+    }
+
+    return (size_t)(p - work_buf);
+}
+
+/* Decode an entry against `ref' into work_buf.  */
+static int rewind_decode(const rewind_entry_t *e, const uint8_t *ref, size_t ref_size)
+{
+    const uint8_t *p = e->data, *end = e->data + e->size;
+    size_t i = 0, zeros, lits;
+
+    if (ref == NULL) {
+        ref_size = 0;
+    }
+
+    rewind_buffer_reserve(&work_buf, &work_alloc, e->raw_size);
+
+    while (p < end) {
+        if ((p = rewind_get_varint(p, end, &zeros)) == NULL
+            || (p = rewind_get_varint(p, end, &lits)) == NULL
+            || zeros > e->raw_size - i
+            || lits > e->raw_size - i - zeros
+            || lits > (size_t)(end - p)) {
+            return -1;
+        }
+        for (; zeros > 0; zeros--, i++) {
+            work_buf[i] = rewind_ref_byte(ref, ref_size, i);
+        }
+        for (; lits > 0; lits--, i++) {
+            work_buf[i] = *p++ ^ rewind_ref_byte(ref, ref_size, i);
+        }
+    }
+
+    return (i == e->raw_size) ? 0 : -1;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Remove `count' entries from the old end of the ring.  */
+static void rewind_drop_oldest(int count)
+{
+    rewind_entry_t *e;
+
+    while (count-- > 0 && entries_count > 0) {
+        e = rewind_entry(0);
+        entries_bytes -= e->size;
+        lib_free(e->data);
+        e->data = NULL;
+        entries_first = (entries_first + 1) % entries_alloc;
+        entries_count--;
+    }
+}
+
+/* Remove all entries newer than index `last'.  */
+static void rewind_drop_newer(int last)
+{
+    rewind_entry_t *e;
+
+    while (entries_count > last + 1) {
+        e = rewind_entry(entries_count - 1);
+        entries_bytes -= e->size;
+        lib_free(e->data);
+        e->data = NULL;
+        entries_count--;
+    }
+}
+
+/* Drop whole keyframe groups until the ring fits in the buffer size.  The
+   newest group is always kept.  */
+static void rewind_trim(void)
+{
+    int next_key;
+
+    while (entries_bytes > (size_t)rewind_buffer_size * 1024) {
+        for (next_key = 1; next_key < entries_count; next_key++) {
+            if (rewind_entry(next_key)->keyframe) {
+                break;
+            }
+        }
+        if (next_key >= entries_count) {
+            break;
+        }
+        rewind_drop_oldest(next_key);
+    }
+}
+
+static void rewind_append(rewind_entry_t *entry)
+{
+    rewind_entry_t *new_entries;
+    int i, new_alloc;
+
+    if (entries_count == entries_alloc) {
+        /* Grow the ring and unwrap it at the same time.  */
+        new_alloc = entries_alloc ? entries_alloc * 2 : 64;
+        new_entries = lib_malloc(sizeof(rewind_entry_t) * new_alloc);
+        for (i = 0; i < entries_count; i++) {
+            new_entries[i] = *rewind_entry(i);
+        }
+        lib_free(entries);
+        entries = new_entries;
+        entries_alloc = new_alloc;
+        entries_first = 0;
+    }
+
+    *rewind_entry(entries_count) = *entry;
+    entries_count++;
+    entries_bytes += entry->size;
+}
+
+void rewind_clear(void)
+{
+    rewind_drop_oldest(entries_count);
+    entries_first = 0;
+    key_size = 0;
+    captures_since_keyframe = 0;
+    frames_until_capture = 0;
+    restored = 0;
+}
+
+/* Restore the capture just written and write it again; the two snapshots
+   must be identical.  The restore happens on the instruction boundary the
+   capture was taken at, so the emulation goes on as if nothing happened.  */
+static int rewind_verify_capture(void)
+{
+    const uint8_t *data;
+    size_t size, n, i;
+    unsigned long start;
+
+    size = snapshot_memory_stream_size(rewind_stream);
+    rewind_buffer_reserve(&verify_buf, &verify_alloc, size);
+    memcpy(verify_buf, snapshot_memory_stream_data(rewind_stream), size);
+
+    start = vsyncarch_gettime();
+    if (machine_read_snapshot_stream(rewind_stream, 0) < 0) {
+        log_error(rewind_log, "Cannot restore machine state.");
+        return -1;
+    }
+    restore_time += vsyncarch_gettime() - start;
+    restore_count++;
+
+    if (machine_write_snapshot_stream(rewind_stream, 0, 0, 0) < 0) {
+        log_error(rewind_log, "Cannot capture machine state.");
+        return -1;
+    }
+
+    data = snapshot_memory_stream_data(rewind_stream);
+    n = snapshot_memory_stream_size(rewind_stream);
+    if (n != size || memcmp(data, verify_buf, size) != 0) {
+        for (i = 0; i < size && i < n && data[i] == verify_buf[i]; i++) {
+        }
+        if (verify_failures == 0) {
+            log_error(rewind_log, "Restored machine state differs at offset %lu of %lu.",
+                      (unsigned long)i, (unsigned long)size);
+        }
+        verify_failures++;
+    }
+
+    return 0;
+}
+
+static void rewind_capture(void)
+{
+    const uint8_t *data;
+    size_t size, encoded;
+    rewind_entry_t entry;
+    unsigned long start;
+
+    if (rewind_stream == NULL) {
+        rewind_stream = snapshot_memory_stream_new();
+    }
+
+    start = vsyncarch_gettime();
+    if (machine_write_snapshot_stream(rewind_stream, 0, 0, 0) < 0) {
+        log_error(rewind_log, "Cannot capture machine state, rewind disabled.");
+        resources_set_int("Rewind", 0);
+        return;
+    }
+    capture_time += vsyncarch_gettime() - start;
+    capture_count++;
+
+    if (rewind_verify && rewind_verify_capture() < 0) {
+        resources_set_int("Rewind", 0);
+        return;
+    }
+
+    data = snapshot_memory_stream_data(rewind_stream);
+    size = snapshot_memory_stream_size(rewind_stream);
+
+    entry.keyframe = (key_size == 0 || captures_since_keyframe >= REWIND_KEYFRAME_INTERVAL);
+    encoded = 0;
+
+    if (!entry.keyframe) {
+        encoded = rewind_encode(data, size, key_buf, key_size);
+        /* Not worth a delta if most of the snapshot changed.  */
+        if (encoded > size / 2) {
+            entry.keyframe = 1;
+        }
+    }
+
+    if (entry.keyframe) {
+        encoded = rewind_encode(data, size, NULL, 0);
+        rewind_buffer_reserve(&key_buf, &key_alloc, size);
+        memcpy(key_buf, data, size);
+        key_size = size;
+        captures_since_keyframe = 0;
+    }
+    captures_since_keyframe++;
+
+    entry.data = lib_malloc(encoded);
+    memcpy(entry.data, work_buf, encoded);
+    entry.size = encoded;
+    entry.raw_size = size;
+    entry.frame = vsync_frame_counter;
+
+    rewind_append(&entry);
+    rewind_trim();
+}
+
+static void rewind_capture_trap(uint16_t addr, void *data)
+{
+    capture_pending = 0;
+    if (rewind_enabled) {
+        rewind_capture();
+    }
+}
+
+void rewind_vsync(void)
+{
+    if (!rewind_enabled || capture_pending || network_connected()) {
+        return;
+    }
+
+    if (--frames_until_capture > 0) {
+        return;
+    }
+    frames_until_capture = rewind_interval;
+
+    /* The snapshot must be taken between two CPU instructions.  */
+    capture_pending = 1;
+    interrupt_maincpu_trigger_trap(rewind_capture_trap, NULL);
+}
+
+int rewind_step_back(int steps)
+{
+    rewind_entry_t *e, *key;
+    int target, k, newest;
+    unsigned long start;
+
+    if (entries_count == 0 || steps < 1) {
+        return 0;
+    }
+
+    /* Right after a restore the newest capture is the current state, so
+       one step back means the capture before it.  */
+    newest = entries_count - 1;
+    if (restored && maincpu_clk == restored_clk) {
+        newest--;
+    }
+    target = newest + 1 - steps;
+    if (target < 0) {
+        target = 0;
+    }
+    e = rewind_entry(target);
+
+    for (k = target; !rewind_entry(k)->keyframe; k--) {
+    }
+    key = rewind_entry(k);
+
+    /* Rebuild the keyframe, it becomes the reference for new deltas.  */
+    if (rewind_decode(key, NULL, 0) < 0) {
+        log_error(rewind_log, "Corrupt rewind keyframe.");
+        rewind_clear();
+        return -1;
+    }
+    rewind_buffer_reserve(&key_buf, &key_alloc, key->raw_size);
+    memcpy(key_buf, work_buf, key->raw_size);
+    key_size = key->raw_size;
+
+    if (e != key && rewind_decode(e, key_buf, key_size) < 0) {
+        log_error(rewind_log, "Corrupt rewind delta.");
+        rewind_clear();
+        return -1;
+    }
+
+    snapshot_memory_stream_set_data(rewind_stream, work_buf, e->raw_size);
+    start = vsyncarch_gettime();
+    if (machine_read_snapshot_stream(rewind_stream, 0) < 0) {
+        log_error(rewind_log, "Cannot restore machine state.");
+        rewind_clear();
+        return -1;
+    }
+    restore_time += vsyncarch_gettime() - start;
+    restore_count++;
+
+    restored = 1;
+    restored_clk = maincpu_clk;
+
+    steps = newest + 1 - target;
+    rewind_drop_newer(target);
+    captures_since_keyframe = target - k + 1;
+    frames_until_capture = rewind_interval;
+
+    return steps;
+}
+
+int rewind_get_info(int *captures, int *keyframes, size_t *bytes, double *seconds)
+{
+    int i, n = 0;
+    double rate = vsync_get_refresh_frequency();
+
+    for (i = 0; i < entries_count; i++) {
+        n += rewind_entry(i)->keyframe;
+    }
+
+    *captures = entries_count;
+    *keyframes = n;
+    *bytes = entries_bytes;
+    *seconds = 0.0;
+    if (entries_count > 1 && rate > 0.0) {
+        *seconds = (rewind_entry(entries_count - 1)->frame - rewind_entry(0)->frame) / rate;
+    }
+
+    return rewind_enabled;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int set_rewind_enabled(int val, void *param)
+{
+    rewind_enabled = val ? 1 : 0;
+
+    if (!rewind_enabled) {
+        rewind_clear();
+    }
+
+    return 0;
+}
+
+static int set_rewind_interval(int val, void *param)
+{
+    if (val < 1) {
+        return -1;
+    }
+
+    rewind_interval = val;
+    if (frames_until_capture > val) {
+        frames_until_capture = val;
+    }
+
+    return 0;
+}
+
+static int set_rewind_buffer_size(int val, void *param)
+{
+    if (val < 64) {
+        return -1;
+    }
+
+    rewind_buffer_size = val;
+    rewind_trim();
+
+    return 0;
+}
+
+static int set_rewind_verify(int val, void *param)
+{
+    rewind_verify = val ? 1 : 0;
+
+    return 0;
+}
+
+static const resource_int_t resources_int[] = {
+    { "Rewind", 0, RES_EVENT_NO, NULL,
+      &rewind_enabled, set_rewind_enabled, NULL },
+    { "RewindInterval", 25, RES_EVENT_NO, NULL,
+      &rewind_interval, set_rewind_interval, NULL },
+    { "RewindBufferSize", 32768, RES_EVENT_NO, NULL,
+      &rewind_buffer_size, set_rewind_buffer_size, NULL },
+    { "RewindVerify", 0, RES_EVENT_NO, NULL,
+      &rewind_verify, set_rewind_verify, NULL },
+    RESOURCE_INT_LIST_END
+};
+
+int rewind_resources_init(void)
+{
+    rewind_log = log_open("Rewind");
+
+    return resources_register_int(resources_int);
+}
+
+static const cmdline_option_t cmdline_options[] =
+{
+    { "-rewind", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "Rewind", (resource_value_t)1,
+      NULL, "Keep a history of machine states to rewind to" },
+    { "+rewind", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "Rewind", (resource_value_t)0,
+      NULL, "Do not keep a rewind history" },
+    { "-rewindinterval", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "RewindInterval", NULL,
+      "<frames>", "Capture the machine state for rewind every <frames> frames" },
+    { "-rewindbuffersize", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "RewindBufferSize", NULL,
+      "<KiB>", "Maximum memory used by the rewind history" },
+    { "-rewindverify", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "RewindVerify", (resource_value_t)1,
+      NULL, "Check every rewind capture by restoring it and capturing again" },
+    { "+rewindverify", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "RewindVerify", (resource_value_t)0,
+      NULL, "Do not check the rewind captures" },
+    CMDLINE_LIST_END
+};
+
+int rewind_cmdline_options_init(void)
+{
+    return cmdline_register_options(cmdline_options);
+}
+
+static double rewind_average_us(unsigned long time, unsigned long count)
+{
+    return (double)time * 1e6 / (double)vsyncarch_frequency() / (double)count;
+}
+
+void rewind_shutdown(void)
+{
+    if (capture_count > 0) {
+        log_message(rewind_log, "%lu machine snapshots written, %.0f us each.",
+                    capture_count, rewind_average_us(capture_time, capture_count));
+    }
+    if (restore_count > 0) {
+        log_message(rewind_log, "%lu machine snapshots read, %.0f us each.",
+                    restore_count, rewind_average_us(restore_time, restore_count));
+    }
+    if (verify_failures > 0) {
+        log_error(rewind_log, "%lu of %lu restored machine states differ.",
+                  verify_failures, capture_count);
+    }
+
+    rewind_clear();
+    lib_free(entries);
+    entries = NULL;
+    entries_alloc = 0;
+    lib_free(key_buf);
+    key_buf = NULL;
+    key_alloc = 0;
+    lib_free(work_buf);
+    work_buf = NULL;
+    work_alloc = 0;
+    lib_free(verify_buf);
+    verify_buf = NULL;
+    verify_alloc = 0;
+    snapshot_memory_stream_free(rewind_stream);
+    rewind_stream = NULL;
+}
@@ -0,0 +1,50 @@
+/*
+ * rewind.h - Rewind buffer of in-memory machine snapshots.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_REWIND_H
+#define VICE_REWIND_H
+
+#include <stddef.h>
+
+extern int rewind_resources_init(void);
+extern int rewind_cmdline_options_init(void);
+extern void rewind_shutdown(void);
+
+/* Called once per emulated frame; schedules a capture when one is due.  */
+extern void rewind_vsync(void);
+
+/* Drop all recorded history.  */
+extern void rewind_clear(void);
+
+/* Restore the machine to the state captured `steps' captures ago (1 is
+   the most recent capture).  Newer captures are discarded.  Must be
+   called at a safe point (trap or monitor), like machine_read_snapshot().
+   Returns the number of steps actually taken, or -1 on error.  */
+extern int rewind_step_back(int steps);
+
+/* Describe the recorded history: number of captures and keyframes, memory
+   used and time span.  Returns nonzero if rewind is enabled.  */
+extern int rewind_get_info(int *captures, int *keyframes, size_t *bytes,
+                           double *seconds);
+
+#endif
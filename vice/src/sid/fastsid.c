@@ -998,7 +998,7 @@ static uint8_t fastsid_read(sound_t *psid, uint16_t addr)
             break;
         default:
             while ((tmp = psid->laststorebit) &&
-                   (tmp = psid->laststoreclk + sidreadclocks[tmp]) < maincpu_clk) {
+                   (tmp = psid->laststoreclk + sidreadclocks[tmp]) < sound_get_clk()) {
                 psid->laststoreclk = tmp;
                 psid->laststore &= 0xfeff >> psid->laststorebit--;
             }
@@ -1057,7 +1057,7 @@ static void fastsid_store(sound_t *psid, uint16_t addr, uint8_t byte)
     psid->d[addr] = byte;
     psid->laststore = byte;
     psid->laststorebit = 8;
-    psid->laststoreclk = maincpu_clk;
+    psid->laststoreclk = sound_get_clk();
 }
 
 static void fastsid_reset(sound_t *psid, CLOCK cpu_clk)
@@ -60,6 +60,9 @@ extern char *strcpy(char *s1, char *s2);
 #endif
 
 #include "sid/sid.h" /* sid_engine_t */
+#include "archdep_join_paths.h"
+#include "archdep_user_config_path.h"
+#include "ioutil.h"
 #include "lib.h"
 #include "log.h"
 #include "resid.h"
@@ -70,6 +73,7 @@ extern char *strcpy(char *s1, char *s2);
 } // extern "C"
 
 #include "resid/sid.h"
+#include "resid/tablecache.h"
 /* resid-dtv/ is used for DTVSID, but the API is the same */
 
 using namespace reSID;
@@ -83,25 +87,46 @@ struct sound_s
 
     /* resid sid implementation */
     reSID::SID *sid;
+
+    /* temporary buffer for speed factors other than 1000 */
+    short *buf;
+    int blen;
 };
 
 typedef struct sound_s sound_t;
 
 /* manage temporary buffers. if the requested size is smaller or equal to the
- * size of the already allocated buffer, reuse it.  */
-static short *buf = NULL;
-static int blen = 0;
-
-static short *getbuf(int len)
+ * size of the already allocated buffer, reuse it. every SID has its own
+ * buffer so several SIDs can be rendered at the same time.  */
+static short *getbuf(sound_t *psid, int len)
 {
-    if ((buf == NULL) || (blen < len)) {
-        if (buf) {
-            lib_free(buf);
+    if ((psid->buf == NULL) || (psid->blen < len)) {
+        if (psid->buf) {
+            lib_free(psid->buf);
         }
-        blen = len;
-        buf = (short *)lib_calloc(len, 1);
+        psid->blen = len;
+        psid->buf = (short *)lib_calloc(len, 1);
+    }
+    return psid->buf;
+}
+
+/* Point the reSID table cache at a directory below the user config path,
+   or disable it, before the next reSID::SID is constructed.  */
+static void resid_table_cache_init(void)
+{
+    static char *cache_dir = NULL;
+    int table_cache;
+
+    if (resources_get_int("SidResidTableCache", &table_cache) < 0 || !table_cache) {
+        reSID::TableCache::set_directory(NULL);
+        return;
     }
-    return buf;
+
+    if (cache_dir == NULL) {
+        cache_dir = archdep_join_paths(archdep_user_config_path(), "resid-cache", NULL);
+        ioutil_mkdir(cache_dir, 0755);
+    }
+    reSID::TableCache::set_directory(cache_dir);
 }
 
 static sound_t *resid_open(uint8_t *sidstate)
@@ -109,8 +134,12 @@ static sound_t *resid_open(uint8_t *sidstate)
     sound_t *psid;
     int i;
 
+    resid_table_cache_init();
+
     psid = new sound_t;
     psid->sid = new reSID::SID;
+    psid->buf = NULL;
+    psid->blen = 0;
 
     for (i = 0x00; i <= 0x18; i++) {
         psid->sid->write(i, sidstate[i]);
@@ -246,13 +275,12 @@ static int resid_init(sound_t *psid, int speed, int cycles_per_sec, int factor)
 
 static void resid_close(sound_t *psid)
 {
+    if (psid->buf) {
+        lib_free(psid->buf);
+    }
+
     delete psid->sid;
     delete psid;
-
-    if (buf) {
-        lib_free(buf);
-        buf = NULL;
-    }
 }
 
 static uint8_t resid_read(sound_t *psid, uint16_t addr)
@@ -279,7 +307,7 @@ static int resid_calculate_samples(sound_t *psid, short *pbuf, int nr,
     if (psid->factor == 1000) {
         return psid->sid->clock(*delta_t, pbuf, nr, interleave);
     }
-    tmp_buf = getbuf(2 * nr * psid->factor / 1000);
+    tmp_buf = getbuf(psid, 2 * nr * psid->factor / 1000);
     retval = psid->sid->clock(*delta_t, tmp_buf, nr * psid->factor / 1000, interleave) * 1000 / psid->factor;
     memcpy(pbuf, tmp_buf, 2 * nr);
     return retval;
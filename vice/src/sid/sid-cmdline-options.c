@@ -191,6 +191,12 @@ static const cmdline_option_t resid_cmdline_options[] =
     { "-resid8580filterbias", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
       NULL, NULL, "SidResid8580FilterBias", NULL,
       "<number>", "reSID 8580 filter bias setting, which can be used to adjust DAC bias in millivolts.", },
+    { "-residtablecache", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "SidResidTableCache", (void *)1,
+      NULL, "Cache the reSID filter and resampling tables on disk" },
+    { "+residtablecache", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "SidResidTableCache", (void *)0,
+      NULL, "Always compute the reSID filter and resampling tables" },
     CMDLINE_LIST_END
 };
 #endif
@@ -222,6 +228,9 @@ static cmdline_option_t stereo_cmdline_options[] =
     { "-sidquadaddress", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
       NULL, NULL, "SidQuadAddressStart", NULL,
       "<Base address>", NULL },
+    { "-sidmixmatrix", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "SidMixMatrix", NULL,
+      "<gains>", "Left and right gain in percent of each SID, separated by commas (empty for the default routing)" },
     CMDLINE_LIST_END
 };
 
@@ -233,6 +242,12 @@ static const cmdline_option_t common_cmdline_options[] =
     { "+sidfilters", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
       NULL, NULL, "SidFilters", (void *)0,
       NULL, "Do not emulate SID filters" },
+    { "-sidthreads", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "SidThreads", (void *)1,
+      NULL, "Render multiple reSID chips on separate threads" },
+    { "+sidthreads", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "SidThreads", (void *)0,
+      NULL, "Render all SID chips on the emulation thread" },
     CMDLINE_LIST_END
 };
 
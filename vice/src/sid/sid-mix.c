@@ -0,0 +1,191 @@
+/*
+ * sid-mix.c - Mix the output of several SIDs.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "sid-mix.h"
+#include "sound.h"
+#include "types.h"
+
+/* Vector version of `sound_audio_mix()'.  For samples of the same sign the
+   result is sign * (|a| + |b| - ((|a| * |b|) >> 15)), otherwise it is
+   a + b; neither can leave the 16 bit range, so plain wrapping 16 bit
+   arithmetic gives exactly the same result as the scalar code.  */
+void sid_mix_buffer(int16_t *dst, const int16_t *src, int nr)
+{
+    int i = 0;
+
+#if defined(__AVX2__)
+    for (; i + 16 <= nr; i += 16) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(dst + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i sa = _mm256_srai_epi16(a, 15);
+        __m256i sb = _mm256_srai_epi16(b, 15);
+        __m256i ua = _mm256_sub_epi16(_mm256_xor_si256(a, sa), sa);
+        __m256i ub = _mm256_sub_epi16(_mm256_xor_si256(b, sb), sb);
+        __m256i p = _mm256_or_si256(_mm256_slli_epi16(_mm256_mulhi_epu16(ua, ub), 1),
+                                    _mm256_srli_epi16(_mm256_mullo_epi16(ua, ub), 15));
+        __m256i m = _mm256_sub_epi16(_mm256_add_epi16(ua, ub), p);
+        __m256i diff = _mm256_srai_epi16(_mm256_xor_si256(a, b), 15);
+
+        m = _mm256_sub_epi16(_mm256_xor_si256(m, sa), sa);
+        m = _mm256_or_si256(_mm256_and_si256(diff, _mm256_add_epi16(a, b)),
+                            _mm256_andnot_si256(diff, m));
+        _mm256_storeu_si256((__m256i *)(dst + i), m);
+    }
+#elif defined(__SSE2__)
+    for (; i + 8 <= nr; i += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i sa = _mm_srai_epi16(a, 15);
+        __m128i sb = _mm_srai_epi16(b, 15);
+        __m128i ua = _mm_sub_epi16(_mm_xor_si128(a, sa), sa);
+        __m128i ub = _mm_sub_epi16(_mm_xor_si128(b, sb), sb);
+        __m128i p = _mm_or_si128(_mm_slli_epi16(_mm_mulhi_epu16(ua, ub), 1),
+                                 _mm_srli_epi16(_mm_mullo_epi16(ua, ub), 15));
+        __m128i m = _mm_sub_epi16(_mm_add_epi16(ua, ub), p);
+        __m128i diff = _mm_srai_epi16(_mm_xor_si128(a, b), 15);
+
+        m = _mm_sub_epi16(_mm_xor_si128(m, sa), sa);
+        m = _mm_or_si128(_mm_and_si128(diff, _mm_add_epi16(a, b)),
+                         _mm_andnot_si128(diff, m));
+        _mm_storeu_si128((__m128i *)(dst + i), m);
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= nr; i += 8) {
+        int16x8_t a = vld1q_s16(dst + i);
+        int16x8_t b = vld1q_s16(src + i);
+        int16x8_t sa = vshrq_n_s16(a, 15);
+        int16x8_t sb = vshrq_n_s16(b, 15);
+        uint16x8_t ua = vreinterpretq_u16_s16(vsubq_s16(veorq_s16(a, sa), sa));
+        uint16x8_t ub = vreinterpretq_u16_s16(vsubq_s16(veorq_s16(b, sb), sb));
+        uint16x8_t p = vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(ua), vget_low_u16(ub)), 15),
+                                    vshrn_n_u32(vmull_u16(vget_high_u16(ua), vget_high_u16(ub)), 15));
+        int16x8_t m = vreinterpretq_s16_u16(vsubq_u16(vaddq_u16(ua, ub), p));
+        uint16x8_t diff = vreinterpretq_u16_s16(vshrq_n_s16(veorq_s16(a, b), 15));
+
+        m = vsubq_s16(veorq_s16(m, sa), sa);
+        vst1q_s16(dst + i, vbslq_s16(diff, vaddq_s16(a, b), m));
+    }
+#endif
+
+    for (; i < nr; i++) {
+        dst[i] = sound_audio_mix(dst[i], src[i]);
+    }
+}
+
+/* The products are computed at 32 bits, shifted down arithmetically and
+   packed back with signed saturation, which is the scalar code below.  */
+void sid_mix_scale(int16_t *dst, const int16_t *src, int nr, int gain)
+{
+    int i = 0;
+    int sample;
+
+#if defined(__AVX2__)
+    __m256i g = _mm256_set1_epi16((short)gain);
+
+    for (; i + 16 <= nr; i += 16) {
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i lo = _mm256_mullo_epi16(s, g);
+        __m256i hi = _mm256_mulhi_epi16(s, g);
+        __m256i p0 = _mm256_srai_epi32(_mm256_unpacklo_epi16(lo, hi), 8);
+        __m256i p1 = _mm256_srai_epi32(_mm256_unpackhi_epi16(lo, hi), 8);
+
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_packs_epi32(p0, p1));
+    }
+#elif defined(__SSE2__)
+    __m128i g = _mm_set1_epi16((short)gain);
+
+    for (; i + 8 <= nr; i += 8) {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i lo = _mm_mullo_epi16(s, g);
+        __m128i hi = _mm_mulhi_epi16(s, g);
+        __m128i p0 = _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 8);
+        __m128i p1 = _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 8);
+
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packs_epi32(p0, p1));
+    }
+#elif defined(__ARM_NEON)
+    int16x4_t g = vdup_n_s16((int16_t)gain);
+
+    for (; i + 8 <= nr; i += 8) {
+        int16x8_t s = vld1q_s16(src + i);
+        int32x4_t p0 = vmull_s16(vget_low_s16(s), g);
+        int32x4_t p1 = vmull_s16(vget_high_s16(s), g);
+
+        vst1q_s16(dst + i, vcombine_s16(vqshrn_n_s32(p0, 8), vqshrn_n_s32(p1, 8)));
+    }
+#endif
+
+    for (; i < nr; i++) {
+        sample = (src[i] * gain) >> 8;
+        if (sample > 32767) {
+            sample = 32767;
+        } else if (sample < -32768) {
+            sample = -32768;
+        }
+        dst[i] = (int16_t)sample;
+    }
+}
+
+void sid_mix_channel(int16_t *dst, int16_t * const *src, const int *gain,
+                     int num, int nr, int16_t *scratch)
+{
+    const int16_t *buf;
+    int i, mixed = 0;
+
+    for (i = 0; i < num; i++) {
+        if (gain[i] == 0) {
+            continue;
+        }
+        buf = src[i];
+        if (gain[i] != SID_MIX_UNITY) {
+            if (!mixed) {
+                sid_mix_scale(dst, buf, nr, gain[i]);
+                mixed = 1;
+                continue;
+            }
+            sid_mix_scale(scratch, buf, nr, gain[i]);
+            buf = scratch;
+        }
+        if (mixed) {
+            sid_mix_buffer(dst, buf, nr);
+        } else {
+            memcpy(dst, buf, nr * sizeof(int16_t));
+            mixed = 1;
+        }
+    }
+    if (!mixed) {
+        memset(dst, 0, nr * sizeof(int16_t));
+    }
+}
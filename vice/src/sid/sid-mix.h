@@ -0,0 +1,45 @@
+/*
+ * sid-mix.h - Mix the output of several SIDs.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_SID_MIX_H
+#define VICE_SID_MIX_H
+
+#include "types.h"
+
+/* Full volume in a panning matrix.  */
+#define SID_MIX_UNITY 256
+
+/* Mix `nr' samples of `src' into `dst' with `sound_audio_mix()'.  */
+extern void sid_mix_buffer(int16_t *dst, const int16_t *src, int nr);
+
+/* Store `nr' samples of `src' times `gain' / SID_MIX_UNITY to `dst',
+   rounded down and clipped to 16 bits.  */
+extern void sid_mix_scale(int16_t *dst, const int16_t *src, int nr, int gain);
+
+/* Mix `num' buffers of `nr' samples into `dst', buffer `i' with `gain[i]'.
+   Buffers with a gain of 0 are left out, buffers at SID_MIX_UNITY are used
+   as they are.  `scratch' has room for `nr' samples.  */
+extern void sid_mix_channel(int16_t *dst, int16_t * const *src, const int *gain,
+                            int num, int nr, int16_t *scratch);
+
+#endif
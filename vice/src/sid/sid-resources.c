@@ -30,6 +30,7 @@
 #include "vice.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "catweaselmkiii.h"
 #include "hardsid.h"
@@ -39,11 +40,14 @@
 #include "parsid.h"
 #endif
 #include "resources.h"
+#include "sid-mix.h"
 #include "sid-resources.h"
+#include "sid-thread.h"
 #include "sid.h"
 #include "ssi2001.h"
 #include "sound.h"
 #include "types.h"
+#include "util.h"
 
 /* Resource handling -- Added by Ettore 98-04-26.  */
 
@@ -54,6 +58,7 @@
 
 static int sid_filters_enabled;       /* app_resources.sidFilters */
 static int sid_model;                 /* app_resources.sidModel */
+static int sid_threads;               /* render SIDs on worker threads */
 #if defined(HAVE_RESID)
 static int sid_resid_sampling;
 static int sid_resid_passband;
@@ -62,6 +67,7 @@ static int sid_resid_filter_bias;
 static int sid_resid_8580_passband;
 static int sid_resid_8580_gain;
 static int sid_resid_8580_filter_bias;
+static int sid_resid_table_cache;
 #endif
 int sid_stereo = 0;
 int checking_sid_stereo;
@@ -71,6 +77,7 @@ unsigned int sid_triple_address_start;
 unsigned int sid_triple_address_end;
 unsigned int sid_quad_address_start;
 unsigned int sid_quad_address_end;
+static char *sid_mix_matrix = NULL;
 static int sid_engine;
 #ifdef HAVE_HARDSID
 static int sid_hardsid_main;
@@ -134,6 +141,16 @@ static int set_sid_filters_enabled(int val, void *param)
     return 0;
 }
 
+static int set_sid_threads(int val, void *param)
+{
+    if (sid_thread_set_enabled(val) < 0) {
+        return -1;
+    }
+    sid_threads = val ? 1 : 0;
+
+    return 0;
+}
+
 static int set_sid_stereo(int val, void *param)
 {
     if ((machine_class == VICE_MACHINE_C64DTV) ||
@@ -201,6 +218,49 @@ int sid_set_sid_quad_address(int val, void *param)
     return 0;
 }
 
+/* Highest gain in the panning matrix, in percent.  */
+#define SID_MIX_GAIN_MAX    400
+
+/* Left and right gain of each SID in percent, separated by commas or
+   spaces.  A negative gain, or a SID that is not listed, keeps the default
+   routing.  */
+static int set_sid_mix_matrix(const char *val, void *param)
+{
+    int matrix[SOUND_SIDS_MAX * 2];
+    const char *p = val;
+    char *end;
+    long gain;
+    int i;
+
+    if (val == NULL || *val == '\0') {
+        sid_sound_machine_set_mix_matrix(NULL);
+        util_string_set(&sid_mix_matrix, "");
+        return 0;
+    }
+
+    for (i = 0; i < SOUND_SIDS_MAX * 2; i++) {
+        matrix[i] = -1;
+    }
+    for (i = 0; *p != '\0'; i++) {
+        if (i == SOUND_SIDS_MAX * 2) {
+            return -1;
+        }
+        gain = strtol(p, &end, 10);
+        if (end == p || gain > SID_MIX_GAIN_MAX) {
+            return -1;
+        }
+        if (gain >= 0) {
+            matrix[i] = (int)(gain * SID_MIX_UNITY / 100);
+        }
+        for (p = end; *p == ',' || *p == ' '; p++) {
+        }
+    }
+
+    sid_sound_machine_set_mix_matrix(matrix);
+    util_string_set(&sid_mix_matrix, val);
+    return 0;
+}
+
 static int set_sid_model(int val, void *param)
 {
     sid_model = val;
@@ -336,6 +396,12 @@ static int set_sid_resid_8580_filter_bias(int i, void *param)
     return 0;
 }
 
+static int set_sid_resid_table_cache(int val, void *param)
+{
+    sid_resid_table_cache = val ? 1 : 0;
+    return 0;
+}
+
 #endif
 
 #ifdef HAVE_HARDSID
@@ -393,6 +459,8 @@ static const resource_int_t resid_resources_int[] = {
       &sid_resid_8580_gain, set_sid_resid_8580_gain, NULL },
     { "SidResid8580FilterBias", -3000, RES_EVENT_NO, NULL,
       &sid_resid_8580_filter_bias, set_sid_resid_8580_filter_bias, NULL },
+    { "SidResidTableCache", 0, RES_EVENT_NO, NULL,
+      &sid_resid_table_cache, set_sid_resid_table_cache, NULL },
     RESOURCE_INT_LIST_END
 };
 #endif
@@ -405,6 +473,8 @@ static const resource_int_t common_resources_int[] = {
       &sid_filters_enabled, set_sid_filters_enabled, NULL },
     { "SidModel", SID_MODEL_DEFAULT, RES_EVENT_SAME, NULL,
       &sid_model, set_sid_model, NULL },
+    { "SidThreads", 0, RES_EVENT_NO, NULL,
+      &sid_threads, set_sid_threads, NULL },
     RESOURCE_INT_LIST_END
 };
 
@@ -424,6 +494,12 @@ static const resource_int_t stereo_resources_int[] = {
     RESOURCE_INT_LIST_END
 };
 
+static const resource_string_t stereo_resources_string[] = {
+    { "SidMixMatrix", "", RES_EVENT_NO, NULL,
+      &sid_mix_matrix, set_sid_mix_matrix, NULL },
+    RESOURCE_STRING_LIST_END
+};
+
 int sid_common_resources_init(void)
 {
 #ifdef HAVE_HARDSID
@@ -448,6 +524,10 @@ int sid_resources_init(void)
         return -1;
     }
 
+    if (resources_register_string(stereo_resources_string) < 0) {
+        return -1;
+    }
+
     return sid_common_resources_init();
 }
 
@@ -0,0 +1,190 @@
+/*
+ * sid-thread.c - Render several SIDs on worker threads.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* The SIDs of a multi SID setup share no state while a sound fragment is
+   rendered, so each one can be clocked on its own thread.  The thread that
+   renders sound clocks the first SID, one worker per additional SID the
+   rest, and `sid_thread_run()' only returns when all of them are done.  Every
+   SID is rendered exactly as in the serial case, so the output does not
+   change.  The workers are started on first use and stopped when sound is
+   closed.  */
+
+#include "vice.h"
+
+#include <stdio.h>
+
+#include "archdep_thread.h"
+#include "log.h"
+#include "sid-thread.h"
+#include "sound.h"
+#include "types.h"
+
+
+static int sid_threads_enabled = 0;
+
+/* Job state, protected by `job_lock'.  */
+static sid_thread_job_t job_func;
+static void *job_data;
+static unsigned int job_go;
+static unsigned int job_done;
+static int threads_quit;
+
+static archdep_thread_t *threads[SOUND_SIDS_MAX];
+static archdep_mutex_t *job_lock = NULL;
+static archdep_cond_t *job_cond = NULL;
+
+/* ------------------------------------------------------------------------- */
+
+static void sid_thread_main(void *data)
+{
+    int chipno = vice_ptr_to_int(data);
+    unsigned int bit = 1U << chipno;
+
+    archdep_mutex_lock(job_lock);
+
+    while (1) {
+        while (!(job_go & bit) && !threads_quit) {
+            archdep_cond_wait(job_cond, job_lock);
+        }
+        if (threads_quit) {
+            break;
+        }
+        job_go &= ~bit;
+        archdep_mutex_unlock(job_lock);
+
+        job_func(chipno, job_data);
+
+        archdep_mutex_lock(job_lock);
+        job_done |= bit;
+        archdep_cond_broadcast(job_cond);
+    }
+
+    archdep_mutex_unlock(job_lock);
+}
+
+static int sid_thread_start(void)
+{
+    int chipno;
+
+    job_lock = archdep_mutex_new();
+    job_cond = archdep_cond_new();
+    threads_quit = 0;
+    job_go = 0;
+
+    /* the main thread renders the first SID itself */
+    for (chipno = 1; chipno < SOUND_SIDS_MAX; chipno++) {
+        threads[chipno] = archdep_thread_create(sid_thread_main,
+                                                int_to_void_ptr(chipno));
+        if (threads[chipno] == NULL) {
+            log_error(LOG_DEFAULT, "SidThreads: cannot create SID thread.");
+            sid_thread_shutdown();
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void sid_thread_shutdown(void)
+{
+    int chipno;
+
+    if (job_lock == NULL) {
+        return;
+    }
+
+    archdep_mutex_lock(job_lock);
+    threads_quit = 1;
+    archdep_cond_broadcast(job_cond);
+    archdep_mutex_unlock(job_lock);
+
+    for (chipno = 1; chipno < SOUND_SIDS_MAX; chipno++) {
+        if (threads[chipno] != NULL) {
+            archdep_thread_join(threads[chipno]);
+            threads[chipno] = NULL;
+        }
+    }
+
+    archdep_cond_destroy(job_cond);
+    archdep_mutex_destroy(job_lock);
+    job_cond = NULL;
+    job_lock = NULL;
+}
+
+int sid_thread_set_enabled(int val)
+{
+    val = val ? 1 : 0;
+
+    if (val && !archdep_thread_available()) {
+        log_warning(LOG_DEFAULT, "SidThreads: threads are not supported on this system.");
+        return -1;
+    }
+
+    /* Idle workers are left alone: the sound thread may be inside
+       sid_thread_run() right now.  They are stopped when sound is closed.  */
+    sid_threads_enabled = val;
+
+    return 0;
+}
+
+int sid_thread_enabled(void)
+{
+    return sid_threads_enabled;
+}
+
+/* Call `job' for chips 0 to `count' - 1 in parallel and wait for all of
+   them.  Return 0 on success or -1 if the caller has to run the jobs
+   itself.  */
+int sid_thread_run(sid_thread_job_t job, int count, void *data)
+{
+    unsigned int mask;
+
+    if (!sid_threads_enabled || count < 2 || count > SOUND_SIDS_MAX) {
+        return -1;
+    }
+
+    if (job_lock == NULL && sid_thread_start() < 0) {
+        sid_threads_enabled = 0;
+        return -1;
+    }
+
+    mask = (1U << count) - 1;
+
+    archdep_mutex_lock(job_lock);
+    job_func = job;
+    job_data = data;
+    job_done = 0;
+    job_go = mask & ~1U;
+    archdep_cond_broadcast(job_cond);
+    archdep_mutex_unlock(job_lock);
+
+    job(0, data);
+
+    archdep_mutex_lock(job_lock);
+    job_done |= 1U;
+    while (job_done != mask) {
+        archdep_cond_wait(job_cond, job_lock);
+    }
+    archdep_mutex_unlock(job_lock);
+
+    return 0;
+}
@@ -0,0 +1,35 @@
+/*
+ * sid-thread.h - Render several SIDs on worker threads.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_SID_THREAD_H
+#define VICE_SID_THREAD_H
+
+typedef void (*sid_thread_job_t)(int chipno, void *data);
+
+extern int sid_thread_set_enabled(int val);
+extern int sid_thread_enabled(void);
+extern void sid_thread_shutdown(void);
+
+extern int sid_thread_run(sid_thread_job_t job, int count, void *data);
+
+#endif
@@ -42,8 +42,10 @@
 #include "maincpu.h"
 #include "parsid.h"
 #include "resources.h"
+#include "sid-mix.h"
 #include "sid-resources.h"
 #include "sid-snapshot.h"
+#include "sid-thread.h"
 #include "sid.h"
 #include "sound.h"
 #include "ssi2001.h"
@@ -349,59 +351,34 @@ sound_t *sid_sound_machine_open(int chipno)
 
 /* manage temporary buffers. if the requested size is smaller or equal to the
  * size of the already allocated buffer, reuse it.  */
-static int16_t *buf1 = NULL;
-static int16_t *buf2 = NULL;
-static int16_t *buf3 = NULL;
+#define SID_MIX_BUF_LEFT    SOUND_SIDS_MAX
+#define SID_MIX_BUF_RIGHT   (SOUND_SIDS_MAX + 1)
+#define SID_MIX_BUF_SCALE   (SOUND_SIDS_MAX + 2)
+#define SID_MIX_BUF_NUM     (SOUND_SIDS_MAX + 3)
 
-static int blen1 = 0;
-static int blen2 = 0;
-static int blen3 = 0;
+static int16_t *mixbuf[SID_MIX_BUF_NUM];
+static int mixblen[SID_MIX_BUF_NUM];
 
-
-static int16_t *getbuf1(int len)
-{
-    if (buf1 != NULL) {
-        if (blen1 >= len) {
-            /* large enough */
-            return buf1;
-        }
-        lib_free(buf1);
-    }
-    buf1 = lib_calloc(len, sizeof(int16_t));
-    blen1 = len;
-    return buf1;
-}
-
-
-static int16_t *getbuf2(int len)
-{
-    if (buf2 != NULL) {
-        if (blen2 >= len) {
-            /* large enough */
-            return buf2;
-        }
-        lib_free(buf2);
-    }
-    buf2 = lib_calloc(len, sizeof(int16_t));
-    blen2 = len;
-    return buf2;
-}
-
-
-static int16_t *getbuf3(int len)
+static int16_t *getbuf(int idx, int len)
 {
-    if (buf3 != NULL) {
-        if (blen3 >= len) {
+    if (mixbuf[idx] != NULL) {
+        if (mixblen[idx] >= len) {
             /* large enough */
-            return buf3;
+            return mixbuf[idx];
         }
-        lib_free(buf3);
+        lib_free(mixbuf[idx]);
     }
-    buf3 = lib_calloc(len, sizeof(int16_t));
-    blen3 = len;
-    return buf3;
+    mixbuf[idx] = lib_calloc(len, sizeof(int16_t));
+    mixblen[idx] = len;
+    return mixbuf[idx];
 }
 
+/* Panning matrix for multi SID mixing, gain of each SID on the left and
+   right channel with SID_MIX_UNITY being full volume.  A gain below 0 means
+   the default routing of `sid_mix_default_gain()' for that channel.  Only
+   used when set with `sid_sound_machine_set_mix_matrix()'.  */
+static int sid_mix_matrix[SOUND_SIDS_MAX][2];
+static int sid_mix_matrix_set = 0;
 
 int sid_sound_machine_init_vbr(sound_t *psid, int speed, int cycles_per_sec, int factor)
 {
@@ -415,22 +392,18 @@ int sid_sound_machine_init(sound_t *psid, int speed, int cycles_per_sec)
 
 void sid_sound_machine_close(sound_t *psid)
 {
+    int i;
+
     sid_engine.close(psid);
+    sid_thread_shutdown();
+
     /* free the temp. buffers */
-    if (buf1) {
-        lib_free(buf1);
-        blen1 = 0;
-        buf1 = NULL;
-    }
-    if (buf2) {
-        lib_free(buf2);
-        blen2 = 0;
-        buf2 = NULL;
-    }
-    if (buf3) {
-        lib_free(buf3);
-        blen3 = 0;
-        buf3 = NULL;
+    for (i = 0; i < SID_MIX_BUF_NUM; i++) {
+        if (mixbuf[i]) {
+            lib_free(mixbuf[i]);
+            mixblen[i] = 0;
+            mixbuf[i] = NULL;
+        }
     }
 }
 
@@ -449,96 +422,177 @@ void sid_sound_machine_reset(sound_t *psid, CLOCK cpu_clk)
     sid_engine.reset(psid, cpu_clk);
 }
 
-int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, int soc, int scc, int *delta_t)
+void sid_sound_machine_set_mix_matrix(const int *matrix)
 {
     int i;
-    int16_t *tmp_buf1;
-    int16_t *tmp_buf2;
-    int16_t *tmp_buf3;
-    int tmp_nr = 0;
-    int tmp_delta_t = *delta_t;
 
-    if (soc == 1 && scc == 1) {
-        return sid_engine.calculate_samples(psid[0], pbuf, nr, 1, delta_t);
+    /* the matrix is read while rendering */
+    sound_sync();
+
+    if (matrix == NULL) {
+        sid_mix_matrix_set = 0;
+        return;
     }
-    if (soc == 1 && scc == 2) {
-        tmp_buf1 = getbuf1(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[0], tmp_buf1, nr, 1, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf, nr, 1, delta_t);
-        for (i = 0; i < tmp_nr; i++) {
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf1[i]);
-        }
-        return tmp_nr;
-    }
-    if (soc == 1 && scc == 3) {
-        tmp_buf1 = getbuf1(2 * nr);
-        tmp_buf2 = getbuf2(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[0], tmp_buf1, nr, 1, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf2, nr, 1, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf, nr, 1, delta_t);
-        for (i = 0; i < tmp_nr; i++) {
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf1[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf2[i]);
+
+    for (i = 0; i < SOUND_SIDS_MAX; i++) {
+        sid_mix_matrix[i][0] = matrix[i * 2];
+        sid_mix_matrix[i][1] = matrix[(i * 2) + 1];
+    }
+    sid_mix_matrix_set = 1;
+}
+
+/* Default routing: in stereo the first SID goes left and the second right,
+   a third SID goes to both channels when there are three and left when
+   there are four, the fourth SID goes right.  */
+static int sid_mix_default_gain(int chipno, int channel, int scc)
+{
+    switch (chipno) {
+        case 0:
+            return (channel == 0) ? SID_MIX_UNITY : 0;
+        case 1:
+            return (channel == 1) ? SID_MIX_UNITY : 0;
+        case 2:
+            return (scc == 3 || channel == 0) ? SID_MIX_UNITY : 0;
+        default:
+            return (channel == 1) ? SID_MIX_UNITY : 0;
+    }
+}
+
+static int sid_mix_gain(int chipno, int channel, int soc, int scc)
+{
+    int left, right;
+
+    left = sid_mix_default_gain(chipno, 0, scc);
+    right = sid_mix_default_gain(chipno, 1, scc);
+    if (sid_mix_matrix_set) {
+        if (sid_mix_matrix[chipno][0] >= 0) {
+            left = sid_mix_matrix[chipno][0];
         }
-        return tmp_nr;
-    }
-    if (soc == 1 && scc == 4) {
-        tmp_buf1 = getbuf1(2 * nr);
-        tmp_buf2 = getbuf2(2 * nr);
-        tmp_buf3 = getbuf3(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[0], tmp_buf1, nr, 1, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf2, nr, 1, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf3, nr, 1, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf, nr, 1, delta_t);
-        for (i = 0; i < tmp_nr; i++) {
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf1[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf2[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf3[i]);
+        if (sid_mix_matrix[chipno][1] >= 0) {
+            right = sid_mix_matrix[chipno][1];
         }
-        return tmp_nr;
     }
-    if (soc == 2 && scc == 1) {
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, 2, delta_t);
-        for (i = 0; i < tmp_nr; i++) {
-            pbuf[(i * 2) + 1] = pbuf[i * 2];
+
+    if (soc == 1) {
+        /* all SIDs end up in the one channel, without a matrix at full volume */
+        if (!sid_mix_matrix_set) {
+            return SID_MIX_UNITY;
         }
-        return tmp_nr;
-    }
-    if (soc == 2 && scc == 2) {
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, 2, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, 2, delta_t);
-        return tmp_nr;
-    }
-    if (soc == 2 && scc == 3) {
-        tmp_buf1 = getbuf1(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf1, nr, 1, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, 2, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, 2, delta_t);
-        for (i = 0; i < tmp_nr; i++) {
-            pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf1[i]);
-            pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf1[i]);
+        return (left > right) ? left : right;
+    }
+    return (channel == 0) ? left : right;
+}
+
+typedef struct sid_render_job_s {
+    sound_t **psid;
+    int16_t **chipbuf;
+    int nr;
+    int start_delta_t;
+    int delta_t[SOUND_SIDS_MAX];
+    int result[SOUND_SIDS_MAX];
+} sid_render_job_t;
+
+static void sid_render_chip(int chipno, void *data)
+{
+    sid_render_job_t *job = (sid_render_job_t *)data;
+
+    job->delta_t[chipno] = job->start_delta_t;
+    job->result[chipno] = sid_engine.calculate_samples(job->psid[chipno],
+                                                       job->chipbuf[chipno],
+                                                       job->nr, 1,
+                                                       &job->delta_t[chipno]);
+}
+
+/* Only reSID instances are known to share nothing while rendering.  */
+static int sid_render_threaded(void)
+{
+#ifdef HAVE_RESID
+    return sidengine == SID_ENGINE_RESID && sid_thread_enabled();
+#else
+    return 0;
+#endif
+}
+
+/* Render every SID into its own buffer, then mix them per output channel.
+   The SIDs are mixed in chip order, which gives the same samples as the
+   old hand written cases for the default routing.  */
+static int sid_mix_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, int soc, int scc, int *delta_t)
+{
+    int16_t *chipbuf[SOUND_SIDS_MAX];
+    int16_t *chanbuf;
+    int gain[SOUND_SIDS_MAX];
+    int chipno, channel, i;
+    int tmp_nr;
+    sid_render_job_t job;
+
+    for (chipno = 0; chipno < scc; chipno++) {
+        chipbuf[chipno] = getbuf(chipno, nr);
+    }
+
+    job.psid = psid;
+    job.chipbuf = chipbuf;
+    job.nr = nr;
+    job.start_delta_t = *delta_t;
+
+    if (!sid_render_threaded() || sid_thread_run(sid_render_chip, scc, &job) < 0) {
+        for (chipno = 0; chipno < scc; chipno++) {
+            sid_render_chip(chipno, &job);
         }
     }
-    if (soc == 2 && scc == 4) {
-        tmp_buf1 = getbuf1(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf1, nr, 2, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf1 + 1, nr, 2, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, 2, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, 2, delta_t);
-        for (i = 0; i < tmp_nr; i++) {
-            pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf1[i * 2]);
-            pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf1[(i * 2) + 1]);
+    tmp_nr = job.result[scc - 1];
+    *delta_t = job.delta_t[scc - 1];
+
+    for (channel = 0; channel < soc; channel++) {
+        /* mono output is mixed in place */
+        if (soc == 1) {
+            chanbuf = pbuf;
+        } else {
+            chanbuf = getbuf(SID_MIX_BUF_LEFT + channel, nr);
+        }
+
+        for (chipno = 0; chipno < scc; chipno++) {
+            gain[chipno] = sid_mix_gain(chipno, channel, soc, scc);
+        }
+        sid_mix_channel(chanbuf, chipbuf, gain, scc, tmp_nr,
+                        getbuf(SID_MIX_BUF_SCALE, nr));
+
+        if (soc != 1) {
+            for (i = 0; i < tmp_nr; i++) {
+                pbuf[(i * soc) + channel] = chanbuf[i];
+            }
         }
     }
     return tmp_nr;
 }
 
+int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, int soc, int scc, int *delta_t)
+{
+    int i;
+    int tmp_nr = 0;
+    int tmp_delta_t = *delta_t;
+
+    /* the threaded renderer needs a buffer per SID */
+    if (!sid_mix_matrix_set && (scc == 1 || !sid_render_threaded())) {
+        /* render straight into the output buffer where no mixing is needed */
+        if (soc == 1 && scc == 1) {
+            return sid_engine.calculate_samples(psid[0], pbuf, nr, 1, delta_t);
+        }
+        if (soc == 2 && scc == 1) {
+            tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, 2, delta_t);
+            for (i = 0; i < tmp_nr; i++) {
+                pbuf[(i * 2) + 1] = pbuf[i * 2];
+            }
+            return tmp_nr;
+        }
+        if (soc == 2 && scc == 2) {
+            tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, 2, &tmp_delta_t);
+            tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, 2, delta_t);
+            return tmp_nr;
+        }
+    }
+    return sid_mix_calculate_samples(psid, pbuf, nr, soc, scc, delta_t);
+}
+
 void sid_sound_machine_prevent_clk_overflow(sound_t *psid, CLOCK sub)
 {
     sid_engine.prevent_clk_overflow(psid, sub);
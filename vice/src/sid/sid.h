@@ -129,6 +129,11 @@ extern uint8_t sid_sound_machine_read(sound_t *psid, uint16_t addr);
 extern void sid_sound_machine_store(sound_t *psid, uint16_t addr, uint8_t byte);
 extern void sid_sound_machine_reset(sound_t *psid, CLOCK cpu_clk);
 extern int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, int sound_output_channels, int sound_chip_channels, int *delta_t);
+
+/* Set the panning matrix used when mixing several SIDs: SOUND_SIDS_MAX
+   pairs of left/right gains, SID_MIX_UNITY being full volume and a gain
+   below 0 the default routing.  NULL restores the default routing.  */
+extern void sid_sound_machine_set_mix_matrix(const int *matrix);
 extern void sid_sound_machine_prevent_clk_overflow(sound_t *psid, CLOCK sub);
 extern char *sid_sound_machine_dump_state(sound_t *psid);
 extern int sid_sound_machine_cycle_based(void);
@@ -50,6 +50,7 @@ static char *current_module = NULL;
 static char read_name[SNAPSHOT_MACHINE_NAME_LEN];
 static char *current_machine_name = NULL;
 static char *current_filename = NULL;
+static char snapshot_memory_name[] = "<memory>";
 
 char snapshot_magic_string[] = "VICE Snapshot File\032";
 char snapshot_version_magic_string[] = "VICE Version\032";
@@ -57,10 +58,25 @@ char snapshot_version_magic_string[] = "VICE Version\032";
 #define SNAPSHOT_MAGIC_LEN              19
 #define SNAPSHOT_VERSION_MAGIC_LEN      13
 
-struct snapshot_module_s {
-    /* File descriptor.  */
+/* Backing store of a snapshot: either a stdio file or a growable memory
+   arena.  */
+struct snapshot_stream_s {
+    /* File descriptor, NULL for memory streams.  */
     FILE *file;
 
+    /* Memory arena: allocated size, amount of valid data and current
+       position.  The arena is kept across snapshots, so repeatedly saving
+       into the same stream does not reallocate.  */
+    uint8_t *data;
+    size_t alloc;
+    size_t size;
+    size_t pos;
+};
+
+struct snapshot_module_s {
+    /* Backing stream.  */
+    snapshot_stream_t *file;
+
     /* Flag: are we writing it?  */
     int write_mode;
 
@@ -75,8 +91,8 @@ struct snapshot_module_s {
 };
 
 struct snapshot_s {
-    /* File descriptor.  */
-    FILE *file;
+    /* Backing stream.  */
+    snapshot_stream_t *file;
 
     /* Offset of the first module.  */
     long first_module_offset;
@@ -87,9 +103,140 @@ struct snapshot_s {
 
 /* ------------------------------------------------------------------------- */
 
-static int snapshot_write_byte(FILE *f, uint8_t data)
+#define SNAPSHOT_STREAM_MIN_ALLOC 0x10000
+
+snapshot_stream_t *snapshot_memory_stream_new(void)
+{
+    return lib_calloc(1, sizeof(snapshot_stream_t));
+}
+
+void snapshot_memory_stream_free(snapshot_stream_t *stream)
+{
+    if (stream != NULL) {
+        lib_free(stream->data);
+        lib_free(stream);
+    }
+}
+
+const uint8_t *snapshot_memory_stream_data(snapshot_stream_t *stream)
+{
+    return stream->data;
+}
+
+size_t snapshot_memory_stream_size(snapshot_stream_t *stream)
+{
+    return stream->size;
+}
+
+static void snapshot_stream_reserve(snapshot_stream_t *f, size_t needed)
+{
+    size_t new_alloc;
+
+    if (needed <= f->alloc) {
+        return;
+    }
+
+    new_alloc = f->alloc ? f->alloc : SNAPSHOT_STREAM_MIN_ALLOC;
+    while (new_alloc < needed) {
+        new_alloc *= 2;
+    }
+    f->data = lib_realloc(f->data, new_alloc);
+    f->alloc = new_alloc;
+}
+
+void snapshot_memory_stream_set_data(snapshot_stream_t *stream, const uint8_t *data, size_t size)
+{
+    snapshot_stream_reserve(stream, size);
+    if (size > 0) {
+        memcpy(stream->data, data, size);
+    }
+    stream->size = size;
+    stream->pos = 0;
+}
+
+static snapshot_stream_t *snapshot_stream_file_new(FILE *f)
+{
+    snapshot_stream_t *stream = lib_calloc(1, sizeof(snapshot_stream_t));
+
+    stream->file = f;
+    return stream;
+}
+
+static int snapshot_stream_write(snapshot_stream_t *f, const void *data, size_t num)
+{
+    size_t end;
+
+    if (f->file != NULL) {
+        return fwrite(data, num, 1, f->file) < 1 ? -1 : 0;
+    }
+
+    end = f->pos + num;
+    snapshot_stream_reserve(f, end);
+    if (f->pos > f->size) {
+        memset(f->data + f->size, 0, f->pos - f->size);
+    }
+    memcpy(f->data + f->pos, data, num);
+    f->pos = end;
+    if (end > f->size) {
+        f->size = end;
+    }
+    return 0;
+}
+
+static int snapshot_stream_read(snapshot_stream_t *f, void *data, size_t num)
+{
+    if (f->file != NULL) {
+        return fread(data, num, 1, f->file) < 1 ? -1 : 0;
+    }
+
+    if (f->pos > f->size || num > f->size - f->pos) {
+        return -1;
+    }
+    memcpy(data, f->data + f->pos, num);
+    f->pos += num;
+    return 0;
+}
+
+static long snapshot_stream_tell(snapshot_stream_t *f)
 {
-    if (fputc(data, f) == EOF) {
+    if (f->file != NULL) {
+        return ftell(f->file);
+    }
+    return (long)f->pos;
+}
+
+static int snapshot_stream_seek(snapshot_stream_t *f, long offset)
+{
+    if (f->file != NULL) {
+        return fseek(f->file, offset, SEEK_SET);
+    }
+    if (offset < 0) {
+        return -1;
+    }
+    f->pos = (size_t)offset;
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int snapshot_write_byte(snapshot_stream_t *f, uint8_t data)
+{
+    if (f->file != NULL) {
+        if (fputc(data, f->file) == EOF) {
+            snapshot_error = SNAPSHOT_WRITE_EOF_ERROR;
+            return -1;
+        }
+        return 0;
+    }
+
+    if (f->pos < f->alloc && f->pos == f->size) {
+        /* Fast path for appending to a memory stream.  */
+        f->data[f->pos++] = data;
+        f->size++;
+        return 0;
+    }
+
+    if (snapshot_stream_write(f, &data, 1) < 0) {
         snapshot_error = SNAPSHOT_WRITE_EOF_ERROR;
         return -1;
     }
@@ -97,7 +244,7 @@ static int snapshot_write_byte(FILE *f, uint8_t data)
     return 0;
 }
 
-static int snapshot_write_word(FILE *f, uint16_t data)
+static int snapshot_write_word(snapshot_stream_t *f, uint16_t data)
 {
     if (snapshot_write_byte(f, (uint8_t)(data & 0xff)) < 0
         || snapshot_write_byte(f, (uint8_t)(data >> 8)) < 0) {
@@ -107,7 +254,7 @@ static int snapshot_write_word(FILE *f, uint16_t data)
     return 0;
 }
 
-static int snapshot_write_dword(FILE *f, uint32_t data)
+static int snapshot_write_dword(snapshot_stream_t *f, uint32_t data)
 {
     if (snapshot_write_word(f, (uint16_t)(data & 0xffff)) < 0
         || snapshot_write_word(f, (uint16_t)(data >> 16)) < 0) {
@@ -117,20 +264,16 @@ static int snapshot_write_dword(FILE *f, uint32_t data)
     return 0;
 }
 
-static int snapshot_write_double(FILE *f, double data)
+static int snapshot_write_double(snapshot_stream_t *f, double data)
 {
-    uint8_t *byte_data = (uint8_t *)&data;
-    int i;
-
-    for (i = 0; i < sizeof(double); i++) {
-        if (snapshot_write_byte(f, byte_data[i]) < 0) {
-            return -1;
-        }
+    if (snapshot_stream_write(f, &data, sizeof(double)) < 0) {
+        snapshot_error = SNAPSHOT_WRITE_EOF_ERROR;
+        return -1;
     }
     return 0;
 }
 
-static int snapshot_write_padded_string(FILE *f, const char *s, uint8_t pad_char,
+static int snapshot_write_padded_string(snapshot_stream_t *f, const char *s, uint8_t pad_char,
                                         int len)
 {
     int i, found_zero;
@@ -149,9 +292,9 @@ static int snapshot_write_padded_string(FILE *f, const char *s, uint8_t pad_char
     return 0;
 }
 
-static int snapshot_write_byte_array(FILE *f, const uint8_t *data, unsigned int num)
+static int snapshot_write_byte_array(snapshot_stream_t *f, const uint8_t *data, unsigned int num)
 {
-    if (num > 0 && fwrite(data, (size_t)num, 1, f) < 1) {
+    if (num > 0 && snapshot_stream_write(f, data, (size_t)num) < 0) {
         snapshot_error = SNAPSHOT_WRITE_BYTE_ARRAY_ERROR;
         return -1;
     }
@@ -159,8 +302,9 @@ static int snapshot_write_byte_array(FILE *f, const uint8_t *data, unsigned int
     return 0;
 }
 
-static int snapshot_write_word_array(FILE *f, const uint16_t *data, unsigned int num)
+static int snapshot_write_word_array(snapshot_stream_t *f, const uint16_t *data, unsigned int num)
 {
+#ifdef WORDS_BIGENDIAN
     unsigned int i;
 
     for (i = 0; i < num; i++) {
@@ -170,10 +314,15 @@ static int snapshot_write_word_array(FILE *f, const uint16_t *data, unsigned int
     }
 
     return 0;
+#else
+    /* The in-memory layout already matches the little endian file format.  */
+    return snapshot_write_byte_array(f, (const uint8_t *)data, num * sizeof(uint16_t));
+#endif
 }
 
-static int snapshot_write_dword_array(FILE *f, const uint32_t *data, unsigned int num)
+static int snapshot_write_dword_array(snapshot_stream_t *f, const uint32_t *data, unsigned int num)
 {
+#ifdef WORDS_BIGENDIAN
     unsigned int i;
 
     for (i = 0; i < num; i++) {
@@ -183,12 +332,15 @@ static int snapshot_write_dword_array(FILE *f, const uint32_t *data, unsigned in
     }
 
     return 0;
+#else
+    return snapshot_write_byte_array(f, (const uint8_t *)data, num * sizeof(uint32_t));
+#endif
 }
 
 
-static int snapshot_write_string(FILE *f, const char *s)
+static int snapshot_write_string(snapshot_stream_t *f, const char *s)
 {
-    size_t len, i;
+    size_t len;
 
     len = s ? (strlen(s) + 1) : 0;      /* length includes nullbyte */
 
@@ -196,20 +348,26 @@ static int snapshot_write_string(FILE *f, const char *s)
         return -1;
     }
 
-    for (i = 0; i < len; i++) {
-        if (snapshot_write_byte(f, s[i]) < 0) {
-            return -1;
-        }
+    if (len > 0 && snapshot_stream_write(f, s, len) < 0) {
+        snapshot_error = SNAPSHOT_WRITE_EOF_ERROR;
+        return -1;
     }
 
     return (int)(len + sizeof(uint16_t));
 }
 
-static int snapshot_read_byte(FILE *f, uint8_t *b_return)
+static int snapshot_read_byte(snapshot_stream_t *f, uint8_t *b_return)
 {
     int c;
 
-    c = fgetc(f);
+    if (f->file != NULL) {
+        c = fgetc(f->file);
+    } else if (f->pos < f->size) {
+        c = f->data[f->pos++];
+    } else {
+        c = EOF;
+    }
+
     if (c == EOF) {
         snapshot_error = SNAPSHOT_READ_EOF_ERROR;
         return -1;
@@ -218,7 +376,7 @@ static int snapshot_read_byte(FILE *f, uint8_t *b_return)
     return 0;
 }
 
-static int snapshot_read_word(FILE *f, uint16_t *w_return)
+static int snapshot_read_word(snapshot_stream_t *f, uint16_t *w_return)
 {
     uint8_t lo, hi;
 
@@ -230,7 +388,7 @@ static int snapshot_read_word(FILE *f, uint16_t *w_return)
     return 0;
 }
 
-static int snapshot_read_dword(FILE *f, uint32_t *dw_return)
+static int snapshot_read_dword(snapshot_stream_t *f, uint32_t *dw_return)
 {
     uint16_t lo, hi;
 
@@ -242,28 +400,21 @@ static int snapshot_read_dword(FILE *f, uint32_t *dw_return)
     return 0;
 }
 
-static int snapshot_read_double(FILE *f, double *d_return)
+static int snapshot_read_double(snapshot_stream_t *f, double *d_return)
 {
-    int i;
-    int c;
     double val;
-    uint8_t *byte_val = (uint8_t *)&val;
 
-    for (i = 0; i < sizeof(double); i++) {
-        c = fgetc(f);
-        if (c == EOF) {
-            snapshot_error = SNAPSHOT_READ_EOF_ERROR;
-            return -1;
-        }
-        byte_val[i] = (uint8_t)c;
+    if (snapshot_stream_read(f, &val, sizeof(double)) < 0) {
+        snapshot_error = SNAPSHOT_READ_EOF_ERROR;
+        return -1;
     }
     *d_return = val;
     return 0;
 }
 
-static int snapshot_read_byte_array(FILE *f, uint8_t *b_return, unsigned int num)
+static int snapshot_read_byte_array(snapshot_stream_t *f, uint8_t *b_return, unsigned int num)
 {
-    if (num > 0 && fread(b_return, (size_t)num, 1, f) < 1) {
+    if (num > 0 && snapshot_stream_read(f, b_return, (size_t)num) < 0) {
         snapshot_error = SNAPSHOT_READ_BYTE_ARRAY_ERROR;
         return -1;
     }
@@ -271,8 +422,9 @@ static int snapshot_read_byte_array(FILE *f, uint8_t *b_return, unsigned int num
     return 0;
 }
 
-static int snapshot_read_word_array(FILE *f, uint16_t *w_return, unsigned int num)
+static int snapshot_read_word_array(snapshot_stream_t *f, uint16_t *w_return, unsigned int num)
 {
+#ifdef WORDS_BIGENDIAN
     unsigned int i;
 
     for (i = 0; i < num; i++) {
@@ -282,10 +434,14 @@ static int snapshot_read_word_array(FILE *f, uint16_t *w_return, unsigned int nu
     }
 
     return 0;
+#else
+    return snapshot_read_byte_array(f, (uint8_t *)w_return, num * sizeof(uint16_t));
+#endif
 }
 
-static int snapshot_read_dword_array(FILE *f, uint32_t *dw_return, unsigned int num)
+static int snapshot_read_dword_array(snapshot_stream_t *f, uint32_t *dw_return, unsigned int num)
 {
+#ifdef WORDS_BIGENDIAN
     unsigned int i;
 
     for (i = 0; i < num; i++) {
@@ -295,11 +451,14 @@ static int snapshot_read_dword_array(FILE *f, uint32_t *dw_return, unsigned int
     }
 
     return 0;
+#else
+    return snapshot_read_byte_array(f, (uint8_t *)dw_return, num * sizeof(uint32_t));
+#endif
 }
 
-static int snapshot_read_string(FILE *f, char **s)
+static int snapshot_read_string(snapshot_stream_t *f, char **s)
 {
-    int i, len;
+    int len;
     uint16_t w;
     char *p = NULL;
 
@@ -317,11 +476,10 @@ static int snapshot_read_string(FILE *f, char **s)
         p = lib_malloc(len);
         *s = p;
 
-        for (i = 0; i < len; i++) {
-            if (snapshot_read_byte(f, (uint8_t *)(p + i)) < 0) {
-                p[0] = 0;
-                return -1;
-            }
+        if (snapshot_stream_read(f, p, (size_t)len) < 0) {
+            snapshot_error = SNAPSHOT_READ_EOF_ERROR;
+            p[0] = 0;
+            return -1;
         }
         p[len - 1] = 0;   /* just to be save */
     }
@@ -427,7 +585,7 @@ int snapshot_module_write_string(snapshot_module_t *m, const char *s)
 
 int snapshot_module_read_byte(snapshot_module_t *m, uint8_t *b_return)
 {
-    if (ftell(m->file) + sizeof(uint8_t) > m->offset + m->size) {
+    if (snapshot_stream_tell(m->file) + sizeof(uint8_t) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
@@ -437,7 +595,7 @@ int snapshot_module_read_byte(snapshot_module_t *m, uint8_t *b_return)
 
 int snapshot_module_read_word(snapshot_module_t *m, uint16_t *w_return)
 {
-    if (ftell(m->file) + sizeof(uint16_t) > m->offset + m->size) {
+    if (snapshot_stream_tell(m->file) + sizeof(uint16_t) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
@@ -447,7 +605,7 @@ int snapshot_module_read_word(snapshot_module_t *m, uint16_t *w_return)
 
 int snapshot_module_read_dword(snapshot_module_t *m, uint32_t *dw_return)
 {
-    if (ftell(m->file) + sizeof(uint32_t) > m->offset + m->size) {
+    if (snapshot_stream_tell(m->file) + sizeof(uint32_t) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
@@ -457,7 +615,7 @@ int snapshot_module_read_dword(snapshot_module_t *m, uint32_t *dw_return)
 
 int snapshot_module_read_double(snapshot_module_t *m, double *db_return)
 {
-    if (ftell(m->file) + sizeof(double) > m->offset + m->size) {
+    if (snapshot_stream_tell(m->file) + sizeof(double) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
@@ -467,7 +625,7 @@ int snapshot_module_read_double(snapshot_module_t *m, double *db_return)
 
 int snapshot_module_read_byte_array(snapshot_module_t *m, uint8_t *b_return, unsigned int num)
 {
-    if ((long)(ftell(m->file) + num) > (long)(m->offset + m->size)) {
+    if ((long)(snapshot_stream_tell(m->file) + num) > (long)(m->offset + m->size)) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
@@ -477,7 +635,7 @@ int snapshot_module_read_byte_array(snapshot_module_t *m, uint8_t *b_return, uns
 
 int snapshot_module_read_word_array(snapshot_module_t *m, uint16_t *w_return, unsigned int num)
 {
-    if ((long)(ftell(m->file) + num * sizeof(uint16_t)) > (long)(m->offset + m->size)) {
+    if ((long)(snapshot_stream_tell(m->file) + num * sizeof(uint16_t)) > (long)(m->offset + m->size)) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
@@ -487,7 +645,7 @@ int snapshot_module_read_word_array(snapshot_module_t *m, uint16_t *w_return, un
 
 int snapshot_module_read_dword_array(snapshot_module_t *m, uint32_t *dw_return, unsigned int num)
 {
-    if ((long)(ftell(m->file) + num * sizeof(uint32_t)) > (long)(m->offset + m->size)) {
+    if ((long)(snapshot_stream_tell(m->file) + num * sizeof(uint32_t)) > (long)(m->offset + m->size)) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
@@ -497,7 +655,7 @@ int snapshot_module_read_dword_array(snapshot_module_t *m, uint32_t *dw_return,
 
 int snapshot_module_read_string(snapshot_module_t *m, char **charp_return)
 {
-    if (ftell(m->file) + sizeof(uint16_t) > m->offset + m->size) {
+    if (snapshot_stream_tell(m->file) + sizeof(uint16_t) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
@@ -570,7 +728,7 @@ snapshot_module_t *snapshot_module_create(snapshot_t *s, const char *name, uint8
 
     m = lib_malloc(sizeof(snapshot_module_t));
     m->file = s->file;
-    m->offset = ftell(s->file);
+    m->offset = snapshot_stream_tell(s->file);
     if (m->offset == -1) {
         snapshot_error = SNAPSHOT_ILLEGAL_OFFSET_ERROR;
         lib_free(m);
@@ -585,8 +743,8 @@ snapshot_module_t *snapshot_module_create(snapshot_t *s, const char *name, uint8
         return NULL;
     }
 
-    m->size = ftell(s->file) - m->offset;
-    m->size_offset = ftell(s->file) - sizeof(uint32_t);
+    m->size = snapshot_stream_tell(s->file) - m->offset;
+    m->size_offset = snapshot_stream_tell(s->file) - sizeof(uint32_t);
 
     return m;
 }
@@ -599,7 +757,7 @@ snapshot_module_t *snapshot_module_open(snapshot_t *s, const char *name, uint8_t
 
     current_module = (char *)name;
 
-    if (fseek(s->file, s->first_module_offset, SEEK_SET) < 0) {
+    if (snapshot_stream_seek(s->file, s->first_module_offset) < 0) {
         snapshot_error = SNAPSHOT_FIRST_MODULE_NOT_FOUND_ERROR;
         return NULL;
     }
@@ -629,18 +787,18 @@ snapshot_module_t *snapshot_module_open(snapshot_t *s, const char *name, uint8_t
         }
 
         m->offset += m->size;
-        if (fseek(s->file, m->offset, SEEK_SET) < 0) {
+        if (snapshot_stream_seek(s->file, m->offset) < 0) {
             snapshot_error = SNAPSHOT_MODULE_NOT_FOUND_ERROR;
             goto fail;
         }
     }
 
-    m->size_offset = ftell(s->file) - sizeof(uint32_t);
+    m->size_offset = snapshot_stream_tell(s->file) - sizeof(uint32_t);
 
     return m;
 
 fail:
-    fseek(s->file, s->first_module_offset, SEEK_SET);
+    snapshot_stream_seek(s->file, s->first_module_offset);
     lib_free(m);
     return NULL;
 }
@@ -649,14 +807,14 @@ int snapshot_module_close(snapshot_module_t *m)
 {
     /* Backpatch module size if writing.  */
     if (m->write_mode
-        && (fseek(m->file, m->size_offset, SEEK_SET) < 0
+        && (snapshot_stream_seek(m->file, m->size_offset) < 0
             || snapshot_write_dword(m->file, m->size) < 0)) {
         snapshot_error = SNAPSHOT_MODULE_CLOSE_ERROR;
         return -1;
     }
 
     /* Skip module.  */
-    if (fseek(m->file, m->offset + m->size, SEEK_SET) < 0) {
+    if (snapshot_stream_seek(m->file, m->offset + m->size) < 0) {
         snapshot_error = SNAPSHOT_MODULE_SKIP_ERROR;
         return -1;
     }
@@ -667,43 +825,33 @@ int snapshot_module_close(snapshot_module_t *m)
 
 /* ------------------------------------------------------------------------- */
 
-snapshot_t *snapshot_create(const char *filename, uint8_t major_version, uint8_t minor_version, const char *snapshot_machine_name)
+static int snapshot_write_header(snapshot_stream_t *f, uint8_t major_version, uint8_t minor_version, const char *snapshot_machine_name)
 {
-    FILE *f;
-    snapshot_t *s;
     unsigned char viceversion[4] = { VERSION_RC_NUMBER };
 
-    current_filename = (char *)filename;
-
-    f = fopen(filename, MODE_WRITE);
-    if (f == NULL) {
-        snapshot_error = SNAPSHOT_CANNOT_CREATE_SNAPSHOT_ERROR;
-        return NULL;
-    }
-
     /* Magic string.  */
     if (snapshot_write_padded_string(f, snapshot_magic_string, (uint8_t)0, SNAPSHOT_MAGIC_LEN) < 0) {
         snapshot_error = SNAPSHOT_CANNOT_WRITE_MAGIC_STRING_ERROR;
-        goto fail;
+        return -1;
     }
 
     /* Version number.  */
     if (snapshot_write_byte(f, major_version) < 0
         || snapshot_write_byte(f, minor_version) < 0) {
         snapshot_error = SNAPSHOT_CANNOT_WRITE_VERSION_ERROR;
-        goto fail;
+        return -1;
     }
 
     /* Machine.  */
     if (snapshot_write_padded_string(f, snapshot_machine_name, (uint8_t)0, SNAPSHOT_MACHINE_NAME_LEN) < 0) {
         snapshot_error = SNAPSHOT_CANNOT_WRITE_MACHINE_NAME_ERROR;
-        goto fail;
+        return -1;
     }
 
     /* VICE version and revision */
     if (snapshot_write_padded_string(f, snapshot_version_magic_string, (uint8_t)0, SNAPSHOT_VERSION_MAGIC_LEN) < 0) {
         snapshot_error = SNAPSHOT_CANNOT_WRITE_MAGIC_STRING_ERROR;
-        goto fail;
+        return -1;
     }
 
     if (snapshot_write_byte(f, viceversion[0]) < 0
@@ -716,62 +864,92 @@ snapshot_t *snapshot_create(const char *filename, uint8_t major_version, uint8_t
         || snapshot_write_dword(f, 0) < 0) {
 #endif
         snapshot_error = SNAPSHOT_CANNOT_WRITE_VERSION_ERROR;
-        goto fail;
+        return -1;
     }
 
+    return 0;
+}
+
+static snapshot_t *snapshot_new(snapshot_stream_t *f, int write_mode)
+{
+    snapshot_t *s;
+
     s = lib_malloc(sizeof(snapshot_t));
     s->file = f;
-    s->first_module_offset = ftell(f);
-    s->write_mode = 1;
+    s->first_module_offset = snapshot_stream_tell(f);
+    s->write_mode = write_mode;
 
     return s;
-
-fail:
-    fclose(f);
-    ioutil_remove(filename);
-    return NULL;
 }
 
-/* informal only, used by the error message created below */
-static unsigned char snapshot_viceversion[4];
-static uint32_t snapshot_vicerevision;
-
-snapshot_t *snapshot_open(const char *filename, uint8_t *major_version_return, uint8_t *minor_version_return, const char *snapshot_machine_name)
+snapshot_t *snapshot_create(const char *filename, uint8_t major_version, uint8_t minor_version, const char *snapshot_machine_name)
 {
     FILE *f;
-    char magic[SNAPSHOT_MAGIC_LEN];
-    snapshot_t *s = NULL;
-    int machine_name_len;
-    size_t offs;
+    snapshot_stream_t *stream;
 
-    current_machine_name = (char *)snapshot_machine_name;
     current_filename = (char *)filename;
-    current_module = NULL;
 
-    f = zfile_fopen(filename, MODE_READ);
+    f = fopen(filename, MODE_WRITE);
     if (f == NULL) {
-        snapshot_error = SNAPSHOT_CANNOT_OPEN_FOR_READ_ERROR;
+        snapshot_error = SNAPSHOT_CANNOT_CREATE_SNAPSHOT_ERROR;
+        return NULL;
+    }
+
+    stream = snapshot_stream_file_new(f);
+
+    if (snapshot_write_header(stream, major_version, minor_version, snapshot_machine_name) < 0) {
+        fclose(f);
+        lib_free(stream);
+        ioutil_remove(filename);
+        return NULL;
+    }
+
+    return snapshot_new(stream, 1);
+}
+
+snapshot_t *snapshot_create_stream(snapshot_stream_t *stream, uint8_t major_version, uint8_t minor_version, const char *snapshot_machine_name)
+{
+    current_filename = snapshot_memory_name;
+
+    /* Start over, but keep the arena allocated.  */
+    stream->size = 0;
+    stream->pos = 0;
+
+    if (snapshot_write_header(stream, major_version, minor_version, snapshot_machine_name) < 0) {
         return NULL;
     }
 
+    return snapshot_new(stream, 1);
+}
+
+/* informal only, used by the error message created below */
+static unsigned char snapshot_viceversion[4];
+static uint32_t snapshot_vicerevision;
+
+static int snapshot_read_header(snapshot_stream_t *f, uint8_t *major_version_return, uint8_t *minor_version_return, const char *snapshot_machine_name)
+{
+    char magic[SNAPSHOT_MAGIC_LEN];
+    int machine_name_len;
+    long offs;
+
     /* Magic string.  */
     if (snapshot_read_byte_array(f, (uint8_t *)magic, SNAPSHOT_MAGIC_LEN) < 0
         || memcmp(magic, snapshot_magic_string, SNAPSHOT_MAGIC_LEN) != 0) {
         snapshot_error = SNAPSHOT_MAGIC_STRING_MISMATCH_ERROR;
-        goto fail;
+        return -1;
     }
 
     /* Version number.  */
     if (snapshot_read_byte(f, major_version_return) < 0
         || snapshot_read_byte(f, minor_version_return) < 0) {
         snapshot_error = SNAPSHOT_CANNOT_READ_VERSION_ERROR;
-        goto fail;
+        return -1;
     }
 
     /* Machine.  */
     if (snapshot_read_byte_array(f, (uint8_t *)read_name, SNAPSHOT_MACHINE_NAME_LEN) < 0) {
         snapshot_error = SNAPSHOT_CANNOT_READ_MACHINE_NAME_ERROR;
-        goto fail;
+        return -1;
     }
 
     /* Check machine name.  */
@@ -780,18 +958,18 @@ snapshot_t *snapshot_open(const char *filename, uint8_t *major_version_return, u
         || (machine_name_len != SNAPSHOT_MODULE_NAME_LEN
             && read_name[machine_name_len] != 0)) {
         snapshot_error = SNAPSHOT_MACHINE_MISMATCH_ERROR;
-        goto fail;
+        return -1;
     }
 
     /* VICE version and revision */
     memset(snapshot_viceversion, 0, 4);
     snapshot_vicerevision = 0;
-    offs = ftell(f);
+    offs = snapshot_stream_tell(f);
 
     if (snapshot_read_byte_array(f, (uint8_t *)magic, SNAPSHOT_VERSION_MAGIC_LEN) < 0
         || memcmp(magic, snapshot_version_magic_string, SNAPSHOT_VERSION_MAGIC_LEN) != 0) {
         /* old snapshots do not contain VICE version */
-        fseek(f, offs, SEEK_SET);
+        snapshot_stream_seek(f, offs);
         log_warning(LOG_DEFAULT, "attempting to load pre 2.4.30 snapshot");
     } else {
         /* actually read the version */
@@ -801,41 +979,74 @@ snapshot_t *snapshot_open(const char *filename, uint8_t *major_version_return, u
             || snapshot_read_byte(f, &snapshot_viceversion[3]) < 0
             || snapshot_read_dword(f, &snapshot_vicerevision) < 0) {
             snapshot_error = SNAPSHOT_CANNOT_READ_VERSION_ERROR;
-            goto fail;
+            return -1;
         }
     }
 
-    s = lib_malloc(sizeof(snapshot_t));
-    s->file = f;
-    s->first_module_offset = ftell(f);
-    s->write_mode = 0;
+    return 0;
+}
+
+snapshot_t *snapshot_open(const char *filename, uint8_t *major_version_return, uint8_t *minor_version_return, const char *snapshot_machine_name)
+{
+    FILE *f;
+    snapshot_stream_t *stream;
+
+    current_machine_name = (char *)snapshot_machine_name;
+    current_filename = (char *)filename;
+    current_module = NULL;
+
+    f = zfile_fopen(filename, MODE_READ);
+    if (f == NULL) {
+        snapshot_error = SNAPSHOT_CANNOT_OPEN_FOR_READ_ERROR;
+        return NULL;
+    }
+
+    stream = snapshot_stream_file_new(f);
+
+    if (snapshot_read_header(stream, major_version_return, minor_version_return, snapshot_machine_name) < 0) {
+        zfile_fclose(f);
+        lib_free(stream);
+        return NULL;
+    }
 
     vsync_suspend_speed_eval();
-    return s;
+    return snapshot_new(stream, 0);
+}
 
-fail:
-    fclose(f);
-    return NULL;
+snapshot_t *snapshot_open_stream(snapshot_stream_t *stream, uint8_t *major_version_return, uint8_t *minor_version_return, const char *snapshot_machine_name)
+{
+    current_machine_name = (char *)snapshot_machine_name;
+    current_filename = snapshot_memory_name;
+    current_module = NULL;
+
+    stream->pos = 0;
+
+    if (snapshot_read_header(stream, major_version_return, minor_version_return, snapshot_machine_name) < 0) {
+        return NULL;
+    }
+
+    vsync_suspend_speed_eval();
+    return snapshot_new(stream, 0);
 }
 
 int snapshot_close(snapshot_t *s)
 {
-    int retval;
+    int retval = 0;
 
-    if (!s->write_mode) {
-        if (zfile_fclose(s->file) == EOF) {
+    if (s->file->file == NULL) {
+        /* Memory streams belong to the caller.  */
+    } else if (!s->write_mode) {
+        if (zfile_fclose(s->file->file) == EOF) {
             snapshot_error = SNAPSHOT_READ_CLOSE_EOF_ERROR;
             retval = -1;
-        } else {
-            retval = 0;
         }
+        lib_free(s->file);
     } else {
-        if (fclose(s->file) == EOF) {
+        if (fclose(s->file->file) == EOF) {
             snapshot_error = SNAPSHOT_WRITE_CLOSE_EOF_ERROR;
             retval = -1;
-        } else {
-            retval = 0;
         }
+        lib_free(s->file);
     }
 
     lib_free(s);
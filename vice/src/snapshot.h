@@ -28,6 +28,8 @@
 #ifndef SNAPSHOT_H
 #define SNAPSHOT_H
 
+#include <stddef.h>
+
 #include "types.h"
 
 #define SNAPSHOT_MACHINE_NAME_LEN       16
@@ -62,6 +64,7 @@
 
 typedef struct snapshot_module_s snapshot_module_t;
 typedef struct snapshot_s snapshot_t;
+typedef struct snapshot_stream_s snapshot_stream_t;
 
 extern void snapshot_display_error(void);
 
@@ -145,6 +148,25 @@ extern snapshot_t *snapshot_open(const char *filename,
                                  const char *snapshot_machine_name);
 extern int snapshot_close(snapshot_t *s);
 
+/* Memory backed snapshots.  The stream is owned by the caller and survives
+   snapshot_close(); creating a snapshot on it replaces its contents but
+   keeps the buffer, so a stream can be reused for frequent snapshots.  */
+extern snapshot_stream_t *snapshot_memory_stream_new(void);
+extern void snapshot_memory_stream_free(snapshot_stream_t *stream);
+extern const uint8_t *snapshot_memory_stream_data(snapshot_stream_t *stream);
+extern size_t snapshot_memory_stream_size(snapshot_stream_t *stream);
+extern void snapshot_memory_stream_set_data(snapshot_stream_t *stream,
+                                            const uint8_t *data, size_t size);
+
+extern snapshot_t *snapshot_create_stream(snapshot_stream_t *stream,
+                                          uint8_t major_version,
+                                          uint8_t minor_version,
+                                          const char *snapshot_machine_name);
+extern snapshot_t *snapshot_open_stream(snapshot_stream_t *stream,
+                                        uint8_t *major_version_return,
+                                        uint8_t *minor_version_return,
+                                        const char *snapshot_machine_name);
+
 extern void snapshot_set_error(int error);
 
 extern int snapshot_version_at_least(uint8_t major_version, uint8_t minor_version, uint8_t major_version_required, uint8_t minor_version_required);
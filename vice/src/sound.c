@@ -41,6 +41,7 @@
 #endif
 
 #include "archdep.h"
+#include "archdep_thread.h"
 #include "clkguard.h"
 #include "cmdline.h"
 #include "debug.h"
@@ -358,6 +359,9 @@ int sid_state_changed;
 /* Sample based or cycle based sound engine. */
 static int cycle_based = 0;
 
+/* Flag: render sound on a thread of its own.  */
+static int sound_thread_enabled = 0;
+
 static int set_output_option(int val, void *param)
 {
     switch (val) {
@@ -499,6 +503,22 @@ static int set_speed_adjustment_setting(int val, void *param)
     return 0;
 }
 
+static int set_sound_thread(int val, void *param)
+{
+    val = val ? 1 : 0;
+
+    if (val && !archdep_thread_available()) {
+        log_warning(sound_log, "Threads are not supported on this system.");
+        return -1;
+    }
+
+    if (sound_thread_enabled != val) {
+        sound_thread_enabled = val;
+        sound_state_changed = TRUE;
+    }
+    return 0;
+}
+
 static int set_volume(int val, void *param)
 {
     volume = val;
@@ -547,6 +567,8 @@ static const resource_int_t resources_int[] = {
       (void *)&volume, set_volume, NULL },
     { "SoundOutput", ARCHDEP_SOUND_OUTPUT_MODE, RES_EVENT_NO, NULL,
       (void *)&output_option, set_output_option, NULL },
+    { "SoundThread", 0, RES_EVENT_NO, NULL,
+      (void *)&sound_thread_enabled, set_sound_thread, NULL },
     RESOURCE_INT_LIST_END
 };
 
@@ -600,6 +622,12 @@ static const cmdline_option_t cmdline_options[] =
     { "-soundvolume", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
       NULL, NULL, "SoundVolume", NULL,
       "<Volume>", "Specify the sound volume (0..100)" },
+    { "-soundthread", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "SoundThread", (resource_value_t)1,
+      NULL, "Render sound on a separate thread" },
+    { "+soundthread", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "SoundThread", (resource_value_t)0,
+      NULL, "Render sound on the emulation thread" },
     CMDLINE_LIST_END
 };
 
@@ -930,8 +958,326 @@ static void sid_close(void)
     }
 }
 
+/* Clock the sound engines from the time of the last call up to `clk' and
+   append the samples to `buf' at `*bufptr'.  Returns -1 if the samples of
+   a sample based engine do not fit.  */
+static int sound_render(CLOCK clk, soundclk_t clkstep, int16_t *buf, int *bufptr)
+{
+    int nr = 0, i;
+    int delta_t = 0;
+    int16_t *bufferptr;
+    static int overflow_warning_count = 0;
+
+    /* Handling of cycle based sound engines. */
+    if (cycle_based) {
+        delta_t = clk - snddata.lastclk;
+        bufferptr = buf + *bufptr * snddata.sound_output_channels;
+        nr = sound_machine_calculate_samples(snddata.psid,
+                                             bufferptr,
+                                             SOUND_BUFSIZE - *bufptr,
+                                             snddata.sound_output_channels,
+                                             snddata.sound_chip_channels,
+                                             &delta_t);
+        if (delta_t) {
+            if (overflow_warning_count < 25) {
+                log_warning(sound_log, "%s", "Sound buffer overflow (cycle based)");
+                overflow_warning_count++;
+            } else {
+                if (overflow_warning_count == 25) {
+                    log_warning(sound_log, "Buffer overflow warning repeated 25 times, will now be ignored");
+                    overflow_warning_count++;
+                }
+            }
+        }
+    } else {
+        /* Handling of sample based sound engines. */
+        nr = (int)((SOUNDCLK_CONSTANT(clk) - snddata.fclk) / clkstep);
+        if (!nr) {
+            return 0;
+        }
+        if (*bufptr + nr > SOUND_BUFSIZE) {
+            return -1;
+        }
+        bufferptr = buf + *bufptr * snddata.sound_output_channels;
+        sound_machine_calculate_samples(snddata.psid,
+                                        bufferptr,
+                                        nr,
+                                        snddata.sound_output_channels,
+                                        snddata.sound_chip_channels,
+                                        &delta_t);
+        snddata.fclk += nr * clkstep;
+    }
+
+    if (amp < 4096) {
+        if (amp) {
+            for (i = 0; i < (nr * snddata.sound_output_channels); i++) {
+                bufferptr[i] = bufferptr[i] * amp / 4096;
+            }
+        } else {
+            memset(bufferptr, 0, nr * snddata.sound_output_channels * sizeof(int16_t));
+        }
+    }
+
+    *bufptr += nr;
+    snddata.lastclk = clk;
+
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Sound thread.
+
+   With `SoundThread' enabled the sound engines belong to a thread of their
+   own.  sound_store() only appends the write and its clock to a ring; the
+   thread clocks the engines up to that clock and then stores the value,
+   just like sound_store() does inline, so the samples are the same.  The
+   emulation thread takes the lock only to hand over a batch of entries.
+
+   At vsync sound_flush() collects what the thread has rendered so far and
+   queues the rest of the frame, which is rendered while the next frame is
+   emulated; this delays the output by up to one frame.  Everything else
+   that touches the engines or the sound clocks (register reads, reset,
+   snapshots, clock overflow) first waits for the thread to run dry.  Reads
+   also let it catch up to the current cycle, so OSC3, ENV3 and the other
+   readable registers return exactly what they return inline.  */
+
+/* Ring size, must be a power of two.  */
+#define SOUND_QUEUE_SIZE 16384
+
+/* Entries handed to the thread at once.  */
+#define SOUND_QUEUE_BATCH 256
+
+/* Cycles after which queued entries are handed over anyway, so the thread
+   keeps up during the frame instead of rendering it all at vsync.  */
+#define SOUND_QUEUE_CYCLES 1024
+
+enum {
+    SOUND_QUEUE_STORE,  /* clock the engines up to `clk', then store */
+    SOUND_QUEUE_RUN,    /* clock the engines up to `clk' */
+    SOUND_QUEUE_FRAME   /* the same, then use the clock step of the next frame */
+};
+
+typedef struct sound_queue_entry_s {
+    CLOCK clk;
+    uint16_t addr;
+    uint8_t val;
+    uint8_t chipno;
+    uint8_t type;
+} sound_queue_entry_t;
+
+static archdep_thread_t *sound_thread = NULL;
+static archdep_mutex_t *sound_thread_lock = NULL;
+static archdep_cond_t *sound_thread_work = NULL;
+static archdep_cond_t *sound_thread_done = NULL;
+
+static sound_queue_entry_t sound_queue[SOUND_QUEUE_SIZE];
+
+/* Next entry to fill, only used by the emulation thread.  */
+static unsigned int queue_write;
+static CLOCK queue_published_clk;
+
+/* Protected by `sound_thread_lock'; only the emulation thread writes
+   `queue_published', so it may read it without the lock.  */
+static unsigned int queue_published;
+static unsigned int queue_read;
+static soundclk_t queue_next_clkstep;
+static int sound_thread_quit;
+
+/* Owned by the thread while entries are pending.  */
+static int16_t sound_thread_buffer[SOUND_CHANNELS_MAX * SOUND_BUFSIZE];
+static int sound_thread_bufptr;
+static soundclk_t sound_thread_clkstep;
+static int sound_thread_error;
+static CLOCK sound_thread_clk;
+
+static void sound_thread_main(void *data)
+{
+    sound_queue_entry_t *e;
+    soundclk_t next_clkstep;
+    unsigned int i, end;
+
+    archdep_mutex_lock(sound_thread_lock);
+
+    while (1) {
+        while (queue_read == queue_published && !sound_thread_quit) {
+            archdep_cond_wait(sound_thread_work, sound_thread_lock);
+        }
+        if (sound_thread_quit) {
+            break;
+        }
+        end = queue_published;
+        next_clkstep = queue_next_clkstep;
+        archdep_mutex_unlock(sound_thread_lock);
+
+        for (i = queue_read; i != end; i++) {
+            e = &sound_queue[i & (SOUND_QUEUE_SIZE - 1)];
+
+            if (!sound_thread_error
+                && sound_render(e->clk, sound_thread_clkstep, sound_thread_buffer,
+                                &sound_thread_bufptr) < 0) {
+                /* reported by the emulation thread */
+                sound_thread_error = 1;
+            }
+            sound_thread_clk = e->clk;
+            switch (e->type) {
+                case SOUND_QUEUE_STORE:
+                    sound_machine_store(snddata.psid[e->chipno], e->addr, e->val);
+                    break;
+                case SOUND_QUEUE_FRAME:
+                    sound_thread_clkstep = next_clkstep;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        archdep_mutex_lock(sound_thread_lock);
+        queue_read = end;
+        archdep_cond_signal(sound_thread_done);
+    }
+
+    archdep_mutex_unlock(sound_thread_lock);
+}
+
+/* Hand the queued entries to the thread.  Waits if the ring has no room
+   for another batch.  */
+static void sound_thread_publish(void)
+{
+    archdep_mutex_lock(sound_thread_lock);
+    queue_published = queue_write;
+    queue_published_clk = maincpu_clk;
+    archdep_cond_signal(sound_thread_work);
+    while (queue_write - queue_read > SOUND_QUEUE_SIZE - SOUND_QUEUE_BATCH) {
+        archdep_cond_wait(sound_thread_done, sound_thread_lock);
+    }
+    archdep_mutex_unlock(sound_thread_lock);
+}
+
+static void sound_thread_queue(int type, CLOCK clk, uint16_t addr, uint8_t val, int chipno)
+{
+    sound_queue_entry_t *e;
+
+    e = &sound_queue[queue_write & (SOUND_QUEUE_SIZE - 1)];
+    e->clk = clk;
+    e->addr = addr;
+    e->val = val;
+    e->chipno = (uint8_t)chipno;
+    e->type = (uint8_t)type;
+    queue_write++;
+
+    if (queue_write - queue_published >= SOUND_QUEUE_BATCH
+        || clk - queue_published_clk >= SOUND_QUEUE_CYCLES) {
+        sound_thread_publish();
+    }
+}
+
+/* Wait until the thread has worked off every entry, then move the samples
+   it has rendered to the sample buffer.  The thread stays idle until the
+   next entry is published, so the caller may touch the engines.  */
+static int sound_thread_sync(void)
+{
+    int nr;
+
+    archdep_mutex_lock(sound_thread_lock);
+    queue_published = queue_write;
+    queue_published_clk = maincpu_clk;
+    archdep_cond_signal(sound_thread_work);
+    while (queue_read != queue_write) {
+        archdep_cond_wait(sound_thread_done, sound_thread_lock);
+    }
+    archdep_mutex_unlock(sound_thread_lock);
+
+    nr = sound_thread_bufptr;
+    if (snddata.bufptr + nr > SOUND_BUFSIZE) {
+        nr = SOUND_BUFSIZE - snddata.bufptr;
+        sound_thread_error = 1;
+    }
+    memcpy(snddata.buffer + snddata.bufptr * snddata.sound_output_channels,
+           sound_thread_buffer,
+           nr * snddata.sound_output_channels * sizeof(int16_t));
+    snddata.bufptr += nr;
+    sound_thread_bufptr = 0;
+
+    if (sound_thread_error) {
+        sound_thread_error = 0;
+#ifndef ANDROID_COMPILE
+        return sound_error("Sound buffer overflow.");
+#endif
+    }
+    return 0;
+}
+
+/* Queue the rest of the frame; `clkstep' applies to the next one.  */
+static void sound_thread_frame(soundclk_t clkstep)
+{
+    sound_thread_queue(SOUND_QUEUE_FRAME, maincpu_clk, 0, 0, 0);
+
+    archdep_mutex_lock(sound_thread_lock);
+    queue_next_clkstep = clkstep;
+    archdep_mutex_unlock(sound_thread_lock);
+
+    sound_thread_publish();
+}
+
+static void sound_thread_start(void)
+{
+    if (!sound_thread_enabled || sound_thread != NULL) {
+        return;
+    }
+
+    sound_thread_lock = archdep_mutex_new();
+    sound_thread_work = archdep_cond_new();
+    sound_thread_done = archdep_cond_new();
+
+    queue_write = 0;
+    queue_published = 0;
+    queue_published_clk = maincpu_clk;
+    queue_read = 0;
+    sound_thread_quit = 0;
+    sound_thread_bufptr = 0;
+    sound_thread_error = 0;
+    sound_thread_clk = maincpu_clk;
+    sound_thread_clkstep = snddata.clkstep;
+    queue_next_clkstep = snddata.clkstep;
+
+    sound_thread = archdep_thread_create(sound_thread_main, NULL);
+    if (sound_thread == NULL) {
+        log_error(sound_log, "Cannot create sound thread, rendering on the emulation thread.");
+        archdep_cond_destroy(sound_thread_done);
+        archdep_cond_destroy(sound_thread_work);
+        archdep_mutex_destroy(sound_thread_lock);
+    }
+}
+
+/* Stop the thread; entries still pending are dropped.  */
+static void sound_thread_stop(void)
+{
+    if (sound_thread == NULL) {
+        return;
+    }
+
+    archdep_mutex_lock(sound_thread_lock);
+    sound_thread_quit = 1;
+    archdep_cond_signal(sound_thread_work);
+    archdep_mutex_unlock(sound_thread_lock);
+
+    archdep_thread_join(sound_thread);
+    sound_thread = NULL;
+
+    archdep_cond_destroy(sound_thread_done);
+    archdep_cond_destroy(sound_thread_work);
+    archdep_mutex_destroy(sound_thread_lock);
+    sound_thread_lock = NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
 sound_t *sound_get_psid(unsigned int channel)
 {
+    if (sound_thread != NULL) {
+        sound_thread_sync();
+    }
     return snddata.psid[channel];
 }
 
@@ -1099,6 +1445,8 @@ int sound_open(void)
     sdev_open = TRUE;
     sound_state_changed = FALSE;
 
+    sound_thread_start();
+
     for (i = 0; (rdev = sound_devices[i]); i++) {
         if (recname && rdev->name && !strcasecmp(recname, rdev->name)) {
             break;
@@ -1147,6 +1495,8 @@ int sound_open(void)
 /* close sid */
 void sound_close(void)
 {
+    sound_thread_stop();
+
     if (snddata.playdev) {
         log_message(sound_log, "Closing device `%s'", snddata.playdev->name);
         if (snddata.playdev->close) {
@@ -1180,13 +1530,10 @@ void sound_close(void)
     vsync_suspend_speed_eval();
 }
 
-/* run sid */
-static int sound_run_sound(void)
+/* Check that sound is on and the device is open.  */
+static int sound_device_ready(void)
 {
-    int nr = 0, i;
-    int delta_t = 0;
-    int16_t *bufferptr;
-    static int overflow_warning_count = 0;
+    int i;
 
     /* XXX: implement the exact ... */
     if (!playback_enabled || (suspend_time > 0 && disabletime)) {
@@ -1199,65 +1546,32 @@ static int sound_run_sound(void)
             return i;
         }
     }
+    return 0;
+}
 
-    /* Handling of cycle based sound engines. */
-    if (cycle_based) {
-        delta_t = maincpu_clk - snddata.lastclk;
-        bufferptr = snddata.buffer + snddata.bufptr * snddata.sound_output_channels;
-        nr = sound_machine_calculate_samples(snddata.psid,
-                                             bufferptr,
-                                             SOUND_BUFSIZE - snddata.bufptr,
-                                             snddata.sound_output_channels,
-                                             snddata.sound_chip_channels,
-                                             &delta_t);
-        if (delta_t) {
-            if (overflow_warning_count < 25) {
-                log_warning(sound_log, "%s", "Sound buffer overflow (cycle based)");
-                overflow_warning_count++;
-            } else {
-                if (overflow_warning_count == 25) {
-                    log_warning(sound_log, "Buffer overflow warning repeated 25 times, will now be ignored");
-                    overflow_warning_count++;
-                }
-            }
-        }
-    } else {
-        /* Handling of sample based sound engines. */
-        nr = (int)((SOUNDCLK_CONSTANT(maincpu_clk) - snddata.fclk)
-                   / snddata.clkstep);
-        if (!nr) {
-            return 0;
-        }
-        if (snddata.bufptr + nr > SOUND_BUFSIZE) {
-#ifndef ANDROID_COMPILE
-            return sound_error("Sound buffer overflow.");
-#else
-            return 0;
-#endif
-        }
-        bufferptr = snddata.buffer + snddata.bufptr * snddata.sound_output_channels;
-        sound_machine_calculate_samples(snddata.psid,
-                                        bufferptr,
-                                        nr,
-                                        snddata.sound_output_channels,
-                                        snddata.sound_chip_channels,
-                                        &delta_t);
-        snddata.fclk += nr * snddata.clkstep;
-    }
+/* run sid */
+static int sound_run_sound(void)
+{
+    int i;
 
-    if (amp < 4096) {
-        if (amp) {
-            for (i = 0; i < (nr * snddata.sound_output_channels); i++) {
-                bufferptr[i] = bufferptr[i] * amp / 4096;
-            }
-        } else {
-            memset(bufferptr, 0, nr * snddata.sound_output_channels * sizeof(int16_t));
-        }
+    i = sound_device_ready();
+    if (i) {
+        return i;
     }
 
-    snddata.bufptr += nr;
-    snddata.lastclk = maincpu_clk;
+    if (sound_thread != NULL) {
+        /* let the thread catch up with the CPU */
+        sound_thread_queue(SOUND_QUEUE_RUN, maincpu_clk, 0, 0, 0);
+        return sound_thread_sync();
+    }
 
+    if (sound_render(maincpu_clk, snddata.clkstep, snddata.buffer, &snddata.bufptr) < 0) {
+#ifndef ANDROID_COMPILE
+        return sound_error("Sound buffer overflow.");
+#else
+        return 0;
+#endif
+    }
     return 0;
 }
 
@@ -1266,6 +1580,10 @@ void sound_reset(void)
 {
     int c;
 
+    if (sound_thread != NULL) {
+        sound_thread_sync();
+        sound_thread_clk = maincpu_clk;
+    }
     snddata.fclk = SOUNDCLK_CONSTANT(maincpu_clk);
     snddata.wclk = maincpu_clk;
     snddata.lastclk = maincpu_clk;
@@ -1281,6 +1599,10 @@ static void prevent_clk_overflow_callback(CLOCK sub, void *data)
 {
     int c;
 
+    if (sound_thread != NULL) {
+        sound_thread_sync();
+        sound_thread_clk -= sub;
+    }
     snddata.lastclk -= sub;
     snddata.fclk -= SOUNDCLK_CONSTANT(sub);
     snddata.wclk -= sub;
@@ -1291,9 +1613,26 @@ static void prevent_clk_overflow_callback(CLOCK sub, void *data)
     }
 }
 
+/* Bring the sample buffer up to date for sound_flush_buffer().  With the
+   thread only collect what it has rendered, the rest of the frame is queued
+   afterwards.  */
+static int sound_run_frame(void)
+{
+    int i;
+
+    if (sound_thread == NULL) {
+        return sound_run_sound();
+    }
+    i = sound_device_ready();
+    if (i) {
+        return i;
+    }
+    return sound_thread_sync();
+}
+
 /* flush all generated samples from buffer to sounddevice. adjust sid runspeed
    to match real running speed of program */
-double sound_flush()
+static double sound_flush_buffer(void)
 {
     int c, i, nr, space = 0, used;
     int j;
@@ -1319,14 +1658,22 @@ double sound_flush()
     if (suspend_time > 0) {
         enablesound();
     }
-    if (sound_run_sound()) {
+    if (sound_run_frame()) {
         return 0;
     }
 
     if (sid_state_changed) {
+        if (sound_thread != NULL) {
+            /* sid_init() changes the clocks, catch up first */
+            sound_thread_queue(SOUND_QUEUE_RUN, maincpu_clk, 0, 0, 0);
+            if (sound_thread_sync()) {
+                return 0;
+            }
+        }
         if (sid_init() != 0) {
             return 0;
         }
+        sound_thread_clkstep = snddata.clkstep;
         sid_state_changed = FALSE;
     }
 
@@ -1488,6 +1835,16 @@ double sound_flush()
     return 0;
 }
 
+double sound_flush(void)
+{
+    double delay = sound_flush_buffer();
+
+    if (sound_thread != NULL) {
+        sound_thread_frame(snddata.clkstep);
+    }
+    return delay;
+}
+
 /* suspend sid (eg. before pause) */
 void sound_suspend(void)
 {
@@ -1576,11 +1933,33 @@ void sound_init(unsigned int clock_rate, unsigned int ticks_per_frame)
     lib_free(devlist);
 }
 
+/* The clock of the access the engines are handling.  With the thread this
+   is the clock of the entry it ran last, which is the current cycle again
+   after sound_thread_sync().  */
+CLOCK sound_get_clk(void)
+{
+    return sound_thread != NULL ? sound_thread_clk : maincpu_clk;
+}
+
+/* Wait until the thread has handled every store made so far.  Chips that
+   keep state outside of their store function call this before they change
+   it.  */
+void sound_sync(void)
+{
+    if (sound_thread != NULL) {
+        sound_thread_sync();
+    }
+}
+
 long sound_sample_position(void)
 {
-    return (snddata.clkstep == 0)
-           ? 0 : (long)((SOUNDCLK_CONSTANT(maincpu_clk) - snddata.fclk)
-                        / snddata.clkstep);
+    soundclk_t clkstep = snddata.clkstep;
+
+    if (sound_thread != NULL) {
+        clkstep = sound_thread_clkstep;
+    }
+    return (clkstep == 0)
+           ? 0 : (long)((SOUNDCLK_CONSTANT(sound_get_clk()) - snddata.fclk) / clkstep);
 }
 
 int sound_dump(int chipno)
@@ -1588,6 +1967,9 @@ int sound_dump(int chipno)
     if (chipno >= snddata.sound_chip_channels) {
         return -1;
     }
+    if (sound_thread != NULL) {
+        sound_thread_sync();
+    }
     mon_out("%s\n", sound_machine_dump_state(snddata.psid[chipno]));
     return 0;
 }
@@ -1609,7 +1991,7 @@ void sound_store(uint16_t addr, uint8_t val, int chipno)
 {
     int i;
 
-    if (sound_run_sound()) {
+    if (sound_thread != NULL ? sound_device_ready() : sound_run_sound()) {
         return;
     }
 
@@ -1617,7 +1999,11 @@ void sound_store(uint16_t addr, uint8_t val, int chipno)
         return;
     }
 
-    sound_machine_store(snddata.psid[chipno], addr, val);
+    if (sound_thread != NULL) {
+        sound_thread_queue(SOUND_QUEUE_STORE, maincpu_clk, addr, val, chipno);
+    } else {
+        sound_machine_store(snddata.psid[chipno], addr, val);
+    }
 
     if (!snddata.playdev->dump) {
         return;
@@ -1661,6 +2047,9 @@ void sound_snapshot_prepare(void)
 
 void sound_snapshot_finish(void)
 {
+    if (sound_thread != NULL) {
+        sound_thread_sync();
+    }
     snddata.lastclk = maincpu_clk;
 }
 
@@ -218,6 +218,8 @@ extern int sound_register_device(sound_device_t *pdevice);
 /* other internal functions used around sound -code */
 extern int sound_read(uint16_t addr, int chipno);
 extern void sound_store(uint16_t addr, uint8_t val, int chipno);
+extern CLOCK sound_get_clk(void);
+extern void sound_sync(void);
 extern long sound_sample_position(void);
 extern int sound_dump(int chipno);
 
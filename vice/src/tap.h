@@ -41,6 +41,7 @@
 
 struct tape_init_s;
 struct tape_file_record_s;
+struct tap_file_index_s;
 
 typedef struct tap_s {
     /* File name.  */
@@ -95,12 +96,24 @@ typedef struct tap_s {
 
     /* Has the tap changed? We correct the size then.  */
     int has_changed;
+
+    /* The whole file (header included) read into memory for the file
+       scanner, NULL until loaded again after the image was written.  */
+    uint8_t *buffer;
+    long buffer_size;
+
+    /* File scanner position, as an offset into the file.  */
+    long buffer_pos;
+
+    /* Positions and header records of the files found so far.  */
+    struct tap_file_index_s *file_index;
 } tap_t;
 
 extern void tap_init(const struct tape_init_s *init);
 extern tap_t *tap_open(const char *name, unsigned int *read_only);
 extern int tap_close(tap_t *tap);
 extern int tap_create(const char *name);
+extern void tap_buffer_invalidate(tap_t *tap);
 
 extern int tap_seek_start(tap_t *tap);
 extern int tap_seek_to_file(tap_t *tap, unsigned int file_number);
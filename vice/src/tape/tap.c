@@ -75,6 +75,23 @@ static int tap_pulse_tt_short_max = 0x22;
 static int tap_pulse_tt_long_min = 0x23;
 static int tap_pulse_tt_long_max = 0x36;
 
+/* Bumped by tap_init(), as changed pulse thresholds invalidate all indexes */
+static int tap_file_index_generation = 0;
+
+/* Start of the header of every file found so far, in tape order.  Entry N
+   holds the state tap_seek_to_file() would arrive at for file N.  */
+typedef struct tap_file_index_entry_s {
+    long pos;
+    tape_file_record_t record;
+} tap_file_index_entry_t;
+
+typedef struct tap_file_index_s {
+    int generation;
+    int count;
+    int size;
+    tap_file_index_entry_t *entries;
+} tap_file_index_t;
+
 
 static int tap_header_read(tap_t *tap, FILE *fd)
 {
@@ -112,10 +129,63 @@ static tap_t *tap_new(void)
     tap->current_file_number = -1;
     tap->current_file_data = NULL;
     tap->current_file_size = 0;
+    tap->buffer = NULL;
+    tap->buffer_size = 0;
+    tap->buffer_pos = TAP_HDR_SIZE;
+    tap->file_index = NULL;
 
     return tap;
 }
 
+static void tap_file_index_free(tap_t *tap)
+{
+    if (tap->file_index != NULL) {
+        lib_free(tap->file_index->entries);
+        lib_free(tap->file_index);
+        tap->file_index = NULL;
+    }
+}
+
+/* Read the whole image into memory, so the file scanner can decode pulses
+   straight from the buffer instead of going through stdio for each one.  */
+static int tap_buffer_load(tap_t *tap)
+{
+    long size;
+
+    if (tap->buffer != NULL) {
+        return 0;
+    }
+
+    size = (long)util_file_length(tap->fd);
+    if (size < TAP_HDR_SIZE) {
+        return -1;
+    }
+
+    tap->buffer = lib_malloc(size);
+    if (fseek(tap->fd, 0, SEEK_SET) != 0
+        || fread(tap->buffer, 1, (size_t)size, tap->fd) != (size_t)size) {
+        lib_free(tap->buffer);
+        tap->buffer = NULL;
+        tap->buffer_size = 0;
+        return -1;
+    }
+    tap->buffer_size = size;
+
+    return 0;
+}
+
+/* Drop the in-memory copy and the file index after the image was written.
+   Both are rebuilt when the tape is scanned the next time.  */
+void tap_buffer_invalidate(tap_t *tap)
+{
+    if (tap->buffer != NULL) {
+        lib_free(tap->buffer);
+        tap->buffer = NULL;
+        tap->buffer_size = 0;
+    }
+    tap_file_index_free(tap);
+}
+
 tap_t *tap_open(const char *name, unsigned int *read_only)
 {
     FILE *fd;
@@ -162,6 +232,15 @@ tap_t *tap_open(const char *name, unsigned int *read_only)
     new->current_file_data = NULL;
     new->current_file_size = 0;
 
+    if (tap_buffer_load(new) < 0) {
+        zfile_fclose(new->fd);
+        lib_free(new->file_name);
+        lib_free(new->tap_file_record);
+        lib_free(new);
+        return NULL;
+    }
+    fseek(new->fd, new->offset, SEEK_SET);
+
     return new;
 }
 
@@ -181,6 +260,7 @@ int tap_close(tap_t *tap)
         retval = 0;
     }
 
+    tap_buffer_invalidate(tap);
     lib_free(tap->current_file_data);
     lib_free(tap->file_name);
     lib_free(tap->tap_file_record);
@@ -226,69 +306,81 @@ int tap_create(const char *name)
 
 static int tap_find_pilot(tap_t *tap, int type);
 
-inline static int tap_get_pulse(tap_t *tap, int *pos_advance)
+/* Decode one half of a pulse from the buffer.  Returns the number of bytes
+   it takes, or 0 if the image ends before the pulse is complete.  */
+inline static int tap_decode_halfwave(const tap_t *tap, long pos, uint32_t *length)
 {
-    uint8_t data;
-    uint32_t pulse_length = 0;
-    size_t res;
+    const uint8_t *p;
 
-    *pos_advance = 0;
-    res = fread(&data, 1, 1, tap->fd);
-
-    if (res == 0) {
-        return -1;
+    if (pos >= tap->buffer_size) {
+        return 0;
     }
+    p = tap->buffer + pos;
 
-    *pos_advance += (int)res;
+    if (p[0] != 0) {
+        *length = p[0];
+        return 1;
+    }
 
-    if (data == 0) {
-        if (tap->version == 0) {
-            pulse_length = 256;
-        } else if ((tap->version == 1) || (tap->version == 2)) {
-            uint8_t size[3];
-            res = fread(size, 3, 1, tap->fd);
-            if (res == 0) {
-                return -1;
-            }
-            *pos_advance += 3;
-            pulse_length = ((size[2] << 16) | (size[1] << 8) | size[0]) >> 3;
+    if (tap->version == 0) {
+        *length = 256;
+        return 1;
+    } else if ((tap->version == 1) || (tap->version == 2)) {
+        if (pos + 4 > tap->buffer_size) {
+            return 0;
         }
-    } else {
-        pulse_length = data;
+        *length = ((p[3] << 16) | (p[2] << 8) | p[1]) >> 3;
+        return 4;
     }
 
-    /*  Handle Halfwave format for C16 tapes */
-    if (tap->version == 2) {
-        uint32_t pulse_length2;
+    *length = 0;
+    return 1;
+}
 
-        res = fread(&data, 1, 1, tap->fd);
+/* Decode the pulse starting at file offset pos.  Returns the number of bytes
+   it takes, or 0 at the end of the image.  */
+inline static int tap_decode_pulse(const tap_t *tap, long pos, uint32_t *pulse_length)
+{
+    int len, len2;
+    uint32_t pulse_length2;
 
-        if (res == 0) {
-            return -1;
-        }
-        *pos_advance += (int)res;
-        if (data == 0) {
-            uint8_t size[3];
-            res = fread(size, 3, 1, tap->fd);
-            if (res == 0) {
-                return -1;
-            }
-            *pos_advance += 3;
-            pulse_length2 = ((size[2] << 16) | (size[1] << 8) | size[0]) >> 3;
-        } else {
-            pulse_length2 = data;
+    len = tap_decode_halfwave(tap, pos, pulse_length);
+    if (len == 0) {
+        return 0;
+    }
+
+    /*  Handle Halfwave format for C16 tapes */
+    if (tap->version == 2) {
+        len2 = tap_decode_halfwave(tap, pos + len, &pulse_length2);
+        if (len2 == 0) {
+            return 0;
         }
 
         /*  This should do for the time being */
-        pulse_length += pulse_length2;
+        *pulse_length += pulse_length2;
+        len += len2;
+    }
+
+    return len;
+}
+
+inline static int tap_get_pulse(tap_t *tap, int *pos_advance)
+{
+    uint32_t pulse_length;
+
+    *pos_advance = tap_decode_pulse(tap, tap->buffer_pos, &pulse_length);
+    if (*pos_advance == 0) {
+        tap->buffer_pos = tap->buffer_size;
+        return -1;
     }
+    tap->buffer_pos += *pos_advance;
 
 #if TAP_DEBUG > 2
-    if (TAP_PULSE_SHORT(data)) {
+    if (TAP_PULSE_SHORT(pulse_length)) {
         log_debug("s");
-    } else if (TAP_PULSE_MIDDLE(data)) {
+    } else if (TAP_PULSE_MIDDLE(pulse_length)) {
         log_debug("m");
-    } else if (TAP_PULSE_LONG(data)) {
+    } else if (TAP_PULSE_LONG(pulse_length)) {
         log_debug("l");
     }
 #endif
@@ -382,7 +474,7 @@ static int tap_cbm_skip_pilot(tap_t *tap)
 
     errors = 0;
     counter = 0;
-    current_filepos = ftell(tap->fd);
+    current_filepos = tap->buffer_pos;
     while (1) {
         /*  Save file position */
         fpos = current_filepos;
@@ -391,7 +483,7 @@ static int tap_cbm_skip_pilot(tap_t *tap)
         fpos2 = current_filepos;
         if (TAP_PULSE_LONG(data)) {
             /* found an L pulse, try to read a byte */
-            fseek(tap->fd, fpos, SEEK_SET);
+            tap->buffer_pos = fpos;
             current_filepos = fpos;
             data = tap_cbm_read_byte(tap);
             if (data == -1) {
@@ -404,12 +496,12 @@ static int tap_cbm_skip_pilot(tap_t *tap)
                 }
 
                 /* Start over after the L pulse */
-                fseek(tap->fd, fpos2, SEEK_SET);
+                tap->buffer_pos = fpos2;
                 current_filepos = fpos2;
                 counter = 0;
             } else {
                 /* success.  Go back to start of byte and return */
-                fseek(tap->fd, fpos, SEEK_SET);
+                tap->buffer_pos = fpos;
                 current_filepos = fpos;
                 return 0;
             }
@@ -766,13 +858,13 @@ static int tap_cbm_skip_file(tap_t *tap)
         int ret;
 
         while (1) {
-            fpos = ftell(tap->fd);
+            fpos = tap->buffer_pos;
 
             /* find next pilot */
             ret = tap_find_pilot(tap, PILOT_TYPE_CBM);
             if (ret < 0) {
                 /* no more pilot found => end of data */
-                fseek(tap->fd, fpos, SEEK_SET);
+                tap->buffer_pos = fpos;
                 break;
             }
 
@@ -780,7 +872,7 @@ static int tap_cbm_skip_file(tap_t *tap)
             ret = tap_cbm_read_block(tap, buffer, 193);
             if (ret < 1 || buffer[0] != 2) {
                 /* next block is not a data continuation block => end of data */
-                fseek(tap->fd, fpos, SEEK_SET);
+                tap->buffer_pos = fpos;
                 break;
             }
         }
@@ -847,7 +939,7 @@ static int tap_tt_skip_pilot(tap_t *tap)
     int data;
 
 #if TAP_DEBUG > 1
-    log_debug("\nTAP_TT_SKIP_PILOT(0x%X", ftell(tap->fd));
+    log_debug("\nTAP_TT_SKIP_PILOT(0x%X", tap->buffer_pos);
 #endif
 
     /* turbo-tape pilot is just repeats of value 0x02 */
@@ -860,12 +952,12 @@ static int tap_tt_skip_pilot(tap_t *tap)
         if (data != 2) {
             /* value != 0x02, we found the end of the pilot.  Go back
                so byte can be read again */
-            fseek(tap->fd, -8, SEEK_CUR);
+            tap->buffer_pos -= 8;
         }
     } while (data == 2);
 
 #if TAP_DEBUG > 1
-    log_debug("-0x%X) ", ftell(tap->fd));
+    log_debug("-0x%X) ", tap->buffer_pos);
 #endif
 
     return 0;
@@ -1087,11 +1179,10 @@ static int tap_determine_pilot_type(tap_t *tap)
 
 static int tap_find_pilot(tap_t *tap, int type)
 {
-    int i, countCBM, countTT, startCBM, startTT, minCBM;
-    int count;
-    int data[256];
-    long pos[257];
-    uint8_t buffer[256];
+    int countCBM, countTT, minCBM, len;
+    long startCBM, startTT, pos, next;
+    uint32_t length;
+    int data;
 
     /* when looking for any pilot type, require CBM pilot to be longer
        than when specifically looking for CBM pilot.  A TurboTape L pulse
@@ -1103,7 +1194,7 @@ static int tap_find_pilot(tap_t *tap, int type)
        file */
     minCBM = (type == PILOT_TYPE_ANY) ? 1000 : PILOT_MIN_LENGTH_CBM;
 
-    startCBM = ftell(tap->fd);
+    startCBM = tap->buffer_pos;
     startTT = startCBM;
     countCBM = 0;
     countTT = 0;
@@ -1112,141 +1203,59 @@ static int tap_find_pilot(tap_t *tap, int type)
     log_debug(" TAP_FIND_PILOT");
 #endif
 
+    pos = tap->buffer_pos;
     while ((countCBM < minCBM) && (countTT < PILOT_MIN_LENGTH_TT * 8)) {
-/*        count = fread(&data, 1, 256, tap->fd); */
-        int startpos = ftell(tap->fd);
-        int readlen = (int)fread(buffer, 1, 256, tap->fd);
-        uint32_t pulse_length = 0;
-        int j = 0;
-        int needed;
-        int res;
-        for (i = 0; i < readlen; ) {
-            pos[j] = startpos + i;
-            if (buffer[i] == 0) {
-                if (tap->version == 0) {
-                    pulse_length = 256;
-                    i++;
-                } else if ((tap->version == 1) || (tap->version == 2)) {
-                    int still_in_buffer = readlen - (i + 1);
-                    needed = 3 - still_in_buffer;
-                    if (needed <= 0) {
-                        pulse_length = ((buffer[i + 3] << 16) | (buffer[i + 2] << 8) | buffer[i + 1]) >> 3;
-                        i += 4;
-                    } else {
-                        /* There is not enough in the buffer
-                           Read some more */
-                        memcpy(buffer, buffer + i + 1, still_in_buffer);
-                        res = (int)fread(buffer + still_in_buffer, 1, needed, tap->fd);
-                        i = readlen;
-                        if (res == 0) {
-                            continue;
-                        }
-                        pulse_length = ((buffer[2] << 16) | (buffer[1] << 8) | buffer[0]) >> 3;
-                    }
-                }
-            } else {
-                pulse_length = buffer[i];
-                i++;
-            }
-            data[j] = pulse_length;
-
-            if (tap->version == 2) {
-                uint32_t pulse_length2;
-                /*  Read one more byte if run out of buffer */
-                if (i == readlen) {
-                    readlen = (int)fread(buffer, 1, 1, tap->fd);
-                    if (readlen == 0) {
-                        continue;
-                    }
-                    i = 0;
-                }
-                if (buffer[i] == 0) {
-                    int still_in_buffer = readlen - (i + 1);
-                    needed = 3 - still_in_buffer;
-                    if (needed <= 0) {
-                        pulse_length2 = ((buffer[i + 3] << 16) | (buffer[i + 2] << 8) | buffer[i + 1]) >> 3;
-                        i += 4;
-                    } else {
-                        /* There is not enough in the buffer
-                           Read some more */
-                        memcpy(buffer, buffer + i + 1, still_in_buffer);
-                        res = (int)fread(buffer + still_in_buffer, 1, needed, tap->fd);
-                        i = readlen;
-                        if (res == 0) {
-                            continue;
-                        }
-                        pulse_length2 = ((buffer[2] << 16) | (buffer[1] << 8) | buffer[0]) >> 3;
-                    }
-                } else {
-                    pulse_length2 = buffer[i];
-                    i++;
-                }
-                data[j] += pulse_length2;
-            }
-            j++;
+        len = tap_decode_pulse(tap, pos, &length);
+        if (len == 0) {
+            tap->buffer_pos = pos;
+            return -1;
         }
-        count = j;
-        pos[j] = ftell(tap->fd);
+        data = (int)length;
+        next = pos + len;
 
-/*        for (i = 0, count = 0; i < 256; i++, count++) {
-            pos[i] = ftell(tap->fd);
-            data[i] = tap_get_pulse(tap);
-            if (data[i] < 0) break;
-        }
-        pos[i] = ftell(tap->fd);*/
-        if (count < 1) {
-            return -1;
+        if (type == PILOT_TYPE_ANY || type == PILOT_TYPE_CBM) {
+            /* cbm pilot is at least PILOT_MIN_LENGTH_CBM consecutive short pulses */
+            if (TAP_PULSE_SHORT(data)) {
+                countCBM++;
+            } else {
+                startCBM = next;
+                countCBM = 0;
+            }
         }
 
-        for (i = 0; (i < count) && (countCBM < minCBM) && (countTT < PILOT_MIN_LENGTH_TT * 8); i++) {
-            if (type == PILOT_TYPE_ANY || type == PILOT_TYPE_CBM) {
-                /* cbm pilot is at least PILOT_MIN_LENGTH_CBM consecutive short pulses */
-                if (TAP_PULSE_SHORT(data[i])) {
-                    countCBM++;
+        if (type == PILOT_TYPE_ANY || type == PILOT_TYPE_TT) {
+            /* TurboTape pilot is PILOT_MIN_LENGTH_TT or more repeats of the value 0x02.
+               Accept any long bit sequence of 1000000010000000100...
+               Trust that reading the header will fail if we detect a wrong
+               sequence (in that case we come back here) */
+            if ((countTT & 7) == 0) {
+                if (TAP_PULSE_TT_LONG(data)) {
+                    countTT++;
                 } else {
-                    startCBM = pos[i + 1];
-                    countCBM = 0;
+                    startTT = next;
+                    countTT = 0;
                 }
-
-/*                  { startCBM+=countCBM+1; countCBM = 0; } */
-            }
-
-            if (type == PILOT_TYPE_ANY || type == PILOT_TYPE_TT) {
-                /* TurboTape pilot is PILOT_MIN_LENGTH_TT or more repeats of the value 0x02.
-                   Accept any long bit sequence of 1000000010000000100...
-                   Trust that reading the header will fail if we detect a wrong
-                   sequence (in that case we come back here) */
-                if ((countTT & 7) == 0) {
-                    if (TAP_PULSE_TT_LONG(data[i])) {
-                        countTT++;
-                    } else {
-                        startTT = pos[i + 1];
-                        countTT = 0;
-                    }
-/*                      { startTT+=countTT+1; countTT = 0; } */
+            } else {
+                if (TAP_PULSE_TT_SHORT(data)) {
+                    countTT++;
+                } else if (TAP_PULSE_TT_LONG(data)) {
+                    startTT = pos;
+                    countTT = 1;
                 } else {
-                    if (TAP_PULSE_TT_SHORT(data[i])) {
-                        countTT++;
-                    } else if (TAP_PULSE_TT_LONG(data[i])) {
-                        startTT = pos[i];
-                        countTT = 1;
-                    }
-/*                      { startTT+=countTT; countTT = 1; } */
-                    else {
-                        startTT = pos[i + 1];
-                        countTT = 0;
-                    }
-/*                      { startTT+=countTT+1; countTT = 0; } */
+                    startTT = next;
+                    countTT = 0;
                 }
             }
         }
+
+        pos = next;
     }
 
 #if TAP_DEBUG > 0
     if (countTT >= PILOT_MIN_LENGTH_TT * 8) {
-        log_debug(" found TT pilot(0x%X)", startTT + 2);
+        log_debug(" found TT pilot(0x%lX)", startTT + 2);
     } else {
-        log_debug(" found CBM pilot(0x%X)", startCBM);
+        log_debug(" found CBM pilot(0x%lX)", startCBM);
     }
 #endif
 
@@ -1254,10 +1263,10 @@ static int tap_find_pilot(tap_t *tap, int type)
         /* startTT points to a '1' bit which we assume to be part of the
            value 00000010.  Skip over the 1 and following 0 so we start
            at the beginning of a 00000010 sequence */
-        fseek(tap->fd, startTT + 2, SEEK_SET);
+        tap->buffer_pos = startTT + 2;
         return 1;
     } else {
-        fseek(tap->fd, startCBM, SEEK_SET);
+        tap->buffer_pos = startCBM;
         return 0;
     }
 }
@@ -1277,21 +1286,21 @@ static int tap_find_header(tap_t *tap)
         }
 
         /* store current position in TAP file */
-        fpos = ftell(tap->fd);
+        fpos = tap->buffer_pos;
 
         /* try to read a header */
         if (type == PILOT_TYPE_CBM) {
             res = tap_cbm_read_header(tap);
             if (res < 0) {
                 int pos_advance;
-                fseek(tap->fd, fpos, SEEK_SET);
+                tap->buffer_pos = fpos;
                 while (TAP_PULSE_SHORT(tap_get_pulse(tap, &pos_advance))) {
                 }
             }
         } else if (type == PILOT_TYPE_TT) {
             res = tap_tt_read_header(tap);
             if (res < 0) {
-                fseek(tap->fd, fpos, SEEK_SET);
+                tap->buffer_pos = fpos;
                 tap_tt_skip_pilot(tap);
             }
         } else {
@@ -1305,7 +1314,7 @@ static int tap_find_header(tap_t *tap)
             }
 
             /* success.  Rewind to start of header and return. */
-            fseek(tap->fd, fpos, SEEK_SET);
+            tap->buffer_pos = fpos;
             tap->current_file_seek_position = fpos;
             return type;
         }
@@ -1323,7 +1332,7 @@ static int tap_read_file(tap_t *tap)
 #endif
 
     /* store current position in TAP file */
-    fpos = ftell(tap->fd);
+    fpos = tap->buffer_pos;
 
     /* clear old file data */
     tap->current_file_size = 0;
@@ -1349,7 +1358,7 @@ static int tap_read_file(tap_t *tap)
     }
 
     /* go back to previous position in TAP file */
-    fseek(tap->fd, fpos, SEEK_SET);
+    tap->buffer_pos = fpos;
 
 #if TAP_DEBUG > 0
     log_debug("\nTAP_READ_FILE(END%i)\n", ret);
@@ -1393,6 +1402,64 @@ static int tap_skip_file(tap_t *tap)
 
 /* ------------------------------------------------------------------------- */
 
+/* Remember where the file just found starts, if it is the next one not
+   indexed yet.  */
+static void tap_file_index_add(tap_t *tap)
+{
+    tap_file_index_t *index = tap->file_index;
+
+    if (index != NULL && index->generation != tap_file_index_generation) {
+        tap_file_index_free(tap);
+        index = NULL;
+    }
+
+    if (index == NULL) {
+        index = lib_calloc(1, sizeof(tap_file_index_t));
+        index->generation = tap_file_index_generation;
+        tap->file_index = index;
+    }
+
+    if (tap->current_file_number != index->count) {
+        return;
+    }
+
+    if (index->count == index->size) {
+        index->size = index->size ? index->size * 2 : 16;
+        index->entries = lib_realloc(index->entries,
+                                     index->size * sizeof(tap_file_index_entry_t));
+    }
+
+    index->entries[index->count].pos = tap->buffer_pos;
+    index->entries[index->count].record = *tap->tap_file_record;
+    index->count++;
+}
+
+/* Put the scanner at the header of an indexed file, as if it had been
+   found by tap_seek_to_next_file().  Returns the file number reached,
+   which is lower than requested if the index does not reach that far.  */
+static int tap_file_index_seek(tap_t *tap, int file_number)
+{
+    tap_file_index_t *index = tap->file_index;
+    tap_file_index_entry_t *entry;
+
+    if (index == NULL || index->count == 0
+        || index->generation != tap_file_index_generation) {
+        return -1;
+    }
+
+    if (file_number >= index->count) {
+        file_number = index->count - 1;
+    }
+    entry = &index->entries[file_number];
+
+    tap->buffer_pos = entry->pos;
+    tap->current_file_seek_position = (int)entry->pos;
+    *tap->tap_file_record = entry->record;
+    tap->current_file_number = file_number;
+
+    return file_number;
+}
+
 tape_file_record_t *tap_get_current_file_record(tap_t *tap)
 {
     return tap->tap_file_record;
@@ -1407,13 +1474,20 @@ int tap_seek_start(tap_t *tap)
 
     tap->current_file_number = -1;
     tap->current_file_seek_position = 0;
+    tap->buffer_pos = tap->offset;
     fseek(tap->fd, tap->offset, SEEK_SET);
-    return 0;
+    return tap_buffer_load(tap);
 }
 
 int tap_seek_to_file(tap_t *tap, unsigned int file_number)
 {
-    tap_seek_start(tap);
+    if (tap_seek_start(tap) < 0) {
+        return -1;
+    }
+
+    /* jump to the file, or to the last one found so far and scan from there */
+    tap_file_index_seek(tap, (int)file_number);
+
     while ((int) file_number > tap->current_file_number) {
         if (tap_seek_to_next_file(tap, 0) < 0) {
             return -1;
@@ -1434,6 +1508,10 @@ int tap_seek_to_next_file(tap_t *tap, unsigned int allow_rewind)
     lib_free(tap->current_file_data);
     tap->current_file_data = NULL;
 
+    if (tap_buffer_load(tap) < 0) {
+        return -1;
+    }
+
     /* skip over current and find NEXT pilot
        (only if not at beginning of tape) */
     if (tap->current_file_number >= 0) {
@@ -1452,6 +1530,7 @@ int tap_seek_to_next_file(tap_t *tap, unsigned int allow_rewind)
     }
 
     tap->current_file_number++;
+    tap_file_index_add(tap);
     return 0;
 }
 
@@ -1462,6 +1541,10 @@ int tap_read(tap_t *tap, uint8_t *buf, size_t size)
         if (tap->current_file_size > 0) {
             return -1; /* data==NULL and size>0 indicates read error */
         } else {
+            if (tap_buffer_load(tap) < 0) {
+                return -1;
+            }
+
             /* if at beginning of TAP file, seek to first file */
             if (tap->current_file_number < 0) {
                 if (tap_seek_to_next_file(tap, 0) < 0) {
@@ -1506,4 +1589,6 @@ void tap_init(const tape_init_t *init)
     tap_pulse_middle_max = init->pulse_middle_max / 8;
     tap_pulse_long_min = init->pulse_long_min / 8;
     tap_pulse_long_max = init->pulse_long_max / 8;
+
+    tap_file_index_generation++;
 }
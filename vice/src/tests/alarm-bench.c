@@ -0,0 +1,262 @@
+/*
+ * alarm-bench.c - Check the pending alarm scheduler and time it.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* This file is built twice, as alarm-flat with the flat pending alarm
+   array and as alarm-heap with the binary heap, whatever configure chose
+   for the emulators, so alarm.c is compiled in here.
+
+   Alarms are dispatched in clock order the way the CPU cores do it, and
+   each callback sets its alarm again some cycles ahead, or unsets it and
+   sets an idle one instead.  A first run checks every dispatch against a
+   plain list of due clocks and prints a hash of the dispatch order, which
+   must be the same for both builds.  Then the dispatches per second are
+   timed for 8 to 128 pending alarms.  */
+
+#include "vice.h"
+
+#ifdef ALARM_BENCH_HEAP
+#ifndef USE_ALARM_HEAP
+#define USE_ALARM_HEAP
+#endif
+#else
+#undef USE_ALARM_HEAP
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "alarm.c"
+
+/* Twice the largest number of pending alarms, so there are idle ones.  */
+#define ALARMS_MAX  256
+
+/* Dispatches for the checked run.  */
+#define CHECK_DISPATCHES    200000
+
+/* Seconds to time each setup for.  */
+#define BENCH_TIME  0.2
+
+static alarm_context_t *context;
+static alarm_t *alarms[ALARMS_MAX];
+static CLOCK due[ALARMS_MAX];
+static int num_alarms;
+
+static CLOCK clk;
+static uint32_t seed;
+static uint32_t order_hash;
+static int checking;
+static int failures = 0;
+
+#define NOT_DUE ((CLOCK)~0L)
+
+static uint32_t next_random(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static void set(int i, CLOCK when)
+{
+    due[i] = when;
+    alarm_set(alarms[i], when);
+}
+
+static void unset(int i)
+{
+    due[i] = NOT_DUE;
+    alarm_unset(alarms[i]);
+}
+
+static void alarm_callback(CLOCK offset, void *data)
+{
+    int i = (int)(long)data;
+    int j;
+
+    if (checking) {
+        if (due[i] != clk) {
+            printf("alarm %d dispatched at %lu, due at %lu\n",
+                   i, (unsigned long)clk, (unsigned long)due[i]);
+            failures++;
+        }
+        order_hash = order_hash * 31 + (uint32_t)i;
+    }
+
+    if ((next_random() & 7) == 0) {
+        /* Hand over to an idle alarm.  */
+        j = (int)(next_random() % (uint32_t)num_alarms);
+        if (due[j] == NOT_DUE) {
+            unset(i);
+            set(j, clk + 1 + (next_random() & 1023));
+            return;
+        }
+    }
+
+    /* Often due again on a clock another alarm has, to cover ties.  */
+    set(i, clk + 1 + (next_random() & 255));
+}
+
+static void setup(int pending)
+{
+    int i;
+
+    context = alarm_context_new("bench");
+    num_alarms = pending * 2;
+    for (i = 0; i < num_alarms; i++) {
+        alarms[i] = alarm_new(context, "bench", alarm_callback, (void *)(long)i);
+        due[i] = NOT_DUE;
+    }
+
+    clk = 0;
+    seed = 0x12345678;
+    order_hash = 0;
+    for (i = 0; i < pending; i++) {
+        set(i, 1 + (next_random() & 1023));
+    }
+}
+
+static void teardown(void)
+{
+    alarm_context_destroy(context);
+}
+
+static void check_next_pending(void)
+{
+    CLOCK min = NOT_DUE;
+    int i;
+
+    for (i = 0; i < num_alarms; i++) {
+        if (due[i] < min) {
+            min = due[i];
+        }
+    }
+    if (alarm_context_next_pending_clk(context) != min) {
+        printf("next pending alarm at %lu, should be %lu\n",
+               (unsigned long)alarm_context_next_pending_clk(context),
+               (unsigned long)min);
+        failures++;
+    }
+}
+
+static void dispatch(void)
+{
+    clk = alarm_context_next_pending_clk(context);
+    alarm_context_dispatch(context, clk);
+}
+
+static void check(int pending)
+{
+    long n;
+
+    setup(pending);
+    checking = 1;
+    for (n = 0; n < CHECK_DISPATCHES && failures < 10; n++) {
+        dispatch();
+        check_next_pending();
+    }
+    checking = 0;
+    printf("%4d pending: dispatch order hash %08x\n", pending, order_hash);
+    teardown();
+}
+
+static double bench(int pending)
+{
+    clock_t start, now;
+    long dispatches = 0;
+    int i;
+
+    setup(pending);
+    start = clock();
+    do {
+        for (i = 0; i < 1000; i++) {
+            dispatch();
+        }
+        dispatches += 1000;
+        now = clock();
+    } while (now - start < (clock_t)(BENCH_TIME * CLOCKS_PER_SEC));
+    teardown();
+
+    return (double)dispatches * CLOCKS_PER_SEC / (double)(now - start);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Stand-ins for the parts of the emulator alarm.c uses.  */
+
+void *lib_malloc(size_t size)
+{
+    void *p = malloc(size);
+
+    if (p == NULL && size > 0) {
+        exit(99);
+    }
+    return p;
+}
+
+void lib_free(const void *ptr)
+{
+    free((void *)ptr);
+}
+
+char *lib_stralloc(const char *str)
+{
+    char *p = lib_malloc(strlen(str) + 1);
+
+    strcpy(p, str);
+    return p;
+}
+
+int log_error(log_t log, const char *format, ...)
+{
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int main(void)
+{
+    static const int pending[] = { 8, 32, 128 };
+    int i;
+
+#ifdef USE_ALARM_HEAP
+    printf("Binary heap:\n");
+#else
+    printf("Flat array:\n");
+#endif
+
+    for (i = 0; i < (int)(sizeof(pending) / sizeof(pending[0])); i++) {
+        check(pending[i]);
+    }
+    for (i = 0; i < (int)(sizeof(pending) / sizeof(pending[0])); i++) {
+        printf("%4d pending: %6.1f million dispatches/s\n",
+               pending[i], bench(pending[i]) / 1e6);
+    }
+
+    if (failures) {
+        printf("%d scheduler checks failed.\n", failures);
+    }
+    return failures != 0;
+}
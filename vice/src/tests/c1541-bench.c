@@ -0,0 +1,204 @@
+/*
+ * c1541-bench.c - Time bulk writes and reads of c1541 on a D81 image.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* The c1541 built in src/ formats a D81 and writes FILES files to it with
+   a single run, which nearly fills the disk, then reads them all back with
+   a second run.  The files read back must be the files written.  Each run
+   is repeated PASSES times.  The time of a run that only formats the image
+   is taken off the others, so the throughput printed is that of the file
+   writes and reads.  Exits with 77 (skipped) when c1541 has not been
+   built.  */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "types.h"
+
+/* 180 files of 16 blocks fill 2880 of the 3160 free blocks.  */
+#define FILES       180
+#define FILE_SIZE   4000
+
+#define PASSES      5
+
+#define C1541       "../c1541"
+#define SCRATCH     "c1541-bench"
+
+static unsigned char data[FILES][FILE_SIZE];
+static unsigned char readback[FILE_SIZE];
+
+static char format_command[256];
+static char write_command[FILES * 64 + 256];
+static char read_command[FILES * 64 + 256];
+
+static double now(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (double)tv.tv_sec + (double)tv.tv_usec / 1e6;
+}
+
+static int write_file(const char *name, const unsigned char *buf, size_t size)
+{
+    FILE *f = fopen(name, "wb");
+
+    if (f == NULL) {
+        return -1;
+    }
+    if (fwrite(buf, 1, size, f) != size) {
+        fclose(f);
+        return -1;
+    }
+    return fclose(f);
+}
+
+static int check_file(const char *name, const unsigned char *buf, size_t size)
+{
+    FILE *f = fopen(name, "rb");
+    size_t n;
+
+    if (f == NULL) {
+        return -1;
+    }
+    n = fread(readback, 1, sizeof(readback), f);
+    if (fgetc(f) != EOF) {
+        n++;
+    }
+    fclose(f);
+
+    return (n == size && memcmp(readback, buf, size) == 0) ? 0 : -1;
+}
+
+/* Run `command' PASSES times and return the average time in seconds, or a
+   negative value if c1541 failed.  */
+static double run(const char *command)
+{
+    double start;
+    int pass;
+
+    start = now();
+    for (pass = 0; pass < PASSES; pass++) {
+        if (system(command) != 0) {
+            return -1.0;
+        }
+    }
+    return (now() - start) / PASSES;
+}
+
+static void cleanup(void)
+{
+    char name[64];
+    int i;
+
+    for (i = 0; i < FILES; i++) {
+        sprintf(name, SCRATCH "-in%02d", i);
+        remove(name);
+        sprintf(name, SCRATCH "-out%02d", i);
+        remove(name);
+    }
+    remove(SCRATCH ".d81");
+    remove(SCRATCH ".log");
+}
+
+int main(void)
+{
+    FILE *f;
+    char name[64];
+    uint32_t seed = 0x12345678;
+    double format_time, write_time, read_time;
+    int i, j, failures = 0;
+
+    f = fopen(C1541, "rb");
+    if (f == NULL) {
+        printf("c1541 has not been built, skipping.\n");
+        return 77;
+    }
+    fclose(f);
+
+    strcpy(format_command, C1541 " -format bench,01 d81 " SCRATCH ".d81"
+           " > " SCRATCH ".log 2>&1");
+    strcpy(write_command, C1541 " -format bench,01 d81 " SCRATCH ".d81");
+    strcpy(read_command, C1541 " " SCRATCH ".d81");
+
+    for (i = 0; i < FILES; i++) {
+        for (j = 0; j < FILE_SIZE; j++) {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            data[i][j] = (unsigned char)seed;
+        }
+        sprintf(name, SCRATCH "-in%02d", i);
+        if (write_file(name, data[i], FILE_SIZE) < 0) {
+            printf("Cannot write `%s'.\n", name);
+            cleanup();
+            return 1;
+        }
+        sprintf(write_command + strlen(write_command),
+                " -write " SCRATCH "-in%02d file%02d", i, i);
+        sprintf(read_command + strlen(read_command),
+                " -read file%02d " SCRATCH "-out%02d", i, i);
+    }
+    strcat(write_command, " > " SCRATCH ".log 2>&1");
+    strcat(read_command, " > " SCRATCH ".log 2>&1");
+
+    format_time = run(format_command);
+    if (format_time < 0.0) {
+        printf("c1541 failed to format the image, see " SCRATCH ".log\n");
+        return 1;
+    }
+    write_time = run(write_command);
+    if (write_time < 0.0) {
+        printf("c1541 failed to write the files, see " SCRATCH ".log\n");
+        return 1;
+    }
+    read_time = run(read_command);
+    if (read_time < 0.0) {
+        printf("c1541 failed to read the files, see " SCRATCH ".log\n");
+        return 1;
+    }
+
+    for (i = 0; i < FILES; i++) {
+        sprintf(name, SCRATCH "-out%02d", i);
+        if (check_file(name, data[i], FILE_SIZE) < 0) {
+            printf("`%s' differs from what was written.\n", name);
+            failures++;
+        }
+    }
+
+    printf("format: %6.1f ms\n", format_time * 1e3);
+    printf("write:  %6.1f ms, %6.0f KiB/s\n", write_time * 1e3,
+           FILES * FILE_SIZE / 1024.0 / (write_time - format_time));
+    printf("read:   %6.1f ms, %6.0f KiB/s\n", read_time * 1e3,
+           FILES * FILE_SIZE / 1024.0 / (read_time - format_time));
+
+    if (failures) {
+        printf("%d files differ.\n", failures);
+    } else {
+        cleanup();
+    }
+    return failures != 0;
+}
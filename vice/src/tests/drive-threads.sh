@@ -0,0 +1,63 @@
+#!/bin/sh
+
+#
+# drive-threads.sh - Compare DriveThreads with the serial drive emulation.
+#
+# This file is part of VICE, the Versatile Commodore Emulator.
+# See README for copyright notice.
+#
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation; either version 2 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software
+#  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+#  02111-1307  USA.
+#
+# x64sc with two 1541s.  The C64 program uploads a delay loop ending in a
+# JAM to drive 9, starts it with M-E and then leaves the bus alone, so the
+# drives run in parallel and drive 9 JAMs on a worker thread.  The JAM
+# resets the machine (-jamaction 3).  The snapshots taken some frames later
+# must be identical with and without DriveThreads.
+
+. "$srcdir/machine-test.sh"
+
+emu_setup x64sc C64 drive-threads
+
+{
+    # 10 SYS2061
+    printf '\001\010\013\010\012\000\236\062\060\066\061\000\000\000'
+    # OPEN 2,9,15,"M-W"...
+    printf '\251\002\242\011\240\017\040\272\377'
+    printf '\251\027\242\075\240\010\040\275\377'
+    printf '\040\300\377'
+    # PRINT#2,"M-E"...
+    printf '\242\002\040\311\377'
+    printf '\242\000\275\124\010\040\322\377\350\340\005\320\365'
+    printf '\040\314\377'
+    # loop: INC $D020 : JMP loop
+    printf '\356\040\320\114\067\010'
+    # "M-W" $0500 17 bytes
+    printf '\115\055\127\000\005\021'
+    # LDY #0 : LDX #0 : DEX : BNE : DEY : BNE : DEC $0510 : BNE : JAM : 8
+    printf '\240\000\242\000\312\320\375\210\320\372\316\020\005\320\365'
+    printf '\002\010'
+    # "M-E" $0500
+    printf '\115\055\105\000\005'
+} > "$workdir/jam.prg"
+
+set -- -truedrive -drive8type 1541 -drive9type 1541 -jamaction 3 \
+    -autostartprgmode 1 -autostart jam.prg -limitcycles 12000000 -warp
+
+emu_run serial.vsf +drivethreads "$@"
+emu_run threads.vsf -drivethreads "$@"
+emu_compare serial.vsf threads.vsf
+
+emu_done
@@ -0,0 +1,87 @@
+#
+# machine-test.sh - Helpers for the tests that run an emulator headless.
+#
+# This file is part of VICE, the Versatile Commodore Emulator.
+# See README for copyright notice.
+#
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation; either version 2 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software
+#  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+#  02111-1307  USA.
+#
+# Sourced by the test scripts.
+#
+# emu_setup <emulator> <rom directory> <test name>
+#   Find the emulator built in src/ and create a scratch directory for the
+#   test.  Exits with 77 (skipped) when the emulator has not been built.
+#
+# emu_run <snapshot> <options>
+#   Run the emulator in console mode with default settings and a fixed
+#   random seed, and save a snapshot when it exits.  Use -limitcycles to
+#   end the run.
+#
+# emu_compare <snapshot> <snapshot>
+#   Fail unless both snapshots are identical.
+#
+# emu_done
+#   Remove the scratch directory.
+
+srcdir=${srcdir-.}
+
+emu_setup()
+{
+    emu=`pwd`/../$1
+    if test ! -x "$emu"; then
+        echo "$1 has not been built, skipping."
+        exit 77
+    fi
+
+    datadir=`cd "$srcdir/../../data" && pwd`
+    romdirs="$datadir/$2:$datadir/DRIVES"
+
+    workdir=`pwd`/$3.dir
+    rm -rf "$workdir"
+    mkdir "$workdir" "$workdir/home"
+}
+
+emu_run()
+{
+    snapshot=$1
+    shift
+
+    # -limitcycles exits with an error status, the snapshot tells whether
+    # the run got there.
+    (cd "$workdir" && HOME="$workdir/home" "$emu" -console -default \
+        -directory "$romdirs" -sounddev dummy -seed 1 \
+        -exitsnapshot "$snapshot" "$@") > "$workdir/$snapshot.log" 2>&1
+
+    if test ! -f "$workdir/$snapshot"; then
+        echo "No snapshot written, see $workdir/$snapshot.log"
+        exit 1
+    fi
+}
+
+emu_compare()
+{
+    if cmp "$workdir/$1" "$workdir/$2"; then
+        :
+    else
+        echo "$1 and $2 differ, see $workdir"
+        exit 1
+    fi
+}
+
+emu_done()
+{
+    rm -rf "$workdir"
+}
@@ -0,0 +1,463 @@
+/*
+ * render-threads.c - Compare banded PAL/CRT rendering with rendering in one go.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* Every PAL and CRT render mode is run at every depth on random source
+   pixels, once on the calling thread and once split into bands on the
+   render threads, and the target buffers must be identical.
+
+   Besides a few frame geometries, the viewport's first and last line are
+   moved across each place where a band would start, and the 2x4 mode is
+   run with odd and even first source lines, so misplaced band borders
+   show up as differences.
+
+   Then every render mode is run at 16, 24 and 32 bpp with each YUV to RGB
+   kernel the CPU has, which must give the pixels of the scalar kernel, and
+   the frames per second of each kernel are printed.  */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "capture.h"
+#include "lib.h"
+#include "log.h"
+#include "machine.h"
+#include "palette.h"
+#include "resources.h"
+#include "types.h"
+#include "video-render-kernel.h"
+#include "video-render-thread.h"
+#include "video-render.h"
+#include "video-sound.h"
+#include "video.h"
+#include "videoarch.h"
+#include "viewport.h"
+
+#define SRC_WIDTH   420
+#define SRC_HEIGHT  300
+#define TRG_PITCH   (SRC_WIDTH * 2 * 4)
+#define TRG_HEIGHT  (SRC_HEIGHT * 4)
+
+/* Seconds to time each kernel for.  */
+#define BENCH_TIME  0.1
+
+/* Band counts to try; 7 gives bands that are not a power of two.  */
+static const int band_counts[] = { 2, 3, 7 };
+
+static const struct {
+    int mode;
+    const char *name;
+    int scale;
+} modes[] = {
+    { VIDEO_RENDER_PAL_1X1, "PAL 1x1", 1 },
+    { VIDEO_RENDER_PAL_2X2, "PAL 2x2", 2 },
+    { VIDEO_RENDER_CRT_1X1, "CRT 1x1", 1 },
+    { VIDEO_RENDER_CRT_1X2, "CRT 1x2", 2 },
+    { VIDEO_RENDER_CRT_2X2, "CRT 2x2", 2 },
+    { VIDEO_RENDER_CRT_2X4, "CRT 2x4", 4 }
+};
+
+static const int depths[] = { 8, 16, 24, 32 };
+
+/* The depths that go through the kernels.  */
+static const int kernel_depths[] = { 16, 24, 32 };
+
+/* first line, last line, xs, ys, xt, yt, width, height */
+static const int geometries[][8] = {
+    { 16, 287, 16, 16, 0, 0, 384, 272 },
+    { 0, 299, 0, 0, 0, 0, 400, 298 },
+    { 40, 200, 8, 30, 1, 3, 300, 200 },
+    { 16, 287, 17, 1, 3, 1, 383, 290 },
+    { 100, 120, 16, 16, 0, 0, 384, 272 },
+    { 30, 250, 4, 35, 2, 2, 390, 160 }
+};
+
+static video_cbm_color_t colors[16] = {
+    { 0.0f, 0.0f, 0, "Black" },
+    { 256.0f, 0.0f, 0, "White" },
+    { 80.0f, 112.5f, 1, "Red" },
+    { 176.0f, 292.5f, 1, "Cyan" },
+    { 96.0f, 45.0f, 1, "Purple" },
+    { 144.0f, 225.0f, 1, "Green" },
+    { 64.0f, 0.0f, 1, "Blue" },
+    { 192.0f, 180.0f, 1, "Yellow" },
+    { 96.0f, 135.0f, 1, "Orange" },
+    { 64.0f, 157.5f, 1, "Brown" },
+    { 128.0f, 112.5f, 1, "Light Red" },
+    { 80.0f, 0.0f, 0, "Dark Grey" },
+    { 120.0f, 0.0f, 0, "Medium Grey" },
+    { 192.0f, 225.0f, 1, "Light Green" },
+    { 120.0f, 0.0f, 1, "Light Blue" },
+    { 160.0f, 0.0f, 0, "Light Grey" }
+};
+
+static video_cbm_palette_t cbm_palette = {
+    16, colors, 50.0f, -4.5f, CBM_PALETTE_YUV
+};
+
+static uint8_t src_buffer[SRC_WIDTH * SRC_HEIGHT];
+static uint8_t *trg_single;
+static uint8_t *trg_bands;
+
+static video_render_config_t config;
+static viewport_t viewport;
+static video_canvas_t canvas;
+
+/* ------------------------------------------------------------------------- */
+
+/* Stand-ins for the parts of the emulator the renderers do not use.  */
+
+void *lib_malloc(size_t size)
+{
+    void *p = malloc(size);
+
+    if (p == NULL && size > 0) {
+        exit(99);
+    }
+    return p;
+}
+
+void *lib_calloc(size_t nmemb, size_t size)
+{
+    void *p = calloc(nmemb, size);
+
+    if (p == NULL && nmemb > 0 && size > 0) {
+        exit(99);
+    }
+    return p;
+}
+
+void lib_free(const void *ptr)
+{
+    free((void *)ptr);
+}
+
+int log_message(log_t log, const char *format, ...)
+{
+    return 0;
+}
+
+int log_warning(log_t log, const char *format, ...)
+{
+    return 0;
+}
+
+int log_error(log_t log, const char *format, ...)
+{
+    return 0;
+}
+
+int log_debug(const char *format, ...)
+{
+    return 0;
+}
+
+palette_t *palette_create(unsigned int num_entries, const char *entry_names[])
+{
+    palette_t *p = lib_malloc(sizeof(palette_t));
+
+    p->num_entries = num_entries;
+    p->entries = lib_calloc(num_entries, sizeof(palette_entry_t));
+    return p;
+}
+
+void palette_free(palette_t *p)
+{
+    if (p != NULL) {
+        lib_free(p->entries);
+        lib_free(p);
+    }
+}
+
+int palette_load(const char *file_name, palette_t *palette_return)
+{
+    return -1;
+}
+
+int video_canvas_palette_set(struct video_canvas_s *c, struct palette_s *p)
+{
+    palette_free(p);
+    return 0;
+}
+
+int resources_get_int(const char *name, int *value_return)
+{
+    *value_return = 0;
+    return 0;
+}
+
+int capture_enabled(void)
+{
+    return 0;
+}
+
+int video_disabled_mode = 0;
+
+void video_sound_update(video_render_config_t *c, const uint8_t *src,
+                        unsigned int width, unsigned int height,
+                        unsigned int xs, unsigned int ys,
+                        unsigned int pitch, viewport_t *v)
+{
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int render_compare(int bands, int depth, int width, int height,
+                          int xs, int ys, int xt, int yt)
+{
+    memset(trg_single, 0x5a, TRG_PITCH * TRG_HEIGHT);
+    memset(trg_bands, 0x5a, TRG_PITCH * TRG_HEIGHT);
+
+    video_render_thread_set_count(0);
+    video_render_main(&config, src_buffer, trg_single, width, height,
+                      xs, ys, xt, yt, SRC_WIDTH, TRG_PITCH, depth, &viewport);
+
+    video_render_thread_set_count(bands);
+    video_render_main(&config, src_buffer, trg_bands, width, height,
+                      xs, ys, xt, yt, SRC_WIDTH, TRG_PITCH, depth, &viewport);
+
+    return memcmp(trg_single, trg_bands, TRG_PITCH * TRG_HEIGHT) != 0;
+}
+
+static int failures = 0;
+static int runs = 0;
+
+static void check(int m, int depth, int bands, int width, int height,
+                  int xs, int ys, int xt, int yt)
+{
+    runs++;
+    if (render_compare(bands, depth, width, height * modes[m].scale,
+                       xs, ys, xt, yt)) {
+        failures++;
+        printf("%s, %d bpp, filter %d, scale2x %d, doublescan %d, crt %d, "
+               "%d bands, lines %u-%u, %dx%d at %d,%d to %d,%d differs\n",
+               modes[m].name, depth, config.filter, config.scale2x,
+               config.doublescan, viewport.crt_type, bands,
+               viewport.first_line, viewport.last_line,
+               width, height, xs, ys, xt, yt);
+    }
+}
+
+/* Move the viewport's first and last line across the line where the first
+   band border falls, for a frame of `lines' source lines.  This follows the
+   split in video_render_thread_run(), which has bands of at least 16 lines
+   and starts 2x4 bands on even lines, numbered from half the first line.  */
+static void check_band_borders(int m, int bands, int lines, int ys)
+{
+    int count, border, offset;
+
+    count = bands < lines / 16 ? bands : lines / 16;
+    if (modes[m].scale == 4) {
+        border = ys / 2 + ((lines / count) & ~1);
+    } else {
+        border = ys + lines / count;
+    }
+
+    for (offset = -4; offset <= 4; offset++) {
+        viewport.first_line = (unsigned int)(border + offset);
+        viewport.last_line = (unsigned int)(ys + lines + 8);
+        check(m, 32, bands, 200, lines, 8, ys, 0, 0);
+
+        viewport.first_line = 0;
+        viewport.last_line = (unsigned int)(border + offset);
+        check(m, 32, bands, 200, lines, 8, ys, 0, 0);
+    }
+}
+
+static void render_frame(uint8_t *trg, int m, int depth)
+{
+    const int *geo = geometries[0];
+
+    video_render_main(&config, src_buffer, trg, geo[6], geo[7] * modes[m].scale,
+                      geo[2], geo[3], geo[4], geo[5], SRC_WIDTH, TRG_PITCH,
+                      depth, &viewport);
+}
+
+/* Render frames for BENCH_TIME seconds and return the frames per second.  */
+static double bench(int m, int depth)
+{
+    clock_t start, now;
+    long frames = 0;
+
+    start = clock();
+    do {
+        render_frame(trg_bands, m, depth);
+        frames++;
+        now = clock();
+    } while (now - start < (clock_t)(BENCH_TIME * CLOCKS_PER_SEC));
+
+    return (double)frames * CLOCKS_PER_SEC / (double)(now - start);
+}
+
+static void check_kernels(void)
+{
+    int best = video_render_kernel_get();
+    int m, d, k, differs;
+
+    viewport.crt_type = 1;
+    viewport.first_line = (unsigned int)geometries[0][0];
+    viewport.last_line = (unsigned int)geometries[0][1];
+    config.filter = VIDEO_FILTER_CRT;
+    config.scale2x = 0;
+    config.doublescan = 1;
+    video_color_update_palette(&canvas);
+    video_render_thread_set_count(0);
+
+    printf("mode      bpp");
+    for (k = 0; k < VIDEO_RENDER_KERNEL_NUM; k++) {
+        if (video_render_kernel_available(k)) {
+            printf("  %7s", video_render_kernel_name(k));
+        }
+    }
+    printf("   (frames/s)\n");
+
+    for (m = 0; m < (int)(sizeof(modes) / sizeof(modes[0])); m++) {
+        config.rendermode = modes[m].mode;
+        for (d = 0; d < (int)(sizeof(kernel_depths) / sizeof(kernel_depths[0])); d++) {
+            memset(trg_single, 0x5a, TRG_PITCH * TRG_HEIGHT);
+            video_render_kernel_set(VIDEO_RENDER_KERNEL_SCALAR);
+            render_frame(trg_single, m, kernel_depths[d]);
+
+            differs = 0;
+            printf("%-8s  %3d", modes[m].name, kernel_depths[d]);
+            for (k = 0; k < VIDEO_RENDER_KERNEL_NUM; k++) {
+                if (video_render_kernel_set(k) < 0) {
+                    continue;
+                }
+                runs++;
+                memset(trg_bands, 0x5a, TRG_PITCH * TRG_HEIGHT);
+                render_frame(trg_bands, m, kernel_depths[d]);
+                if (memcmp(trg_single, trg_bands, TRG_PITCH * TRG_HEIGHT) != 0) {
+                    failures++;
+                    differs |= 1 << k;
+                }
+                printf("  %7.0f", bench(m, kernel_depths[d]));
+            }
+            printf("\n");
+
+            for (k = 0; k < VIDEO_RENDER_KERNEL_NUM; k++) {
+                if (differs & (1 << k)) {
+                    printf("%s, %d bpp, %s kernel differs from the scalar one\n",
+                           modes[m].name, kernel_depths[d], video_render_kernel_name(k));
+                }
+            }
+        }
+    }
+
+    video_render_kernel_set(best);
+}
+
+int main(void)
+{
+    unsigned int i;
+    int m, d, b, g, filter, scale2x, doublescan, crt, ys;
+
+    trg_single = lib_malloc(TRG_PITCH * TRG_HEIGHT);
+    trg_bands = lib_malloc(TRG_PITCH * TRG_HEIGHT);
+
+    srand(1);
+    for (i = 0; i < sizeof(src_buffer); i++) {
+        src_buffer[i] = (uint8_t)(rand() & 15);
+    }
+
+    video_render_initconfig(&config);
+    config.video_resources.color_saturation = 1000;
+    config.video_resources.color_contrast = 1000;
+    config.video_resources.color_brightness = 1000;
+    config.video_resources.color_gamma = 2200;
+    config.video_resources.color_tint = 1000;
+    config.video_resources.pal_scanlineshade = 667;
+    config.video_resources.pal_blur = 500;
+    config.video_resources.pal_oddlines_phase = 1250;
+    config.video_resources.pal_oddlines_offset = 750;
+    for (i = 0; i < 256; i++) {
+        config.color_tables.physical_colors[i] = (uint32_t)rand() * 2654435761U;
+    }
+    /* the masks of a 32 bit target, without them the RGB modes only give
+       black pixels */
+    for (i = 0; i < 256; i++) {
+        video_render_setrawrgb(i, i << 16, i << 8, i);
+    }
+    video_render_setrawalpha(0xff000000);
+
+    canvas.videoconfig = &config;
+    canvas.viewport = &viewport;
+    video_color_palette_internal(&canvas, &cbm_palette);
+
+    video_render_1x2_init();
+    video_render_2x2_init();
+    video_render_pal_init();
+    video_render_crt_init();
+
+    for (crt = 0; crt < 2; crt++) {
+        viewport.crt_type = crt;
+        for (filter = 0; filter < 2; filter++) {
+            config.filter = filter ? VIDEO_FILTER_CRT : VIDEO_FILTER_NONE;
+            if (video_color_update_palette(&canvas) < 0) {
+                printf("Cannot calculate the color tables.\n");
+                return 1;
+            }
+            for (scale2x = 0; scale2x < 2; scale2x++) {
+                config.scale2x = scale2x;
+                for (doublescan = 0; doublescan < 2; doublescan++) {
+                    config.doublescan = doublescan;
+                    for (m = 0; m < (int)(sizeof(modes) / sizeof(modes[0])); m++) {
+                        config.rendermode = modes[m].mode;
+
+                        for (d = 0; d < (int)(sizeof(depths) / sizeof(depths[0])); d++) {
+                            for (g = 0; g < (int)(sizeof(geometries) / sizeof(geometries[0])); g++) {
+                                const int *geo = geometries[g];
+
+                                if (geo[5] + geo[7] * modes[m].scale > TRG_HEIGHT) {
+                                    continue;
+                                }
+                                viewport.first_line = (unsigned int)geo[0];
+                                viewport.last_line = (unsigned int)geo[1];
+                                check(m, depths[d], 7, geo[6], geo[7],
+                                      geo[2], geo[3], geo[4], geo[5]);
+                            }
+                        }
+
+                        for (b = 0; b < (int)(sizeof(band_counts) / sizeof(band_counts[0])); b++) {
+                            for (ys = 20; ys < 22; ys++) {
+                                check_band_borders(m, band_counts[b], 96, ys);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    check_kernels();
+
+    video_render_thread_shutdown();
+    lib_free(trg_single);
+    lib_free(trg_bands);
+
+    printf("%d of %d renders identical.\n", runs - failures, runs);
+    return failures != 0;
+}
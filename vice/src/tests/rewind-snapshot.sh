@@ -0,0 +1,49 @@
+#!/bin/sh
+
+#
+# rewind-snapshot.sh - Time the machine snapshots of the rewind history.
+#
+# This file is part of VICE, the Versatile Commodore Emulator.
+# See README for copyright notice.
+#
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation; either version 2 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software
+#  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+#  02111-1307  USA.
+# x64sc with a 1541 captures the machine for the rewind history every frame.
+# With RewindVerify each capture is restored and captured again, so every
+# frame times one machine_write_snapshot_stream() and one
+# machine_read_snapshot_stream() of the whole machine.  The average times are
+# logged at exit and printed here.  The test fails when no snapshot could be
+# written or read back; a restored state that does not capture the same is
+# reported, but the snapshot modules do not all restore every detail.
+
+. "$srcdir/machine-test.sh"
+
+emu_setup x64sc C64 rewind-snapshot
+
+emu_run rewind.vsf -warp -rewind -rewindinterval 1 -rewindverify \
+    -limitcycles 8000000
+
+log="$workdir/rewind.vsf.log"
+sed -n 's/^Rewind: //p' "$log"
+
+if grep "snapshots written" "$log" > /dev/null \
+    && grep "snapshots read" "$log" > /dev/null; then
+    :
+else
+    echo "No machine snapshots timed, see $log"
+    exit 1
+fi
+
+emu_done
@@ -0,0 +1,216 @@
+/*
+ * sid-mix.c - Check the SID mixing kernels and time the mixing of 1-8 SIDs.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* The vector kernels of sid-mix.c must give the same samples as the scalar
+   code: sid_mix_buffer() as sound_audio_mix() and sid_mix_scale() as the
+   rounded down and clipped product.  Mixing buffers at full volume one
+   after the other must give exactly what the old hand written cases gave.
+
+   Then the mixing of 1 to 8 SID buffers into a stereo fragment is timed,
+   once with the default routing and once with every SID panned, and the
+   output samples per second are printed.  The emulator mixes at most
+   SOUND_SIDS_MAX SIDs; the rest show how the kernels scale.  */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sid-mix.h"
+#include "sound.h"
+#include "types.h"
+
+/* Samples in a fragment, a PAL frame at 44100 Hz.  */
+#define FRAGMENT    882
+
+#define SIDS_MAX    8
+
+/* Seconds to time each setup for.  */
+#define BENCH_TIME  0.1
+
+static int16_t chipbuf[SIDS_MAX][FRAGMENT];
+static int16_t chanbuf[2][FRAGMENT];
+static int16_t scratch[FRAGMENT];
+
+static int failures = 0;
+
+static int16_t random_sample(void)
+{
+    switch (rand() & 7) {
+        case 0:
+            return 32767;
+        case 1:
+            return -32768;
+        case 2:
+            return (int16_t)((rand() & 31) - 16);
+        default:
+            return (int16_t)((rand() & 0xffff) - 0x8000);
+    }
+}
+
+static void check_mix_buffer(void)
+{
+    static int16_t a[FRAGMENT], b[FRAGMENT], dst[FRAGMENT];
+    int i, run;
+
+    for (run = 0; run < 2000; run++) {
+        for (i = 0; i < FRAGMENT; i++) {
+            a[i] = random_sample();
+            b[i] = random_sample();
+        }
+        memcpy(dst, a, sizeof(dst));
+        /* odd lengths leave a tail for the scalar code */
+        sid_mix_buffer(dst, b, FRAGMENT - (run & 15));
+        for (i = 0; i < FRAGMENT - (run & 15); i++) {
+            if (dst[i] != sound_audio_mix(a[i], b[i])) {
+                printf("sid_mix_buffer(): %d + %d gives %d instead of %d\n",
+                       a[i], b[i], dst[i], sound_audio_mix(a[i], b[i]));
+                failures++;
+                return;
+            }
+        }
+    }
+}
+
+static void check_mix_scale(void)
+{
+    static const int gains[] = {
+        0, 1, 100, 128, 255, 256, 257, 384, 512, 1000, 1024
+    };
+    static int16_t src[0x10000], dst[0x10000];
+    int i, g, sample;
+
+    for (i = 0; i < 0x10000; i++) {
+        src[i] = (int16_t)(i - 0x8000);
+    }
+    for (g = 0; g < (int)(sizeof(gains) / sizeof(gains[0])); g++) {
+        sid_mix_scale(dst, src, 0x10000 - g, gains[g]);
+        for (i = 0; i < 0x10000 - g; i++) {
+            sample = (src[i] * gains[g]) >> 8;
+            if (sample > 32767) {
+                sample = 32767;
+            } else if (sample < -32768) {
+                sample = -32768;
+            }
+            if (dst[i] != sample) {
+                printf("sid_mix_scale(): %d * %d gives %d instead of %d\n",
+                       src[i], gains[g], dst[i], sample);
+                failures++;
+                break;
+            }
+        }
+    }
+}
+
+/* Full volume buffers are mixed in order with sound_audio_mix().  */
+static void check_mix_channel(void)
+{
+    int16_t *src[SIDS_MAX];
+    int gain[SIDS_MAX];
+    int16_t expect;
+    int i, n, chip;
+
+    for (chip = 0; chip < SIDS_MAX; chip++) {
+        src[chip] = chipbuf[chip];
+        gain[chip] = SID_MIX_UNITY;
+    }
+
+    for (n = 1; n <= SIDS_MAX; n++) {
+        sid_mix_channel(chanbuf[0], src, gain, n, FRAGMENT, scratch);
+        for (i = 0; i < FRAGMENT; i++) {
+            expect = chipbuf[0][i];
+            for (chip = 1; chip < n; chip++) {
+                expect = sound_audio_mix(expect, chipbuf[chip][i]);
+            }
+            if (chanbuf[0][i] != expect) {
+                printf("sid_mix_channel(): %d SIDs differ at sample %d\n",
+                       n, i);
+                failures++;
+                break;
+            }
+        }
+    }
+}
+
+/* Mix `n' SIDs to a stereo fragment for BENCH_TIME seconds.  With
+   `panned' every SID is on both channels at less than full volume,
+   otherwise the SIDs alternate between left and right.  */
+static double bench(int n, int panned)
+{
+    int16_t *src[SIDS_MAX];
+    int gain[2][SIDS_MAX];
+    clock_t start, now;
+    long fragments = 0;
+    int chip, channel;
+
+    for (chip = 0; chip < n; chip++) {
+        src[chip] = chipbuf[chip];
+        if (panned) {
+            gain[0][chip] = 64 + (chip * 128) / SIDS_MAX;
+            gain[1][chip] = 192 - (chip * 128) / SIDS_MAX;
+        } else {
+            gain[0][chip] = (chip & 1) ? 0 : SID_MIX_UNITY;
+            gain[1][chip] = (chip & 1) ? SID_MIX_UNITY : 0;
+        }
+    }
+
+    start = clock();
+    do {
+        for (channel = 0; channel < 2; channel++) {
+            sid_mix_channel(chanbuf[channel], src, gain[channel], n,
+                            FRAGMENT, scratch);
+        }
+        fragments++;
+        now = clock();
+    } while (now - start < (clock_t)(BENCH_TIME * CLOCKS_PER_SEC));
+
+    return (double)fragments * FRAGMENT * CLOCKS_PER_SEC / (double)(now - start);
+}
+
+int main(void)
+{
+    int i, n;
+
+    srand(1);
+    for (n = 0; n < SIDS_MAX; n++) {
+        for (i = 0; i < FRAGMENT; i++) {
+            chipbuf[n][i] = random_sample();
+        }
+    }
+
+    check_mix_buffer();
+    check_mix_scale();
+    check_mix_channel();
+
+    printf("SIDs   default   panned   (million samples/s)\n");
+    for (n = 1; n <= SIDS_MAX; n++) {
+        printf("%4d   %7.1f   %6.1f\n", n, bench(n, 0) / 1e6, bench(n, 1) / 1e6);
+    }
+
+    if (failures) {
+        printf("%d kernel checks failed.\n", failures);
+    }
+    return failures != 0;
+}
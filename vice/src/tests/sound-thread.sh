@@ -0,0 +1,115 @@
+#!/bin/sh
+
+#
+# sound-thread.sh - Compare SoundThread with rendering on the emulation thread.
+#
+# This file is part of VICE, the Versatile Commodore Emulator.
+# See README for copyright notice.
+#
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation; either version 2 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software
+#  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+#  02111-1307  USA.
+# x64sc with FastSID.  The C64 program reads OSC3 and ENV3 while it changes
+# the frequency of voice 3, then reads OSC3 of the noise waveform for a few
+# frames without writing to the SID.  Last it reads back the value of a write
+# as it fades from the data bus.  FastSID computes all of these from the cycle
+# of the access, so the values stored in memory and the snapshots must be
+# identical with and without SoundThread.
+#
+# Then x64sc with a 1541 and the drive sound.  The C64 program sends "I" to
+# the drive, which has no disk, so it turns on the motor and moves the head
+# around.  The drive sound is written to a WAV file.  The sound thread is a
+# frame behind, so the samples are compared from the first sound on.
+
+. "$srcdir/machine-test.sh"
+
+emu_setup x64sc C64 sound-thread
+
+{
+    # 10 SYS2061
+    printf '\001\010\013\010\012\000\236\062\060\066\061\000\000\000'
+    # SEI : voice 3 frequency $FFFF, volume 15, AD $00, SR $F0, sawtooth
+    printf '\170\251\377\215\016\324\215\017\324\251\017\215\030\324'
+    printf '\251\000\215\023\324\251\360\215\024\324\251\041\215\022\324'
+    # LDX #0
+    printf '\242\000'
+    # OSC3 to $C000,X, ENV3 to $C100,X, X to the frequency low byte
+    printf '\255\033\324\235\000\300\255\034\324\235\000\301\216\016\324'
+    printf '\350\320\356'
+    # noise, OSC3 to $C200-$CFFF
+    printf '\251\201\215\022\324'
+    printf '\255\033\324\235\000\302\350\320\367'
+    printf '\356\110\010\255\110\010\311\320\320\355'
+    # $FF to $D41F, then the fading bus value of $D41D to $0900-$090F
+    printf '\251\377\215\037\324'
+    for i in 0 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15; do
+        printf "$(printf '\\255\\035\\324\\215\\%03o\\011' $i)"
+    done
+    # loop: INC $D020 : JMP loop
+    printf '\356\040\320\114\273\010'
+} > "$workdir/osc3.prg"
+
+set -- -sidenginemodel 0 -autostartprgmode 1 -autostart osc3.prg \
+    -limitcycles 4000000
+
+emu_run inline.vsf +soundthread "$@"
+emu_run thread.vsf -soundthread "$@"
+emu_compare inline.vsf thread.vsf
+
+{
+    # 10 SYS2061
+    printf '\001\010\013\010\012\000\236\062\060\066\061\000\000\000'
+    # OPEN 15,8,15,"I"
+    printf '\251\017\242\010\240\017\040\272\377'
+    printf '\251\001\242\050\240\010\040\275\377'
+    printf '\040\300\377'
+    # loop: INC $D020 : JMP loop
+    printf '\356\040\320\114\042\010'
+    # "I"
+    printf '\111'
+} > "$workdir/init.prg"
+
+# The 16-bit samples of a WAV file from the first one that is not 0, one
+# per line.
+wav_samples()
+{
+    od -An -v -td2 "$workdir/$1" | awk '{
+        for (i = 1; i <= NF; i++) {
+            n++
+            if (n > 22 && (s || $i != 0)) {
+                s = 1
+                print $i
+            }
+        }
+    }'
+}
+
+set -- -truedrive -drive8type 1541 -drivesound -soundrate 44100 \
+    -sounddev wav -autostartprgmode 1 -autostart init.prg \
+    -limitcycles 6000000
+
+emu_run drive-inline.vsf +soundthread -soundarg inline.wav "$@"
+emu_run drive-thread.vsf -soundthread -soundarg thread.wav "$@"
+emu_compare drive-inline.vsf drive-thread.vsf
+
+wav_samples inline.wav > "$workdir/inline.txt"
+wav_samples thread.wav | head -n `wc -l < "$workdir/inline.txt"` \
+    > "$workdir/thread.txt"
+if test ! -s "$workdir/inline.txt"; then
+    echo "No drive sound in inline.wav, see $workdir"
+    exit 1
+fi
+emu_compare inline.txt thread.txt
+
+emu_done
@@ -0,0 +1,68 @@
+#!/bin/sh
+
+#
+# vicii-skip.sh - Compare skipped frames of x64sc with frames drawn in full.
+#
+# This file is part of VICE, the Versatile Commodore Emulator.
+# See README for copyright notice.
+#
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation; either version 2 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software
+#  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+#  02111-1307  USA.
+# x64sc in warp mode draws the frames it skips only as far as the sprite
+# collision registers need them, unless a screenshot is taken at exit.  The
+# C64 program moves eight overlapping sprites over a screen full of
+# characters, toggles multicolor text mode and stores $D01E and $D01F once a
+# frame.  Then it blanks the screen, so the line buffer in the snapshot holds
+# the border color whichever frame the run ends in.  The values stored in
+# memory and the snapshots must be identical with and without the reduced
+# drawing.
+
+. "$srcdir/machine-test.sh"
+
+emu_setup x64sc C64 vicii-skip
+
+{
+    # 10 SYS2061
+    printf '\001\010\013\010\012\000\236\062\060\066\061\000\000\000'
+    # SEI, fill the screen and the sprite data
+    printf '\170\242\000\212\235\000\004\235\000\005\235\000\006\235\000\007'
+    printf '\235\000\040\350\320\355'
+    # sprite pointers and positions
+    printf '\242\007\212\051\003\011\200\235\370\007\212\012\250\012\012'
+    printf '\012\151\050\231\000\320\212\012\012\012\151\074\231\001\320'
+    printf '\312\020\341'
+    # enable, multicolor, priority, expansion
+    printf '\251\377\215\025\320\251\360\215\034\320\251\125\215\033\320'
+    printf '\251\063\215\035\320\251\017\215\027\320'
+    # result pointer
+    printf '\251\000\205\373\251\300\205\374\240\000'
+    # frame: wait for line 250, store $D01E and $D01F
+    printf '\255\022\320\311\372\320\371\255\036\320\221\373\310\255\037'
+    printf '\320\221\373\310\320\002\346\374'
+    # move sprites, toggle multicolor text
+    printf '\356\000\320\356\004\320\356\004\320\316\012\320\356\003\320'
+    printf '\255\026\320\111\020\215\026\320\255\022\320\311\372\360\371'
+    printf '\245\374\311\304\320\305'
+    # sprites off, blank the screen, loop: JMP loop
+    printf '\251\000\215\025\320\251\013\215\021\320\114\254\010'
+} > "$workdir/sprites.prg"
+
+set -- -warp -autostartprgmode 1 -autostart sprites.prg -limitcycles 16000000
+
+emu_run skip.vsf "$@"
+emu_run full.vsf -exitscreenshot full.png "$@"
+emu_compare skip.vsf full.vsf
+
+emu_done
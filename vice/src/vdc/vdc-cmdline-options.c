@@ -54,6 +54,12 @@ static const cmdline_option_t cmdline_options[] =
     { "-VDCRevision", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
       NULL, NULL, "VDCRevision", NULL,
       "<number>", "Set VDC revision (0..2)" },
+    { "-VDCthread", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "VDCThread", (resource_value_t)1,
+      NULL, "Draw the VDC screen on a separate thread" },
+    { "+VDCthread", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "VDCThread", (resource_value_t)0,
+      NULL, "Draw the VDC screen on the emulation thread" },
     CMDLINE_LIST_END
 };
 
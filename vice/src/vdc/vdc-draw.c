@@ -41,6 +41,10 @@
 #include "vdc.h"
 #include "vdctypes.h"
 
+/* The VDC state the drawing functions read: `vdc' itself, or the copy the
+   render thread draws from (see vdc-thread.c).  */
+static vdc_t *vd = &vdc;
+
 /* The following tables are used to speed up the drawing.  We do not use
    multi-dimensional arrays as we can optimize better this way...  */
 
@@ -77,8 +81,8 @@ static const uint8_t semigfxmask[16] = {
 static void draw_std_background(unsigned int start_pixel,
                                 unsigned int end_pixel)
 {
-    memset(vdc.raster.draw_buffer_ptr + start_pixel,
-           vdc.raster.idle_background_color,
+    memset(vd->raster.draw_buffer_ptr + start_pixel,
+           vd->raster.idle_background_color,
            end_pixel - start_pixel + 1);
 }
 */
@@ -136,32 +140,32 @@ index = where in the screen memory we are, to check against the cursor */
     uint8_t data;
     if (a & VDC_ALTCHARSET_ATTR) {
         /* swich to alternate charset if appropriate attribute bit set */
-        char_mem += 0x100 * vdc.bytes_per_char; /* 0x1000 or 0x2000, depending on character height */
+        char_mem += 0x100 * vd->bytes_per_char; /* 0x1000 or 0x2000, depending on character height */
     }
 
-    if (l > (signed)vdc.regs[23]) {
+    if (l > (signed)vd->regs[23]) {
         /* Return nothing if > Vertical Character Size */
         data = 0x00;
     } else {
         /* mask against r[22] - pixels per char mask */
-        data = char_mem[(c * bytes_per_char) + l] & mask[vdc.regs[22] & 0x0F];
+        data = char_mem[(c * bytes_per_char) + l] & mask[vd->regs[22] & 0x0F];
     }
 
-    if ((l == (signed)vdc.regs[29]) && (a & VDC_UNDERLINE_ATTR)) {
+    if ((l == (signed)vd->regs[29]) && (a & VDC_UNDERLINE_ATTR)) {
         /* TODO - figure out if the pixels per char applies to the underline */
         data = 0xFF;
     }
 
-    if ((a & VDC_FLASH_ATTR) && (vdc.attribute_blink)) {
+    if ((a & VDC_FLASH_ATTR) && (vd->attribute_blink)) {
         /* underline byte also blinks! */
         data = 0x00;
     }
 
-    if (vdc.regs[25] & 0x20) {
+    if (vd->regs[25] & 0x20) {
         /* Semi-graphics mode */
-        if (data & semigfxtest[vdc.regs[22] & 0x0F]) {
+        if (data & semigfxtest[vd->regs[22] & 0x0F]) {
             /* if the far right pixel is on.. */
-            data |= semigfxmask[vdc.regs[22] & 0x0F];
+            data |= semigfxmask[vd->regs[22] & 0x0F];
             /* .. mask the rest of the right hand side on */
         }
     }
@@ -171,7 +175,7 @@ index = where in the screen memory we are, to check against the cursor */
         data ^= 0xFF;
     }
 
-    if (vdc.regs[24] & 0x40) {
+    if (vd->regs[24] & 0x40) {
         /* Reverse screen bit */
         data ^= 0xFF;
     }
@@ -179,12 +183,12 @@ index = where in the screen memory we are, to check against the cursor */
     /* on a 80x25 text screen (2000 characters) this is only true for 1 character. */
     if (curpos == index) {
         /* invert anything at all? */
-        if ((vdc.frame_counter | 1) & crsrblink[(vdc.regs[10] >> 5) & 3]) {
+        if ((vd->frame_counter | 1) & crsrblink[(vd->regs[10] >> 5) & 3]) {
             /* invert current byte of the character? */
             if (
-            ((l >= (vdc.regs[10] & 0x1F)) && (l < (vdc.regs[11] & 0x1F)))
-            || ((l == (vdc.regs[10] & 0x1F)) && (l == (vdc.regs[11] & 0x1F)))
-            || (((vdc.regs[10] & 0x1F) > (vdc.regs[11] & 0x1F)) && ((l >= (vdc.regs[10] & 0x1F)) || (l < (vdc.regs[11] & 0x1F))))
+            ((l >= (vd->regs[10] & 0x1F)) && (l < (vd->regs[11] & 0x1F)))
+            || ((l == (vd->regs[10] & 0x1F)) && (l == (vd->regs[11] & 0x1F)))
+            || (((vd->regs[10] & 0x1F) > (vd->regs[11] & 0x1F)) && ((l >= (vd->regs[10] & 0x1F)) || (l < (vd->regs[11] & 0x1F))))
             ) {
                 /* The VDC cursor reverses the char */
                 data ^= 0xFF;
@@ -381,18 +385,18 @@ static int get_std_text(raster_cache_t *cache, unsigned int *xs, unsigned int *x
     /* r=return value, cursor_pos=the cursor position in screen memory so that it can be drawn correctly */
     int r, cursor_pos;
 
-    cursor_pos = vdc.crsrpos - vdc.screen_adr - vdc.mem_counter;
+    cursor_pos = vd->crsrpos - vd->screen_adr - vd->mem_counter;
 
-    if (vdc.regs[25] & 0x40) {
+    if (vd->regs[25] & 0x40) {
         /* attribute mode */
         /* get the character definition data, with any attributes applied from attribute memory, into the raster cache foreground_data */
         r = cache_data_fill_attr_text(cache->foreground_data,
-                                      vdc.ram + vdc.screen_adr + vdc.mem_counter,
-                                      vdc.ram + vdc.attribute_adr + vdc.mem_counter,
-                                      vdc.ram + vdc.chargen_adr,
-                                      vdc.bytes_per_char,
-                                      vdc.screen_text_cols,
-                                      vdc.raster.ycounter,
+                                      vd->ram + vd->screen_adr + vd->mem_counter,
+                                      vd->ram + vd->attribute_adr + vd->mem_counter,
+                                      vd->ram + vd->chargen_adr,
+                                      vd->bytes_per_char,
+                                      vd->screen_text_cols,
+                                      vd->raster.ycounter,
                                       xs, xe,
                                       rr,
                                       0,
@@ -400,20 +404,20 @@ static int get_std_text(raster_cache_t *cache, unsigned int *xs, unsigned int *x
                                       cursor_pos);
         /* fill the raster cache color_data_1 with the attributes from vdc memory */
         r |= raster_cache_data_fill(cache->color_data_1,
-                                    vdc.ram + vdc.attribute_adr + vdc.mem_counter,
-                                    vdc.screen_text_cols,
+                                    vd->ram + vd->attribute_adr + vd->mem_counter,
+                                    vd->screen_text_cols,
                                     xs, xe,
                                     rr);
     } else {
         /* monochrome mode - attributes from register 26 */
         /* get the character definition data, fixed attributes (only background colour, which doesn't actually do anything to these functions!) */
         r = cache_data_fill_attr_text_const(cache->foreground_data,
-                                            vdc.ram + vdc.screen_adr + vdc.mem_counter,
-                                            (uint8_t)(vdc.regs[26] & 0x0f),
-                                            vdc.ram + vdc.chargen_adr,
-                                            vdc.bytes_per_char,
-                                            (int)vdc.screen_text_cols,
-                                            vdc.raster.ycounter,
+                                            vd->ram + vd->screen_adr + vd->mem_counter,
+                                            (uint8_t)(vd->regs[26] & 0x0f),
+                                            vd->ram + vd->chargen_adr,
+                                            vd->bytes_per_char,
+                                            (int)vd->screen_text_cols,
+                                            vd->raster.ycounter,
                                             xs, xe,
                                             rr,
                                             0,
@@ -421,8 +425,8 @@ static int get_std_text(raster_cache_t *cache, unsigned int *xs, unsigned int *x
                                             cursor_pos);
         /* fill the raster cache color_data_1 with the foreground colour from vdc reg 26 */
         r |= raster_cache_data_fill_const(cache->color_data_1,
-                                          (uint8_t)(vdc.regs[26] >> 4),
-                                          (int)vdc.screen_text_cols,
+                                          (uint8_t)(vd->regs[26] >> 4),
+                                          (int)vd->screen_text_cols,
                                           xs, xe,
                                           rr);
     }
@@ -440,28 +444,28 @@ static void draw_std_text_cached(raster_cache_t *cache, unsigned int xs,
     unsigned int i, charwidth;
     int icsi = -1;  /* Inter Character Spacing Index - used as a combo flag/index as to whether there is any intercharacter gap to render */
     
-    if (vdc.regs[25] & 0x10) { /* double pixel a.k.a 40column mode */
-        charwidth = 2 * (vdc.regs[22] >> 4);
+    if (vd->regs[25] & 0x10) { /* double pixel a.k.a 40column mode */
+        charwidth = 2 * (vd->regs[22] >> 4);
         if (charwidth > 16) {   /* Is there inter character spacing to render? */
             icsi = charwidth / 2 - 8;
         }
     } else { /* 80 column mode */
-        charwidth = 1 + (vdc.regs[22] >> 4);
+        charwidth = 1 + (vd->regs[22] >> 4);
         if (charwidth > 8) {    /* Is there inter character spacing to render? */
             icsi = charwidth - 8;
         }
     }
-    p = vdc.raster.draw_buffer_ptr
-        + vdc.border_width
-        + ((vdc.regs[25] & 0x10) ? 2 : 0)
-        + vdc.xsmooth * ((vdc.regs[25] & 0x10) ? 2 : 1)
-        - (vdc.regs[22] >> 4) * ((vdc.regs[25] & 0x10) ? 2 : 1)
+    p = vd->raster.draw_buffer_ptr
+        + vd->border_width
+        + ((vd->regs[25] & 0x10) ? 2 : 0)
+        + vd->xsmooth * ((vd->regs[25] & 0x10) ? 2 : 1)
+        - (vd->regs[22] >> 4) * ((vd->regs[25] & 0x10) ? 2 : 1)
         + xs * charwidth;
-    table_ptr = hr_table + ((vdc.regs[26] & 0x0f) << 4);
-    pdl_ptr = pdl_table + ((vdc.regs[26] & 0x0f) << 4);
-    pdh_ptr = pdh_table + ((vdc.regs[26] & 0x0f) << 4);
+    table_ptr = hr_table + ((vd->regs[26] & 0x0f) << 4);
+    pdl_ptr = pdl_table + ((vd->regs[26] & 0x0f) << 4);
+    pdh_ptr = pdh_table + ((vd->regs[26] & 0x0f) << 4);
 
-    if (vdc.regs[25] & 0x10) { /* double pixel mode */
+    if (vd->regs[25] & 0x10) { /* double pixel mode */
         for (i = xs; i <= (unsigned int)xe; i++, p += charwidth) {
             uint32_t *pdwl = pdl_ptr + ((cache->color_data_1[i] & 0x0f) << 8);
             uint32_t *pdwh = pdh_ptr + ((cache->color_data_1[i] & 0x0f) << 8);
@@ -472,7 +476,7 @@ static void draw_std_text_cached(raster_cache_t *cache, unsigned int xs,
             *((uint32_t *)p + 3) = *(pdwl + (d & 0x0f));
             if (icsi >= 0) {    /* if there's inter character spacing, then render it */
                 q = p + 16;
-                if ((vdc.regs[25] & 0x20) && (d & semigfxtest[vdc.regs[22] & 0x0F])) { /* If semi-graphics mode and the rightmost active bit is set */
+                if ((vd->regs[25] & 0x20) && (d & semigfxtest[vd->regs[22] & 0x0F])) { /* If semi-graphics mode and the rightmost active bit is set */
                     d = mask[icsi];   /* .. figure out how big it is based on the width of the gap */
                 } else { /* otherwise just draw the background */
                     d = 0;
@@ -480,7 +484,7 @@ static void draw_std_text_cached(raster_cache_t *cache, unsigned int xs,
                 if (cache->color_data_1[i] & VDC_REVERSE_ATTR) { /* reverse if the reverse attribute is set for this char */
                     d ^= 0xff;
                 }
-                if (vdc.regs[24] & VDC_REVERSE_ATTR) {  /* whole screen reverse */
+                if (vd->regs[24] & VDC_REVERSE_ATTR) {  /* whole screen reverse */
                     d ^= 0xff;
                 }
                 *((uint32_t *)q) = *(pdwh + (d >> 4));
@@ -497,7 +501,7 @@ static void draw_std_text_cached(raster_cache_t *cache, unsigned int xs,
             *((uint32_t *)p + 1) = *(ptr + (d & 0x0f));
             if (icsi >= 0) {    /* if there's inter character spacing, then render it */
                 q = p + 8;
-                if ((vdc.regs[25] & 0x20) && (d & semigfxtest[vdc.regs[22] & 0x0F])) { /* If semi-graphics mode and the rightmost active bit is set */
+                if ((vd->regs[25] & 0x20) && (d & semigfxtest[vd->regs[22] & 0x0F])) { /* If semi-graphics mode and the rightmost active bit is set */
                     d = mask[icsi];   /* .. figure out how big it is based on the width of the gap */
                 } else { /* otherwise just draw the background */
                     d = 0;
@@ -505,7 +509,7 @@ static void draw_std_text_cached(raster_cache_t *cache, unsigned int xs,
                 if (cache->color_data_1[i] & VDC_REVERSE_ATTR) { /* reverse if the reverse attribute is set for this char */
                     d ^= 0xff;
                 }
-                if (vdc.regs[24] & VDC_REVERSE_ATTR) {  /* whole screen reverse */
+                if (vd->regs[24] & VDC_REVERSE_ATTR) {  /* whole screen reverse */
                     d ^= 0xff;
                 }
                 *((uint32_t *)q) = *(ptr + (d >> 4));
@@ -515,9 +519,9 @@ static void draw_std_text_cached(raster_cache_t *cache, unsigned int xs,
     }
 
     /* fill the last few pixels of the display with bg colour if smooth scroll != 0 - if needed */
-    if (i == vdc.screen_text_cols) {
-        for (i = vdc.xsmooth; i < (unsigned)(vdc.regs[22] >> 4); i++, p++) {
-            *p = (vdc.regs[26] & 0x0f);
+    if (i == vd->screen_text_cols) {
+        for (i = vd->xsmooth; i < (unsigned)(vd->regs[22] >> 4); i++, p++) {
+            *p = (vd->regs[26] & 0x0f);
         }
     }
 }
@@ -525,7 +529,7 @@ static void draw_std_text_cached(raster_cache_t *cache, unsigned int xs,
 static void draw_std_text(void)
 /* raster_modes_draw_line() in raster - draw text mode when cache is not used
    This draws one raster line of text directly into the raster buffer
-   (vdc.raster.draw_buffer_ptr), which is one byte per pixel, based on the VDC
+   (vd->raster.draw_buffer_ptr), which is one byte per pixel, based on the VDC
    screen, attr(ibute) and char(set) ram (which are one byte per 8 pixels */
 {
     uint8_t *p, *q;
@@ -536,64 +540,64 @@ static void draw_std_text(void)
     unsigned int cpos = 0xffff;
     int icsi = -1;  /* Inter Character Spacing Index - used as a combo flag/index as to whether there is any intercharacter gap to render */
     
-    cpos = vdc.crsrpos - vdc.screen_adr - vdc.mem_counter;
+    cpos = vd->crsrpos - vd->screen_adr - vd->mem_counter;
 
-    if(vdc.regs[25] & 0x10) { /* double pixel a.k.a 40column mode */
-        charwidth = 2 * (vdc.regs[22] >> 4);
+    if(vd->regs[25] & 0x10) { /* double pixel a.k.a 40column mode */
+        charwidth = 2 * (vd->regs[22] >> 4);
         if (charwidth > 16) {   /* Is there inter character spacing to render? */
             icsi = charwidth / 2 - 8;
         }
     } else { /* 80 column mode */
-        charwidth = 1 + (vdc.regs[22] >> 4);
+        charwidth = 1 + (vd->regs[22] >> 4);
         if (charwidth > 8) {    /* Is there inter character spacing to render? */
             icsi = charwidth - 8;
         }
     }
     
-    p = vdc.raster.draw_buffer_ptr
-        + vdc.border_width
-        + ((vdc.regs[25] & 0x10) ? 2 : 0)
-        + vdc.xsmooth * ((vdc.regs[25] & 0x10) ? 2 : 1)
-        - (vdc.regs[22] >> 4) * ((vdc.regs[25] & 0x10) ? 2 : 1);
+    p = vd->raster.draw_buffer_ptr
+        + vd->border_width
+        + ((vd->regs[25] & 0x10) ? 2 : 0)
+        + vd->xsmooth * ((vd->regs[25] & 0x10) ? 2 : 1)
+        - (vd->regs[22] >> 4) * ((vd->regs[25] & 0x10) ? 2 : 1);
 
-    attr_ptr = vdc.ram + vdc.attribute_adr + vdc.mem_counter;
-    screen_ptr = vdc.ram + vdc.screen_adr + vdc.mem_counter;
-    char_ptr = vdc.ram + vdc.chargen_adr + vdc.raster.ycounter;
+    attr_ptr = vd->ram + vd->attribute_adr + vd->mem_counter;
+    screen_ptr = vd->ram + vd->screen_adr + vd->mem_counter;
+    char_ptr = vd->ram + vd->chargen_adr + vd->raster.ycounter;
 
-    if (vdc.regs[25] & 0x40) {
+    if (vd->regs[25] & 0x40) {
         /* attribute mode */
         /* regs[26] & 0xf is the background colour */
-        table_ptr = hr_table + ((vdc.regs[26] & 0x0f) << 4);
-        pdl_ptr = pdl_table + ((vdc.regs[26] & 0x0f) << 4);
-        pdh_ptr = pdh_table + ((vdc.regs[26] & 0x0f) << 4);
-        for (i = 0; i < vdc.screen_text_cols; i++, p += charwidth) {
-            if (vdc.raster.ycounter > (signed)vdc.regs[23]) {
+        table_ptr = hr_table + ((vd->regs[26] & 0x0f) << 4);
+        pdl_ptr = pdl_table + ((vd->regs[26] & 0x0f) << 4);
+        pdh_ptr = pdh_table + ((vd->regs[26] & 0x0f) << 4);
+        for (i = 0; i < vd->screen_text_cols; i++, p += charwidth) {
+            if (vd->raster.ycounter > (signed)vd->regs[23]) {
                 /* Return nothing if > Vertical Character Size */
                 d = 0x00;
             } else {
                 d = *(char_ptr
-                  + ((*(attr_ptr + i) & VDC_ALTCHARSET_ATTR) ? 0x100 * vdc.bytes_per_char : 0) /* the offset to the alternate character set is either 0x1000 or 0x2000, depending on the character size (16 or 32) */
-                  + (*(screen_ptr + i) * vdc.bytes_per_char));
+                  + ((*(attr_ptr + i) & VDC_ALTCHARSET_ATTR) ? 0x100 * vd->bytes_per_char : 0) /* the offset to the alternate character set is either 0x1000 or 0x2000, depending on the character size (16 or 32) */
+                  + (*(screen_ptr + i) * vd->bytes_per_char));
             }
             /* mask against r[22] - pixels per char mask */
-            d &= mask[vdc.regs[22] & 0x0F];
+            d &= mask[vd->regs[22] & 0x0F];
                   
             /* set underline if the underline attrib is set for this char */
-            if ((vdc.raster.ycounter == vdc.regs[29]) && (*(attr_ptr + i) & VDC_UNDERLINE_ATTR)) {
+            if ((vd->raster.ycounter == vd->regs[29]) && (*(attr_ptr + i) & VDC_UNDERLINE_ATTR)) {
                 /* TODO - figure out if the pixels per char applies to the underline */
                 d = 0xFF;
             }
 
             /* blink if the blink attribute is set for this char */
-            if (vdc.attribute_blink && (*(attr_ptr + i) & VDC_FLASH_ATTR)) {
+            if (vd->attribute_blink && (*(attr_ptr + i) & VDC_FLASH_ATTR)) {
                 d = 0x00;
             }
 
-            if (vdc.regs[25] & 0x20) {
+            if (vd->regs[25] & 0x20) {
                 /* Semi-graphics mode */
-                if (d & semigfxtest[vdc.regs[22] & 0x0F]) {
+                if (d & semigfxtest[vd->regs[22] & 0x0F]) {
                 /* if the far right pixel is on.. */
-                    d |= semigfxmask[vdc.regs[22] & 0x0F];
+                    d |= semigfxmask[vd->regs[22] & 0x0F];
                     /* .. mask the rest of the right hand side on */
                 }
             }
@@ -604,12 +608,12 @@ static void draw_std_text(void)
             }
 
             if (cpos == i) { /* handle cursor if this is the cursor */
-                if ((vdc.frame_counter | 1) & crsrblink[(vdc.regs[10] >> 5) & 3]) {
+                if ((vd->frame_counter | 1) & crsrblink[(vd->regs[10] >> 5) & 3]) {
                     /* invert current byte of the character if we are within the cursor area */
                     if (
-                    ((vdc.raster.ycounter >= (vdc.regs[10] & 0x1F)) && (vdc.raster.ycounter < (vdc.regs[11] & 0x1F)))
-                    || ((vdc.raster.ycounter == (vdc.regs[10] & 0x1F)) && (vdc.raster.ycounter == (vdc.regs[11] & 0x1F)))
-                    || (((vdc.regs[10] & 0x1F) > (vdc.regs[11] & 0x1F)) && ((vdc.raster.ycounter >= (vdc.regs[10] & 0x1F)) || (vdc.raster.ycounter < (vdc.regs[11] & 0x1F))))
+                    ((vd->raster.ycounter >= (vd->regs[10] & 0x1F)) && (vd->raster.ycounter < (vd->regs[11] & 0x1F)))
+                    || ((vd->raster.ycounter == (vd->regs[10] & 0x1F)) && (vd->raster.ycounter == (vd->regs[11] & 0x1F)))
+                    || (((vd->regs[10] & 0x1F) > (vd->regs[11] & 0x1F)) && ((vd->raster.ycounter >= (vd->regs[10] & 0x1F)) || (vd->raster.ycounter < (vd->regs[11] & 0x1F))))
                     ) {
                         /* The VDC cursor reverses the char */
                         d ^= 0xFF;
@@ -617,12 +621,12 @@ static void draw_std_text(void)
                 }
             }
 
-            if (vdc.regs[24] & VDC_REVERSE_ATTR) { /* whole screen reverse */
+            if (vd->regs[24] & VDC_REVERSE_ATTR) { /* whole screen reverse */
                 d ^= 0xff;
             }
 
             /* actually render the byte into 8 bytes of colour pixels using the lookup tables */
-            if (vdc.regs[25] & 0x10) { /* double pixel mode */
+            if (vd->regs[25] & 0x10) { /* double pixel mode */
                 uint32_t *pdwl = pdl_ptr + ((*(attr_ptr + i) & 0x0f) << 8);
                 uint32_t *pdwh = pdh_ptr + ((*(attr_ptr + i) & 0x0f) << 8);
                 *((uint32_t *)p) = *(pdwh + (d >> 4));
@@ -631,7 +635,7 @@ static void draw_std_text(void)
                 *((uint32_t *)p + 3) = *(pdwl + (d & 0x0f));
                 if (icsi >= 0) {    /* if there's inter character spacing, then render it */
                     q = p + 16;
-                    if ((vdc.regs[25] & 0x20) && (d & semigfxtest[vdc.regs[22] & 0x0F])) { /* If semi-graphics mode and the rightmost active bit is set */
+                    if ((vd->regs[25] & 0x20) && (d & semigfxtest[vd->regs[22] & 0x0F])) { /* If semi-graphics mode and the rightmost active bit is set */
                         d = mask[icsi];   /* .. figure out how big it is based on the width of the gap */
                     } else { /* otherwise just draw the background */
                         d = 0;
@@ -639,7 +643,7 @@ static void draw_std_text(void)
                     if (*(attr_ptr + i) & VDC_REVERSE_ATTR) { /* reverse if the reverse attribute is set for this char */
                         d ^= 0xff;
                     }
-                    if (vdc.regs[24] & VDC_REVERSE_ATTR) {  /* whole screen reverse */
+                    if (vd->regs[24] & VDC_REVERSE_ATTR) {  /* whole screen reverse */
                         d ^= 0xff;
                     }
                     *((uint32_t *)q) = *(pdwh + (d >> 4));
@@ -653,7 +657,7 @@ static void draw_std_text(void)
                 *((uint32_t *)p + 1) = *(ptr + (d & 0x0f));
                 if (icsi >= 0) {    /* if there's inter character spacing, then render it */
                     q = p + 8;
-                    if ((vdc.regs[25] & 0x20) && (d & semigfxtest[vdc.regs[22] & 0x0F])) { /* If semi-graphics mode and the rightmost active bit is set */
+                    if ((vd->regs[25] & 0x20) && (d & semigfxtest[vd->regs[22] & 0x0F])) { /* If semi-graphics mode and the rightmost active bit is set */
                         d = mask[icsi];   /* .. figure out how big it is based on the width of the gap */
                     } else { /* otherwise just draw the background */
                         d = 0;
@@ -661,7 +665,7 @@ static void draw_std_text(void)
                     if (*(attr_ptr + i) & VDC_REVERSE_ATTR) { /* reverse if the reverse attribute is set for this char */
                         d ^= 0xff;
                     }
-                    if (vdc.regs[24] & VDC_REVERSE_ATTR) { /* whole screen reverse */
+                    if (vd->regs[24] & VDC_REVERSE_ATTR) { /* whole screen reverse */
                         d ^= 0xff;
                     }
                     *((uint32_t *)q) = *(ptr + (d >> 4));
@@ -671,31 +675,31 @@ static void draw_std_text(void)
         }
     } else {
         /* monochrome mode - attributes from register 26 */
-        uint32_t *ptr = hr_table + (vdc.regs[26] << 4);
-        uint32_t *pdwl = pdl_table + (vdc.regs[26] << 4);  /* Pointers into the lookup tables */
-        uint32_t *pdwh = pdh_table + (vdc.regs[26] << 4);
-        for (i = 0; i < vdc.screen_text_cols; i++, p += charwidth) {
-            d = *(char_ptr + (*(screen_ptr + i) * vdc.bytes_per_char));
+        uint32_t *ptr = hr_table + (vd->regs[26] << 4);
+        uint32_t *pdwl = pdl_table + (vd->regs[26] << 4);  /* Pointers into the lookup tables */
+        uint32_t *pdwh = pdh_table + (vd->regs[26] << 4);
+        for (i = 0; i < vd->screen_text_cols; i++, p += charwidth) {
+            d = *(char_ptr + (*(screen_ptr + i) * vd->bytes_per_char));
             
             /* mask against r[22] - pixels per char mask */
-            d &= mask[vdc.regs[22] & 0x0F];
+            d &= mask[vd->regs[22] & 0x0F];
 
-            if (vdc.regs[25] & 0x20) {
+            if (vd->regs[25] & 0x20) {
                 /* Semi-graphics mode */
-                if (d & semigfxtest[vdc.regs[22] & 0x0F]) {
+                if (d & semigfxtest[vd->regs[22] & 0x0F]) {
                 /* if the far right pixel is on.. */
-                    d |= semigfxmask[vdc.regs[22] & 0x0F];
+                    d |= semigfxmask[vd->regs[22] & 0x0F];
                     /* .. mask the rest of the right hand side on */
                 }
             }
             
             if (cpos == i) { /* handle cursor if this is the cursor */
-                if ((vdc.frame_counter | 1) & crsrblink[(vdc.regs[10] >> 5) & 3]) {
+                if ((vd->frame_counter | 1) & crsrblink[(vd->regs[10] >> 5) & 3]) {
                     /* invert current byte of the character if we are within the cursor area */
                     if (
-                    ((vdc.raster.ycounter >= (vdc.regs[10] & 0x1F)) && (vdc.raster.ycounter < (vdc.regs[11] & 0x1F)))
-                    || ((vdc.raster.ycounter == (vdc.regs[10] & 0x1F)) && (vdc.raster.ycounter == (vdc.regs[11] & 0x1F)))
-                    || (((vdc.regs[10] & 0x1F) > (vdc.regs[11] & 0x1F)) && ((vdc.raster.ycounter >= (vdc.regs[10] & 0x1F)) || (vdc.raster.ycounter < (vdc.regs[11] & 0x1F))))
+                    ((vd->raster.ycounter >= (vd->regs[10] & 0x1F)) && (vd->raster.ycounter < (vd->regs[11] & 0x1F)))
+                    || ((vd->raster.ycounter == (vd->regs[10] & 0x1F)) && (vd->raster.ycounter == (vd->regs[11] & 0x1F)))
+                    || (((vd->regs[10] & 0x1F) > (vd->regs[11] & 0x1F)) && ((vd->raster.ycounter >= (vd->regs[10] & 0x1F)) || (vd->raster.ycounter < (vd->regs[11] & 0x1F))))
                     ) {
                         /* The VDC cursor reverses the char */
                         d ^= 0xFF;
@@ -703,24 +707,24 @@ static void draw_std_text(void)
                 }
             }
 
-            if (vdc.regs[24] & VDC_REVERSE_ATTR) { /* whole screen reverse */
+            if (vd->regs[24] & VDC_REVERSE_ATTR) { /* whole screen reverse */
                 d ^= 0xff;
             }
 
             /* actually render the byte into 8 bytes of colour pixels using the lookup tables */
-            if (vdc.regs[25] & 0x10) { /* double pixel mode */
+            if (vd->regs[25] & 0x10) { /* double pixel mode */
                 *((uint32_t *)p) = *(pdwh + (d >> 4));
                 *((uint32_t *)p + 1) = *(pdwl + (d >> 4));
                 *((uint32_t *)p + 2) = *(pdwh + (d & 0x0f));
                 *((uint32_t *)p + 3) = *(pdwl + (d & 0x0f));
                 if (icsi >= 0) {    /* if there's inter character spacing, then render it */
                     q = p + 16;
-                    if ((vdc.regs[25] & 0x20) && (d & semigfxtest[vdc.regs[22] & 0x0F])) { /* If semi-graphics mode and the rightmost active bit is set */
+                    if ((vd->regs[25] & 0x20) && (d & semigfxtest[vd->regs[22] & 0x0F])) { /* If semi-graphics mode and the rightmost active bit is set */
                         d = mask[icsi];   /* .. figure out how big it is based on the width of the gap */
                     } else { /* otherwise just draw the background */
                         d = 0;
                     }    
-                    if (vdc.regs[24] & VDC_REVERSE_ATTR) { /* whole screen reverse */
+                    if (vd->regs[24] & VDC_REVERSE_ATTR) { /* whole screen reverse */
                         d ^= 0xff;
                     }
                     *((uint32_t *)q) = *(pdwh + (d >> 4));
@@ -733,12 +737,12 @@ static void draw_std_text(void)
                 *((uint32_t *)p + 1) = *(ptr + (d & 0x0f));
                 if (icsi >= 0) {    /* if there's inter character spacing, then render it */
                     q = p + 8;
-                    if ((vdc.regs[25] & 0x20) && (d & semigfxtest[vdc.regs[22] & 0x0F])) { /* If semi-graphics mode and the rightmost active bit is set */
+                    if ((vd->regs[25] & 0x20) && (d & semigfxtest[vd->regs[22] & 0x0F])) { /* If semi-graphics mode and the rightmost active bit is set */
                         d = mask[icsi];   /* .. figure out how big it is based on the width of the gap */
                     } else { /* otherwise just draw the background */
                         d = 0;
                     }
-                    if (vdc.regs[24] & VDC_REVERSE_ATTR) { /* whole screen reverse */
+                    if (vd->regs[24] & VDC_REVERSE_ATTR) { /* whole screen reverse */
                         d ^= 0xff;
                     }
                     *((uint32_t *)q) = *(ptr + (d >> 4));
@@ -748,8 +752,8 @@ static void draw_std_text(void)
         }
     }
     /* fill the last few pixels of the display with bg colour if smooth scroll != 0 */
-    for (i = vdc.xsmooth; i < (unsigned)(vdc.regs[22] >> 4); i++, p++) {
-        *p = (vdc.regs[26] & 0x0f);
+    for (i = vd->xsmooth; i < (unsigned)(vd->regs[22] >> 4); i++, p++) {
+        *p = (vd->regs[26] & 0x0f);
     }
 }
 
@@ -762,26 +766,26 @@ static int get_std_bitmap(raster_cache_t *cache, unsigned int *xs,
     int r;
 
     r = cache_data_fill(cache->foreground_data,
-                        vdc.ram + vdc.screen_adr + vdc.bitmap_counter,
-                        vdc.screen_text_cols + 1,
+                        vd->ram + vd->screen_adr + vd->bitmap_counter,
+                        vd->screen_text_cols + 1,
                         1,
                         xs, xe,
                         rr,
-                        (vdc.regs[24] & VDC_REVERSE_ATTR) ? 0xff : 0x0);
+                        (vd->regs[24] & VDC_REVERSE_ATTR) ? 0xff : 0x0);
 
-    if (vdc.regs[25] & 0x40) {
+    if (vd->regs[25] & 0x40) {
         /* attribute mode */
         r |= raster_cache_data_fill(cache->color_data_1,
-                                    vdc.ram + vdc.attribute_adr
-                                    + vdc.mem_counter + vdc.attribute_offset,
-                                    vdc.screen_text_cols + 1,
+                                    vd->ram + vd->attribute_adr
+                                    + vd->mem_counter + vd->attribute_offset,
+                                    vd->screen_text_cols + 1,
                                     xs, xe,
                                     rr);
     } else {
         /* monochrome mode - attributes from register 26 */
         r |= raster_cache_data_fill_const(cache->color_data_1,
-                                          (uint8_t)(vdc.regs[26] >> 4),
-                                          (int)vdc.screen_text_cols + 1,
+                                          (uint8_t)(vd->regs[26] >> 4),
+                                          (int)vd->screen_text_cols + 1,
                                           xs, xe,
                                           rr);
     }
@@ -797,22 +801,22 @@ static void draw_std_bitmap_cached(raster_cache_t *cache, unsigned int xs,
     uint32_t *ptr, *pdwl, *pdwh;
 
     unsigned int i, d, j, fg, bg, charwidth;
-    if (vdc.regs[25] & 0x10) { /* double pixel a.k.a 40column mode */
-        charwidth = 2 * (vdc.regs[22] >> 4);
+    if (vd->regs[25] & 0x10) { /* double pixel a.k.a 40column mode */
+        charwidth = 2 * (vd->regs[22] >> 4);
     } else { /* 80 column mode */
-        charwidth = 1 + (vdc.regs[22] >> 4);
+        charwidth = 1 + (vd->regs[22] >> 4);
     }
-    p = vdc.raster.draw_buffer_ptr
-        + vdc.border_width
-        + ((vdc.regs[25] & 0x10) ? 2 : 0)
-        + vdc.xsmooth * ((vdc.regs[25] & 0x10) ? 2 : 1)
-        - (vdc.regs[22] >> 4) * ((vdc.regs[25] & 0x10) ? 2 : 1)
+    p = vd->raster.draw_buffer_ptr
+        + vd->border_width
+        + ((vd->regs[25] & 0x10) ? 2 : 0)
+        + vd->xsmooth * ((vd->regs[25] & 0x10) ? 2 : 1)
+        - (vd->regs[22] >> 4) * ((vd->regs[25] & 0x10) ? 2 : 1)
         + xs * charwidth;
 
     /* TODO: See if we even need to split these renderers between attr/mono, because the attr data is filled either way. draw_std_text_cached mode() doesn't differentiate */
-    if (vdc.regs[25] & 0x40) {
+    if (vd->regs[25] & 0x40) {
         /* attribute mode */
-        if (vdc.regs[25] & 0x10) { /* double pixel mode */
+        if (vd->regs[25] & 0x10) { /* double pixel mode */
             for (i = xs; i <= (unsigned int)xe; i++, p += charwidth) {
                 d = cache->foreground_data[i];
                 pdwl = pdl_table + ((cache->color_data_1[i] & 0x0f) << 8) + (cache->color_data_1[i] & 0xf0);
@@ -835,9 +839,9 @@ static void draw_std_bitmap_cached(raster_cache_t *cache, unsigned int xs,
         }
     } else {
         /* monochrome mode - attributes from register 26 */
-        if (vdc.regs[25] & 0x10) { /* double pixel mode */
-            pdl_ptr = pdl_table + ((vdc.regs[26] & 0x0f) << 4);
-            pdh_ptr = pdh_table + ((vdc.regs[26] & 0x0f) << 4);
+        if (vd->regs[25] & 0x10) { /* double pixel mode */
+            pdl_ptr = pdl_table + ((vd->regs[26] & 0x0f) << 4);
+            pdh_ptr = pdh_table + ((vd->regs[26] & 0x0f) << 4);
 
             for (i = xs; i <= (unsigned int)xe; i++, p += charwidth) {
                 d = cache->foreground_data[i];
@@ -849,7 +853,7 @@ static void draw_std_bitmap_cached(raster_cache_t *cache, unsigned int xs,
                 *((uint32_t *)p + 3) = *(pdwl + (d & 0x0f));
             }
         } else { /* normal text size */
-            table_ptr = hr_table + ((vdc.regs[26] & 0x0f) << 4);
+            table_ptr = hr_table + ((vd->regs[26] & 0x0f) << 4);
 
             for (i = xs; i <= (unsigned int)xe; i++, p += charwidth) {
                 d = cache->foreground_data[i];
@@ -864,20 +868,20 @@ static void draw_std_bitmap_cached(raster_cache_t *cache, unsigned int xs,
 
     /* fill the last few pixels of the display with bg colour if xsmooth scroll != maximum  */
     d = cache->foreground_data[i];
-    if (vdc.regs[24] & VDC_REVERSE_ATTR) {
+    if (vd->regs[24] & VDC_REVERSE_ATTR) {
         /* reverse screen bit */
         d ^= 0xff;
     }
-    if (vdc.regs[25] & 0x40) {
+    if (vd->regs[25] & 0x40) {
         /* attribute mode */
         fg = cache->color_data_1[i] >> 4;
         bg = cache->color_data_1[i] & 0x0F;
     } else {
         /* monochrome mode - attributes from register 26 */
-        bg = vdc.regs[26] & 0x0F;
-        fg = vdc.regs[26] >> 4;
+        bg = vd->regs[26] & 0x0F;
+        fg = vd->regs[26] >> 4;
     }
-    for (i = vdc.xsmooth, j = 0x80; i < (unsigned)(vdc.regs[22] >> 4); i++, p++, j >>= 1) {
+    for (i = vd->xsmooth, j = 0x80; i < (unsigned)(vd->regs[22] >> 4); i++, p++, j >>= 1) {
         if (d & j) {
             /* foreground */
             *p = fg;
@@ -897,44 +901,44 @@ static void draw_std_bitmap(void)
 
     unsigned int i, d, j, fg, bg, charwidth;
     
-    if(vdc.regs[25] & 0x10) { /* double pixel a.k.a 40column mode */
-        charwidth = 2 * (vdc.regs[22] >> 4);
+    if(vd->regs[25] & 0x10) { /* double pixel a.k.a 40column mode */
+        charwidth = 2 * (vd->regs[22] >> 4);
     } else { /* 80 column mode */
-        charwidth = 1 + (vdc.regs[22] >> 4);
+        charwidth = 1 + (vd->regs[22] >> 4);
     }
     
-    p = vdc.raster.draw_buffer_ptr
-        + vdc.border_width
-        + ((vdc.regs[25] & 0x10) ? 2 : 0)
-        + vdc.xsmooth * ((vdc.regs[25] & 0x10) ? 2 : 1)
-        - (vdc.regs[22] >> 4) * ((vdc.regs[25] & 0x10) ? 2 : 1);
+    p = vd->raster.draw_buffer_ptr
+        + vd->border_width
+        + ((vd->regs[25] & 0x10) ? 2 : 0)
+        + vd->xsmooth * ((vd->regs[25] & 0x10) ? 2 : 1)
+        - (vd->regs[22] >> 4) * ((vd->regs[25] & 0x10) ? 2 : 1);
 
-    attr_ptr = vdc.ram + vdc.attribute_adr + vdc.mem_counter + vdc.attribute_offset;
-    bitmap_ptr = vdc.ram + vdc.screen_adr + vdc.bitmap_counter;
+    attr_ptr = vd->ram + vd->attribute_adr + vd->mem_counter + vd->attribute_offset;
+    bitmap_ptr = vd->ram + vd->screen_adr + vd->bitmap_counter;
 
-    for (i = 0; i < vdc.mem_counter_inc; i++, p += charwidth) {
+    for (i = 0; i < vd->mem_counter_inc; i++, p += charwidth) {
         uint32_t *ptr, *pdwl, *pdwh;
 
-        if (vdc.regs[25] & 0x40) {
+        if (vd->regs[25] & 0x40) {
             /* attribute mode */
             ptr = hr_table + (*(attr_ptr + i) & 0xf0) + ((*(attr_ptr + i) & 0x0f) << 8);
             pdwl = pdl_table + (*(attr_ptr + i) & 0xf0) + ((*(attr_ptr + i) & 0x0f) << 8);
             pdwh = pdh_table + (*(attr_ptr + i) & 0xf0) + ((*(attr_ptr + i) & 0x0f) << 8);
         } else {
             /* monochrome mode - attributes from register 26 */
-            ptr = hr_table + (vdc.regs[26] << 4);
-            pdwl = pdl_table + (vdc.regs[26] << 4);  /* Pointers into the lookup tables */
-            pdwh = pdh_table + (vdc.regs[26] << 4);
+            ptr = hr_table + (vd->regs[26] << 4);
+            pdwl = pdl_table + (vd->regs[26] << 4);  /* Pointers into the lookup tables */
+            pdwh = pdh_table + (vd->regs[26] << 4);
         }
 
         d = *(bitmap_ptr + i); /* grab the data byte from the bitmap */
 
-        if (vdc.regs[24] & VDC_REVERSE_ATTR) { /* whole screen reverse */
+        if (vd->regs[24] & VDC_REVERSE_ATTR) { /* whole screen reverse */
             d ^= 0xff;
         }
 
         /* actually render the byte into 8 bytes of colour pixels using the lookup tables */
-        if (vdc.regs[25] & 0x10) { /* double pixel mode */
+        if (vd->regs[25] & 0x10) { /* double pixel mode */
             *((uint32_t *)p) = *(pdwh + (d >> 4));
             *((uint32_t *)p + 1) = *(pdwl + (d >> 4));
             *((uint32_t *)p + 2) = *(pdwh + (d & 0x0f));
@@ -947,19 +951,19 @@ static void draw_std_bitmap(void)
 
     /* fill the last few pixels of the display with bg colour if xsmooth scroll != maximum  */
     d = *(bitmap_ptr + i);
-    if (vdc.regs[24] & VDC_REVERSE_ATTR) { /* reverse screen bit */
+    if (vd->regs[24] & VDC_REVERSE_ATTR) { /* reverse screen bit */
         d ^= 0xff;
     }
-    if (vdc.regs[25] & 0x40) {
+    if (vd->regs[25] & 0x40) {
         /* attribute mode */
         fg = *(attr_ptr + i) >> 4;
         bg = *(attr_ptr + i) & 0x0F;
     } else {
         /* monochrome mode - attributes from register 26 */
-        fg = vdc.regs[26] >> 4;
-        bg = vdc.regs[26] & 0x0F;
+        fg = vd->regs[26] >> 4;
+        bg = vd->regs[26] & 0x0F;
     }
-    for (i = vdc.xsmooth, j = 0x80; i < (unsigned)(vdc.regs[22] >> 4); i++, p++, j >>= 1) {
+    for (i = vd->xsmooth, j = 0x80; i < (unsigned)(vd->regs[22] >> 4); i++, p++, j >>= 1) {
         if (d & j) {
             /* foreground */
             *p = fg;
@@ -974,10 +978,10 @@ static int get_idle(raster_cache_t *cache, unsigned int *xs, unsigned int *xe,
                     int rr)
 /* aka raster_modes_fill_cache() in raster */
 {
-    if (rr || (vdc.regs[26] >> 4) != cache->color_data_1[0]) {
+    if (rr || (vd->regs[26] >> 4) != cache->color_data_1[0]) {
         *xs = 0;
-        *xe = vdc.screen_text_cols;
-        cache->color_data_1[0] = vdc.regs[26] >> 4;
+        *xe = vd->screen_text_cols;
+        cache->color_data_1[0] = vd->regs[26] >> 4;
         return 1;
     }
 
@@ -993,8 +997,8 @@ static void draw_idle_cached(raster_cache_t *cache, unsigned int xs,
 
     unsigned int i;
 
-    p = vdc.raster.draw_buffer_ptr + vdc.border_width
-        + vdc.raster.xsmooth + xs * 8;
+    p = vd->raster.draw_buffer_ptr + vd->border_width
+        + vd->raster.xsmooth + xs * 8;
 
     idleval = *(hr_table + ((cache->color_data_1[0] & 0x0f) << 8));
 
@@ -1012,16 +1016,16 @@ static void draw_idle(void)
 
     unsigned int i;
 
-    p = vdc.raster.draw_buffer_ptr + vdc.border_width
-        + vdc.raster.xsmooth;
+    p = vd->raster.draw_buffer_ptr + vd->border_width
+        + vd->raster.xsmooth;
 
     /* border colour is just the screen background colour from reg 26 bits 0-3 */
-    idleval = *(hr_table + ((vdc.regs[26] & 0x0f) << 4));
+    idleval = *(hr_table + ((vd->regs[26] & 0x0f) << 4));
 
-    for (i = 0; i < vdc.mem_counter_inc; i++, p += ((vdc.regs[25] & 0x10) ? 16 : 8)) {
+    for (i = 0; i < vd->mem_counter_inc; i++, p += ((vd->regs[25] & 0x10) ? 16 : 8)) {
         *((uint32_t *)p) = idleval;
         *((uint32_t *)p + 1) = idleval;
-        if (vdc.regs[25] & 0x10) { /* double pixel mode */
+        if (vd->regs[25] & 0x10) { /* double pixel mode */
             *((uint32_t *)p + 2) = idleval;
             *((uint32_t *)p + 3) = idleval;
         }
@@ -1031,21 +1035,21 @@ static void draw_idle(void)
 
 static void setup_modes(void)
 {
-    raster_modes_set(vdc.raster.modes, VDC_TEXT_MODE,
+    raster_modes_set(vd->raster.modes, VDC_TEXT_MODE,
                      get_std_text,                      /* raster_modes_fill_cache() in raster */
                      draw_std_text_cached,              /* raster_modes_draw_line_cached() in raster */
                      draw_std_text,                     /* raster_modes_draw_line() in raster */
                      NULL,                              /* draw_std_background */
                      NULL);                             /* draw_std_text_foreground */
 
-    raster_modes_set(vdc.raster.modes, VDC_BITMAP_MODE,
+    raster_modes_set(vd->raster.modes, VDC_BITMAP_MODE,
                      get_std_bitmap,                    /* aka raster_modes_fill_cache() in raster */
                      draw_std_bitmap_cached,            /* raster_modes_draw_line_cached() in raster */
                      draw_std_bitmap,                   /* raster_modes_draw_line() in raster */
                      NULL,                              /* draw_std_background */
                      NULL);                             /* draw_std_text_foreground */
 
-    raster_modes_set(vdc.raster.modes, VDC_IDLE_MODE,
+    raster_modes_set(vd->raster.modes, VDC_IDLE_MODE,
                      get_idle,                          /* aka raster_modes_fill_cache() in raster */
                      draw_idle_cached,                  /* raster_modes_draw_line_cached() in raster */
                      draw_idle,                         /* raster_modes_draw_line() in raster */
@@ -1053,6 +1057,11 @@ static void setup_modes(void)
                      NULL);                             /*draw_std_text_foreground */
 }
 
+void vdc_draw_set_state(vdc_t *state)
+{
+    vd = state;
+}
+
 void vdc_draw_init(void)
 {
     init_drawing_tables();
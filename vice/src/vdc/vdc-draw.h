@@ -29,6 +29,9 @@
 #ifndef VICE_VDC_DRAW_H
 #define VICE_VDC_DRAW_H
 
+struct vdc_s;
+
 extern void vdc_draw_init(void);
+extern void vdc_draw_set_state(struct vdc_s *state);
 
 #endif
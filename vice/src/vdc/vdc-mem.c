@@ -38,6 +38,7 @@
 #include "monitor.h"
 #include "types.h"
 #include "vdc-mem.h"
+#include "vdc-thread.h"
 #include "vdc.h"
 #include "vdctypes.h"
 
@@ -66,6 +67,7 @@ static void vdc_write_data(void)
 
     /* Write data byte to update address. */
     vdc.ram[ptr & vdc.vdc_address_mask] = vdc.regs[31];
+    vdc_thread_store(ptr & vdc.vdc_address_mask, vdc.regs[31]);
 #ifdef REG_DEBUG
     log_message(vdc.log, "STORE %04x %02x", ptr & vdc.vdc_address_mask,
                 vdc.regs[31]);
@@ -94,6 +96,8 @@ static void vdc_perform_fillcopy(void)
         for (i = 0; i < blklen; i++) {
             vdc.ram[(ptr + i) & vdc.vdc_address_mask]
                 = vdc.ram[(ptr2 + i) & vdc.vdc_address_mask];
+            vdc_thread_store((ptr + i) & vdc.vdc_address_mask,
+                             vdc.ram[(ptr + i) & vdc.vdc_address_mask]);
         }
         ptr2 += blklen;
         vdc.regs[31] = vdc.ram[(ptr2 - 1) & vdc.vdc_address_mask];
@@ -106,6 +110,7 @@ static void vdc_perform_fillcopy(void)
 #endif
         for (i = 0; i < blklen; i++) {
             vdc.ram[(ptr + i) & vdc.vdc_address_mask] = vdc.regs[31];
+            vdc_thread_store((ptr + i) & vdc.vdc_address_mask, vdc.regs[31]);
         }
     }
 
@@ -574,6 +579,7 @@ uint8_t vdc_ram_read(uint16_t addr)
 void vdc_ram_store(uint16_t addr, uint8_t value)
 {
     vdc.ram[addr & vdc.vdc_address_mask] = value;
+    vdc_thread_store(addr & vdc.vdc_address_mask, value);
 }
 
 
@@ -42,6 +42,7 @@
 #include "raster-resources.h"
 #include "resources.h"
 #include "vdc-resources.h"
+#include "vdc-thread.h"
 #include "vdctypes.h"
 #include "video.h"
 
@@ -103,6 +104,15 @@ static int set_stretch(int val, void *param)
     return 0;
 }
 
+static int set_render_thread(int val, void *param)
+{
+    if (vdc_thread_set_enabled(val) < 0) {
+        return -1;
+    }
+    vdc_resources.render_thread = val ? 1 : 0;
+    return 0;
+}
+
 static const resource_int_t resources_int[] =
 {
     { "VDC64KB", 1, RES_EVENT_SAME, NULL,
@@ -111,6 +121,8 @@ static const resource_int_t resources_int[] =
       (int *)&vdc.revision, set_vdc_revision, NULL },
     { "VDCStretchVertical", 1, RES_EVENT_SAME, NULL,
       &vdc_resources.stretchy, set_stretch, NULL },
+    { "VDCThread", 0, RES_EVENT_NO, NULL,
+      &vdc_resources.render_thread, set_render_thread, NULL },
     RESOURCE_INT_LIST_END
 };
 
@@ -0,0 +1,385 @@
+/*
+ * vdc-thread.c - Draw VDC raster lines on a separate thread.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* Drawing a VDC line only reads the VDC registers, the VDC RAM and the
+   raster state, so it can run behind the emulation.  The raster alarm
+   handler still does all of its bookkeeping, but instead of drawing the
+   line it copies everything in `vdc' up to the RAM into a ring.  Writes to
+   the VDC RAM are queued in a second ring.  The thread keeps a copy of the
+   whole chip, applies the RAM writes made before a line, takes over the
+   line's state and draws it with `raster_line_emulate()', so each line
+   comes out exactly as it would have been drawn in place.  Lines are handed
+   over in batches, which is the only time the emulation thread takes a
+   lock.
+
+   A few raster fields are changed by drawing itself (the cache counters and
+   the blank flip-flop); those stay with the thread's copy until the next
+   `vdc_thread_sync()', which waits for the thread and hands them back.  A
+   repaint requested on the emulation thread in the meantime is passed on
+   with the next line.  The line that ends a frame is drawn on the emulation
+   thread after a sync, so the canvas is refreshed there as before, and the
+   new frame's geometry and cache changes find the thread idle.  The UI
+   syncs through `raster_sync()' before it draws into the canvas.  */
+
+#include "vice.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "archdep_thread.h"
+#include "log.h"
+#include "raster.h"
+#include "raster-line.h"
+#include "types.h"
+#include "vdc-draw.h"
+#include "vdc-thread.h"
+#include "vdctypes.h"
+#include "viewport.h"
+
+/* Lines that may be queued ahead of the thread; must be a power of 2.  */
+#define VDC_THREAD_LINES    128
+
+/* Lines handed to the thread at a time.  */
+#define VDC_THREAD_BATCH    16
+
+/* RAM writes that may be queued ahead of the thread; must be a power of 2.  */
+#define VDC_THREAD_STORES   0x10000
+
+/* The part of `vdc' copied for each line: everything but the RAM.  */
+#define VDC_THREAD_STATE_SIZE   offsetof(vdc_t, ram)
+
+typedef struct vdc_thread_line_s {
+    /* `vdc' as it was when the line was due.  */
+    uint8_t state[VDC_THREAD_STATE_SIZE];
+    /* RAM writes to apply before drawing the line.  */
+    unsigned int stores_end;
+    /* Take over the raster state as a whole (first line after a sync).  */
+    int reseed;
+    /* `raster_force_repaint()' was called since the previous line.  */
+    int repaint;
+} vdc_thread_line_t;
+
+typedef struct vdc_thread_store_s {
+    uint16_t addr;
+    uint8_t value;
+} vdc_thread_store_t;
+
+static int vdc_thread_enabled = 0;
+
+/* The chip as seen by the thread.  */
+static vdc_t thread_vdc;
+
+static vdc_thread_line_t line_ring[VDC_THREAD_LINES];
+static vdc_thread_store_t store_ring[VDC_THREAD_STORES];
+
+/* Written by the emulation thread only.  */
+static unsigned int line_write;
+static unsigned int store_write;
+static unsigned int store_limit;
+static int reseed;
+static int lines_drawn;
+
+/* Protected by `thread_lock'.  */
+static unsigned int line_published;
+static unsigned int line_read;
+static unsigned int store_read;
+static int thread_quit;
+
+/* RAM writes applied by the thread so far.  */
+static unsigned int thread_store_read;
+
+static archdep_thread_t *thread = NULL;
+static archdep_mutex_t *thread_lock = NULL;
+static archdep_cond_t *thread_work = NULL;
+static archdep_cond_t *thread_done = NULL;
+
+/* ------------------------------------------------------------------------- */
+
+/* Copy the raster fields that drawing a line changes.  */
+static void copy_draw_progress(raster_t *dest, const raster_t *src)
+{
+    dest->blank_enabled = src->blank_enabled;
+    dest->blank_this_line = src->blank_this_line;
+    dest->open_left_border = src->open_left_border;
+    dest->open_right_border = src->open_right_border;
+    dest->dont_cache = src->dont_cache;
+    dest->num_cached_lines = src->num_cached_lines;
+}
+
+static void draw_line(const vdc_thread_line_t *line)
+{
+    raster_t progress;
+    unsigned int i;
+
+    for (i = thread_store_read; i != line->stores_end; i++) {
+        const vdc_thread_store_t *s = &store_ring[i & (VDC_THREAD_STORES - 1)];
+
+        thread_vdc.ram[s->addr] = s->value;
+    }
+    thread_store_read = line->stores_end;
+
+    if (line->reseed) {
+        memcpy(&thread_vdc, line->state, VDC_THREAD_STATE_SIZE);
+    } else {
+        copy_draw_progress(&progress, &thread_vdc.raster);
+        memcpy(&thread_vdc, line->state, VDC_THREAD_STATE_SIZE);
+        copy_draw_progress(&thread_vdc.raster, &progress);
+        if (line->repaint) {
+            raster_force_repaint(&thread_vdc.raster);
+        }
+    }
+
+    raster_line_emulate(&thread_vdc.raster);
+}
+
+static void vdc_thread_main(void *data)
+{
+    unsigned int i, end;
+
+    archdep_mutex_lock(thread_lock);
+
+    while (1) {
+        while (line_read == line_published && !thread_quit) {
+            archdep_cond_wait(thread_work, thread_lock);
+        }
+        if (thread_quit) {
+            break;
+        }
+        end = line_published;
+        archdep_mutex_unlock(thread_lock);
+
+        vdc_draw_set_state(&thread_vdc);
+        for (i = line_read; i != end; i++) {
+            draw_line(&line_ring[i & (VDC_THREAD_LINES - 1)]);
+        }
+
+        archdep_mutex_lock(thread_lock);
+        line_read = end;
+        store_read = thread_store_read;
+        archdep_cond_signal(thread_done);
+    }
+
+    archdep_mutex_unlock(thread_lock);
+}
+
+static void vdc_thread_start(void)
+{
+    if (!vdc_thread_enabled || thread != NULL || !vdc.initialized) {
+        return;
+    }
+
+    thread_lock = archdep_mutex_new();
+    thread_work = archdep_cond_new();
+    thread_done = archdep_cond_new();
+
+    memcpy(&thread_vdc, &vdc, sizeof(vdc_t));
+    line_write = line_published = line_read = 0;
+    store_write = store_read = thread_store_read = 0;
+    store_limit = VDC_THREAD_STORES;
+    reseed = 1;
+    lines_drawn = 0;
+    thread_quit = 0;
+
+    thread = archdep_thread_create(vdc_thread_main, NULL);
+    if (thread == NULL) {
+        log_error(vdc.log, "Cannot create render thread, drawing on the emulation thread.");
+        archdep_cond_destroy(thread_done);
+        archdep_cond_destroy(thread_work);
+        archdep_mutex_destroy(thread_lock);
+        thread_lock = NULL;
+    }
+}
+
+static void vdc_thread_stop(void)
+{
+    if (thread == NULL) {
+        return;
+    }
+
+    vdc_thread_sync();
+
+    archdep_mutex_lock(thread_lock);
+    thread_quit = 1;
+    archdep_cond_signal(thread_work);
+    archdep_mutex_unlock(thread_lock);
+
+    archdep_thread_join(thread);
+    thread = NULL;
+
+    archdep_cond_destroy(thread_done);
+    archdep_cond_destroy(thread_work);
+    archdep_mutex_destroy(thread_lock);
+    thread_lock = NULL;
+
+    vdc_draw_set_state(&vdc);
+}
+
+/* True if the current line ends the frame, which makes
+   `raster_line_emulate()' refresh the canvas.  */
+static int line_ends_frame(void)
+{
+    geometry_t *geometry = vdc.raster.geometry;
+    unsigned int next = vdc.raster.current_line + 1;
+
+    if (next == geometry->screen_size.height) {
+        return 1;
+    }
+    return geometry->screen_size.height <= geometry->last_displayed_line
+           && next == geometry->last_displayed_line - geometry->screen_size.height + 1;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int vdc_thread_set_enabled(int val)
+{
+    val = val ? 1 : 0;
+
+    if (val && !archdep_thread_available()) {
+        log_warning(LOG_DEFAULT, "Threads are not supported on this system.");
+        return -1;
+    }
+
+    vdc_thread_enabled = val;
+    if (val) {
+        vdc_thread_start();
+    } else {
+        vdc_thread_stop();
+    }
+    return 0;
+}
+
+static void vdc_thread_raster_sync(raster_t *raster)
+{
+    vdc_thread_sync();
+}
+
+void vdc_thread_init(void)
+{
+    vdc.raster.sync = vdc_thread_raster_sync;
+    vdc_thread_start();
+}
+
+void vdc_thread_shutdown(void)
+{
+    vdc_thread_stop();
+}
+
+/* Wait until the thread has drawn every queued line.  Afterwards `vdc' holds
+   the complete raster state and may be changed freely; the thread takes it
+   over again with the next line.  */
+void vdc_thread_sync(void)
+{
+    if (thread == NULL) {
+        return;
+    }
+
+    archdep_mutex_lock(thread_lock);
+    line_published = line_write;
+    archdep_cond_signal(thread_work);
+    while (line_read != line_write) {
+        archdep_cond_wait(thread_done, thread_lock);
+    }
+    archdep_mutex_unlock(thread_lock);
+
+    if (lines_drawn) {
+        copy_draw_progress(&vdc.raster, &thread_vdc.raster);
+        lines_drawn = 0;
+    }
+
+    /* Writes not yet handed over are part of the RAM copied here.  */
+    memcpy(thread_vdc.ram, vdc.ram, sizeof(vdc.ram));
+    store_read = thread_store_read = store_write;
+    store_limit = store_write + VDC_THREAD_STORES;
+    reseed = 1;
+}
+
+/* Queue a write to the VDC RAM; `vdc.ram' has been updated already.  */
+void vdc_thread_store(unsigned int addr, uint8_t value)
+{
+    vdc_thread_store_t *s;
+
+    if (thread == NULL) {
+        return;
+    }
+
+    if (store_write == store_limit) {
+        archdep_mutex_lock(thread_lock);
+        store_limit = store_read + VDC_THREAD_STORES;
+        archdep_mutex_unlock(thread_lock);
+        if (store_write == store_limit) {
+            /* The lines queued so far do not free any room: let the thread
+               catch up and take the RAM as a whole.  */
+            vdc_thread_sync();
+            return;
+        }
+    }
+
+    s = &store_ring[store_write & (VDC_THREAD_STORES - 1)];
+    s->addr = (uint16_t)addr;
+    s->value = value;
+    store_write++;
+}
+
+/* Draw the current raster line, or queue it for the thread.  */
+void vdc_thread_emulate_line(void)
+{
+    vdc_thread_line_t *line;
+
+    if (thread == NULL) {
+        raster_line_emulate(&vdc.raster);
+        return;
+    }
+
+    if (line_ends_frame()) {
+        vdc_thread_sync();
+        vdc_draw_set_state(&vdc);
+        raster_line_emulate(&vdc.raster);
+        return;
+    }
+
+    line = &line_ring[line_write & (VDC_THREAD_LINES - 1)];
+    memcpy(line->state, &vdc, VDC_THREAD_STATE_SIZE);
+    line->stores_end = store_write;
+    line->reseed = reseed;
+    line->repaint = vdc.raster.dont_cache;
+    reseed = 0;
+    lines_drawn = 1;
+
+    /* From here on the thread owns the drawing state; `vdc' only tracks the
+       line and passes on repaint requests.  */
+    vdc.raster.dont_cache = 0;
+    vdc.raster.current_line++;
+
+    line_write++;
+
+    if (line_write - line_published >= VDC_THREAD_BATCH) {
+        archdep_mutex_lock(thread_lock);
+        line_published = line_write;
+        archdep_cond_signal(thread_work);
+        while (line_write - line_read > VDC_THREAD_LINES - VDC_THREAD_BATCH) {
+            archdep_cond_wait(thread_done, thread_lock);
+        }
+        archdep_mutex_unlock(thread_lock);
+    }
+}
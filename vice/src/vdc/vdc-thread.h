@@ -0,0 +1,37 @@
+/*
+ * vdc-thread.h - Draw VDC raster lines on a separate thread.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_VDC_THREAD_H
+#define VICE_VDC_THREAD_H
+
+#include "types.h"
+
+extern int vdc_thread_set_enabled(int val);
+extern void vdc_thread_init(void);
+extern void vdc_thread_shutdown(void);
+
+extern void vdc_thread_sync(void);
+extern void vdc_thread_store(unsigned int addr, uint8_t value);
+extern void vdc_thread_emulate_line(void);
+
+#endif
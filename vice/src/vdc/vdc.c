@@ -49,6 +49,7 @@
 #include "vdc-draw.h"
 #include "vdc-resources.h"
 #include "vdc-snapshot.h"
+#include "vdc-thread.h"
 #include "vdc.h"
 #include "vdctypes.h"
 #include "video.h"
@@ -221,6 +222,8 @@ raster_t *vdc_init(void)
 
     vdc.initialized = 1;
 
+    vdc_thread_init();
+
     /*vdc_set_geometry();*/
     resources_touch("VDCDoubleSize");
 
@@ -313,6 +316,8 @@ static void vdc_update_geometry(void)
 /* Reset the VDC chip */
 void vdc_reset(void)
 {
+    vdc_thread_sync();
+
     if (vdc.initialized) {
         raster_reset(&vdc.raster);
     }
@@ -615,8 +620,8 @@ static void vdc_raster_draw_alarm_handler(CLOCK offset, void *data)
         vdc.raster.video_mode = VDC_IDLE_MODE;
     }
 
-    /* actually draw the current raster line */
-    raster_line_emulate(&vdc.raster);
+    /* actually draw the current raster line (or have it drawn) */
+    vdc_thread_emulate_line();
 
     /* see if we still should be drawing things - if we haven't drawn more than regs[6] rows since the top border */
     if (!in_idle_state) {
@@ -670,6 +675,7 @@ int vdc_read_snapshot_module(snapshot_t *s)
 
 void vdc_screenshot(screenshot_t *screenshot)
 {
+    vdc_thread_sync();
     raster_screenshot(&vdc.raster, screenshot);
     screenshot->chipid = "VDC";
     screenshot->video_regs = vdc.regs;
@@ -683,10 +689,12 @@ void vdc_screenshot(screenshot_t *screenshot)
 
 void vdc_async_refresh(struct canvas_refresh_s *refresh)
 {
+    vdc_thread_sync();
     raster_async_refresh(&vdc.raster, refresh);
 }
 
 void vdc_shutdown(void)
 {
+    vdc_thread_shutdown();
     raster_shutdown(&vdc.raster);
 }
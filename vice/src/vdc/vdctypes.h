@@ -186,9 +186,6 @@ struct vdc_s {
     /* Video chip capabilities.  */
     struct video_chip_cap_s *video_chip_cap;
 
-    /* Internal VDC video memory */
-    uint8_t ram[0x10000];
-
     /* used to record the value of the cpu clock at the start of a raster line */
     CLOCK vdc_line_start;
     /* based on blacky_stardust calculations, calculating current_x_pixel should be like:
@@ -208,6 +205,10 @@ struct vdc_s {
 
     /* Light pen. */
     vdc_light_pen_t light_pen;
+
+    /* Internal VDC video memory.  Kept last, the render thread copies
+       everything before it for each line (see vdc-thread.c).  */
+    uint8_t ram[0x10000];
 };
 typedef struct vdc_s vdc_t;
 
@@ -59,14 +59,17 @@
 #define SNAP_MINOR          0
 
 
-int vic20_snapshot_write(const char *name, int save_roms, int save_disks,
-                         int event_mode)
+static int vic20_snapshot_write_internal(const char *name, snapshot_stream_t *stream,
+                                         int save_roms, int save_disks, int event_mode)
 {
     snapshot_t *s;
     int ieee488;
 
-    s = snapshot_create(name, ((uint8_t)(SNAP_MAJOR)), ((uint8_t)(SNAP_MINOR)),
-                        machine_name);
+    if (stream != NULL) {
+        s = snapshot_create_stream(stream, ((uint8_t)(SNAP_MAJOR)), ((uint8_t)(SNAP_MINOR)), machine_name);
+    } else {
+        s = snapshot_create(name, ((uint8_t)(SNAP_MAJOR)), ((uint8_t)(SNAP_MINOR)), machine_name);
+    }
     if (s == NULL) {
         return -1;
     }
@@ -86,7 +89,9 @@ int vic20_snapshot_write(const char *name, int save_roms, int save_disks,
         || joyport_snapshot_write_module(s, JOYPORT_1) < 0
         || userport_snapshot_write_module(s) < 0) {
         snapshot_close(s);
-        ioutil_remove(name);
+        if (name != NULL) {
+            ioutil_remove(name);
+        }
         return -1;
     }
 
@@ -95,7 +100,9 @@ int vic20_snapshot_write(const char *name, int save_roms, int save_disks,
         if (viacore_snapshot_write_module(machine_context.ieeevia1, s) < 0
             || viacore_snapshot_write_module(machine_context.ieeevia2, s) < 0) {
             snapshot_close(s);
-            ioutil_remove(name);
+            if (name != NULL) {
+                ioutil_remove(name);
+            }
             return 1;
         }
     }
@@ -104,12 +111,17 @@ int vic20_snapshot_write(const char *name, int save_roms, int save_disks,
     return 0;
 }
 
-int vic20_snapshot_read(const char *name, int event_mode)
+static int vic20_snapshot_read_internal(const char *name, snapshot_stream_t *stream,
+                                        int event_mode)
 {
     snapshot_t *s;
     uint8_t minor, major;
 
-    s = snapshot_open(name, &major, &minor, machine_name);
+    if (stream != NULL) {
+        s = snapshot_open_stream(stream, &major, &minor, machine_name);
+    } else {
+        s = snapshot_open(name, &major, &minor, machine_name);
+    }
     if (s == NULL) {
         return -1;
     }
@@ -160,3 +172,23 @@ fail:
 
     return -1;
 }
+
+int vic20_snapshot_write(const char *name, int save_roms, int save_disks, int event_mode)
+{
+    return vic20_snapshot_write_internal(name, NULL, save_roms, save_disks, event_mode);
+}
+
+int vic20_snapshot_write_stream(snapshot_stream_t *stream, int save_roms, int save_disks, int event_mode)
+{
+    return vic20_snapshot_write_internal(NULL, stream, save_roms, save_disks, event_mode);
+}
+
+int vic20_snapshot_read(const char *name, int event_mode)
+{
+    return vic20_snapshot_read_internal(name, NULL, event_mode);
+}
+
+int vic20_snapshot_read_stream(snapshot_stream_t *stream, int event_mode)
+{
+    return vic20_snapshot_read_internal(NULL, stream, event_mode);
+}
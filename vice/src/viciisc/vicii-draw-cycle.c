@@ -135,7 +135,9 @@ static const uint8_t colors[] = {
     COL_NONE, COL_NONE, COL_NONE, COL_NONE          /* ECM=1 BMM=1 MCM=1 */
 };
 
-static DRAW_INLINE void draw_graphics(int i)
+/* With `pri_only' set only the foreground flag needed for the collisions
+   is produced, not the color.  */
+static DRAW_INLINE void draw_graphics(int i, int pri_only)
 {
     uint8_t px;
     uint8_t cc;
@@ -186,8 +188,12 @@ static DRAW_INLINE void draw_graphics(int i)
     gbuf_mc_flop ^= 1;
 
     /* Determine pixel color and priority */
-    vmode = vmode11_pipe | vmode16_pipe;
     pixel_pri = (px & 0x2);
+    if (pri_only) {
+        pri_buffer[i] = pixel_pri;
+        return;
+    }
+    vmode = vmode11_pipe | vmode16_pipe;
     cc = colors[vmode | px];
 
     /* lookup colors and render pixel */
@@ -218,7 +224,7 @@ static DRAW_INLINE void draw_graphics(int i)
     pri_buffer[i] = pixel_pri;
 }
 
-static DRAW_INLINE void draw_graphics8(unsigned int cycle_flags)
+static DRAW_INLINE void draw_graphics8(unsigned int cycle_flags, int pri_only)
 {
     int vis_en;
 
@@ -226,34 +232,34 @@ static DRAW_INLINE void draw_graphics8(unsigned int cycle_flags)
 
     /* render pixels */
     /* pixel 0 */
-    draw_graphics(0);
+    draw_graphics(0, pri_only);
     /* pixel 1 */
-    draw_graphics(1);
+    draw_graphics(1, pri_only);
     /* pixel 2 */
-    draw_graphics(2);
+    draw_graphics(2, pri_only);
     /* pixel 3 */
-    draw_graphics(3);
+    draw_graphics(3, pri_only);
     /* pixel 4 */
     vmode16_pipe = ( vicii.regs[0x16] & 0x10 ) >> 2;
     if (vicii.color_latency) {
         /* handle rising edge of internal signal */
         vmode11_pipe |= ( vicii.regs[0x11] & 0x60 ) >> 2;
     }
-    draw_graphics(4);
+    draw_graphics(4, pri_only);
     /* pixel 5 */
-    draw_graphics(5);
+    draw_graphics(5, pri_only);
     /* pixel 6 */
     if (vicii.color_latency) {
         /* handle falling edge of internal signal */
         vmode11_pipe &= ( vicii.regs[0x11] & 0x60 ) >> 2;
     }
-    draw_graphics(6);
+    draw_graphics(6, pri_only);
     /* pixel 7 */
     if (vmode16_pipe && !vmode16_pipe2) {
         gbuf_mc_flop = 0;
     }
     vmode16_pipe2 = vmode16_pipe;
-    draw_graphics(7);
+    draw_graphics(7, pri_only);
 
     if (!vicii.color_latency) {
         vmode11_pipe = ( vicii.regs[0x11] & 0x60 ) >> 2;
@@ -337,7 +343,7 @@ static DRAW_INLINE void trigger_sprites(int xpos, uint8_t candidate_bits)
     }
 }
 
-static DRAW_INLINE void draw_sprites(int i)
+static DRAW_INLINE void draw_sprites(int i, int pri_only)
 {
     int s;
     int active_sprite;
@@ -400,7 +406,7 @@ static DRAW_INLINE void draw_sprites(int i)
         uint8_t pixel_pri = pri_buffer[i];
         int s = active_sprite;
         uint8_t spri = sprite_pri_bits & (1 << s);
-        if (!(pixel_pri && spri)) {
+        if (!pri_only && !(pixel_pri && spri)) {
             switch (sbuf_pixel_reg[s]) {
                 case 1:
                     render_buffer[i] = COL_D025;
@@ -464,7 +470,7 @@ static DRAW_INLINE void update_sprite_xpos(void)
 
 
 
-static DRAW_INLINE void draw_sprites8(unsigned int cycle_flags)
+static DRAW_INLINE void draw_sprites8(unsigned int cycle_flags, int pri_only)
 {
     uint8_t candidate_bits;
     uint8_t dma_cycle_0 = 0;
@@ -487,28 +493,28 @@ static DRAW_INLINE void draw_sprites8(unsigned int cycle_flags)
     /* process and render sprites */
     /* pixel 0 */
     trigger_sprites(xpos + 0, candidate_bits);
-    draw_sprites(0);
+    draw_sprites(0, pri_only);
     /* pixel 1 */
     trigger_sprites(xpos + 1, candidate_bits);
-    draw_sprites(1);
+    draw_sprites(1, pri_only);
     /* pixel 2 */
     sprite_active_bits &= ~dma_cycle_2;
     trigger_sprites(xpos + 2, candidate_bits);
-    draw_sprites(2);
+    draw_sprites(2, pri_only);
     /* pixel 3 */
     sprite_halt_bits |= dma_cycle_0;
     trigger_sprites(xpos + 3, candidate_bits);
-    draw_sprites(3);
+    draw_sprites(3, pri_only);
     /* pixel 4 */
     if (spr_en) {
         sprite_pending_bits = vicii.sprite_display_bits;
     }
     update_sprite_data(cycle_flags);
     trigger_sprites(xpos + 4, candidate_bits);
-    draw_sprites(4);
+    draw_sprites(4, pri_only);
     /* pixel 5 */
     trigger_sprites(xpos + 5, candidate_bits);
-    draw_sprites(5);
+    draw_sprites(5, pri_only);
     /* pixel 6 */
     if (!vicii.color_latency) {
         update_sprite_mc_bits_8565();
@@ -516,14 +522,14 @@ static DRAW_INLINE void draw_sprites8(unsigned int cycle_flags)
     sprite_pri_bits = vicii.regs[0x1b];
     sprite_expx_bits = vicii.regs[0x1d];
     trigger_sprites(xpos + 6, candidate_bits);
-    draw_sprites(6);
+    draw_sprites(6, pri_only);
     /* pixel 7 */
     if (vicii.color_latency) {
         update_sprite_mc_bits_6569();
     }
     sprite_halt_bits &= ~dma_cycle_2;
     trigger_sprites(xpos + 7, candidate_bits);
-    draw_sprites(7);
+    draw_sprites(7, pri_only);
 
     /* pipe xpos */
     update_sprite_xpos();
@@ -659,6 +665,20 @@ static DRAW_INLINE void draw_colors8(void)
     update_cregs();
 }
 
+/* Keep the color registers up to date without drawing.  */
+static DRAW_INLINE void skip_colors8(void)
+{
+    if (vicii.dbuf_offset > VICII_DRAW_BUFFER_SIZE - 8) {
+        return;
+    }
+    if (last_color_reg != 0xff) {
+        cregs[last_color_reg] = last_color_value;
+    }
+    vicii.dbuf_offset += 8;
+
+    update_cregs();
+}
+
 
 /**************************************************************************
  *
@@ -673,13 +693,26 @@ void vicii_draw_cycle(void)
         vicii.dbuf_offset = 0;
     }
 
-    draw_graphics8(cycle_flags_pipe);
+    if (vicii.skip_draw) {
+        /* Skipped frame: only the graphics foreground and the sprite
+           shifters matter, for the collision registers.  The border
+           does not take part in collisions.  */
+        draw_graphics8(cycle_flags_pipe, 1);
+
+        draw_sprites8(cycle_flags_pipe, 1);
 
-    draw_sprites8(cycle_flags_pipe);
+        border_state = vicii.main_border;
+
+        skip_colors8();
+    } else {
+        draw_graphics8(cycle_flags_pipe, 0);
 
-    draw_border8();
+        draw_sprites8(cycle_flags_pipe, 0);
 
-    draw_colors8();
+        draw_border8();
+
+        draw_colors8();
+    }
 
     cycle_flags_pipe = vicii.cycle_flags;
 }
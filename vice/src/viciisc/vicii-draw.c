@@ -94,8 +94,13 @@ inline static void _draw_dummy(uint8_t *p, unsigned int xs, unsigned int xe,
     memcpy(dest, src, (xe - xs + 1) * 8);
 }
 
+/* On frames drawn only for the collisions `vicii.dbuf' is stale, so the
+   frame buffer keeps the last frame that was drawn in full.  */
 static void draw_dummy(void)
 {
+    if (vicii.skip_draw) {
+        return;
+    }
     ALIGN_DRAW_FUNC(_draw_dummy, 0, FULL_WIDTH_CHARS - 1,
                     vicii.raster.gfx_msk);
 }
@@ -103,6 +108,9 @@ static void draw_dummy(void)
 static void draw_dummy_cached(raster_cache_t *cache, unsigned int xs,
                               unsigned int xe)
 {
+    if (vicii.skip_draw) {
+        return;
+    }
     ALIGN_DRAW_FUNC(_draw_dummy, xs, xe, cache->gfx_msk);
 }
 
@@ -114,6 +122,9 @@ static void draw_dummy_foreground(unsigned int start_char,
     uint8_t *src;
     uint8_t *dest;
 
+    if (vicii.skip_draw) {
+        return;
+    }
     src = &(vicii.dbuf[DBUF_OFFSET + start_char * 8]);
     dest = (GFX_PTR() + start_char * 8);
 
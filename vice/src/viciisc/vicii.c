@@ -429,6 +429,23 @@ void vicii_update_memory_ptrs_external(void)
 {
 }
 
+/* Frames that are skipped are drawn only as far as the collision registers
+   need it, unless the frame buffer may still be read: while a movie is
+   recorded, or when a screenshot is taken at exit.  */
+static void vicii_skip_frame(int skip)
+{
+    const char *name = NULL;
+
+    raster_skip_frame(&vicii.raster, skip);
+
+    if (skip && !screenshot_is_recording()) {
+        resources_get_string("ExitScreenshotName", &name);
+        vicii.skip_draw = (name == NULL || *name == 0);
+    } else {
+        vicii.skip_draw = 0;
+    }
+}
+
 /* Redraw the current raster line.  This happens after the last cycle
    of each line.  */
 void vicii_raster_draw_handler(void)
@@ -451,9 +468,8 @@ void vicii_raster_draw_handler(void)
     if (vicii.raster.current_line == 0) {
         /* no vsync here for NTSC  */
         if ((unsigned int)vicii.last_displayed_line < vicii.screen_height) {
-            raster_skip_frame(&vicii.raster,
-                              vsync_do_vsync(vicii.raster.canvas,
-                                             vicii.raster.skip_frame));
+            vicii_skip_frame(vsync_do_vsync(vicii.raster.canvas,
+                                            vicii.raster.skip_frame));
         }
 
     }
@@ -461,9 +477,8 @@ void vicii_raster_draw_handler(void)
     /* vsync for NTSC */
     if ((unsigned int)vicii.last_displayed_line >= vicii.screen_height
         && vicii.raster.current_line == vicii.last_displayed_line - vicii.screen_height + 1) {
-        raster_skip_frame(&vicii.raster,
-                          vsync_do_vsync(vicii.raster.canvas,
-                                         vicii.raster.skip_frame));
+        vicii_skip_frame(vsync_do_vsync(vicii.raster.canvas,
+                                        vicii.raster.skip_frame));
     }
 }
 
@@ -155,6 +155,10 @@ struct vicii_s {
     /* Draw buffer for a full line (one byte per pixel) */
     uint8_t dbuf[VICII_DRAW_BUFFER_SIZE];
 
+    /* Flag: the current frame is not displayed, only the state behind the
+       collision registers is drawn.  */
+    int skip_draw;
+
     /* parsed vicii register fields */
     unsigned int ysmooth;
 
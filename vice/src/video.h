@@ -155,6 +155,13 @@ struct video_render_color_tables_s {
     int32_t line_yuv_0[VIDEO_MAX_OUTPUT_WIDTH * 3];
     int16_t prevrgbline[VIDEO_MAX_OUTPUT_WIDTH * 3];
     uint8_t rgbscratchbuffer[VIDEO_MAX_OUTPUT_WIDTH * 4];
+
+    /* one target line for the render kernels, see video-render-kernel.h */
+    int32_t line_y[VIDEO_MAX_OUTPUT_WIDTH];
+    int32_t line_u[VIDEO_MAX_OUTPUT_WIDTH];
+    int32_t line_v[VIDEO_MAX_OUTPUT_WIDTH];
+    uint32_t line_rgb[VIDEO_MAX_OUTPUT_WIDTH];      /* before packing to 16/24 bits */
+    uint32_t scanline_rgb[VIDEO_MAX_OUTPUT_WIDTH];
 };
 typedef struct video_render_color_tables_s video_render_color_tables_t;
 
@@ -30,77 +30,12 @@
 #include "render1x1crt.h"
 #include "types.h"
 #include "video-color.h"
+#include "video-render-kernel.h"
 
 /*
     right now this is basically the PAL renderer without delay line emulation
 */
 
-static inline
-void yuv_to_rgb(int32_t y, int32_t u, int32_t v,
-                int32_t *red, int32_t *grn, int32_t *blu)
-{
-    *red = (y + v) >> 16;
-    *blu = (y + u) >> 16;
-    *grn = (y - ((50 * u + 130 * v) >> 8)) >> 16;
-}
-
-static inline
-void store_pixel_2(uint8_t *trg, int32_t y1, int32_t u1, int32_t v1, int32_t y2, int32_t u2, int32_t v2)
-{
-    uint16_t *tmp;
-    int32_t red;
-    int32_t grn;
-    int32_t blu;
-
-    yuv_to_rgb(y1, u1, v1, &red, &grn, &blu);
-    tmp = (uint16_t *) trg;
-    tmp[0] = (uint16_t) (gamma_red[256 + red] | gamma_grn[256 + grn] | gamma_blu[256 + blu]);
-
-    yuv_to_rgb(y2, u2, v2, &red, &grn, &blu);
-    tmp[1] = (uint16_t) (gamma_red[256 + red] | gamma_grn[256 + grn] | gamma_blu[256 + blu]);
-}
-
-static inline
-void store_pixel_3(uint8_t *trg, int32_t y1, int32_t u1, int32_t v1, int32_t y2, int32_t u2, int32_t v2)
-{
-    uint32_t tmp;
-    int32_t red;
-    int32_t grn;
-    int32_t blu;
-
-    yuv_to_rgb(y1, u1, v1, &red, &grn, &blu);
-    tmp = gamma_red[256 + red] | gamma_grn[256 + grn] | gamma_blu[256 + blu];
-    trg[0] = (uint8_t) tmp;
-    tmp >>= 8;
-    trg[1] = (uint8_t) tmp;
-    tmp >>= 8;
-    trg[2] = (uint8_t) tmp;
-
-    yuv_to_rgb(y2, u2, v2, &red, &grn, &blu);
-    tmp = gamma_red[256 + red] | gamma_grn[256 + grn] | gamma_blu[256 + blu];
-    trg[3] = (uint8_t) tmp;
-    tmp >>= 8;
-    trg[4] = (uint8_t) tmp;
-    tmp >>= 8;
-    trg[5] = (uint8_t) tmp;
-}
-
-static inline
-void store_pixel_4(uint8_t *trg, int32_t y1, int32_t u1, int32_t v1, int32_t y2, int32_t u2, int32_t v2)
-{
-    uint32_t *tmp;
-    int32_t red;
-    int32_t grn;
-    int32_t blu;
-
-    yuv_to_rgb(y1, u1, v1, &red, &grn, &blu);
-    tmp = (uint32_t *) trg;
-    tmp[0] = gamma_red[256 + red] | gamma_grn[256 + grn] | gamma_blu[256 + blu] | alpha;
-
-    yuv_to_rgb(y2, u2, v2, &red, &grn, &blu);
-    tmp[1] = gamma_red[256 + red] | gamma_grn[256 + grn] | gamma_blu[256 + blu] | alpha;
-}
-
 static inline
 void store_pixel_UYVY(uint8_t *trg, int32_t y1_, int32_t u1, int32_t v1, int32_t y2_, int32_t u2, int32_t v2)
 {
@@ -215,8 +150,16 @@ render_generic_1x1_crt(video_render_color_tables_t *color_tab, const uint8_t *sr
             u2 = (unew) * off_flip;
             v2 = (vnew) * off_flip;
 
-            store_func(tmptrg, l1, u1, v1, l2, u2, v2);
-            tmptrg += pixelstride;
+            if (yuvtarget) {
+                store_func(tmptrg, l1, u1, v1, l2, u2, v2);
+                tmptrg += pixelstride;
+            } else {
+                video_render_kernel_put(color_tab, x * 2, l1, u1, v1);
+                video_render_kernel_put(color_tab, x * 2 + 1, l2, u2, v2);
+            }
+        }
+        if (!yuvtarget) {
+            video_render_kernel_store(color_tab, trg, NULL, width * 2, pixelstride / 2);
         }
 
         src += pitchs;
@@ -273,7 +216,7 @@ render_16_1x1_crt(video_render_color_tables_t *color_tab,
 {
     render_generic_1x1_crt(color_tab, src, trg, width, height, xs, ys, xt, yt,
                             pitchs, pitcht,
-                            4, store_pixel_2, 0);
+                            4, NULL, 0);
 }
 
 void
@@ -286,7 +229,7 @@ render_24_1x1_crt(video_render_color_tables_t *color_tab,
 {
     render_generic_1x1_crt(color_tab, src, trg, width, height, xs, ys, xt, yt,
                             pitchs, pitcht,
-                            6, store_pixel_3, 0);
+                            6, NULL, 0);
 }
 
 void
@@ -299,5 +242,5 @@ render_32_1x1_crt(video_render_color_tables_t *color_tab,
 {
     render_generic_1x1_crt(color_tab, src, trg, width, height, xs, ys, xt, yt,
                             pitchs, pitcht,
-                            8, store_pixel_4, 0);
+                            8, NULL, 0);
 }
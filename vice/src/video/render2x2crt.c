@@ -33,6 +33,7 @@
 #include "render2x2crt.h"
 #include "types.h"
 #include "video-color.h"
+#include "video-render-kernel.h"
 
 /*
     this is the simpliest possible CRT emulation, meaning blur and scanlines only.
@@ -40,107 +41,6 @@
     TODO: use RGB color space
 */
 
-static inline
-void yuv_to_rgb(int32_t y, int32_t u, int32_t v, int16_t *red, int16_t *grn, int16_t *blu)
-{
-#ifdef _MSC_VER
-# pragma warning( push )
-# pragma warning( disable: 4244 )
-#endif
-
-    *red = (y + v) >> 16;
-    *blu = (y + u) >> 16;
-    *grn = (y - ((50 * u + 130 * v) >> 8)) >> 16;
-
-#ifdef _MSC_VER
-# pragma warning( pop )
-#endif
-}
-
-/* Often required function that stores gamma-corrected pixel to current line,
- * averages the current rgb with the contents of previous non-scanline-line,
- * stores the gamma-corrected scanline, and updates the prevline rgb buffer.
- * The variants 4, 3, 2 refer to pixel width of output. */
-
-static inline
-void store_line_and_scanline_2(
-    uint8_t *const line, uint8_t *const scanline,
-    int16_t *const prevline, const int shade, /* ignored by RGB modes */
-    const int32_t y, const int32_t u, const int32_t v)
-{
-    int16_t red, grn, blu;
-    uint16_t *tmp1, *tmp2;
-    yuv_to_rgb(y, u, v, &red, &grn, &blu);
-
-    tmp1 = (uint16_t *) scanline;
-    tmp2 = (uint16_t *) line;
-
-    *tmp1 = (uint16_t) (gamma_red_fac[512 + red + prevline[0]]
-                    | gamma_grn_fac[512 + grn + prevline[1]]
-                    | gamma_blu_fac[512 + blu + prevline[2]]);
-
-    *tmp2 = (uint16_t) (gamma_red[256 + red] | gamma_grn[256 + grn] | gamma_blu[256 + blu]);
-
-    prevline[0] = red;
-    prevline[1] = grn;
-    prevline[2] = blu;
-}
-
-static inline
-void store_line_and_scanline_3(
-    uint8_t *const line, uint8_t *const scanline,
-    int16_t *const prevline, const int shade, /* ignored by RGB modes */
-    const int32_t y, const int32_t u, const int32_t v)
-{
-    uint32_t tmp1, tmp2;
-    int16_t red, grn, blu;
-    yuv_to_rgb(y, u, v, &red, &grn, &blu);
-
-    tmp1 = gamma_red_fac[512 + red + prevline[0]]
-           | gamma_grn_fac[512 + grn + prevline[1]]
-           | gamma_blu_fac[512 + blu + prevline[2]];
-    tmp2 = gamma_red[256 + red] | gamma_grn[256 + grn] | gamma_blu[256 + blu];
-    scanline[0] = (uint8_t) tmp1;
-    tmp1 >>= 8;
-    scanline[1] = (uint8_t) tmp1;
-    tmp1 >>= 8;
-    scanline[2] = (uint8_t) tmp1;
-
-    line[0] = (uint8_t) tmp2;
-    tmp2 >>= 8;
-    line[1] = (uint8_t) tmp2;
-    tmp2 >>= 8;
-    line[2] = (uint8_t) tmp2;
-
-    prevline[0] = red;
-    prevline[1] = grn;
-    prevline[2] = blu;
-}
-
-static inline
-void store_line_and_scanline_4(
-    uint8_t *const line, uint8_t *const scanline,
-    int16_t *const prevline, const int shade, /* ignored by RGB modes */
-    const int32_t y, const int32_t u, const int32_t v)
-{
-    int16_t red, grn, blu;
-    uint32_t *tmp1, *tmp2;
-    yuv_to_rgb(y, u, v, &red, &grn, &blu);
-
-    tmp1 = (uint32_t *) scanline;
-    tmp2 = (uint32_t *) line;
-    *tmp1 = gamma_red_fac[512 + red + prevline[0]]
-            | gamma_grn_fac[512 + grn + prevline[1]]
-            | gamma_blu_fac[512 + blu + prevline[2]]
-            | alpha;
-    *tmp2 = gamma_red[256 + red] | gamma_grn[256 + grn] | gamma_blu[256 + blu]
-            | alpha;
-
-    prevline[0] = red;
-    prevline[1] = grn;
-    prevline[2] = blu;
-}
-
 static inline
 void store_line_and_scanline_UYVY(
     uint8_t *const line, uint8_t *const scanline,
@@ -286,7 +186,7 @@ void render_generic_2x2_crt(video_render_color_tables_t *color_tab,
     const uint8_t *tmpsrc;
     uint8_t *tmptrg, *tmptrgscanline;
     int32_t *cbtable, *crtable;
-    uint32_t x, y, wfirst, wlast, yys;
+    uint32_t x, y, wfirst, wlast, yys, n;
     int32_t l, l2, u, u2, unew, v, v2, vnew, off_flip, shade;
     int first_line = viewport->first_line * 2;
     int last_line = (viewport->last_line * 2) + 1;
@@ -355,6 +255,7 @@ void render_generic_2x2_crt(video_render_color_tables_t *color_tab,
 
         /* actual line */
         prevrgblineptr = &color_tab->prevrgbline[0];
+        n = 0;
         if (wfirst) {
             l2 = ytablel[tmpsrc[1]] + ytableh[tmpsrc[2]] + ytablel[tmpsrc[3]];
             unew += cbtable[tmpsrc[3]];
@@ -365,10 +266,7 @@ void render_generic_2x2_crt(video_render_color_tables_t *color_tab,
             tmpsrc += 1;
 #if 1
             if (write_interpolated_pixels) {
-                store_func(tmptrg, tmptrgscanline, prevrgblineptr, shade, (l + l2) >> 1, (u + u2) >> 1, (v + v2) >> 1);
-                tmptrgscanline += pixelstride;
-                tmptrg += pixelstride;
-                prevrgblineptr += 3;
+                video_render_kernel_put(color_tab, n++, (l + l2) >> 1, (u + u2) >> 1, (v + v2) >> 1);
             }
 #endif
             l = l2;
@@ -377,10 +275,14 @@ void render_generic_2x2_crt(video_render_color_tables_t *color_tab,
         }
         for (x = 0; x < width; x++) {
 #if 1
-            store_func(tmptrg, tmptrgscanline, prevrgblineptr, shade, l, u, v);
-            tmptrgscanline += pixelstride;
-            tmptrg += pixelstride;
-            prevrgblineptr += 3;
+            if (write_interpolated_pixels) {
+                video_render_kernel_put(color_tab, n++, l, u, v);
+            } else {
+                store_func(tmptrg, tmptrgscanline, prevrgblineptr, shade, l, u, v);
+                tmptrgscanline += pixelstride;
+                tmptrg += pixelstride;
+                prevrgblineptr += 3;
+            }
 #endif
             l2 = ytablel[tmpsrc[1]] + ytableh[tmpsrc[2]] + ytablel[tmpsrc[3]];
             unew += cbtable[tmpsrc[3]];
@@ -391,10 +293,7 @@ void render_generic_2x2_crt(video_render_color_tables_t *color_tab,
             tmpsrc += 1;
 #if 1
             if (write_interpolated_pixels) {
-                store_func(tmptrg, tmptrgscanline, prevrgblineptr, shade, (l + l2) >> 1, (u + u2) >> 1, (v + v2) >> 1);
-                tmptrgscanline += pixelstride;
-                tmptrg += pixelstride;
-                prevrgblineptr += 3;
+                video_render_kernel_put(color_tab, n++, (l + l2) >> 1, (u + u2) >> 1, (v + v2) >> 1);
             }
 #endif
             l = l2;
@@ -402,7 +301,14 @@ void render_generic_2x2_crt(video_render_color_tables_t *color_tab,
             v = v2;
         }
         if (wlast) {
-            store_func(tmptrg, tmptrgscanline, prevrgblineptr, shade, l, u, v);
+            if (write_interpolated_pixels) {
+                video_render_kernel_put(color_tab, n++, l, u, v);
+            } else {
+                store_func(tmptrg, tmptrgscanline, prevrgblineptr, shade, l, u, v);
+            }
+        }
+        if (write_interpolated_pixels) {
+            video_render_kernel_store(color_tab, tmptrg, tmptrgscanline, n, pixelstride);
         }
 
         src += pitchs;
@@ -459,7 +365,7 @@ void render_16_2x2_crt(video_render_color_tables_t *color_tab,
 {
     render_generic_2x2_crt(color_tab, src, trg, width, height, xs, ys,
                            xt, yt, pitchs, pitcht, viewport,
-                           2, store_line_and_scanline_2, 1, config);
+                           2, NULL, 1, config);
 }
 
 void render_24_2x2_crt(video_render_color_tables_t *color_tab,
@@ -472,7 +378,7 @@ void render_24_2x2_crt(video_render_color_tables_t *color_tab,
 {
     render_generic_2x2_crt(color_tab, src, trg, width, height, xs, ys,
                            xt, yt, pitchs, pitcht, viewport,
-                           3, store_line_and_scanline_3, 1, config);
+                           3, NULL, 1, config);
 }
 
 void render_32_2x2_crt(video_render_color_tables_t *color_tab,
@@ -485,5 +391,5 @@ void render_32_2x2_crt(video_render_color_tables_t *color_tab,
 {
     render_generic_2x2_crt(color_tab, src, trg, width, height, xs, ys,
                            xt, yt, pitchs, pitcht, viewport,
-                           4, store_line_and_scanline_4, 1, config);
+                           4, NULL, 1, config);
 }
@@ -41,6 +41,7 @@
 
 #include "videoarch.h"
 
+#include "capture.h"
 #include "lib.h"
 #include "log.h"
 #include "machine.h"
@@ -837,7 +838,8 @@ static palette_t *video_load_palette(const video_cbm_palette_t *p,
         return NULL;
     }
 
-    if (!video_disabled_mode && palette_load(name, palette) < 0) {
+    if ((!video_disabled_mode || capture_enabled())
+        && palette_load(name, palette) < 0) {
         /* log_message(vicii.log, "Cannot load palette file `%s'.", name); */
         return NULL;
     }
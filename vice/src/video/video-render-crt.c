@@ -48,6 +48,7 @@
 #include "renderscale2x.h"
 #include "resources.h"
 #include "types.h"
+#include "video-render-kernel.h"
 #include "video-render.h"
 #include "video.h"
 
@@ -262,5 +263,6 @@ static void video_render_crt_main(video_render_config_t *config,
 
 void video_render_crt_init(void)
 {
+    video_render_kernel_init();
     video_render_crtfunc_set(video_render_crt_main);
 }
@@ -0,0 +1,486 @@
+/*
+ * video-render-kernel.c - YUV to RGB line kernels for the PAL/CRT renderers.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* The renderers work out the YUV value of each target pixel of a line and
+   the kernels here turn the line into RGB:
+
+    R = Y + V
+    G = Y - (0.1953 * U + 0.5078 * V)
+    B = Y + U
+
+   followed by the gamma table lookups.  The scanline kernels also blend
+   each pixel with the one of the previous line, which they keep in
+   `prevrgbline' with the reds first, then the greens, then the blues, each
+   VIDEO_MAX_OUTPUT_WIDTH entries apart.
+
+   The SSE2 and NEON kernels do the arithmetic four pixels at a time and
+   leave the table lookups to scalar code.  The AVX2 kernels do eight pixels
+   at a time including the lookups, and are picked at run time when the CPU
+   has AVX2.  Every kernel gives exactly the pixels of the scalar one.  */
+
+#include "vice.h"
+
+#include <stdio.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_KERNEL_AVX2
+#define KERNEL_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+
+#if defined(__SSE2__)
+#define HAVE_KERNEL_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON)
+#define HAVE_KERNEL_NEON
+#include <arm_neon.h>
+#endif
+
+#include "types.h"
+#include "video-color.h"
+#include "video-render-kernel.h"
+#include "video.h"
+
+#define PREV_RED(t) ((t)->prevrgbline)
+#define PREV_GRN(t) ((t)->prevrgbline + VIDEO_MAX_OUTPUT_WIDTH)
+#define PREV_BLU(t) ((t)->prevrgbline + VIDEO_MAX_OUTPUT_WIDTH * 2)
+
+/* Convert pixels `i' up to `n' of the queued line to `line', and for the
+   scanline kernels also to `scanline'.  */
+typedef void (*kernel_func_t)(uint32_t *line, uint32_t *scanline,
+                              video_render_color_tables_t *t,
+                              unsigned int i, unsigned int n, uint32_t a);
+
+static int kernel = VIDEO_RENDER_KERNEL_SCALAR;
+
+/* ------------------------------------------------------------------------- */
+
+static void line_scalar(uint32_t *line, uint32_t *scanline,
+                        video_render_color_tables_t *t,
+                        unsigned int i, unsigned int n, uint32_t a)
+{
+    int32_t red, grn, blu;
+
+    for (; i < n; i++) {
+        red = (t->line_y[i] + t->line_v[i]) >> 16;
+        blu = (t->line_y[i] + t->line_u[i]) >> 16;
+        grn = (t->line_y[i] - ((50 * t->line_u[i] + 130 * t->line_v[i]) >> 8)) >> 16;
+
+        line[i] = gamma_red[256 + red] | gamma_grn[256 + grn] | gamma_blu[256 + blu] | a;
+    }
+}
+
+static void scanline_scalar(uint32_t *line, uint32_t *scanline,
+                            video_render_color_tables_t *t,
+                            unsigned int i, unsigned int n, uint32_t a)
+{
+    int16_t *prev_red = PREV_RED(t);
+    int16_t *prev_grn = PREV_GRN(t);
+    int16_t *prev_blu = PREV_BLU(t);
+    int32_t red, grn, blu;
+
+    for (; i < n; i++) {
+        red = (t->line_y[i] + t->line_v[i]) >> 16;
+        blu = (t->line_y[i] + t->line_u[i]) >> 16;
+        grn = (t->line_y[i] - ((50 * t->line_u[i] + 130 * t->line_v[i]) >> 8)) >> 16;
+
+        scanline[i] = gamma_red_fac[512 + red + prev_red[i]]
+                      | gamma_grn_fac[512 + grn + prev_grn[i]]
+                      | gamma_blu_fac[512 + blu + prev_blu[i]]
+                      | a;
+        line[i] = gamma_red[256 + red] | gamma_grn[256 + grn] | gamma_blu[256 + blu] | a;
+
+        prev_red[i] = (int16_t)red;
+        prev_grn[i] = (int16_t)grn;
+        prev_blu[i] = (int16_t)blu;
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+#ifdef HAVE_KERNEL_SSE2
+
+/* 50 * u + 130 * v with shifts, SSE2 has no 32 bit multiply.  */
+static inline void yuv_to_rgb_sse2(const video_render_color_tables_t *t,
+                                   unsigned int i,
+                                   int32_t *red, int32_t *grn, int32_t *blu)
+{
+    __m128i y = _mm_loadu_si128((const __m128i *)(t->line_y + i));
+    __m128i u = _mm_loadu_si128((const __m128i *)(t->line_u + i));
+    __m128i v = _mm_loadu_si128((const __m128i *)(t->line_v + i));
+    __m128i uv = _mm_add_epi32(_mm_add_epi32(_mm_slli_epi32(u, 5), _mm_slli_epi32(u, 4)),
+                               _mm_add_epi32(_mm_slli_epi32(u, 1), _mm_slli_epi32(v, 1)));
+
+    uv = _mm_add_epi32(uv, _mm_slli_epi32(v, 7));
+    _mm_storeu_si128((__m128i *)red, _mm_srai_epi32(_mm_add_epi32(y, v), 16));
+    _mm_storeu_si128((__m128i *)blu, _mm_srai_epi32(_mm_add_epi32(y, u), 16));
+    _mm_storeu_si128((__m128i *)grn, _mm_srai_epi32(_mm_sub_epi32(y, _mm_srai_epi32(uv, 8)), 16));
+}
+
+static void line_sse2(uint32_t *line, uint32_t *scanline,
+                      video_render_color_tables_t *t,
+                      unsigned int i, unsigned int n, uint32_t a)
+{
+    int32_t red[4], grn[4], blu[4];
+    int k;
+
+    for (; i + 4 <= n; i += 4) {
+        yuv_to_rgb_sse2(t, i, red, grn, blu);
+        for (k = 0; k < 4; k++) {
+            line[i + k] = gamma_red[256 + red[k]] | gamma_grn[256 + grn[k]] | gamma_blu[256 + blu[k]] | a;
+        }
+    }
+    line_scalar(line, scanline, t, i, n, a);
+}
+
+static void scanline_sse2(uint32_t *line, uint32_t *scanline,
+                          video_render_color_tables_t *t,
+                          unsigned int i, unsigned int n, uint32_t a)
+{
+    int16_t *prev[3];
+    int32_t rgb[3][4], sum[3][4];
+    __m128i p;
+    int c, k;
+
+    prev[0] = PREV_RED(t);
+    prev[1] = PREV_GRN(t);
+    prev[2] = PREV_BLU(t);
+
+    for (; i + 4 <= n; i += 4) {
+        yuv_to_rgb_sse2(t, i, rgb[0], rgb[1], rgb[2]);
+        for (c = 0; c < 3; c++) {
+            __m128i cur = _mm_loadu_si128((const __m128i *)rgb[c]);
+
+            p = _mm_loadl_epi64((const __m128i *)(prev[c] + i));
+            p = _mm_srai_epi32(_mm_unpacklo_epi16(p, p), 16);
+            _mm_storeu_si128((__m128i *)sum[c], _mm_add_epi32(cur, p));
+            _mm_storel_epi64((__m128i *)(prev[c] + i), _mm_packs_epi32(cur, cur));
+        }
+        for (k = 0; k < 4; k++) {
+            scanline[i + k] = gamma_red_fac[512 + sum[0][k]]
+                              | gamma_grn_fac[512 + sum[1][k]]
+                              | gamma_blu_fac[512 + sum[2][k]]
+                              | a;
+            line[i + k] = gamma_red[256 + rgb[0][k]] | gamma_grn[256 + rgb[1][k]] | gamma_blu[256 + rgb[2][k]] | a;
+        }
+    }
+    scanline_scalar(line, scanline, t, i, n, a);
+}
+
+#endif
+
+/* ------------------------------------------------------------------------- */
+
+#ifdef HAVE_KERNEL_AVX2
+
+static inline KERNEL_AVX2 void yuv_to_rgb_avx2(const video_render_color_tables_t *t,
+                                               unsigned int i,
+                                               __m256i *red, __m256i *grn, __m256i *blu)
+{
+    __m256i y = _mm256_loadu_si256((const __m256i *)(t->line_y + i));
+    __m256i u = _mm256_loadu_si256((const __m256i *)(t->line_u + i));
+    __m256i v = _mm256_loadu_si256((const __m256i *)(t->line_v + i));
+    __m256i uv = _mm256_add_epi32(_mm256_mullo_epi32(u, _mm256_set1_epi32(50)),
+                                  _mm256_mullo_epi32(v, _mm256_set1_epi32(130)));
+
+    *red = _mm256_srai_epi32(_mm256_add_epi32(y, v), 16);
+    *blu = _mm256_srai_epi32(_mm256_add_epi32(y, u), 16);
+    *grn = _mm256_srai_epi32(_mm256_sub_epi32(y, _mm256_srai_epi32(uv, 8)), 16);
+}
+
+static KERNEL_AVX2 void line_avx2(uint32_t *line, uint32_t *scanline,
+                                  video_render_color_tables_t *t,
+                                  unsigned int i, unsigned int n, uint32_t a)
+{
+    __m256i red, grn, blu, pixel;
+
+    for (; i + 8 <= n; i += 8) {
+        yuv_to_rgb_avx2(t, i, &red, &grn, &blu);
+        pixel = _mm256_or_si256(_mm256_i32gather_epi32((const int *)(gamma_red + 256), red, 4),
+                                _mm256_i32gather_epi32((const int *)(gamma_grn + 256), grn, 4));
+        pixel = _mm256_or_si256(pixel, _mm256_i32gather_epi32((const int *)(gamma_blu + 256), blu, 4));
+        pixel = _mm256_or_si256(pixel, _mm256_set1_epi32((int)a));
+        _mm256_storeu_si256((__m256i *)(line + i), pixel);
+    }
+    line_scalar(line, scanline, t, i, n, a);
+}
+
+static KERNEL_AVX2 void scanline_avx2(uint32_t *line, uint32_t *scanline,
+                                      video_render_color_tables_t *t,
+                                      unsigned int i, unsigned int n, uint32_t a)
+{
+    int16_t *prev_red = PREV_RED(t);
+    int16_t *prev_grn = PREV_GRN(t);
+    int16_t *prev_blu = PREV_BLU(t);
+    __m256i red, grn, blu, pixel, sr, sg, sb;
+
+    for (; i + 8 <= n; i += 8) {
+        yuv_to_rgb_avx2(t, i, &red, &grn, &blu);
+
+        sr = _mm256_add_epi32(red, _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(prev_red + i))));
+        sg = _mm256_add_epi32(grn, _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(prev_grn + i))));
+        sb = _mm256_add_epi32(blu, _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(prev_blu + i))));
+        pixel = _mm256_or_si256(_mm256_i32gather_epi32((const int *)(gamma_red_fac + 512), sr, 4),
+                                _mm256_i32gather_epi32((const int *)(gamma_grn_fac + 512), sg, 4));
+        pixel = _mm256_or_si256(pixel, _mm256_i32gather_epi32((const int *)(gamma_blu_fac + 512), sb, 4));
+        pixel = _mm256_or_si256(pixel, _mm256_set1_epi32((int)a));
+        _mm256_storeu_si256((__m256i *)(scanline + i), pixel);
+
+        pixel = _mm256_or_si256(_mm256_i32gather_epi32((const int *)(gamma_red + 256), red, 4),
+                                _mm256_i32gather_epi32((const int *)(gamma_grn + 256), grn, 4));
+        pixel = _mm256_or_si256(pixel, _mm256_i32gather_epi32((const int *)(gamma_blu + 256), blu, 4));
+        pixel = _mm256_or_si256(pixel, _mm256_set1_epi32((int)a));
+        _mm256_storeu_si256((__m256i *)(line + i), pixel);
+
+        _mm_storeu_si128((__m128i *)(prev_red + i),
+                         _mm_packs_epi32(_mm256_castsi256_si128(red), _mm256_extracti128_si256(red, 1)));
+        _mm_storeu_si128((__m128i *)(prev_grn + i),
+                         _mm_packs_epi32(_mm256_castsi256_si128(grn), _mm256_extracti128_si256(grn, 1)));
+        _mm_storeu_si128((__m128i *)(prev_blu + i),
+                         _mm_packs_epi32(_mm256_castsi256_si128(blu), _mm256_extracti128_si256(blu, 1)));
+    }
+    scanline_scalar(line, scanline, t, i, n, a);
+}
+
+static int cpu_has_avx2(void)
+{
+#if defined(__AVX2__)
+    return 1;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif
+
+/* ------------------------------------------------------------------------- */
+
+#ifdef HAVE_KERNEL_NEON
+
+static inline void yuv_to_rgb_neon(const video_render_color_tables_t *t,
+                                   unsigned int i,
+                                   int32x4_t *red, int32x4_t *grn, int32x4_t *blu)
+{
+    int32x4_t y = vld1q_s32(t->line_y + i);
+    int32x4_t u = vld1q_s32(t->line_u + i);
+    int32x4_t v = vld1q_s32(t->line_v + i);
+    int32x4_t uv = vaddq_s32(vmulq_n_s32(u, 50), vmulq_n_s32(v, 130));
+
+    *red = vshrq_n_s32(vaddq_s32(y, v), 16);
+    *blu = vshrq_n_s32(vaddq_s32(y, u), 16);
+    *grn = vshrq_n_s32(vsubq_s32(y, vshrq_n_s32(uv, 8)), 16);
+}
+
+static void line_neon(uint32_t *line, uint32_t *scanline,
+                      video_render_color_tables_t *t,
+                      unsigned int i, unsigned int n, uint32_t a)
+{
+    int32x4_t vr, vg, vb;
+    int32_t red[4], grn[4], blu[4];
+    int k;
+
+    for (; i + 4 <= n; i += 4) {
+        yuv_to_rgb_neon(t, i, &vr, &vg, &vb);
+        vst1q_s32(red, vr);
+        vst1q_s32(grn, vg);
+        vst1q_s32(blu, vb);
+        for (k = 0; k < 4; k++) {
+            line[i + k] = gamma_red[256 + red[k]] | gamma_grn[256 + grn[k]] | gamma_blu[256 + blu[k]] | a;
+        }
+    }
+    line_scalar(line, scanline, t, i, n, a);
+}
+
+static void scanline_neon(uint32_t *line, uint32_t *scanline,
+                          video_render_color_tables_t *t,
+                          unsigned int i, unsigned int n, uint32_t a)
+{
+    int16_t *prev[3];
+    int32x4_t cur[3];
+    int32_t rgb[3][4], sum[3][4];
+    int c, k;
+
+    prev[0] = PREV_RED(t);
+    prev[1] = PREV_GRN(t);
+    prev[2] = PREV_BLU(t);
+
+    for (; i + 4 <= n; i += 4) {
+        yuv_to_rgb_neon(t, i, &cur[0], &cur[1], &cur[2]);
+        for (c = 0; c < 3; c++) {
+            vst1q_s32(rgb[c], cur[c]);
+            vst1q_s32(sum[c], vaddq_s32(cur[c], vmovl_s16(vld1_s16(prev[c] + i))));
+            vst1_s16(prev[c] + i, vmovn_s32(cur[c]));
+        }
+        for (k = 0; k < 4; k++) {
+            scanline[i + k] = gamma_red_fac[512 + sum[0][k]]
+                              | gamma_grn_fac[512 + sum[1][k]]
+                              | gamma_blu_fac[512 + sum[2][k]]
+                              | a;
+            line[i + k] = gamma_red[256 + rgb[0][k]] | gamma_grn[256 + rgb[1][k]] | gamma_blu[256 + rgb[2][k]] | a;
+        }
+    }
+    scanline_scalar(line, scanline, t, i, n, a);
+}
+
+#endif
+
+/* ------------------------------------------------------------------------- */
+
+static const struct {
+    const char *name;
+    kernel_func_t line;
+    kernel_func_t scanline;
+} kernels[VIDEO_RENDER_KERNEL_NUM] = {
+    { "scalar", line_scalar, scanline_scalar },
+#ifdef HAVE_KERNEL_SSE2
+    { "SSE2", line_sse2, scanline_sse2 },
+#else
+    { "SSE2", NULL, NULL },
+#endif
+#ifdef HAVE_KERNEL_AVX2
+    { "AVX2", line_avx2, scanline_avx2 },
+#else
+    { "AVX2", NULL, NULL },
+#endif
+#ifdef HAVE_KERNEL_NEON
+    { "NEON", line_neon, scanline_neon }
+#else
+    { "NEON", NULL, NULL }
+#endif
+};
+
+int video_render_kernel_available(int k)
+{
+    if (k < 0 || k >= VIDEO_RENDER_KERNEL_NUM || kernels[k].line == NULL) {
+        return 0;
+    }
+#ifdef HAVE_KERNEL_AVX2
+    if (k == VIDEO_RENDER_KERNEL_AVX2) {
+        return cpu_has_avx2();
+    }
+#endif
+    return 1;
+}
+
+/* Pick the widest kernel the CPU runs.  */
+void video_render_kernel_init(void)
+{
+    int k;
+
+    for (k = VIDEO_RENDER_KERNEL_NUM - 1; k > VIDEO_RENDER_KERNEL_SCALAR; k--) {
+        if (video_render_kernel_available(k)) {
+            break;
+        }
+    }
+    kernel = k;
+}
+
+int video_render_kernel_set(int k)
+{
+    if (!video_render_kernel_available(k)) {
+        return -1;
+    }
+    kernel = k;
+    return 0;
+}
+
+int video_render_kernel_get(void)
+{
+    return kernel;
+}
+
+const char *video_render_kernel_name(int k)
+{
+    if (k < 0 || k >= VIDEO_RENDER_KERNEL_NUM) {
+        return "unknown";
+    }
+    return kernels[k].name;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void pack_2(uint8_t *trg, const uint32_t *src, unsigned int n)
+{
+    uint16_t *tmp = (uint16_t *)trg;
+    unsigned int i;
+
+    for (i = 0; i < n; i++) {
+        tmp[i] = (uint16_t)src[i];
+    }
+}
+
+static void pack_3(uint8_t *trg, const uint32_t *src, unsigned int n)
+{
+    unsigned int i;
+
+    for (i = 0; i < n; i++) {
+        trg[0] = (uint8_t)src[i];
+        trg[1] = (uint8_t)(src[i] >> 8);
+        trg[2] = (uint8_t)(src[i] >> 16);
+        trg += 3;
+    }
+}
+
+/* Convert the `n' pixels queued for the current target line and store them
+   to `line', with `pixelstride' bytes per pixel.  With `scanline' not NULL
+   also store the scanline below the previous line and remember this line
+   for the next scanline.  32 bit pixels are written straight to the
+   target, 16 and 24 bit pixels are packed from a scratch line.  */
+void video_render_kernel_store(video_render_color_tables_t *color_tab,
+                               uint8_t *line, uint8_t *scanline,
+                               unsigned int n, unsigned int pixelstride)
+{
+    uint32_t *line32, *scanline32;
+    uint32_t a;
+
+    if (pixelstride == 4) {
+        line32 = (uint32_t *)line;
+        scanline32 = (uint32_t *)scanline;
+        a = alpha;
+    } else {
+        line32 = color_tab->line_rgb;
+        scanline32 = color_tab->scanline_rgb;
+        a = 0;
+    }
+
+    if (scanline != NULL) {
+        kernels[kernel].scanline(line32, scanline32, color_tab, 0, n, a);
+    } else {
+        kernels[kernel].line(line32, NULL, color_tab, 0, n, a);
+    }
+
+    if (pixelstride == 2) {
+        pack_2(line, line32, n);
+        if (scanline != NULL) {
+            pack_2(scanline, scanline32, n);
+        }
+    } else if (pixelstride == 3) {
+        pack_3(line, line32, n);
+        if (scanline != NULL) {
+            pack_3(scanline, scanline32, n);
+        }
+    }
+}
@@ -0,0 +1,58 @@
+/*
+ * video-render-kernel.h - YUV to RGB line kernels for the PAL/CRT renderers.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_VIDEO_RENDER_KERNEL_H
+#define VICE_VIDEO_RENDER_KERNEL_H
+
+#include "types.h"
+#include "video.h"
+
+#define VIDEO_RENDER_KERNEL_SCALAR  0
+#define VIDEO_RENDER_KERNEL_SSE2    1
+#define VIDEO_RENDER_KERNEL_AVX2    2
+#define VIDEO_RENDER_KERNEL_NEON    3
+#define VIDEO_RENDER_KERNEL_NUM     4
+
+extern void video_render_kernel_init(void);
+extern int video_render_kernel_available(int kernel);
+extern int video_render_kernel_set(int kernel);
+extern int video_render_kernel_get(void);
+extern const char *video_render_kernel_name(int kernel);
+
+/* The RGB modes queue the YUV value of each target pixel of a line with
+   video_render_kernel_put() and convert the whole line at once with
+   video_render_kernel_store().  */
+static inline void video_render_kernel_put(video_render_color_tables_t *color_tab,
+                                           unsigned int i,
+                                           int32_t y, int32_t u, int32_t v)
+{
+    color_tab->line_y[i] = y;
+    color_tab->line_u[i] = u;
+    color_tab->line_v[i] = v;
+}
+
+extern void video_render_kernel_store(video_render_color_tables_t *color_tab,
+                                      uint8_t *line, uint8_t *scanline,
+                                      unsigned int n, unsigned int pixelstride);
+
+#endif
@@ -43,6 +43,7 @@
 #include "renderscale2x.h"
 #include "resources.h"
 #include "types.h"
+#include "video-render-kernel.h"
 #include "video-render.h"
 #include "video.h"
 
@@ -221,5 +222,6 @@ static void video_render_pal_main(video_render_config_t *config,
 
 void video_render_pal_init(void)
 {
+    video_render_kernel_init();
     video_render_palfunc_set(video_render_pal_main);
 }
@@ -0,0 +1,332 @@
+/*
+ * video-render-thread.c - Render CRT emulation frames in bands on worker threads.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* The PAL and CRT renderers only carry state from one source line to the
+   next in the delay line and the previous RGB line of the color tables.
+   Both are rebuilt from the line above the first one when a renderer is
+   called, and the scanline between two calls is written by the upper
+   call.  A frame can therefore be split into horizontal bands that are
+   rendered at the same time, each with its own copy of the render config
+   holding those buffers.  The main thread renders the first band, one
+   worker per additional band renders the rest, and
+   `video_render_thread_run()' only returns when the whole frame is done.
+
+   Band borders are kept away from the first and last visible line of the
+   viewport, where the renderers treat scanlines specially, so the output
+   is the same as when the frame is rendered in one go.  */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "archdep_thread.h"
+#include "lib.h"
+#include "log.h"
+#include "types.h"
+#include "video-render-thread.h"
+#include "video.h"
+#include "viewport.h"
+
+/* Bands with fewer source lines are not worth a thread.  */
+#define BAND_MIN_LINES 16
+
+typedef struct render_band_s {
+    video_render_config_t *config;
+    viewport_t viewport;
+    viewport_t *viewport_ptr;
+    int height;
+    int ys;
+    int yt;
+} render_band_t;
+
+static int render_threads = 0;
+static int threads_running = 0;
+
+/* Job state, protected by `job_lock'.  */
+static video_render_band_func_t job_func;
+static uint8_t *job_src;
+static uint8_t *job_trg;
+static int job_width, job_xs, job_xt, job_pitchs, job_pitcht, job_depth;
+static unsigned int job_go;
+static unsigned int job_done;
+static int threads_quit;
+
+static render_band_t bands[VIDEO_RENDER_THREADS_MAX];
+static video_render_config_t *band_configs[VIDEO_RENDER_THREADS_MAX];
+
+static archdep_thread_t *threads[VIDEO_RENDER_THREADS_MAX];
+static archdep_mutex_t *job_lock = NULL;
+static archdep_cond_t *job_cond = NULL;
+
+/* ------------------------------------------------------------------------- */
+
+static void render_band(int band)
+{
+    render_band_t *b = &bands[band];
+
+    if (b->height > 0) {
+        job_func(b->config, job_src, job_trg, job_width, b->height,
+                 job_xs, b->ys, job_xt, b->yt, job_pitchs, job_pitcht,
+                 job_depth, b->viewport_ptr);
+    }
+}
+
+static void render_thread_main(void *data)
+{
+    int band = vice_ptr_to_int(data);
+    unsigned int bit = 1U << band;
+
+    archdep_mutex_lock(job_lock);
+
+    while (1) {
+        while (!(job_go & bit) && !threads_quit) {
+            archdep_cond_wait(job_cond, job_lock);
+        }
+        if (threads_quit) {
+            break;
+        }
+        job_go &= ~bit;
+        archdep_mutex_unlock(job_lock);
+
+        render_band(band);
+
+        archdep_mutex_lock(job_lock);
+        job_done |= bit;
+        archdep_cond_broadcast(job_cond);
+    }
+
+    archdep_mutex_unlock(job_lock);
+}
+
+static int render_thread_start(void)
+{
+    int band;
+
+    job_lock = archdep_mutex_new();
+    job_cond = archdep_cond_new();
+    threads_quit = 0;
+    job_go = 0;
+    threads_running = render_threads;
+
+    /* the main thread renders the first band with the canvas' own config */
+    for (band = 1; band < threads_running; band++) {
+        band_configs[band] = lib_malloc(sizeof(video_render_config_t));
+        threads[band] = archdep_thread_create(render_thread_main,
+                                              int_to_void_ptr(band));
+        if (threads[band] == NULL) {
+            log_error(LOG_DEFAULT, "VideoRenderThreads: cannot create render thread.");
+            video_render_thread_shutdown();
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void video_render_thread_shutdown(void)
+{
+    int band;
+
+    if (job_lock == NULL) {
+        return;
+    }
+
+    archdep_mutex_lock(job_lock);
+    threads_quit = 1;
+    archdep_cond_broadcast(job_cond);
+    archdep_mutex_unlock(job_lock);
+
+    for (band = 1; band < VIDEO_RENDER_THREADS_MAX; band++) {
+        if (threads[band] != NULL) {
+            archdep_thread_join(threads[band]);
+            threads[band] = NULL;
+        }
+        lib_free(band_configs[band]);
+        band_configs[band] = NULL;
+    }
+
+    archdep_cond_destroy(job_cond);
+    archdep_mutex_destroy(job_lock);
+    job_cond = NULL;
+    job_lock = NULL;
+    threads_running = 0;
+}
+
+/* Set the number of bands a frame is split into, 0 or 1 renders frames on
+   the calling thread only.  */
+int video_render_thread_set_count(int count)
+{
+    if (count < 0 || count > VIDEO_RENDER_THREADS_MAX) {
+        return -1;
+    }
+
+    if (count > 1 && !archdep_thread_available()) {
+        log_warning(LOG_DEFAULT, "VideoRenderThreads: threads are not supported on this system.");
+        return -1;
+    }
+
+    if (count != threads_running) {
+        video_render_thread_shutdown();
+    }
+    render_threads = count;
+
+    return 0;
+}
+
+/* Number of target lines per source line of the PAL and CRT modes.  */
+static int render_scale_y(int rendermode)
+{
+    switch (rendermode) {
+        case VIDEO_RENDER_PAL_1X1:
+        case VIDEO_RENDER_CRT_1X1:
+            return 1;
+        case VIDEO_RENDER_PAL_2X2:
+        case VIDEO_RENDER_CRT_1X2:
+        case VIDEO_RENDER_CRT_2X2:
+            return 2;
+        case VIDEO_RENDER_CRT_2X4:
+            return 4;
+    }
+    return 0;
+}
+
+/* Whether a band may start `start' source lines into the frame.  The 2x4
+   renderer numbers its lines from half the first source line.  */
+static int band_border_ok(int scale, int ys, int start, const viewport_t *viewport)
+{
+    unsigned int line = (unsigned int)((scale == 4 ? ys / 2 : ys) + start);
+
+    return line > viewport->first_line + 2 && line + 2 < viewport->last_line;
+}
+
+/* Render the frame in bands on the render threads.  Return 0 on success or
+   -1 if the caller has to render the frame itself.  */
+int video_render_thread_run(video_render_band_func_t func,
+                            video_render_config_t *config,
+                            uint8_t *src, uint8_t *trg,
+                            int width, int height, int xs, int ys,
+                            int xt, int yt, int pitchs, int pitcht,
+                            int depth, viewport_t *viewport)
+{
+    int scale, lines, count, band, start, next;
+    unsigned int mask;
+
+    scale = render_scale_y(config->rendermode);
+    if (render_threads < 2 || scale == 0 || height <= 0) {
+        return -1;
+    }
+
+    lines = height / scale;
+    count = render_threads;
+    if (count > lines / BAND_MIN_LINES) {
+        count = lines / BAND_MIN_LINES;
+    }
+    if (count < 2) {
+        return -1;
+    }
+
+    if (job_lock == NULL && render_thread_start() < 0) {
+        render_threads = 0;
+        return -1;
+    }
+
+    /* split into bands of whole source lines */
+    start = 0;
+    for (band = 0; band < count; band++) {
+        render_band_t *b = &bands[band];
+
+        if (band == count - 1) {
+            next = lines;
+        } else {
+            next = lines * (band + 1) / count;
+            /* the 2x4 renderer counts lines in half steps, keep its line
+               numbers aligned with the viewport */
+            if (scale == 4) {
+                next &= ~1;
+            }
+            while (next < lines && !band_border_ok(scale, ys, next, viewport)) {
+                next += (scale == 4) ? 2 : 1;
+            }
+            if (next >= lines) {
+                next = lines;
+            }
+        }
+
+        b->ys = ys + start;
+        b->yt = yt + start * scale;
+        b->height = (next == lines) ? height - start * scale : (next - start) * scale;
+        b->viewport_ptr = viewport;
+
+        if (band == 0) {
+            b->config = config;
+        } else {
+            b->config = band_configs[band];
+            memcpy(b->config, config, sizeof(video_render_config_t));
+            if (scale == 4) {
+                /* the 2x4 renderer compares (ys * 2 + 4 * line) with the
+                   viewport, so shift the viewport by what the later start
+                   moves that origin */
+                unsigned int shift = (unsigned int)start / 2;
+
+                b->viewport = *viewport;
+                b->viewport.first_line = viewport->first_line > shift ? viewport->first_line - shift : 0;
+                b->viewport.last_line = viewport->last_line > shift ? viewport->last_line - shift : 0;
+                b->viewport_ptr = &b->viewport;
+            }
+        }
+
+        if (next >= lines) {
+            count = band + 1;
+            break;
+        }
+        start = next;
+    }
+
+    mask = (1U << count) - 1;
+
+    archdep_mutex_lock(job_lock);
+    job_func = func;
+    job_src = src;
+    job_trg = trg;
+    job_width = width;
+    job_xs = xs;
+    job_xt = xt;
+    job_pitchs = pitchs;
+    job_pitcht = pitcht;
+    job_depth = depth;
+    job_done = 0;
+    job_go = mask & ~1U;
+    archdep_cond_broadcast(job_cond);
+    archdep_mutex_unlock(job_lock);
+
+    render_band(0);
+
+    archdep_mutex_lock(job_lock);
+    job_done |= 1U;
+    while (job_done != mask) {
+        archdep_cond_wait(job_cond, job_lock);
+    }
+    archdep_mutex_unlock(job_lock);
+
+    return 0;
+}
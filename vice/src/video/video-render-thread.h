@@ -0,0 +1,50 @@
+/*
+ * video-render-thread.h - Render CRT emulation frames in bands on worker threads.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_VIDEO_RENDER_THREAD_H
+#define VICE_VIDEO_RENDER_THREAD_H
+
+#include "types.h"
+#include "viewport.h"
+
+#define VIDEO_RENDER_THREADS_MAX 16
+
+struct video_render_config_s;
+
+typedef void (*video_render_band_func_t)(struct video_render_config_s *config,
+                                         uint8_t *src, uint8_t *trg,
+                                         int width, int height, int xs, int ys,
+                                         int xt, int yt, int pitchs, int pitcht,
+                                         int depth, viewport_t *viewport);
+
+extern int video_render_thread_set_count(int count);
+extern void video_render_thread_shutdown(void);
+
+extern int video_render_thread_run(video_render_band_func_t func,
+                                   struct video_render_config_s *config,
+                                   uint8_t *src, uint8_t *trg,
+                                   int width, int height, int xs, int ys,
+                                   int xt, int yt, int pitchs, int pitcht,
+                                   int depth, viewport_t *viewport);
+
+#endif
@@ -40,6 +40,7 @@
 #include "render2x4crt.h"
 #include "renderyuv.h"
 #include "types.h"
+#include "video-render-thread.h"
 #include "video-render.h"
 #include "video-sound.h"
 #include "video.h"
@@ -126,16 +127,24 @@ void video_render_main(video_render_config_t *config, uint8_t *src, uint8_t *trg
 
         case VIDEO_RENDER_PAL_1X1:
         case VIDEO_RENDER_PAL_2X2:
-            (*render_pal_func)(config, src, trg, width, height, xs, ys, xt, yt,
-                               pitchs, pitcht, depth, viewport);
+            if (video_render_thread_run(render_pal_func, config, src, trg,
+                                        width, height, xs, ys, xt, yt,
+                                        pitchs, pitcht, depth, viewport) < 0) {
+                (*render_pal_func)(config, src, trg, width, height, xs, ys, xt, yt,
+                                   pitchs, pitcht, depth, viewport);
+            }
             return;
 
         case VIDEO_RENDER_CRT_1X1:
         case VIDEO_RENDER_CRT_1X2:
         case VIDEO_RENDER_CRT_2X2:
         case VIDEO_RENDER_CRT_2X4:
-            (*render_crt_func)(config, src, trg, width, height, xs, ys, xt, yt,
-                               pitchs, pitcht, depth, viewport);
+            if (video_render_thread_run(render_crt_func, config, src, trg,
+                                        width, height, xs, ys, xt, yt,
+                                        pitchs, pitcht, depth, viewport) < 0) {
+                (*render_crt_func)(config, src, trg, width, height, xs, ys, xt, yt,
+                                   pitchs, pitcht, depth, viewport);
+            }
             return;
 
         case VIDEO_RENDER_RGB_1X1:
@@ -45,6 +45,7 @@
 #include "machine.h"
 #include "resources.h"
 #include "video-color.h"
+#include "video-render-thread.h"
 #include "video.h"
 #include "viewport.h"
 #include "util.h"
@@ -70,6 +71,25 @@ static resource_int_t resources_hwscale_possible[] =
 };
 #endif
 
+static int video_render_threads;
+
+static int set_video_render_threads(int val, void *param)
+{
+    if (video_render_thread_set_count(val) < 0) {
+        return -1;
+    }
+    video_render_threads = val;
+
+    return 0;
+}
+
+static resource_int_t resources_render_threads[] =
+{
+    { "VideoRenderThreads", 0, RES_EVENT_NO, NULL,
+      &video_render_threads, set_video_render_threads, NULL },
+    RESOURCE_INT_LIST_END
+};
+
 int video_resources_init(void)
 {
 #ifdef HAVE_HWSCALE
@@ -80,11 +100,18 @@ int video_resources_init(void)
     }
 #endif
 
+    if (machine_class != VICE_MACHINE_VSID) {
+        if (resources_register_int(resources_render_threads) < 0) {
+            return -1;
+        }
+    }
+
     return video_arch_resources_init();
 }
 
 void video_resources_shutdown(void)
 {
+    video_render_thread_shutdown();
     video_arch_resources_shutdown();
 }
 
@@ -201,6 +201,15 @@ void video_sound_update(video_render_config_t *config, const uint8_t *src,
     float lum;
     int chipnum = get_chip_num(config);
 
+    if (!config->video_resources.audioleak && !video_sound.chip_enabled) {
+        chip[chipnum].enabled = 0;
+        return;
+    }
+
+    /* the line lumas are read while rendering the samples, wait for the
+       sound thread before changing them */
+    sound_sync();
+
     chip[chipnum].enabled = config->video_resources.audioleak;
     if (!check_enabled()) {
         video_sound.chip_enabled = 0;
@@ -55,6 +55,7 @@ int vsync_frame_counter;
 #include "videoarch.h"
 #endif
 
+#include "capture.h"
 #include "clkguard.h"
 #include "cmdline.h"
 #include "debug.h"
@@ -66,6 +67,7 @@ int vsync_frame_counter;
 #endif
 #include "network.h"
 #include "resources.h"
+#include "rewind.h"
 #include "sound.h"
 #include "types.h"
 #include "vsync.h"
@@ -325,6 +327,7 @@ void vsync_sync_reset(void)
 int vsync_do_vsync(struct video_canvas_s *c, int been_skipped)
 {
     static unsigned long next_frame_start = 0;
+    static int resimulating = 0;
     unsigned long network_hook_time = 0;
 
     /*
@@ -377,6 +380,22 @@ int vsync_do_vsync(struct video_canvas_s *c, int been_skipped)
 
     vsync_hook();
 
+    rewind_vsync();
+
+    capture_vsync();
+
+    /* A frame re-emulated after a netplay rollback has been shown and heard
+       already: drop its sound, and neither pace nor render the re-run.  */
+    if (resimulating) {
+        sound_flush();
+        resimulating = network_resimulating();
+        if (!resimulating) {
+            sound_set_warp_mode(warp_mode_enabled);
+        }
+        vsyncarch_postsync();
+        return resimulating;
+    }
+
     if (network_connected()) {
         network_hook_time = vsyncarch_gettime() - network_hook_time;
 
@@ -419,6 +438,11 @@ int vsync_do_vsync(struct video_canvas_s *c, int been_skipped)
     /* Flush sound buffer, get delay in seconds. */
     sound_delay = sound_flush();
 
+    if (network_resimulating()) {
+        resimulating = 1;
+        sound_set_warp_mode(1);
+    }
+
     /* Get current time, directly after getting the sound delay. */
     now = vsyncarch_gettime();
 
@@ -456,7 +480,7 @@ int vsync_do_vsync(struct video_canvas_s *c, int been_skipped)
     refresh_div = (int)(refresh_cmp + 0.5f);
     refresh_cmp /= (float)refresh_div;
 
-    if ((timer_speed == 100) && (!warp_mode_enabled) &&
+    if ((timer_speed == 100) && (!warp_mode_enabled) && !capture_enabled() &&
         vsyncarch_vbl_sync_enabled() &&
         (refresh_cmp <= 1.02f) && (refresh_cmp > 0.98f) &&
         (refresh_div == 1)) {
@@ -468,13 +492,15 @@ int vsync_do_vsync(struct video_canvas_s *c, int been_skipped)
     /*
      * We sleep until the start of the next frame, if:
      *  - warp_mode is disabled
+     *  - no movie is being captured
      *  - a limiting speed is given
      *  - we have not reached next_frame_start yet
      *
      * We could optimize by sleeping only if a frame is to be output.
      */
     /*log_debug("vsync_do_vsync: sound_delay=%f  frame_ticks=%d  delay=%d", sound_delay, frame_ticks, delay);*/
-    if (!warp_mode_enabled && timer_speed && (skipped_redraw == 0) && (delay < 0)) {
+    if (!warp_mode_enabled && !capture_enabled() && timer_speed
+        && (skipped_redraw == 0) && (delay < 0)) {
         /* FIXME: this is likely implemented as a regular sleep(), which means
            it will wait *at least* the given time (but may just as well wait
            much longer. its doomed to break on those archs - we should instead
@@ -493,6 +519,7 @@ int vsync_do_vsync(struct video_canvas_s *c, int been_skipped)
      *  - if warp_mode enabled
      *  - if speed is not limited or we are too slow and
      *    refresh rate is automatic or fixed and needs correction
+     *  - never while capturing a movie
      *
      * Remark: The time_deviation should be the equivalent of two
      *         frames and must be scaled to make sure, that we
@@ -507,7 +534,8 @@ int vsync_do_vsync(struct video_canvas_s *c, int been_skipped)
     compval = (frame_ticks_integer * 3 * timer_speed)
               + ((frame_ticks_remainder * 3 * timer_speed) / 100);
 
-    if ((skipped_redraw < MAX_SKIPPED_FRAMES)
+    if (!capture_enabled()
+        && (skipped_redraw < MAX_SKIPPED_FRAMES)
         && (warp_mode_enabled
             || (skipped_redraw < (refresh_rate - 1))
             || ((!timer_speed || delay > compval) && !refresh_rate))
@@ -577,6 +605,10 @@ int vsync_do_vsync(struct video_canvas_s *c, int been_skipped)
     next_frame_start += frame_ticks;
 #endif
 
+    if (resimulating) {
+        skip_next_frame = 1;
+    }
+
     vsyncarch_postsync();
 
 #ifdef VSYNC_DEBUG